@@ -0,0 +1,163 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "atomselection.h"
+
+#include <algorithm>
+#include <bitset>
+
+namespace Avogadro {
+namespace Core {
+
+const Index AtomSelection::WordBits;
+
+AtomSelection::AtomSelection() : m_size(0)
+{
+}
+
+AtomSelection::AtomSelection(Index size_, bool value)
+  : m_size(size_), m_words(wordCount(size_), value ? ~Word(0) : Word(0))
+{
+  clearUnusedBits();
+}
+
+void AtomSelection::resize(Index size_, bool value)
+{
+  Index oldSize = m_size;
+  m_size = size_;
+  m_words.resize(wordCount(size_), 0);
+  if (value && size_ > oldSize)
+    setRange(oldSize, size_, true);
+  clearUnusedBits();
+}
+
+void AtomSelection::setAll(bool value)
+{
+  std::fill(m_words.begin(), m_words.end(), value ? ~Word(0) : Word(0));
+  clearUnusedBits();
+}
+
+void AtomSelection::setRange(Index begin, Index end, bool value)
+{
+  end = std::min(end, m_size);
+  if (begin >= end)
+    return;
+
+  Index first = begin / WordBits;
+  Index last = (end - 1) / WordBits;
+  Word firstMask = ~Word(0) << (begin % WordBits);
+  Word lastMask = ~Word(0) >> (WordBits - 1 - (end - 1) % WordBits);
+  if (first == last) {
+    firstMask &= lastMask;
+    m_words[first] = value ? m_words[first] | firstMask
+                           : m_words[first] & ~firstMask;
+    return;
+  }
+
+  Word fill = value ? ~Word(0) : Word(0);
+  std::fill(m_words.begin() + first + 1, m_words.begin() + last, fill);
+  if (value) {
+    m_words[first] |= firstMask;
+    m_words[last] |= lastMask;
+  } else {
+    m_words[first] &= ~firstMask;
+    m_words[last] &= ~lastMask;
+  }
+}
+
+void AtomSelection::invert()
+{
+  for (Index w = 0; w < m_words.size(); ++w)
+    m_words[w] = ~m_words[w];
+  clearUnusedBits();
+}
+
+Index AtomSelection::count() const
+{
+  Index result = 0;
+  for (Index w = 0; w < m_words.size(); ++w) {
+#if defined(__GNUC__)
+    result += static_cast<Index>(__builtin_popcountll(m_words[w]));
+#else
+    result += std::bitset<WordBits>(m_words[w]).count();
+#endif
+  }
+  return result;
+}
+
+bool AtomSelection::any() const
+{
+  Word combined = 0;
+  for (Index w = 0; w < m_words.size(); ++w)
+    combined |= m_words[w];
+  return combined != 0;
+}
+
+std::vector<Index> AtomSelection::indices() const
+{
+  std::vector<Index> result;
+  result.reserve(count());
+  forEach([&result](Index i) { result.push_back(i); });
+  return result;
+}
+
+AtomSelection& AtomSelection::subtract(const AtomSelection& other)
+{
+  Index n = std::min(m_words.size(), other.m_words.size());
+  for (Index w = 0; w < n; ++w)
+    m_words[w] &= ~other.m_words[w];
+  return *this;
+}
+
+AtomSelection& AtomSelection::operator&=(const AtomSelection& other)
+{
+  if (other.m_size > m_size)
+    resize(other.m_size);
+  Index n = std::min(m_words.size(), other.m_words.size());
+  for (Index w = 0; w < n; ++w)
+    m_words[w] &= other.m_words[w];
+  std::fill(m_words.begin() + n, m_words.end(), Word(0));
+  return *this;
+}
+
+AtomSelection& AtomSelection::operator|=(const AtomSelection& other)
+{
+  if (other.m_size > m_size)
+    resize(other.m_size);
+  for (Index w = 0; w < other.m_words.size(); ++w)
+    m_words[w] |= other.m_words[w];
+  return *this;
+}
+
+AtomSelection& AtomSelection::operator^=(const AtomSelection& other)
+{
+  if (other.m_size > m_size)
+    resize(other.m_size);
+  for (Index w = 0; w < other.m_words.size(); ++w)
+    m_words[w] ^= other.m_words[w];
+  return *this;
+}
+
+AtomSelection AtomSelection::operator~() const
+{
+  AtomSelection result(*this);
+  result.invert();
+  return result;
+}
+
+bool AtomSelection::operator==(const AtomSelection& other) const
+{
+  return m_size == other.m_size && m_words == other.m_words;
+}
+
+void AtomSelection::clearUnusedBits()
+{
+  Index used = m_size % WordBits;
+  if (used != 0)
+    m_words.back() &= ~(~Word(0) << used);
+}
+
+} // namespace Core
+} // namespace Avogadro
@@ -0,0 +1,186 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_ATOMSELECTION_H
+#define AVOGADRO_CORE_ATOMSELECTION_H
+
+#include "avogadrocore.h"
+
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @class AtomSelection atomselection.h <avogadro/core/atomselection.h>
+ * @brief A dense set of atom indices stored as a bitset.
+ *
+ * Each atom takes one bit, and set operations work on 64 atoms at a time in
+ * simple loops over the words, which the compiler vectorizes. Combining,
+ * inverting and counting selections of a million atoms therefore takes
+ * microseconds. Bits past size() are always zero.
+ *
+ * Binary operations on selections of different sizes extend the smaller one
+ * with unselected atoms.
+ */
+class AVOGADROCORE_EXPORT AtomSelection
+{
+public:
+  typedef uint64_t Word;
+  static const Index WordBits = 64;
+
+  /** Creates an empty selection of zero atoms. */
+  AtomSelection();
+
+  /** Creates a selection of @a size atoms, all set to @a value. */
+  explicit AtomSelection(Index size, bool value = false);
+
+  /** @return The number of atoms covered by the selection. */
+  Index size() const { return m_size; }
+
+  /**
+   * Change the number of atoms covered. New atoms are set to @a value.
+   */
+  void resize(Index size, bool value = false);
+
+  /** @return True if atom @a index is selected, false if it is out of range. */
+  bool test(Index index) const
+  {
+    return index < m_size &&
+           (m_words[index / WordBits] >> (index % WordBits)) & 1;
+  }
+  bool operator[](Index index) const { return test(index); }
+
+  /** Select or deselect atom @a index, which must be less than size(). */
+  void set(Index index, bool value = true)
+  {
+    Word mask = Word(1) << (index % WordBits);
+    if (value)
+      m_words[index / WordBits] |= mask;
+    else
+      m_words[index / WordBits] &= ~mask;
+  }
+  void reset(Index index) { set(index, false); }
+
+  /** Select or deselect all atoms. */
+  void setAll(bool value = true);
+
+  /** Select the atoms in the range [begin, end). */
+  void setRange(Index begin, Index end, bool value = true);
+
+  /** Select the unselected atoms and deselect the selected ones. */
+  void invert();
+
+  /** @return The number of selected atoms. */
+  Index count() const;
+
+  /** @return True if any atom is selected. */
+  bool any() const;
+
+  /** @return True if no atom is selected. */
+  bool none() const { return !any(); }
+
+  /** @return The indices of the selected atoms in increasing order. */
+  std::vector<Index> indices() const;
+
+  /** Call @a f with the index of each selected atom in increasing order. */
+  template <typename Function>
+  void forEach(Function f) const;
+
+  /** @return The underlying words, 64 atoms per word, lowest index first. */
+  const std::vector<Word>& words() const { return m_words; }
+
+  /**
+   * Replace the 64 atoms starting at @a wordIndex * 64 with the bits of
+   * @a word, the lowest bit being the first atom. Bits past size() are
+   * ignored.
+   */
+  void setWord(Index wordIndex, Word word)
+  {
+    m_words[wordIndex] = word;
+    if (wordIndex + 1 == m_words.size())
+      clearUnusedBits();
+  }
+
+  /** Remove the atoms selected in @a other from this selection. */
+  AtomSelection& subtract(const AtomSelection& other);
+
+  AtomSelection& operator&=(const AtomSelection& other);
+  AtomSelection& operator|=(const AtomSelection& other);
+  AtomSelection& operator^=(const AtomSelection& other);
+  AtomSelection operator~() const;
+
+  bool operator==(const AtomSelection& other) const;
+  bool operator!=(const AtomSelection& other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  static Index wordCount(Index size)
+  {
+    return (size + WordBits - 1) / WordBits;
+  }
+  static int trailingZeros(Word word);
+  void clearUnusedBits();
+
+  Index m_size;
+  std::vector<Word> m_words;
+};
+
+inline AtomSelection operator&(AtomSelection a, const AtomSelection& b)
+{
+  return a &= b;
+}
+
+inline AtomSelection operator|(AtomSelection a, const AtomSelection& b)
+{
+  return a |= b;
+}
+
+inline AtomSelection operator^(AtomSelection a, const AtomSelection& b)
+{
+  return a ^= b;
+}
+
+inline int AtomSelection::trailingZeros(Word word)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_WIN64)
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return static_cast<int>(index);
+#else
+  int index = 0;
+  while (!(word & 1)) {
+    word >>= 1;
+    ++index;
+  }
+  return index;
+#endif
+}
+
+template <typename Function>
+void AtomSelection::forEach(Function f) const
+{
+  for (Index w = 0; w < m_words.size(); ++w) {
+    Word word = m_words[w];
+    while (word) {
+      f(w * WordBits + trailingZeros(word));
+      word &= word - 1;
+    }
+  }
+}
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_ATOMSELECTION_H
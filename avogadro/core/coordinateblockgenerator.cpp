@@ -16,193 +16,267 @@
 
 #include "coordinateblockgenerator.h"
 
-#include <avogadro/core/atom.h>
 #include <avogadro/core/avogadrocore.h>
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/unitcell.h>
 
-#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
 
 namespace Avogadro {
 namespace Core {
 
-CoordinateBlockGenerator::CoordinateBlockGenerator()
-  : m_molecule(nullptr), m_distanceUnit(Angstrom)
+namespace {
+// Below this many atoms per thread, spawning threads costs more than it saves.
+const Index MinAtomsPerThread = 4096;
+
+// widths
+enum
 {
+  atomicNumberWidth = 3,
+  coordinateWidth = 11,
+  elementNameWidth = 13, // Currently the longest element name
+  elementSymbolWidth = 3,
+  gamessAtomicNumberWidth = 5
+};
+
+// Field types that are not specification characters.
+const char LiteralSpace = ' ';
+const char Skip = '\0';
+
+void appendPadded(std::string& out, const char* text, size_t length,
+                  size_t width, bool left)
+{
+  size_t padding = length < width ? width - length : 0;
+  if (!left)
+    out.append(padding, ' ');
+  out.append(text, length);
+  if (left)
+    out.append(padding, ' ');
 }
 
-std::string CoordinateBlockGenerator::generateCoordinateBlock()
+// Write the decimal digits of @a value backwards, ending at @a end.
+char* writeDigits(uint64_t value, char* end)
 {
-  if (!m_molecule)
-    return "";
+  do {
+    *--end = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value);
+  return end;
+}
 
-  // Reset stream.
-  m_stream.str("");
-  m_stream.clear();
+void appendInteger(std::string& out, uint64_t value, size_t width, bool left,
+                   const char* suffix = "")
+{
+  char buffer[32];
+  char* begin = writeDigits(value, buffer + 20);
+  size_t length = buffer + 20 - begin;
+  size_t suffixLength = std::strlen(suffix);
+  std::memcpy(buffer + 20, suffix, suffixLength);
+  appendPadded(out, begin, length + suffixLength, width, left);
+}
 
-  // Create/cache some iterators for the specification string.
-  std::string::const_iterator it;
-  const std::string::const_iterator begin = m_specification.begin();
-  const std::string::const_iterator end = m_specification.end();
+// Format @a value like printf("%.6f"), which is what the stream formatting
+// used before produced. The scaled value is rounded as an integer, and only
+// values too large for that or too close to a rounding tie to decide in
+// double precision go through snprintf.
+void appendCoordinate(std::string& out, double value)
+{
+  char buffer[64];
+  double scaled = std::abs(value) * 1e6;
+  double fraction = scaled - std::floor(scaled);
+  if (!(scaled < 1e15) ||
+      std::abs(fraction - 0.5) <= scaled * 1e-15 + 1e-300) {
+    int length = std::snprintf(buffer, sizeof(buffer), "%.6f", value);
+    appendPadded(out, buffer, static_cast<size_t>(length), coordinateWidth,
+                 false);
+    return;
+  }
 
-  // Check the spec to see if certain items are needed.
-  bool needElementSymbol(false);
-  bool needElementName(false);
-  bool needPosition(false);
-  bool needFractionalPosition(false);
-  for (it = begin; it != end; ++it) {
-    switch (*it) {
+  uint64_t rounded = static_cast<uint64_t>(std::floor(scaled + 0.5));
+  char* end = buffer + sizeof(buffer);
+  char* begin = end;
+  uint64_t decimals = rounded % 1000000;
+  for (int i = 0; i < 6; ++i) {
+    *--begin = static_cast<char>('0' + decimals % 10);
+    decimals /= 10;
+  }
+  *--begin = '.';
+  begin = writeDigits(rounded / 1000000, begin);
+  if (std::signbit(value))
+    *--begin = '-';
+  appendPadded(out, begin, end - begin, coordinateWidth, false);
+}
+} // namespace
+
+CoordinateBlockGenerator::CoordinateBlockGenerator()
+  : m_molecule(nullptr), m_distanceUnit(Angstrom), m_threadCount(0)
+{
+}
+
+void CoordinateBlockGenerator::setSpecification(const std::string& spec)
+{
+  m_specification = spec;
+
+  // Compile the specification once into the list of fields to write for
+  // each atom, each followed by a space or, for the last, a newline.
+  m_fields.clear();
+  for (size_t i = 0; i < spec.size(); ++i) {
+    Field field;
+    field.separator = i + 1 < spec.size() ? ' ' : '\n';
+    switch (spec[i]) {
+      case '#':
+      case 'Z':
+      case 'G':
       case 'S':
-        needElementSymbol = true;
-        break;
       case 'N':
-        needElementName = true;
-        break;
       case 'x':
       case 'y':
       case 'z':
-        needPosition = true;
-        break;
       case 'a':
       case 'b':
       case 'c':
-        needFractionalPosition = true;
+      case '0':
+      case '1':
+        field.type = spec[i];
+        break;
+      case '_':
+        // Space character. A space follows every field but the last, so only
+        // a trailing '_' needs one of its own before the newline.
+        field.type = i + 1 < spec.size() ? Skip : LiteralSpace;
+        break;
+      default:
+        field.type = Skip;
         break;
     }
+    m_fields.push_back(field);
+  }
+}
+
+std::string CoordinateBlockGenerator::generateCoordinateBlock()
+{
+  if (!m_molecule)
+    return "";
+
+  // Check the spec to see if certain items are needed.
+  bool needFractionalPosition(false);
+  for (size_t i = 0; i < m_fields.size(); ++i) {
+    char type = m_fields[i].type;
+    if (type == 'a' || type == 'b' || type == 'c')
+      needFractionalPosition = true;
   }
 
-  // Variables for loops below
   const Index numAtoms = m_molecule->atomCount();
-  Atom atom;
-  unsigned char atomicNumber;
-  const char* symbol;
-  const char* name;
-  Vector3 pos3d;
-  Vector3 fpos3d;
+  if (numAtoms == 0 || m_fields.empty())
+    return "";
+
+  const Array<unsigned char>& atomicNumbers = m_molecule->atomicNumbers();
+  const Array<Vector3>& positions = m_molecule->atomPositions3d();
   const UnitCell* cell =
     needFractionalPosition ? molecule()->unitCell() : nullptr;
+  const Real distanceScale =
+    m_distanceUnit == Bohr ? static_cast<Real>(ANGSTROM_TO_BOHR_F) : 1.0;
+  const size_t indexWidth =
+    static_cast<size_t>(std::log10(static_cast<float>(numAtoms))) + 1;
 
-  // widths/precisions
-  enum
-  {
-    atomicNumberPrecision = 0,
-    atomicNumberWidth = 3,
-    coordinatePrecision = 6,
-    coordinateWidth = 11,
-    elementNameWidth = 13, // Currently the longest element name
-    elementSymbolWidth = 3,
-    gamessAtomicNumberPrecision = 1,
-    gamessAtomicNumberWidth = 5
-  };
-  const int indexWidth(
-    static_cast<int>(std::log10(static_cast<float>(numAtoms))) + 1);
-
-  // Use fixed number format.
-  m_stream << std::fixed;
-
-  // Iterate through the atoms
-  for (Index atomI = 0; atomI < numAtoms; ++atomI) {
-    atom = m_molecule->atom(atomI);
-    atomicNumber = atom.atomicNumber();
-    if (needElementSymbol)
-      symbol = Core::Elements::symbol(atomicNumber);
-    if (needElementName)
-      name = Core::Elements::name(atomicNumber);
-    if (needPosition)
-      pos3d = atom.position3d();
-    if (needFractionalPosition)
-      fpos3d = cell ? cell->toFractional(atom.position3d()) : Vector3::Zero();
-
-    switch (m_distanceUnit) {
-      case Bohr:
-        pos3d *= ANGSTROM_TO_BOHR_F;
-        break;
-      default:
-      case Angstrom:
-        break;
-    }
+  // Format the atoms in [begin, end) into out.
+  auto formatAtoms = [&](Index begin, Index end, std::string& out) {
+    out.reserve((end - begin) * m_fields.size() * 12);
+    for (Index atomI = begin; atomI < end; ++atomI) {
+      unsigned char atomicNumber = atomicNumbers[atomI];
+      Vector3 position =
+        atomI < positions.size() ? positions[atomI] : Vector3(Vector3::Zero());
+      Vector3 fractional = cell ? cell->toFractional(position) : position;
+      position *= distanceScale;
 
-    for (it = begin; it != end; ++it) {
-      switch (*it) {
-        case '_':
-          // Space character. If we are not at the end of the spec, a space will
-          // be added by default after the switch clause. If we are at the end,
-          // add a space before the newline that will be added.
-          if (it + 1 == end)
-            m_stream << std::setw(1) << " ";
-          break;
-        case '#':
-          m_stream << std::left << std::setw(indexWidth)
-                   << static_cast<int>(atomI + 1);
-          break;
-        case 'Z':
-          m_stream << std::left << std::setw(atomicNumberWidth)
-                   << std::setprecision(atomicNumberPrecision)
-                   << static_cast<int>(atomicNumber);
-          break;
-        case 'G':
-          m_stream << std::right << std::setw(gamessAtomicNumberWidth)
-                   << std::setprecision(gamessAtomicNumberPrecision)
-                   << static_cast<float>(atomicNumber);
-          break;
-        case 'S':
-          m_stream << std::left << std::setw(elementSymbolWidth) << symbol;
-          break;
-        case 'N':
-          m_stream << std::left << std::setw(elementNameWidth) << name;
-          break;
-        case 'x':
-          m_stream << std::right << std::setw(coordinateWidth)
-                   << std::setprecision(coordinatePrecision) << pos3d.x();
-          break;
-        case 'y':
-          m_stream << std::right << std::setw(coordinateWidth)
-                   << std::setprecision(coordinatePrecision) << pos3d.y();
-          break;
-        case 'z':
-          m_stream << std::right << std::setw(coordinateWidth)
-                   << std::setprecision(coordinatePrecision) << pos3d.z();
-          break;
-        case '0':
-          m_stream << std::left << std::setw(1) << 0;
-          break;
-        case '1':
-          m_stream << std::left << std::setw(1) << 1;
-          break;
-        case 'a':
-          if (cell) {
-            m_stream << std::right << std::setw(coordinateWidth)
-                     << std::setprecision(coordinatePrecision) << fpos3d.x();
-          } else {
-            m_stream << std::right << std::setw(coordinateWidth) << "N/A";
-          }
-          break;
-        case 'b':
-          if (cell) {
-            m_stream << std::right << std::setw(coordinateWidth)
-                     << std::setprecision(coordinatePrecision) << fpos3d.y();
-          } else {
-            m_stream << std::right << std::setw(coordinateWidth) << "N/A";
+      for (size_t i = 0; i < m_fields.size(); ++i) {
+        const Field& field = m_fields[i];
+        switch (field.type) {
+          case LiteralSpace:
+            out.push_back(' ');
+            break;
+          case '#':
+            appendInteger(out, atomI + 1, indexWidth, true);
+            break;
+          case 'Z':
+            appendInteger(out, atomicNumber, atomicNumberWidth, true);
+            break;
+          case 'G':
+            appendInteger(out, atomicNumber, gamessAtomicNumberWidth, false,
+                          ".0");
+            break;
+          case 'S': {
+            const char* symbol = Elements::symbol(atomicNumber);
+            appendPadded(out, symbol, std::strlen(symbol), elementSymbolWidth,
+                         true);
+            break;
           }
-          break;
-        case 'c':
-          if (cell) {
-            m_stream << std::right << std::setw(coordinateWidth)
-                     << std::setprecision(coordinatePrecision) << fpos3d.z();
-          } else {
-            m_stream << std::right << std::setw(coordinateWidth) << "N/A";
+          case 'N': {
+            const char* name = Elements::name(atomicNumber);
+            appendPadded(out, name, std::strlen(name), elementNameWidth,
+                         true);
+            break;
           }
-          break;
-      } // end switch
+          case 'x':
+          case 'y':
+          case 'z':
+            appendCoordinate(out, position[field.type - 'x']);
+            break;
+          case 'a':
+          case 'b':
+          case 'c':
+            if (cell)
+              appendCoordinate(out, fractional[field.type - 'a']);
+            else
+              appendPadded(out, "N/A", 3, coordinateWidth, false);
+            break;
+          case '0':
+          case '1':
+            out.push_back(field.type);
+            break;
+        }
+        out.push_back(field.separator);
+      }
+    }
+  };
+
+  Index threads = m_threadCount;
+  if (threads == 0) {
+    unsigned int hardware = std::thread::hardware_concurrency();
+    threads = std::min<Index>(std::max(1u, hardware),
+                              std::max<Index>(1, numAtoms / MinAtomsPerThread));
+  }
+  threads = std::min(threads, numAtoms);
+  if (threads <= 1) {
+    std::string block;
+    formatAtoms(0, numAtoms, block);
+    return block;
+  }
 
-      // Prepare for next value. Push a space into the output stream if we are
-      // not at the end of the line, or a newline if we are.
-      m_stream << std::setw(1) << (it + 1 != end ? ' ' : '\n');
-    } // end spec char
-  }   // end for atom
+  std::vector<std::string> chunks(threads);
+  std::vector<std::thread> pool;
+  for (Index t = 0; t < threads; ++t) {
+    Index begin = numAtoms * t / threads;
+    Index end = numAtoms * (t + 1) / threads;
+    pool.push_back(std::thread(
+      [&, t, begin, end]() { formatAtoms(begin, end, chunks[t]); }));
+  }
+  size_t totalSize = 0;
+  for (Index t = 0; t < threads; ++t) {
+    pool[t].join();
+    totalSize += chunks[t].size();
+  }
 
-  return m_stream.str();
+  std::string block;
+  block.reserve(totalSize);
+  for (Index t = 0; t < threads; ++t)
+    block += chunks[t];
+  return block;
 }
 
 } // namespace Core
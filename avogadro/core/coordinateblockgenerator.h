@@ -19,8 +19,8 @@
 
 #include <avogadrocoreexport.h>
 
-#include <sstream>
 #include <string>
+#include <vector>
 
 namespace Avogadro {
 namespace Core {
@@ -89,7 +89,7 @@ __SZxyz110
   H  1   -2.396173  0.450760  0.000000 1 1 0
 ~~~
    */
-  void setSpecification(const std::string& spec) { m_specification = spec; }
+  void setSpecification(const std::string& spec);
   std::string specification() const { return m_specification; }
   /** @} */
 
@@ -104,15 +104,35 @@ __SZxyz110
   /** @} */
 
   /**
-   * Generate and return the coordinate block.
+   * Set the number of threads that format the block. Zero (the default)
+   * uses the hardware concurrency, but only for molecules large enough to
+   * benefit. Otherwise exactly this many threads are used, at most one per
+   * atom.
+   * @{
+   */
+  void setThreadCount(unsigned int threads) { m_threadCount = threads; }
+  unsigned int threadCount() const { return m_threadCount; }
+  /** @} */
+
+  /**
+   * Generate and return the coordinate block. Large molecules are formatted
+   * in chunks on several threads, see setThreadCount().
    */
   std::string generateCoordinateBlock();
 
 private:
+  /** One column of the block, compiled from a specification character. */
+  struct Field
+  {
+    char type;
+    char separator;
+  };
+
   const Molecule* m_molecule;
   std::string m_specification;
+  std::vector<Field> m_fields;
   DistanceUnit m_distanceUnit;
-  std::stringstream m_stream;
+  unsigned int m_threadCount;
 };
 
 } // namespace Core
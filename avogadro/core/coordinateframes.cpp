@@ -0,0 +1,275 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "coordinateframes.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+// The first byte of a quantized frame says how its deltas are taken.
+enum DeltaMode
+{
+  AtomDeltas = 0,     // Each atom relative to the previous atom of the frame.
+  ReferenceDeltas = 1 // Each atom relative to the first frame of the block.
+};
+
+typedef Eigen::Matrix<Real, 3, Eigen::Dynamic> Coordinates;
+typedef Eigen::Matrix<float, 3, Eigen::Dynamic> SingleCoordinates;
+
+void appendVarint(std::vector<unsigned char>& bytes, uint64_t value)
+{
+  while (value >= 0x80) {
+    bytes.push_back(static_cast<unsigned char>(value | 0x80));
+    value >>= 7;
+  }
+  bytes.push_back(static_cast<unsigned char>(value));
+}
+
+uint64_t readVarint(const unsigned char*& byte)
+{
+  uint64_t value = 0;
+  int shift = 0;
+  while (*byte & 0x80) {
+    value |= static_cast<uint64_t>(*byte++ & 0x7f) << shift;
+    shift += 7;
+  }
+  return value | static_cast<uint64_t>(*byte++) << shift;
+}
+
+// Zigzag encoding maps small negative numbers to small unsigned ones.
+uint32_t zigzag(int32_t value)
+{
+  return (static_cast<uint32_t>(value) << 1) ^
+         static_cast<uint32_t>(value >> 31);
+}
+
+int32_t unzigzag(uint32_t value)
+{
+  return static_cast<int32_t>((value >> 1) ^ (0u - (value & 1)));
+}
+
+void encodeDeltas(std::vector<unsigned char>& bytes, DeltaMode mode,
+                  const Eigen::Matrix<int32_t, 3, Eigen::Dynamic>& deltas)
+{
+  bytes.clear();
+  bytes.reserve(1 + 3 * deltas.size());
+  bytes.push_back(static_cast<unsigned char>(mode));
+  appendVarint(bytes, static_cast<uint64_t>(deltas.cols()));
+  const int32_t* delta = deltas.data();
+  for (Eigen::Index i = 0; i < deltas.size(); ++i)
+    appendVarint(bytes, zigzag(delta[i]));
+}
+
+inline Eigen::Map<const Coordinates> coordinates(
+  const Array<Vector3>& positions)
+{
+  return Eigen::Map<const Coordinates>(positions[0].data(), 3,
+                                       positions.size());
+}
+} // namespace
+
+CoordinateFrames::CoordinateFrames() : m_compression(None), m_precision(0.001)
+{
+}
+
+void CoordinateFrames::resize(Index count)
+{
+  m_frames.resize(count);
+}
+
+void CoordinateFrames::clear()
+{
+  m_frames.clear();
+}
+
+Array<Vector3> CoordinateFrames::frame(Index index) const
+{
+  if (m_compression == None)
+    return m_frames[index].positions;
+  Array<Vector3> positions;
+  frame(index, positions);
+  return positions;
+}
+
+void CoordinateFrames::frame(Index index, Array<Vector3>& positions) const
+{
+  const Frame& f = m_frames[index];
+  if (m_compression == None) {
+    positions = f.positions;
+    return;
+  }
+  if (f.atomCount == 0) {
+    positions.clear();
+    return;
+  }
+
+  positions.resize(f.atomCount);
+  Eigen::Map<Coordinates> out(positions.data()->data(), 3, f.atomCount);
+  if (m_compression == SinglePrecision) {
+    out = Eigen::Map<const SingleCoordinates>(f.singles.data(), 3,
+                                              f.atomCount)
+            .cast<Real>();
+  } else {
+    Quanta quanta;
+    decodeQuanta(index, quanta);
+    out = quanta.cast<Real>() * m_precision;
+  }
+}
+
+void CoordinateFrames::setFrame(Index index, const Array<Vector3>& positions)
+{
+  if (index >= m_frames.size())
+    m_frames.resize(index + 1);
+  encode(index, positions);
+}
+
+bool CoordinateFrames::setCompression(Compression compression,
+                                      Real precision)
+{
+  if (!(precision > 0.0))
+    return false;
+  if (compression == m_compression &&
+      (compression != Quantized || precision == m_precision)) {
+    m_precision = precision;
+    return true;
+  }
+
+  // Encode into a new store so that the reference frames of the old one
+  // stay readable until every frame is converted.
+  CoordinateFrames converted;
+  converted.m_compression = compression;
+  converted.m_precision = precision;
+  converted.m_frames.resize(m_frames.size());
+  Array<Vector3> positions;
+  for (Index i = 0; i < m_frames.size(); ++i) {
+    frame(i, positions);
+    converted.encode(i, positions);
+  }
+  *this = converted;
+  return true;
+}
+
+Index CoordinateFrames::memoryUsage() const
+{
+  Index bytes = m_frames.size() * sizeof(Frame);
+  for (Index i = 0; i < m_frames.size(); ++i) {
+    const Frame& f = m_frames[i];
+    bytes += f.positions.size() * sizeof(Vector3) +
+             f.singles.size() * sizeof(float) + f.bytes.size();
+  }
+  return bytes;
+}
+
+void CoordinateFrames::encode(Index index, const Array<Vector3>& positions)
+{
+  Index atomCount = positions.size();
+  if (m_compression == None) {
+    Frame& f = m_frames[index];
+    f.atomCount = atomCount;
+    f.positions = positions;
+    return;
+  }
+
+  if (m_compression == SinglePrecision) {
+    Frame& f = m_frames[index];
+    f.atomCount = atomCount;
+    f.positions.clear();
+    f.bytes.clear();
+    f.singles = Array<float>(3 * atomCount);
+    if (atomCount > 0) {
+      Eigen::Map<SingleCoordinates>(f.singles.data(), 3, atomCount) =
+        coordinates(positions).cast<float>();
+    }
+    return;
+  }
+
+  Quanta quanta(3, atomCount);
+  if (atomCount > 0)
+    quanta =
+      (coordinates(positions) / m_precision).array().round().cast<int32_t>();
+
+  // Frames later in the block may be stored relative to this one, decode
+  // them before it changes and store them again afterwards.
+  std::vector<std::pair<Index, Quanta>> dependents;
+  if (index % BlockSize == 0) {
+    Index end = std::min(index + BlockSize, m_frames.size());
+    for (Index i = index + 1; i < end; ++i) {
+      const Array<unsigned char>& bytes = m_frames[i].bytes;
+      if (!bytes.empty() && bytes[0] == ReferenceDeltas) {
+        dependents.push_back(std::make_pair(i, Quanta()));
+        decodeQuanta(i, dependents.back().second);
+      }
+    }
+  }
+
+  storeQuanta(index, quanta);
+  for (size_t i = 0; i < dependents.size(); ++i)
+    storeQuanta(dependents[i].first, dependents[i].second);
+}
+
+void CoordinateFrames::storeQuanta(Index index, const Quanta& quanta)
+{
+  Eigen::Index atomCount = quanta.cols();
+  Frame& f = m_frames[index];
+  f.atomCount = static_cast<Index>(atomCount);
+  f.positions.clear();
+  f.singles.clear();
+
+  Quanta deltas(3, atomCount);
+  if (atomCount > 0) {
+    deltas.col(0) = quanta.col(0);
+    deltas.rightCols(atomCount - 1) =
+      quanta.rightCols(atomCount - 1) - quanta.leftCols(atomCount - 1);
+  }
+  std::vector<unsigned char> bytes;
+  encodeDeltas(bytes, AtomDeltas, deltas);
+
+  // Consecutive trajectory frames usually differ far less than neighboring
+  // atoms do, keep the reference deltas if they are the smaller encoding.
+  Index reference = index - index % BlockSize;
+  if (reference != index && atomCount > 0 &&
+      m_frames[reference].atomCount == f.atomCount) {
+    Quanta referenceQuanta;
+    decodeQuanta(reference, referenceQuanta);
+    deltas = quanta - referenceQuanta;
+    std::vector<unsigned char> referenceBytes;
+    encodeDeltas(referenceBytes, ReferenceDeltas, deltas);
+    if (referenceBytes.size() < bytes.size())
+      bytes.swap(referenceBytes);
+  }
+  f.bytes = Array<unsigned char>(bytes.begin(), bytes.end());
+}
+
+void CoordinateFrames::decodeQuanta(Index index, Quanta& quanta) const
+{
+  const Frame& f = m_frames[index];
+  quanta.resize(3, f.atomCount);
+  if (f.atomCount == 0 || f.bytes.empty())
+    return;
+
+  const unsigned char* byte = f.bytes.data();
+  DeltaMode mode = static_cast<DeltaMode>(*byte++);
+  readVarint(byte); // The atom count, already known.
+  int32_t* value = quanta.data();
+  for (Eigen::Index i = 0; i < quanta.size(); ++i)
+    value[i] = unzigzag(static_cast<uint32_t>(readVarint(byte)));
+
+  if (mode == ReferenceDeltas) {
+    Quanta referenceQuanta;
+    decodeQuanta(index - index % BlockSize, referenceQuanta);
+    quanta += referenceQuanta;
+  } else {
+    for (Eigen::Index i = 1; i < quanta.cols(); ++i)
+      quanta.col(i) += quanta.col(i - 1);
+  }
+}
+
+} // namespace Core
+} // namespace Avogadro
@@ -0,0 +1,120 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_COORDINATEFRAMES_H
+#define AVOGADRO_CORE_COORDINATEFRAMES_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "vector.h"
+
+#include <cstdint>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @class CoordinateFrames coordinateframes.h
+ * <avogadro/core/coordinateframes.h>
+ * @brief Storage for the conformers or trajectory frames of a molecule.
+ *
+ * By default each frame is kept as an Array<Vector3>, exactly as set. Large
+ * conformer libraries and trajectories can instead be stored compressed:
+ *
+ * - SinglePrecision keeps each coordinate as a float, halving the memory.
+ * - Quantized rounds each coordinate to a multiple of precision() and stores
+ *   the integers as variable-length deltas, in the spirit of the XTC format.
+ *   Frames are grouped in blocks of BlockSize. The first frame of a block is
+ *   encoded as differences between consecutive atoms, later frames as
+ *   differences from the first frame of their block, or like the first if
+ *   that is smaller (unrelated conformers for instance). Any frame decodes
+ *   from itself and at most one other frame, so random access stays cheap.
+ *   A typical trajectory needs a quarter or less of the uncompressed memory.
+ *
+ * Frames are decoded on demand. The conversions to and from double precision
+ * are written as Eigen array expressions, which are vectorized.
+ */
+class AVOGADROCORE_EXPORT CoordinateFrames
+{
+public:
+  enum Compression
+  {
+    None,
+    SinglePrecision,
+    Quantized
+  };
+
+  /** The number of frames sharing a reference frame in Quantized mode. */
+  static const Index BlockSize = 16;
+
+  CoordinateFrames();
+
+  /** @return The number of frames. */
+  Index size() const { return m_frames.size(); }
+  bool empty() const { return m_frames.empty(); }
+
+  /** Change the number of frames. New frames are empty. */
+  void resize(Index count);
+
+  /** Remove all frames. The compression settings are kept. */
+  void clear();
+
+  /** @return Frame @a index, decoded. @a index must be less than size(). */
+  Array<Vector3> frame(Index index) const;
+
+  /** Decode frame @a index into @a positions, reusing its storage. */
+  void frame(Index index, Array<Vector3>& positions) const;
+
+  /**
+   * Replace frame @a index with @a positions, growing the frame count if
+   * needed.
+   */
+  void setFrame(Index index, const Array<Vector3>& positions);
+
+  /** @return The current compression mode. */
+  Compression compression() const { return m_compression; }
+
+  /** @return The quantization step in Angstrom used by Quantized mode. */
+  Real precision() const { return m_precision; }
+
+  /**
+   * Convert all frames to @a compression. @a precision is the quantization
+   * step in Angstrom for Quantized mode, where coordinates must stay within
+   * about 2^30 * @a precision of the origin. Switching to a lossy mode rounds
+   * the stored frames.
+   * @return False if @a precision is not positive, leaving the frames as
+   * they were.
+   */
+  bool setCompression(Compression compression, Real precision = 0.001);
+
+  /** @return The approximate number of bytes taken by the frame data. */
+  Index memoryUsage() const;
+
+private:
+  struct Frame
+  {
+    Frame() : atomCount(0) {}
+    Index atomCount;
+    Array<Vector3> positions;
+    Array<float> singles;
+    Array<unsigned char> bytes;
+  };
+
+  typedef Eigen::Matrix<int32_t, 3, Eigen::Dynamic> Quanta;
+
+  void encode(Index index, const Array<Vector3>& positions);
+  void storeQuanta(Index index, const Quanta& quanta);
+  void decodeQuanta(Index index, Quanta& quanta) const;
+
+  Compression m_compression;
+  Real m_precision;
+  Array<Frame> m_frames;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_COORDINATEFRAMES_H
@@ -26,7 +26,7 @@ namespace Core {
 Cube::Cube()
   : m_data(0), m_min(0.0, 0.0, 0.0), m_max(0.0, 0.0, 0.0),
     m_spacing(0.0, 0.0, 0.0), m_points(0, 0, 0), m_minValue(0.0),
-    m_maxValue(0.0), m_lock(new Mutex)
+    m_maxValue(0.0), m_cubeType(None), m_lock(new Mutex)
 {
 }
 
@@ -36,6 +36,30 @@ Cube::~Cube()
   m_lock = 0;
 }
 
+Cube::Cube(const Cube& other)
+  : m_data(other.m_data), m_min(other.m_min), m_max(other.m_max),
+    m_spacing(other.m_spacing), m_points(other.m_points),
+    m_minValue(other.m_minValue), m_maxValue(other.m_maxValue),
+    m_name(other.m_name), m_cubeType(other.m_cubeType), m_lock(new Mutex)
+{
+}
+
+Cube& Cube::operator=(const Cube& other)
+{
+  if (this != &other) {
+    m_data = other.m_data;
+    m_min = other.m_min;
+    m_max = other.m_max;
+    m_spacing = other.m_spacing;
+    m_points = other.m_points;
+    m_minValue = other.m_minValue;
+    m_maxValue = other.m_maxValue;
+    m_name = other.m_name;
+    m_cubeType = other.m_cubeType;
+  }
+  return *this;
+}
+
 bool Cube::setLimits(const Vector3& min_, const Vector3& max_,
                      const Vector3i& points)
 {
@@ -42,6 +42,10 @@ public:
   Cube();
   ~Cube();
 
+  /** Copies the data and limits of @a other. The copy has its own lock. */
+  Cube(const Cube& other);
+  Cube& operator=(const Cube& other);
+
   /**
    * \enum Different Cube types relating to the data
    */
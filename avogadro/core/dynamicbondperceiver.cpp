@@ -0,0 +1,283 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "dynamicbondperceiver.h"
+
+#include "elements.h"
+#include "molecule.h"
+#include "neighborperceiver.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace Avogadro {
+namespace Core {
+
+DynamicBondPerceiver::DynamicBondPerceiver(Real tolerance, Real minDistance)
+  : m_tolerance(tolerance), m_minDistance(minDistance), m_skin(1.0),
+    m_synchronized(false), m_rebuildCount(0)
+{
+}
+
+void DynamicBondPerceiver::setSkin(Real skin)
+{
+  m_skin = std::max(skin, Real(0.0));
+  reset();
+}
+
+void DynamicBondPerceiver::reset()
+{
+  m_atomicNumbers = Array<unsigned char>();
+  m_reference = Array<Vector3>();
+  m_candidates.clear();
+  m_bonded.clear();
+  m_candidateBond.clear();
+  m_bondCandidate.clear();
+  m_bondPairs = Array<std::pair<Index, Index>>();
+  m_bondOrders = Array<unsigned char>();
+  m_synchronized = false;
+}
+
+bool DynamicBondPerceiver::update(Molecule& mol)
+{
+  const Array<Vector3>& positions = mol.atomPositions3d();
+  if (positions.size() != mol.atomCount())
+    return false;
+
+  if (!listIsValid(mol))
+    rebuild(mol);
+
+  std::vector<Index> flipped;
+  perceive(positions, flipped);
+
+  // The bonds were changed elsewhere since the last update, match them up
+  // with the perceived ones from scratch.
+  if (!m_synchronized || mol.bondPairs() != m_bondPairs ||
+      mol.bondOrders() != m_bondOrders) {
+    return synchronize(mol);
+  }
+
+  if (flipped.empty())
+    return false;
+
+  std::vector<Index> added;
+  for (Index c : flipped) {
+    if (m_bonded[c])
+      added.push_back(c);
+    else
+      removeBond(mol, m_candidateBond[c]);
+  }
+  addBonds(mol, added);
+
+  m_bondPairs = mol.bondPairs();
+  m_bondOrders = mol.bondOrders();
+  return true;
+}
+
+void DynamicBondPerceiver::adoptBonds(const Molecule& mol)
+{
+  m_synchronized = false;
+
+  // Once an atom moved too far the list is rebuilt by the next update()
+  // anyway, and the bonds are matched up with it then.
+  const Array<Vector3>& positions = mol.atomPositions3d();
+  if (positions.size() != mol.atomCount() || !listIsValid(mol))
+    return;
+
+  std::vector<Index> flipped;
+  perceive(positions, flipped);
+
+  const Index atomCount = mol.atomCount();
+  std::unordered_map<Index, Index> perceived;
+  for (Index c = 0; c < m_candidates.size(); ++c) {
+    if (m_bonded[c])
+      perceived[m_candidates[c].first * atomCount + m_candidates[c].second] = c;
+  }
+  if (perceived.size() != mol.bondCount())
+    return;
+
+  std::fill(m_candidateBond.begin(), m_candidateBond.end(), MaxIndex);
+  m_bondCandidate.assign(mol.bondCount(), MaxIndex);
+  for (Index b = 0; b < mol.bondCount(); ++b) {
+    std::pair<Index, Index> pair = mol.bondPair(b);
+    Index key = std::min(pair.first, pair.second) * atomCount +
+                std::max(pair.first, pair.second);
+    auto found = perceived.find(key);
+    if (found == perceived.end() ||
+        m_candidateBond[found->second] != MaxIndex || mol.bondOrder(b) != 1) {
+      return;
+    }
+    m_candidateBond[found->second] = b;
+    m_bondCandidate[b] = found->second;
+  }
+
+  m_bondPairs = mol.bondPairs();
+  m_bondOrders = mol.bondOrders();
+  m_synchronized = true;
+}
+
+bool DynamicBondPerceiver::listIsValid(const Molecule& mol) const
+{
+  if (m_reference.size() != mol.atomCount() ||
+      mol.atomicNumbers() != m_atomicNumbers) {
+    return false;
+  }
+
+  // No pair outside of the list can have come within its cutoff unless one
+  // of the atoms moved by more than half the skin.
+  const Array<Vector3>& positions = mol.atomPositions3d();
+  const Real limitSquared = 0.25 * m_skin * m_skin;
+  for (Index i = 0; i < positions.size(); ++i) {
+    if ((positions[i] - m_reference[i]).squaredNorm() > limitSquared)
+      return false;
+  }
+  return true;
+}
+
+void DynamicBondPerceiver::rebuild(const Molecule& mol)
+{
+  ++m_rebuildCount;
+  m_atomicNumbers = mol.atomicNumbers();
+  m_reference = mol.atomPositions3d();
+
+  // Same radii as Molecule::perceiveBondsSimple().
+  std::vector<Real> radii(m_atomicNumbers.size());
+  Real maxRadius = 0.0;
+  for (Index i = 0; i < radii.size(); ++i) {
+    radii[i] = Elements::radiusCovalent(m_atomicNumbers[i]);
+    if (radii[i] <= 0.0)
+      radii[i] = 2.0;
+    maxRadius = std::max(maxRadius, radii[i]);
+  }
+
+  NeighborPerceiver perceiver(m_reference,
+                              2.0 * maxRadius + m_tolerance + m_skin);
+  std::vector<std::pair<Index, Index>> pairs;
+  perceiver.getPairs(pairs);
+
+  m_candidates.clear();
+  for (const std::pair<Index, Index>& pair : pairs) {
+    Index i = pair.first;
+    Index j = pair.second;
+    if (m_atomicNumbers[i] == 1 && m_atomicNumbers[j] == 1)
+      continue;
+    Real cutoff = radii[i] + radii[j] + m_tolerance;
+    Real listCutoff = cutoff + m_skin;
+    if ((m_reference[j] - m_reference[i]).squaredNorm() <
+        listCutoff * listCutoff) {
+      Candidate candidate = { i, j, cutoff * cutoff };
+      m_candidates.push_back(candidate);
+    }
+  }
+
+  m_bonded.assign(m_candidates.size(), 0);
+  m_candidateBond.assign(m_candidates.size(), MaxIndex);
+  m_bondCandidate.clear();
+  m_synchronized = false;
+}
+
+void DynamicBondPerceiver::perceive(const Array<Vector3>& positions,
+                                    std::vector<Index>& flipped)
+{
+  const Real minSquared = m_minDistance * m_minDistance;
+  for (Index c = 0; c < m_candidates.size(); ++c) {
+    const Candidate& candidate = m_candidates[c];
+    Real distanceSquared =
+      (positions[candidate.second] - positions[candidate.first]).squaredNorm();
+    unsigned char bonded = distanceSquared < candidate.cutoffSquared &&
+                           distanceSquared > minSquared;
+    if (bonded != m_bonded[c]) {
+      m_bonded[c] = bonded;
+      flipped.push_back(c);
+    }
+  }
+}
+
+bool DynamicBondPerceiver::synchronize(Molecule& mol)
+{
+  const Index atomCount = mol.atomCount();
+  std::unordered_map<Index, Index> perceived;
+  for (Index c = 0; c < m_candidates.size(); ++c) {
+    if (m_bonded[c])
+      perceived[m_candidates[c].first * atomCount + m_candidates[c].second] = c;
+  }
+
+  std::fill(m_candidateBond.begin(), m_candidateBond.end(), MaxIndex);
+  m_bondCandidate.assign(mol.bondCount(), MaxIndex);
+
+  // Walk backwards, so that the bond moved into the place of a removed one
+  // has already been looked at.
+  bool changed = false;
+  for (Index b = mol.bondCount(); b-- > 0;) {
+    std::pair<Index, Index> pair = mol.bondPair(b);
+    Index key = std::min(pair.first, pair.second) * atomCount +
+                std::max(pair.first, pair.second);
+    auto found = perceived.find(key);
+    if (found == perceived.end() ||
+        m_candidateBond[found->second] != MaxIndex) {
+      removeBond(mol, b);
+      changed = true;
+      continue;
+    }
+    m_candidateBond[found->second] = b;
+    m_bondCandidate[b] = found->second;
+    if (mol.bondOrder(b) != 1) {
+      mol.setBondOrder(b, 1);
+      changed = true;
+    }
+  }
+
+  std::vector<Index> added;
+  for (Index c = 0; c < m_candidates.size(); ++c) {
+    if (m_bonded[c] && m_candidateBond[c] == MaxIndex)
+      added.push_back(c);
+  }
+  addBonds(mol, added);
+  changed = changed || !added.empty();
+
+  m_bondPairs = mol.bondPairs();
+  m_bondOrders = mol.bondOrders();
+  m_synchronized = true;
+  return changed;
+}
+
+void DynamicBondPerceiver::removeBond(Molecule& mol, Index bond)
+{
+  Index last = static_cast<Index>(m_bondCandidate.size() - 1);
+  Index removed = m_bondCandidate[bond];
+  if (removed != MaxIndex)
+    m_candidateBond[removed] = MaxIndex;
+
+  // Molecule::removeBond() fills the gap with the last bond. Should that ever
+  // change, the next update() notices the mismatch and synchronizes again.
+  mol.removeBond(bond);
+  if (bond != last) {
+    Index moved = m_bondCandidate[last];
+    m_bondCandidate[bond] = moved;
+    if (moved != MaxIndex)
+      m_candidateBond[moved] = bond;
+  }
+  m_bondCandidate.pop_back();
+}
+
+void DynamicBondPerceiver::addBonds(Molecule& mol,
+                                    const std::vector<Index>& candidates)
+{
+  if (candidates.empty())
+    return;
+
+  Array<std::pair<Index, Index>> pairs;
+  pairs.reserve(candidates.size());
+  for (Index c : candidates) {
+    pairs.push_back(
+      std::make_pair(m_candidates[c].first, m_candidates[c].second));
+    m_candidateBond[c] = mol.bondCount() + pairs.size() - 1;
+    m_bondCandidate.push_back(c);
+  }
+  mol.addBonds(pairs, 1);
+}
+
+} // namespace Core
+} // namespace Avogadro
@@ -0,0 +1,115 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_DYNAMICBONDPERCEIVER_H
+#define AVOGADRO_CORE_DYNAMICBONDPERCEIVER_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "vector.h"
+
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class Molecule;
+
+/**
+ * @class DynamicBondPerceiver dynamicbondperceiver.h
+ * <avogadro/core/dynamicbondperceiver.h>
+ * @brief Keeps the bonds of a moving molecule up to date, e.g. while playing
+ * back a trajectory.
+ *
+ * The result of update() is the same as calling Molecule::clearBonds()
+ * followed by Molecule::perceiveBondsSimple(), but the work is spread over
+ * the frames. A Verlet list stores every atom pair that was within its bond
+ * cutoff plus skin() of each other when the list was built, and each frame
+ * only those pairs are tested. The list stays valid until an atom has moved
+ * more than half the skin away from its position at that time, after which it
+ * is rebuilt with a NeighborPerceiver. Bonds are then only added or removed
+ * where the perception changed.
+ */
+class AVOGADROCORE_EXPORT DynamicBondPerceiver
+{
+public:
+  /**
+   * @param tolerance Added to the sum of the covalent radii.
+   * @param minDistance Atoms closer than this are not bonded.
+   */
+  explicit DynamicBondPerceiver(Real tolerance = 0.45,
+                                Real minDistance = 0.32);
+
+  Real tolerance() const { return m_tolerance; }
+  Real minDistance() const { return m_minDistance; }
+
+  /**
+   * Extra distance included in the pair list. Larger values mean fewer
+   * rebuilds but more pairs to test per frame. Default 1 A.
+   */
+  void setSkin(Real skin);
+  Real skin() const { return m_skin; }
+
+  /** Forget all state, the next update() starts from scratch. */
+  void reset();
+
+  /**
+   * Perceive the bonds of @a mol for its current atom positions. Bonds that
+   * were not perceived are removed, and all bonds get an order of one.
+   * @return True if any bond was added, removed or changed.
+   */
+  bool update(Molecule& mol);
+
+  /**
+   * Take the current bonds of @a mol as the ones perceived for its current
+   * atom positions, e.g. when another perceiver computed them. The next
+   * update() then continues from there instead of matching all bonds up
+   * again. Nothing is changed in @a mol.
+   */
+  void adoptBonds(const Molecule& mol);
+
+  /** @return The number of times the pair list was built. */
+  Index rebuildCount() const { return m_rebuildCount; }
+
+private:
+  struct Candidate
+  {
+    Index first;
+    Index second;
+    Real cutoffSquared;
+  };
+
+  bool listIsValid(const Molecule& mol) const;
+  void rebuild(const Molecule& mol);
+  void perceive(const Array<Vector3>& positions, std::vector<Index>& flipped);
+  bool synchronize(Molecule& mol);
+  void removeBond(Molecule& mol, Index bond);
+  void addBonds(Molecule& mol, const std::vector<Index>& candidates);
+
+  Real m_tolerance;
+  Real m_minDistance;
+  Real m_skin;
+
+  Array<unsigned char> m_atomicNumbers;
+  Array<Vector3> m_reference;
+  std::vector<Candidate> m_candidates;
+  std::vector<unsigned char> m_bonded;
+
+  // Which molecule bond belongs to which candidate pair and back, valid while
+  // the molecule's bonds are exactly the ones written by the last update().
+  std::vector<Index> m_candidateBond;
+  std::vector<Index> m_bondCandidate;
+  Array<std::pair<Index, Index>> m_bondPairs;
+  Array<unsigned char> m_bondOrders;
+  bool m_synchronized;
+
+  Index m_rebuildCount;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_DYNAMICBONDPERCEIVER_H
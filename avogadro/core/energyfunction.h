@@ -0,0 +1,97 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_ENERGYFUNCTION_H
+#define AVOGADRO_CORE_ENERGYFUNCTION_H
+
+#include "avogadrocore.h"
+
+#include <Eigen/Dense>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @class EnergyFunction energyfunction.h <avogadro/core/energyfunction.h>
+ * @brief Interface for potential energy functions of atomic coordinates.
+ *
+ * Coordinates are passed as a flat vector of length 3N (x0, y0, z0, x1, ...)
+ * in Angstrom. Implementations must provide value(), and should override
+ * gradient() and valueAndGradient() with analytic versions; the default
+ * gradient() falls back to central finite differences.
+ *
+ * A mask can be set to freeze coordinates: cleanGradients() zeroes all
+ * gradient components whose mask entry is zero, so optimizers never move
+ * frozen atoms.
+ */
+class AVOGADROCORE_EXPORT EnergyFunction
+{
+public:
+  EnergyFunction() {}
+  virtual ~EnergyFunction() {}
+
+  /** @return The energy for the coordinates @a x. */
+  virtual Real value(const Eigen::VectorXd& x) = 0;
+
+  /**
+   * Calculate the gradient of the energy for the coordinates @a x.
+   * @param x The coordinates.
+   * @param grad The gradient, resized to the size of @a x.
+   */
+  virtual void gradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad);
+
+  /**
+   * Calculate both the energy and its gradient, which is usually cheaper than
+   * calling value() and gradient() separately.
+   */
+  virtual Real valueAndGradient(const Eigen::VectorXd& x,
+                                Eigen::VectorXd& grad)
+  {
+    gradient(x, grad);
+    return value(x);
+  }
+
+  /**
+   * Set the mask of active coordinates, which must have the same size as the
+   * coordinate vectors. Entries of 0.0 freeze a coordinate, 1.0 frees it. An
+   * empty mask (the default) leaves all coordinates free.
+   */
+  void setMask(const Eigen::VectorXd& mask) { m_mask = mask; }
+
+  /** @return The mask of active coordinates. */
+  const Eigen::VectorXd& mask() const { return m_mask; }
+
+  /** Zero the gradient of any frozen coordinates. */
+  void cleanGradients(Eigen::VectorXd& grad) const
+  {
+    if (m_mask.size() == grad.size())
+      grad = grad.cwiseProduct(m_mask);
+  }
+
+protected:
+  Eigen::VectorXd m_mask;
+};
+
+inline void EnergyFunction::gradient(const Eigen::VectorXd& x,
+                                     Eigen::VectorXd& grad)
+{
+  const Real step = 1.0e-5;
+  Eigen::VectorXd displaced(x);
+  grad.resize(x.size());
+  for (Eigen::Index i = 0; i < x.size(); ++i) {
+    displaced[i] = x[i] + step;
+    Real plus = value(displaced);
+    displaced[i] = x[i] - step;
+    Real minus = value(displaced);
+    displaced[i] = x[i];
+    grad[i] = (plus - minus) / (2.0 * step);
+  }
+  cleanGradients(grad);
+}
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_ENERGYFUNCTION_H
@@ -0,0 +1,225 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "geometrytools.h"
+
+#include "unitcell.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Avogadro {
+namespace Core {
+
+typedef GeometryTools::Positions Positions;
+typedef GeometryTools::Values Values;
+
+namespace {
+// Rows of a distance matrix handled together. 256 rows of three coordinates
+// and the scratch arrays fit comfortably in the L1 cache.
+const Eigen::Index BlockSize = 256;
+
+// The rows of a row-major 3xN matrix are contiguous arrays.
+Eigen::Map<const Values> coordinates(const Positions& p, int row)
+{
+  return Eigen::Map<const Values>(p.data() + row * p.cols(), p.cols());
+}
+
+// Replace the cartesian displacements by their shortest periodic images.
+void minimumImage(Values& dx, Values& dy, Values& dz, const UnitCell& cell)
+{
+  const Matrix3& f = cell.fractionalMatrix();
+  const Matrix3& m = cell.cellMatrix();
+  Values fx = f(0, 0) * dx + f(0, 1) * dy + f(0, 2) * dz;
+  Values fy = f(1, 0) * dx + f(1, 1) * dy + f(1, 2) * dz;
+  Values fz = f(2, 0) * dx + f(2, 1) * dy + f(2, 2) * dz;
+  fx -= fx.round();
+  fy -= fy.round();
+  fz -= fz.round();
+  dx = m(0, 0) * fx + m(0, 1) * fy + m(0, 2) * fz;
+  dy = m(1, 0) * fx + m(1, 1) * fy + m(1, 2) * fz;
+  dz = m(2, 0) * fx + m(2, 1) * fy + m(2, 2) * fz;
+}
+
+void pairDisplacements(const Positions& p,
+                       const Array<std::pair<Index, Index>>& pairs,
+                       Values& dx, Values& dy, Values& dz)
+{
+  const Index n = pairs.size();
+  dx.resize(n);
+  dy.resize(n);
+  dz.resize(n);
+  for (Index k = 0; k < n; ++k) {
+    const Index i = pairs[k].first;
+    const Index j = pairs[k].second;
+    dx[k] = p(0, j) - p(0, i);
+    dy[k] = p(1, j) - p(1, i);
+    dz[k] = p(2, j) - p(2, i);
+  }
+}
+} // namespace
+
+Positions GeometryTools::toStructureOfArrays(const Array<Vector3>& positions)
+{
+  Positions result(3, positions.size());
+  for (Index i = 0; i < positions.size(); ++i)
+    result.col(i) = positions[i];
+  return result;
+}
+
+Values GeometryTools::distances(const Positions& positions,
+                                const Vector3& point)
+{
+  return ((coordinates(positions, 0) - point.x()).square() +
+          (coordinates(positions, 1) - point.y()).square() +
+          (coordinates(positions, 2) - point.z()).square())
+    .sqrt();
+}
+
+Values GeometryTools::distances(const Positions& positions,
+                                const Vector3& point, const UnitCell& cell)
+{
+  Values dx = coordinates(positions, 0) - point.x();
+  Values dy = coordinates(positions, 1) - point.y();
+  Values dz = coordinates(positions, 2) - point.z();
+  minimumImage(dx, dy, dz, cell);
+  return (dx.square() + dy.square() + dz.square()).sqrt();
+}
+
+Values GeometryTools::distances(const Positions& positions,
+                                const Array<std::pair<Index, Index>>& pairs)
+{
+  Values dx, dy, dz;
+  pairDisplacements(positions, pairs, dx, dy, dz);
+  return (dx.square() + dy.square() + dz.square()).sqrt();
+}
+
+Values GeometryTools::distances(const Positions& positions,
+                                const Array<std::pair<Index, Index>>& pairs,
+                                const UnitCell& cell)
+{
+  Values dx, dy, dz;
+  pairDisplacements(positions, pairs, dx, dy, dz);
+  minimumImage(dx, dy, dz, cell);
+  return (dx.square() + dy.square() + dz.square()).sqrt();
+}
+
+GeometryTools::DistanceMatrix GeometryTools::distanceMatrix(const Positions& a,
+                                                            const Positions& b)
+{
+  DistanceMatrix result(a.cols(), b.cols());
+  for (Eigen::Index start = 0; start < a.cols(); start += BlockSize) {
+    const Eigen::Index size = std::min(BlockSize, a.cols() - start);
+    auto ax = coordinates(a, 0).segment(start, size);
+    auto ay = coordinates(a, 1).segment(start, size);
+    auto az = coordinates(a, 2).segment(start, size);
+    for (Eigen::Index j = 0; j < b.cols(); ++j) {
+      result.col(j).segment(start, size) =
+        ((ax - b(0, j)).square() + (ay - b(1, j)).square() +
+         (az - b(2, j)).square())
+          .sqrt()
+          .matrix();
+    }
+  }
+  return result;
+}
+
+GeometryTools::DistanceMatrix GeometryTools::distanceMatrix(
+  const Positions& a, const Positions& b, const UnitCell& cell)
+{
+  // Work in fractional coordinates, so each displacement only needs to be
+  // rounded before it is converted back.
+  const Matrix3& m = cell.cellMatrix();
+  Positions fa = cell.fractionalMatrix() * a;
+  Positions fb = cell.fractionalMatrix() * b;
+
+  DistanceMatrix result(a.cols(), b.cols());
+  Values fx, fy, fz, dx, dy, dz;
+  for (Eigen::Index start = 0; start < a.cols(); start += BlockSize) {
+    const Eigen::Index size = std::min(BlockSize, a.cols() - start);
+    auto ax = coordinates(fa, 0).segment(start, size);
+    auto ay = coordinates(fa, 1).segment(start, size);
+    auto az = coordinates(fa, 2).segment(start, size);
+    for (Eigen::Index j = 0; j < b.cols(); ++j) {
+      fx = ax - fb(0, j);
+      fy = ay - fb(1, j);
+      fz = az - fb(2, j);
+      fx -= fx.round();
+      fy -= fy.round();
+      fz -= fz.round();
+      dx = m(0, 0) * fx + m(0, 1) * fy + m(0, 2) * fz;
+      dy = m(1, 0) * fx + m(1, 1) * fy + m(1, 2) * fz;
+      dz = m(2, 0) * fx + m(2, 1) * fy + m(2, 2) * fz;
+      result.col(j).segment(start, size) =
+        (dx.square() + dy.square() + dz.square()).sqrt().matrix();
+    }
+  }
+  return result;
+}
+
+Values GeometryTools::angles(const Positions& p,
+                             const Array<std::array<Index, 3>>& triples)
+{
+  const Index n = triples.size();
+  Values ax(n), ay(n), az(n), bx(n), by(n), bz(n);
+  for (Index k = 0; k < n; ++k) {
+    const std::array<Index, 3>& t = triples[k];
+    ax[k] = p(0, t[0]) - p(0, t[1]);
+    ay[k] = p(1, t[0]) - p(1, t[1]);
+    az[k] = p(2, t[0]) - p(2, t[1]);
+    bx[k] = p(0, t[2]) - p(0, t[1]);
+    by[k] = p(1, t[2]) - p(1, t[1]);
+    bz[k] = p(2, t[2]) - p(2, t[1]);
+  }
+
+  // atan2 of the cross and dot products is accurate for all angles.
+  Values cross = ((ay * bz - az * by).square() + (az * bx - ax * bz).square() +
+                  (ax * by - ay * bx).square())
+                   .sqrt();
+  Values dot = ax * bx + ay * by + az * bz;
+  Values result(n);
+  for (Index k = 0; k < n; ++k)
+    result[k] = std::atan2(cross[k], dot[k]) * RAD_TO_DEG;
+  return result;
+}
+
+Values GeometryTools::dihedrals(const Positions& p,
+                                const Array<std::array<Index, 4>>& quadruples)
+{
+  const Index n = quadruples.size();
+  Values b1x(n), b1y(n), b1z(n), b2x(n), b2y(n), b2z(n), b3x(n), b3y(n),
+    b3z(n);
+  for (Index k = 0; k < n; ++k) {
+    const std::array<Index, 4>& q = quadruples[k];
+    b1x[k] = p(0, q[1]) - p(0, q[0]);
+    b1y[k] = p(1, q[1]) - p(1, q[0]);
+    b1z[k] = p(2, q[1]) - p(2, q[0]);
+    b2x[k] = p(0, q[2]) - p(0, q[1]);
+    b2y[k] = p(1, q[2]) - p(1, q[1]);
+    b2z[k] = p(2, q[2]) - p(2, q[1]);
+    b3x[k] = p(0, q[3]) - p(0, q[2]);
+    b3y[k] = p(1, q[3]) - p(1, q[2]);
+    b3z[k] = p(2, q[3]) - p(2, q[2]);
+  }
+
+  // n1 = b1 x b2, n2 = b2 x b3, and the angle between them is
+  // atan2(|b2| b1 . n2, n1 . n2).
+  Values n1x = b1y * b2z - b1z * b2y;
+  Values n1y = b1z * b2x - b1x * b2z;
+  Values n1z = b1x * b2y - b1y * b2x;
+  Values n2x = b2y * b3z - b2z * b3y;
+  Values n2y = b2z * b3x - b2x * b3z;
+  Values n2z = b2x * b3y - b2y * b3x;
+  Values b2Norm = (b2x.square() + b2y.square() + b2z.square()).sqrt();
+  Values y = b2Norm * (b1x * n2x + b1y * n2y + b1z * n2z);
+  Values x = n1x * n2x + n1y * n2y + n1z * n2z;
+  Values result(n);
+  for (Index k = 0; k < n; ++k)
+    result[k] = std::atan2(y[k], x[k]) * RAD_TO_DEG;
+  return result;
+}
+
+} // namespace Core
+} // namespace Avogadro
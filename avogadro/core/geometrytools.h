@@ -0,0 +1,102 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_GEOMETRYTOOLS_H
+#define AVOGADRO_CORE_GEOMETRYTOOLS_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "vector.h"
+
+#include <Eigen/Core>
+
+#include <array>
+#include <utility>
+
+namespace Avogadro {
+namespace Core {
+class UnitCell;
+
+/**
+ * @class GeometryTools geometrytools.h <avogadro/core/geometrytools.h>
+ * @brief Batched distance, angle and dihedral calculations.
+ *
+ * The functions work on coordinates stored as a structure of arrays, with all
+ * x coordinates followed by all y and all z coordinates. The inner loops then
+ * run over contiguous values and are vectorized by Eigen, instead of handling
+ * one Vector3 at a time. Convert an Array<Vector3> once with
+ * toStructureOfArrays() and reuse the result for several queries.
+ *
+ * Periodic variants take a UnitCell and use the minimum image convention in
+ * the same way as UnitCell::distance().
+ */
+class AVOGADROCORE_EXPORT GeometryTools
+{
+public:
+  /** Coordinates as a structure of arrays: rows hold the x, y and z values. */
+  typedef Eigen::Matrix<Real, 3, Eigen::Dynamic, Eigen::RowMajor> Positions;
+
+  /** The result of a batched calculation, one value per item. */
+  typedef Eigen::Array<Real, Eigen::Dynamic, 1> Values;
+
+  /** A matrix of distances. */
+  typedef Eigen::Matrix<Real, Eigen::Dynamic, Eigen::Dynamic> DistanceMatrix;
+
+  /** Convert an array of positions to a structure of arrays. */
+  static Positions toStructureOfArrays(const Array<Vector3>& positions);
+
+  /** @return The distances from @a point to each of @a positions. */
+  static Values distances(const Positions& positions, const Vector3& point);
+
+  /**
+   * @return The shortest periodic distances from @a point to each of
+   * @a positions.
+   */
+  static Values distances(const Positions& positions, const Vector3& point,
+                          const UnitCell& cell);
+
+  /** @return The distance between the two positions of each pair. */
+  static Values distances(const Positions& positions,
+                          const Array<std::pair<Index, Index>>& pairs);
+
+  /**
+   * @return The shortest periodic distance between the two positions of each
+   * pair.
+   */
+  static Values distances(const Positions& positions,
+                          const Array<std::pair<Index, Index>>& pairs,
+                          const UnitCell& cell);
+
+  /**
+   * @return The matrix of distances between each of @a a (rows) and each of
+   * @a b (columns). The matrix is computed in blocks of rows that stay in
+   * cache while all columns are visited.
+   */
+  static DistanceMatrix distanceMatrix(const Positions& a, const Positions& b);
+
+  /** @return The matrix of shortest periodic distances. @overload */
+  static DistanceMatrix distanceMatrix(const Positions& a, const Positions& b,
+                                       const UnitCell& cell);
+
+  /**
+   * @return The angle in degrees at the middle position of each triple, in
+   * the range [0, 180].
+   */
+  static Values angles(const Positions& positions,
+                       const Array<std::array<Index, 3>>& triples);
+
+  /**
+   * @return The dihedral angle in degrees about the bond between the middle
+   * two positions of each quadruple, in the range [-180, 180].
+   */
+  static Values dihedrals(const Positions& positions,
+                          const Array<std::array<Index, 4>>& quadruples);
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_GEOMETRYTOOLS_H
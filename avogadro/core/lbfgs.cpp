@@ -0,0 +1,134 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "lbfgs.h"
+
+#include "energyfunction.h"
+
+#include <cmath>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+LBFGS::LBFGS()
+  : m_function(nullptr), m_energy(0.0), m_iteration(0), m_converged(false),
+    m_historySize(8), m_maxIterations(500), m_gradientTolerance(1.0e-3),
+    m_maxStep(0.3)
+{
+}
+
+bool LBFGS::minimize(EnergyFunction& func, Eigen::VectorXd& x)
+{
+  initialize(func, x);
+  while (m_iteration < m_maxIterations && step()) {
+    if (m_progress && !m_progress(m_iteration, m_x, m_energy))
+      break;
+  }
+  x = m_x;
+  return m_converged;
+}
+
+void LBFGS::initialize(EnergyFunction& func, const Eigen::VectorXd& x)
+{
+  m_function = &func;
+  m_x = x;
+  m_energy = m_function->valueAndGradient(m_x, m_gradient);
+  m_iteration = 0;
+  m_s.clear();
+  m_y.clear();
+  m_converged = m_gradient.size() == 0 ||
+                m_gradient.cwiseAbs().maxCoeff() < m_gradientTolerance;
+}
+
+Eigen::VectorXd LBFGS::searchDirection() const
+{
+  // Standard two-loop recursion.
+  Eigen::VectorXd q = -m_gradient;
+  size_t count = m_s.size();
+  std::vector<Real> alpha(count);
+  for (size_t k = count; k-- > 0;) {
+    Real rho = 1.0 / m_y[k].dot(m_s[k]);
+    alpha[k] = rho * m_s[k].dot(q);
+    q -= alpha[k] * m_y[k];
+  }
+  if (count > 0) {
+    Real gamma = m_s.back().dot(m_y.back()) / m_y.back().squaredNorm();
+    q *= gamma;
+  }
+  for (size_t k = 0; k < count; ++k) {
+    Real rho = 1.0 / m_y[k].dot(m_s[k]);
+    Real beta = rho * m_y[k].dot(q);
+    q += (alpha[k] - beta) * m_s[k];
+  }
+  return q;
+}
+
+bool LBFGS::step()
+{
+  if (!m_function || m_converged)
+    return false;
+
+  Eigen::VectorXd direction = searchDirection();
+  m_function->cleanGradients(direction);
+  Real slope = direction.dot(m_gradient);
+  if (slope >= 0.0) {
+    // The curvature history no longer describes the surface, restart from
+    // steepest descent.
+    m_s.clear();
+    m_y.clear();
+    direction = -m_gradient;
+    slope = direction.dot(m_gradient);
+  }
+
+  Real largest = direction.cwiseAbs().maxCoeff();
+  if (largest == 0.0) {
+    m_converged = true;
+    return false;
+  }
+  Real alpha = 1.0;
+  if (largest > m_maxStep)
+    alpha = m_maxStep / largest;
+
+  // Backtracking line search on the Armijo condition.
+  const Real c1 = 1.0e-4;
+  Eigen::VectorXd trial;
+  Eigen::VectorXd trialGradient;
+  Real trialEnergy = 0.0;
+  bool accepted = false;
+  for (int attempt = 0; attempt < 20; ++attempt) {
+    trial = m_x + alpha * direction;
+    trialEnergy = m_function->valueAndGradient(trial, trialGradient);
+    if (trialEnergy <= m_energy + c1 * alpha * slope) {
+      accepted = true;
+      break;
+    }
+    alpha *= 0.5;
+  }
+  if (!accepted)
+    return false;
+
+  Eigen::VectorXd s = trial - m_x;
+  Eigen::VectorXd y = trialGradient - m_gradient;
+  if (s.dot(y) > 1.0e-10) {
+    m_s.push_back(s);
+    m_y.push_back(y);
+    if (static_cast<int>(m_s.size()) > m_historySize) {
+      m_s.pop_front();
+      m_y.pop_front();
+    }
+  }
+
+  m_x = trial;
+  m_gradient = trialGradient;
+  m_energy = trialEnergy;
+  ++m_iteration;
+
+  m_converged = m_gradient.cwiseAbs().maxCoeff() < m_gradientTolerance;
+  return !m_converged;
+}
+
+} // namespace Core
+} // namespace Avogadro
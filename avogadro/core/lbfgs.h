@@ -0,0 +1,116 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_LBFGS_H
+#define AVOGADRO_CORE_LBFGS_H
+
+#include "avogadrocore.h"
+
+#include <Eigen/Dense>
+
+#include <deque>
+#include <functional>
+
+namespace Avogadro {
+namespace Core {
+
+class EnergyFunction;
+
+/**
+ * @class LBFGS lbfgs.h <avogadro/core/lbfgs.h>
+ * @brief Limited-memory BFGS minimizer for an EnergyFunction.
+ *
+ * The minimizer can either be run to convergence with minimize(), or driven
+ * one iteration at a time with initialize() and step(), which is how
+ * interactive callers publish intermediate coordinates. A backtracking line
+ * search enforcing the Armijo condition is used, and the stored curvature
+ * pairs are discarded whenever the search direction stops descending.
+ */
+class AVOGADROCORE_EXPORT LBFGS
+{
+public:
+  /**
+   * Called after every accepted iteration with the iteration number, the
+   * current coordinates and energy. Return false to stop the minimization.
+   */
+  typedef std::function<bool(int, const Eigen::VectorXd&, Real)>
+    ProgressFunction;
+
+  LBFGS();
+
+  /** Number of curvature pairs kept. Default 8. */
+  void setHistorySize(int size) { m_historySize = size; }
+  int historySize() const { return m_historySize; }
+
+  /** Maximum number of iterations for minimize(). Default 500. */
+  void setMaxIterations(int iterations) { m_maxIterations = iterations; }
+  int maxIterations() const { return m_maxIterations; }
+
+  /**
+   * Convergence is reached when the largest gradient component drops below
+   * this value. Default 1.0e-3.
+   */
+  void setGradientTolerance(Real tolerance) { m_gradientTolerance = tolerance; }
+  Real gradientTolerance() const { return m_gradientTolerance; }
+
+  /** Largest displacement of a single coordinate per step. Default 0.3 A. */
+  void setMaxStep(Real step) { m_maxStep = step; }
+  Real maxStep() const { return m_maxStep; }
+
+  /** Set a callback invoked after every iteration of minimize(). */
+  void setProgressFunction(const ProgressFunction& func) { m_progress = func; }
+
+  /**
+   * Minimize @a func starting from @a x, which is updated in place.
+   * @return True if the minimization converged.
+   */
+  bool minimize(EnergyFunction& func, Eigen::VectorXd& x);
+
+  /** Start a new minimization of @a func from @a x. */
+  void initialize(EnergyFunction& func, const Eigen::VectorXd& x);
+
+  /**
+   * Perform one iteration.
+   * @return True while further progress is possible, false once converged or
+   * if the line search failed.
+   */
+  bool step();
+
+  /** @return True if the last step() reached convergence. */
+  bool converged() const { return m_converged; }
+
+  /** @return The current coordinates. */
+  const Eigen::VectorXd& coordinates() const { return m_x; }
+
+  /** @return The energy at the current coordinates. */
+  Real energy() const { return m_energy; }
+
+  /** @return The number of iterations performed since initialize(). */
+  int iteration() const { return m_iteration; }
+
+private:
+  Eigen::VectorXd searchDirection() const;
+
+  EnergyFunction* m_function;
+  Eigen::VectorXd m_x;
+  Eigen::VectorXd m_gradient;
+  Real m_energy;
+  int m_iteration;
+  bool m_converged;
+
+  std::deque<Eigen::VectorXd> m_s;
+  std::deque<Eigen::VectorXd> m_y;
+
+  int m_historySize;
+  int m_maxIterations;
+  Real m_gradientTolerance;
+  Real m_maxStep;
+  ProgressFunction m_progress;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_LBFGS_H
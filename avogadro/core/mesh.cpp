@@ -19,12 +19,21 @@
 
 #include "mutex.h"
 
+#include <atomic>
+
 using std::vector;
 
 namespace Avogadro {
 namespace Core {
 
-Mesh::Mesh() : m_stable(true), m_other(0), m_cube(0), m_lock(new Mutex)
+namespace {
+// Meshes can be generated in several threads at once.
+std::atomic<Index> lastRevision(0);
+}
+
+Mesh::Mesh()
+  : m_stable(true), m_other(0), m_cube(0), m_lock(new Mutex),
+    m_revision(++lastRevision)
 {
   m_vertices.reserve(100);
   m_normals.reserve(100);
@@ -35,7 +44,7 @@ Mesh::Mesh(const Mesh& other)
   : m_vertices(other.m_vertices), m_normals(other.m_normals),
     m_colors(other.m_colors), m_name(other.m_name), m_stable(true),
     m_isoValue(other.m_isoValue), m_other(other.m_other), m_cube(other.m_cube),
-    m_lock(new Mutex)
+    m_lock(new Mutex), m_revision(other.m_revision)
 {
 }
 
@@ -78,6 +87,7 @@ bool Mesh::setVertices(const Core::Array<Vector3f>& values)
 {
   m_vertices.clear();
   m_vertices = values;
+  modified();
   return true;
 }
 
@@ -88,6 +98,7 @@ bool Mesh::addVertices(const Core::Array<Vector3f>& values)
   if (values.size() % 3 == 0) {
     for (unsigned int i = 0; i < values.size(); ++i)
       m_vertices.push_back(values.at(i));
+    modified();
     return true;
   } else {
     return false;
@@ -108,6 +119,7 @@ bool Mesh::setNormals(const Core::Array<Vector3f>& values)
 {
   m_normals.clear();
   m_normals = values;
+  modified();
   return true;
 }
 
@@ -118,6 +130,7 @@ bool Mesh::addNormals(const Core::Array<Vector3f>& values)
   if (values.size() % 3 == 0) {
     for (unsigned int i = 0; i < values.size(); ++i)
       m_normals.push_back(values.at(i));
+    modified();
     return true;
   } else {
     return false;
@@ -142,6 +155,7 @@ bool Mesh::setColors(const Core::Array<Color3f>& values)
 {
   m_colors.clear();
   m_colors = values;
+  modified();
   return true;
 }
 
@@ -152,6 +166,7 @@ bool Mesh::addColors(const Core::Array<Color3f>& values)
   if (values.size() % 3 == 0) {
     for (unsigned int i = 0; i < values.size(); ++i)
       m_colors.push_back(values.at(i));
+    modified();
     return true;
   } else {
     return false;
@@ -175,19 +190,28 @@ bool Mesh::clear()
   m_vertices.clear();
   m_normals.clear();
   m_colors.clear();
+  modified();
   return true;
 }
 
 Mesh& Mesh::operator=(const Mesh& other)
 {
   m_vertices = other.m_vertices;
-  m_normals = other.m_vertices;
+  m_normals = other.m_normals;
   m_colors = other.m_colors;
   m_name = other.m_name;
   m_isoValue = other.m_isoValue;
+  m_other = other.m_other;
+  m_cube = other.m_cube;
+  m_revision = other.m_revision;
 
   return *this;
 }
 
+void Mesh::modified()
+{
+  m_revision = ++lastRevision;
+}
+
 } // End namespace QtGui
 } // End namespace Avogadro
@@ -226,6 +226,14 @@ public:
    */
   Mutex* lock() const { return m_lock; }
 
+  /**
+   * A number that changes whenever the vertices, normals or colors of the mesh
+   * change, and is never shared by meshes with different contents. Copies keep
+   * the revision of the original until they are modified, so it can be used to
+   * cache data derived from the mesh.
+   */
+  Index revision() const { return m_revision; }
+
   friend class Molecule;
 
 private:
@@ -238,6 +246,10 @@ private:
   unsigned int m_other; // Unique id of the other mesh if this is part of a pair
   unsigned int m_cube;  // Unique id of the cube this mesh was generated from
   Mutex* m_lock;
+  Index m_revision;
+
+  /** Give the mesh a new revision, as its contents changed. */
+  void modified();
 };
 
 } // End namespace Core
@@ -30,6 +30,18 @@
 namespace Avogadro {
 namespace Core {
 
+namespace {
+// Give the holder its own copy of a mesh or cube shared with other
+// molecules before it is modified.
+template <typename T>
+T* detach(std::shared_ptr<T>& object)
+{
+  if (object.use_count() > 1)
+    object = std::make_shared<T>(*object);
+  return object.get();
+}
+} // namespace
+
 Molecule::Molecule()
   : m_graphDirty(false), m_basisSet(nullptr), m_unitCell(nullptr)
 {}
@@ -43,24 +55,15 @@ Molecule::Molecule(const Molecule& other)
     m_formalCharges(other.m_formalCharges),
     m_vibrationFrequencies(other.m_vibrationFrequencies),
     m_vibrationIntensities(other.m_vibrationIntensities),
-    m_vibrationLx(other.m_vibrationLx), m_bondPairs(other.m_bondPairs),
+    m_vibrationLx(other.m_vibrationLx),
+    m_vibrationDisplacements(other.m_vibrationDisplacements),
+    m_bondPairs(other.m_bondPairs),
     m_bondOrders(other.m_bondOrders), m_selectedAtoms(other.m_selectedAtoms),
-    m_meshes(std::vector<Mesh*>()), m_cubes(std::vector<Cube*>()),
+    m_meshes(other.m_meshes), m_cubes(other.m_cubes),
     m_basisSet(other.m_basisSet ? other.m_basisSet->clone() : nullptr),
     m_unitCell(other.m_unitCell ? new UnitCell(*other.m_unitCell) : nullptr),
     m_residues(other.m_residues)
 {
-  // Copy over any meshes
-  for (Index i = 0; i < other.meshCount(); ++i) {
-    Mesh* m = addMesh();
-    *m = *other.mesh(i);
-  }
-
-  // Copy over any cubes
-  for (Index i = 0; i < other.cubeCount(); ++i) {
-    Cube* c = addCube();
-    *c = *other.cube(i);
-  }
 }
 
 Molecule::Molecule(Molecule&& other) noexcept
@@ -78,6 +81,7 @@ Molecule::Molecule(Molecule&& other) noexcept
     m_vibrationFrequencies(std::move(other.m_vibrationFrequencies)),
     m_vibrationIntensities(std::move(other.m_vibrationIntensities)),
     m_vibrationLx(std::move(other.m_vibrationLx)),
+    m_vibrationDisplacements(std::move(other.m_vibrationDisplacements)),
     m_bondPairs(std::move(other.m_bondPairs)),
     m_bondOrders(std::move(other.m_bondOrders)),
     m_selectedAtoms(std::move(other.m_selectedAtoms)),
@@ -108,26 +112,15 @@ Molecule& Molecule::operator=(const Molecule& other)
     m_vibrationFrequencies = other.m_vibrationFrequencies;
     m_vibrationIntensities = other.m_vibrationIntensities;
     m_vibrationLx = other.m_vibrationLx;
+    m_vibrationDisplacements = other.m_vibrationDisplacements;
     m_bondPairs = other.m_bondPairs;
     m_bondOrders = other.m_bondOrders;
     m_selectedAtoms = other.m_selectedAtoms;
     m_residues = other.m_residues;
 
-    clearMeshes();
-
-    // Copy over any meshes
-    for (Index i = 0; i < other.meshCount(); ++i) {
-      Mesh* m = addMesh();
-      *m = *other.mesh(i);
-    }
-
-    clearCubes();
-
-    // Copy over any cubes
-    for (Index i = 0; i < other.cubeCount(); ++i) {
-      Cube* c = addCube();
-      *c = *other.cube(i);
-    }
+    // Meshes and cubes are shared until either molecule modifies them.
+    m_meshes = other.m_meshes;
+    m_cubes = other.m_cubes;
 
     delete m_basisSet;
     m_basisSet = other.m_basisSet ? other.m_basisSet->clone() : nullptr;
@@ -155,15 +148,13 @@ Molecule& Molecule::operator=(Molecule&& other) noexcept
     m_vibrationFrequencies = std::move(other.m_vibrationFrequencies);
     m_vibrationIntensities = std::move(other.m_vibrationIntensities);
     m_vibrationLx = std::move(other.m_vibrationLx);
+    m_vibrationDisplacements = std::move(other.m_vibrationDisplacements);
     m_bondPairs = std::move(other.m_bondPairs);
     m_bondOrders = std::move(other.m_bondOrders);
     m_selectedAtoms = std::move(other.m_selectedAtoms);
     m_residues = std::move(other.m_residues);
 
-    clearMeshes();
     m_meshes = std::move(other.m_meshes);
-
-    clearCubes();
     m_cubes = std::move(other.m_cubes);
 
     delete m_basisSet;
@@ -182,8 +173,6 @@ Molecule::~Molecule()
 {
   delete m_basisSet;
   delete m_unitCell;
-  clearMeshes();
-  clearCubes();
 }
 
 void Molecule::setData(const std::string& name, const Variant& value)
@@ -464,6 +453,23 @@ Molecule::BondType Molecule::addBond(const AtomType& a, const AtomType& b,
   return addBond(a.index(), b.index(), order);
 }
 
+void Molecule::addBonds(const Array<std::pair<Index, Index>>& pairs,
+                        unsigned char order)
+{
+  if (pairs.empty())
+    return;
+
+  m_graphDirty = true;
+  m_bondPairs.reserve(m_bondPairs.size() + pairs.size());
+  m_bondOrders.reserve(m_bondOrders.size() + pairs.size());
+  for (Index i = 0; i < pairs.size(); ++i) {
+    assert(pairs[i].first < atomCount());
+    assert(pairs[i].second < atomCount());
+    m_bondPairs.push_back(makeBondPair(pairs[i].first, pairs[i].second));
+    m_bondOrders.push_back(order);
+  }
+}
+
 bool Molecule::removeBond(Index index)
 {
   if (index >= bondCount())
@@ -559,14 +565,14 @@ Index Molecule::bondCount() const
 
 Mesh* Molecule::addMesh()
 {
-  m_meshes.push_back(new Mesh);
-  return m_meshes.back();
+  m_meshes.push_back(std::make_shared<Mesh>());
+  return m_meshes.back().get();
 }
 
 Mesh* Molecule::mesh(Index index)
 {
   if (index < static_cast<Index>(m_meshes.size()))
-    return m_meshes[index];
+    return detach(m_meshes[index]);
   else
     return nullptr;
 }
@@ -574,29 +580,26 @@ Mesh* Molecule::mesh(Index index)
 const Mesh* Molecule::mesh(Index index) const
 {
   if (index < static_cast<Index>(m_meshes.size()))
-    return m_meshes[index];
+    return m_meshes[index].get();
   else
     return nullptr;
 }
 
 void Molecule::clearMeshes()
 {
-  while (!m_meshes.empty()) {
-    delete m_meshes.back();
-    m_meshes.pop_back();
-  }
+  m_meshes.clear();
 }
 
 Cube* Molecule::addCube()
 {
-  m_cubes.push_back(new Cube);
-  return m_cubes.back();
+  m_cubes.push_back(std::make_shared<Cube>());
+  return m_cubes.back().get();
 }
 
 Cube* Molecule::cube(Index index)
 {
   if (index < static_cast<Index>(m_cubes.size()))
-    return m_cubes[index];
+    return detach(m_cubes[index]);
   else
     return nullptr;
 }
@@ -604,17 +607,30 @@ Cube* Molecule::cube(Index index)
 const Cube* Molecule::cube(Index index) const
 {
   if (index < static_cast<Index>(m_cubes.size()))
-    return m_cubes[index];
+    return m_cubes[index].get();
   else
     return nullptr;
 }
 
 void Molecule::clearCubes()
 {
-  while (!m_cubes.empty()) {
-    delete m_cubes.back();
-    m_cubes.pop_back();
-  }
+  m_cubes.clear();
+}
+
+std::vector<Cube*> Molecule::cubes()
+{
+  std::vector<Cube*> result;
+  for (size_t i = 0; i < m_cubes.size(); ++i)
+    result.push_back(detach(m_cubes[i]));
+  return result;
+}
+
+const std::vector<Cube*> Molecule::cubes() const
+{
+  std::vector<Cube*> result;
+  for (size_t i = 0; i < m_cubes.size(); ++i)
+    result.push_back(m_cubes[i].get());
+  return result;
 }
 
 std::string Molecule::formula(const std::string& delimiter, int over) const
@@ -709,6 +725,11 @@ void Molecule::setVibrationLx(const Array<Array<Vector3>>& lx)
   m_vibrationLx = lx;
 }
 
+void Molecule::setVibrationDisplacements(const Array<Vector3>& displacements)
+{
+  m_vibrationDisplacements = displacements;
+}
+
 // bond perception code ported from VTK's vtkSimpleBondPerceiver class
 void Molecule::perceiveBondsSimple(const double tolerance, const double min)
 {
@@ -761,7 +782,7 @@ int Molecule::coordinate3dCount()
 bool Molecule::setCoordinate3d(int coord)
 {
   if (coord >= 0 && coord < static_cast<int>(m_coordinates3d.size())) {
-    m_positions3d = m_coordinates3d[coord];
+    m_coordinates3d.frame(coord, m_positions3d);
     return true;
   }
   return false;
@@ -769,17 +790,23 @@ bool Molecule::setCoordinate3d(int coord)
 
 Array<Vector3> Molecule::coordinate3d(int index) const
 {
-  return m_coordinates3d[index];
+  return m_coordinates3d.frame(index);
 }
 
 bool Molecule::setCoordinate3d(const Array<Vector3>& coords, int index)
 {
-  if (static_cast<int>(m_coordinates3d.size()) <= index)
-    m_coordinates3d.resize(index + 1);
-  m_coordinates3d[index] = coords;
+  if (index < 0)
+    return false;
+  m_coordinates3d.setFrame(index, coords);
   return true;
 }
 
+bool Molecule::setCoordinate3dCompression(
+  CoordinateFrames::Compression compression, Real precision)
+{
+  return m_coordinates3d.setCompression(compression, precision);
+}
+
 double Molecule::timeStep(int index, bool& status)
 {
   if (static_cast<int>(m_timesteps.size()) <= index) {
@@ -20,10 +20,13 @@
 #include "avogadrocore.h"
 
 #include <map>
+#include <memory>
 #include <string>
 
 #include "array.h"
+#include "atomselection.h"
 #include "bond.h"
+#include "coordinateframes.h"
 #include "graph.h"
 #include "variantmap.h"
 #include "vector.h"
@@ -253,6 +256,24 @@ public:
   /** Returns whether the selection is empty or not */
   bool isSelectionEmpty() const;
 
+  /**
+   * @return The selected atoms. The selection may cover fewer atoms than the
+   * molecule, the remaining atoms are not selected.
+   */
+  const AtomSelection& atomSelection() const { return m_selectedAtoms; }
+
+  /**
+   * Replace the selection with @a selection, which is resized to the number
+   * of atoms in the molecule.
+   */
+  void setAtomSelection(const AtomSelection& selection);
+
+  /**
+   * Select every unselected atom and deselect every selected one, including
+   * atoms added since the selection was last resized.
+   */
+  void invertAtomSelection();
+
   /** Returns a vector of pairs of atom indices of the bonds in the molecule. */
   Array<std::pair<Index, Index>>& bondPairs();
 
@@ -394,6 +415,15 @@ public:
                            unsigned char order = 1);
   /** @} */
 
+  /**
+   * Append a bond of order @a order for each atom pair in @a pairs. Unlike
+   * addBond() this does not look for an existing bond between the atoms, so
+   * large numbers of bonds can be added in linear time. The caller must make
+   * sure that none of the bonds exist yet.
+   */
+  virtual void addBonds(const Array<std::pair<Index, Index>>& pairs,
+                        unsigned char order = 1);
+
   /**
    * @brief Remove the specified bond.
    * @param index The index of the bond to be removed.
@@ -449,10 +479,20 @@ public:
 
   /**
    * @brief Add a mesh to the molecule.
-   * @return The mesh object added to the molecule.
+   * @return The mesh object added to the molecule. The pointer is only valid
+   * until the molecule is next copied or modified, keep the index instead.
    */
   Mesh* addMesh();
 
+  /**
+   * Meshes and cubes are shared between copies of a molecule until one of
+   * them is modified, as for the arrays of atom data. The non-const
+   * accessors give the molecule its own copy first if the object is shared.
+   * The pointers they return are only valid until the molecule is next copied
+   * or modified: a copy shares the object again, and the next non-const
+   * access may replace it. Fetch them by index for each operation rather
+   * than keeping them, and use the const accessors to read without copying.
+   */
   Mesh* mesh(Index index);
   const Mesh* mesh(Index index) const;
 
@@ -462,10 +502,15 @@ public:
 
   /**
    * @brief Add a cube to the molecule.
-   * @return The cube object added to the molecule.
+   * @return The cube object added to the molecule. The pointer is only valid
+   * until the molecule is next copied or modified, keep the index instead.
    */
   Cube* addCube();
 
+  /**
+   * @return The cube at @a index. As for mesh(), the pointer is only valid
+   * until the molecule is next copied or modified.
+   */
   Cube* cube(Index index);
   const Cube* cube(Index index) const;
 
@@ -475,10 +520,13 @@ public:
 
   /**
    * @brief Get the cubes vector set (if present) for the molecule.
-   * @return The cube vector for the molecule
+   * @return The cube vector for the molecule. The non-const version detaches
+   * every shared cube first, the cubes returned by the const version must
+   * not be modified. Either way the pointers are only valid until the
+   * molecule is next copied or modified.
    */
-  std::vector<Cube*> cubes() { return m_cubes; }
-  const std::vector<Cube*> cubes() const { return m_cubes; }
+  std::vector<Cube*> cubes();
+  const std::vector<Cube*> cubes() const;
 
   /**
    * Returns the chemical formula of the molecule.
@@ -523,6 +571,20 @@ public:
   Array<Vector3> vibrationLx(int mode) const;
   void setVibrationLx(const Array<Array<Vector3>>& lx);
 
+  /**
+   * Per-atom displacements of the vibration being animated, already scaled by
+   * the amplitude. Renderers offset each atom by its displacement times a
+   * factor in [-1, 1] that changes every frame, so the scene only needs to be
+   * built once per mode. Empty when no vibration is animated.
+   * @{
+   */
+  const Array<Vector3>& vibrationDisplacements() const
+  {
+    return m_vibrationDisplacements;
+  }
+  void setVibrationDisplacements(const Array<Vector3>& displacements);
+  /** @} */
+
   /**
    * Perceives bonds in the molecule based on the 3D coordinates of the atoms.
    *  atoms are considered bonded if within the sum of radii
@@ -542,6 +604,18 @@ public:
   Array<Vector3> coordinate3d(int index) const;
   bool setCoordinate3d(const Array<Vector3>& coords, int index);
 
+  /**
+   * Store the conformers or trajectory frames compressed, converting those
+   * already present. Set this before reading a large trajectory to keep the
+   * peak memory low. See CoordinateFrames for the available modes.
+   * @return False if @a precision is not positive.
+   */
+  bool setCoordinate3dCompression(CoordinateFrames::Compression compression,
+                                  Real precision = 0.001);
+
+  /** @return The storage of the conformers or trajectory frames. */
+  const CoordinateFrames& coordinateFrames() const { return m_coordinates3d; }
+
   /**
    * Timestep property is used when molecular dynamics trajectories are read
    */
@@ -551,6 +625,7 @@ public:
   Residue& addResidue(std::string& name, Index& number, char& id);
   void addResidue(Residue& residue);
   Residue& residue(int index);
+  const Array<Residue>& residues() const { return m_residues; }
 
 protected:
   mutable Graph m_graph;     // A transformation of the molecule to a graph.
@@ -560,7 +635,7 @@ protected:
   Array<unsigned char> m_atomicNumbers;
   Array<Vector2> m_positions2d;
   Array<Vector3> m_positions3d;
-  Array<Array<Vector3>> m_coordinates3d; // Used for conformers/trajectories.
+  CoordinateFrames m_coordinates3d; // Used for conformers/trajectories.
   Array<double> m_timesteps;
   Array<AtomHybridization> m_hybridizations;
   Array<signed char> m_formalCharges;
@@ -569,15 +644,16 @@ protected:
   Array<double> m_vibrationFrequencies;
   Array<double> m_vibrationIntensities;
   Array<Array<Vector3>> m_vibrationLx;
+  Array<Vector3> m_vibrationDisplacements;
 
   Array<std::pair<Index, Index>> m_bondPairs;
   Array<unsigned char> m_bondOrders;
 
-  // Array declaring whether atoms are selected or not.
-  std::vector<bool> m_selectedAtoms;
+  // Bitset declaring whether atoms are selected or not.
+  AtomSelection m_selectedAtoms;
 
-  std::vector<Mesh*> m_meshes;
-  std::vector<Cube*> m_cubes;
+  std::vector<std::shared_ptr<Mesh>> m_meshes;
+  std::vector<std::shared_ptr<Cube>> m_cubes;
 
   BasisSet* m_basisSet;
   UnitCell* m_unitCell;
@@ -734,23 +810,31 @@ inline void Molecule::setAtomSelected(Index atomId, bool selected)
 {
   if (atomId < atomCount()) {
     if (atomId >= m_selectedAtoms.size())
-      m_selectedAtoms.resize(atomCount(), false);
-    m_selectedAtoms[atomId] = selected;
+      m_selectedAtoms.resize(atomCount());
+    m_selectedAtoms.set(atomId, selected);
   }
 }
 
 inline bool Molecule::atomSelected(Index atomId) const
 {
-  return atomId < m_selectedAtoms.size() ? m_selectedAtoms[atomId] : false;
+  return m_selectedAtoms.test(atomId);
 }
 
 inline bool Molecule::isSelectionEmpty() const
 {
-  for (Index i = 0; i < m_selectedAtoms.size(); ++i) {
-    if (m_selectedAtoms[i])
-      return false;
-  }
-  return true;
+  return m_selectedAtoms.none();
+}
+
+inline void Molecule::setAtomSelection(const AtomSelection& selection)
+{
+  m_selectedAtoms = selection;
+  m_selectedAtoms.resize(atomCount());
+}
+
+inline void Molecule::invertAtomSelection()
+{
+  m_selectedAtoms.resize(atomCount());
+  m_selectedAtoms.invert();
 }
 
 inline std::pair<Index, Index> Molecule::bondPair(Index bondId) const
@@ -16,19 +16,22 @@
 
 #include "mutex.h"
 
+#include <condition_variable>
 #include <mutex>
 
 namespace Avogadro {
 namespace Core {
 
-using std::mutex;
-
 class Mutex::PIMPL
 {
 public:
-  PIMPL() {}
+  PIMPL() : readers(0), writer(false), waitingWriters(0) {}
 
-  mutex lock;
+  std::mutex lock;
+  std::condition_variable changed;
+  int readers;
+  bool writer;
+  int waitingWriters;
 };
 
 Mutex::Mutex() : d(new PIMPL)
@@ -42,17 +45,58 @@ Mutex::~Mutex()
 
 void Mutex::lock()
 {
-  d->lock.lock();
+  std::unique_lock<std::mutex> guard(d->lock);
+  ++d->waitingWriters;
+  while (d->writer || d->readers > 0)
+    d->changed.wait(guard);
+  --d->waitingWriters;
+  d->writer = true;
 }
 
 bool Mutex::tryLock()
 {
-  return d->lock.try_lock();
+  std::lock_guard<std::mutex> guard(d->lock);
+  if (d->writer || d->readers > 0)
+    return false;
+  d->writer = true;
+  return true;
 }
 
 void Mutex::unlock()
 {
-  d->lock.unlock();
+  {
+    std::lock_guard<std::mutex> guard(d->lock);
+    d->writer = false;
+  }
+  d->changed.notify_all();
+}
+
+void Mutex::lockShared()
+{
+  std::unique_lock<std::mutex> guard(d->lock);
+  while (d->writer || d->waitingWriters > 0)
+    d->changed.wait(guard);
+  ++d->readers;
+}
+
+bool Mutex::tryLockShared()
+{
+  std::lock_guard<std::mutex> guard(d->lock);
+  if (d->writer || d->waitingWriters > 0)
+    return false;
+  ++d->readers;
+  return true;
+}
+
+void Mutex::unlockShared()
+{
+  bool last = false;
+  {
+    std::lock_guard<std::mutex> guard(d->lock);
+    last = --d->readers == 0;
+  }
+  if (last)
+    d->changed.notify_all();
 }
 }
 }
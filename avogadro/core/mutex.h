@@ -32,6 +32,13 @@ namespace Core {
  *
  * A very simple, and thin wrapper around the C++11 (or Boost fallback) mutex
  * class, allowing for lock, tryLock and unlock.
+ *
+ * The mutex can also be locked in shared mode for reading. Any number of
+ * threads may hold a shared lock at the same time, while an exclusive lock
+ * excludes all other locks. Threads waiting for an exclusive lock take
+ * precedence over new shared locks, so a thread must not take a second
+ * shared lock on a mutex it already holds. Prefer the ReadLocker and
+ * WriteLocker guards to pairing the calls by hand.
  */
 
 class AVOGADROCORE_EXPORT Mutex
@@ -56,10 +63,61 @@ public:
    */
   void unlock();
 
+  /**
+   * @brief Obtain a shared lock, waiting while an exclusive lock is held or
+   * requested.
+   */
+  void lockShared();
+
+  /**
+   * @brief Attempt to obtain a shared lock.
+   * @return True on success, false on failure.
+   */
+  bool tryLockShared();
+
+  /**
+   * @brief Release a shared lock.
+   */
+  void unlockShared();
+
 private:
   class PIMPL;
   PIMPL* d;
 };
+
+/**
+ * @class ReadLocker mutex.h <avogadro/core/mutex.h>
+ * @brief Holds a shared lock on a Mutex for the lifetime of the locker.
+ */
+class ReadLocker
+{
+public:
+  explicit ReadLocker(Mutex* mutex) : m_mutex(mutex) { m_mutex->lockShared(); }
+  ~ReadLocker() { m_mutex->unlockShared(); }
+
+private:
+  ReadLocker(const ReadLocker&);
+  ReadLocker& operator=(const ReadLocker&);
+
+  Mutex* m_mutex;
+};
+
+/**
+ * @class WriteLocker mutex.h <avogadro/core/mutex.h>
+ * @brief Holds an exclusive lock on a Mutex for the lifetime of the locker.
+ */
+class WriteLocker
+{
+public:
+  explicit WriteLocker(Mutex* mutex) : m_mutex(mutex) { m_mutex->lock(); }
+  ~WriteLocker() { m_mutex->unlock(); }
+
+private:
+  WriteLocker(const WriteLocker&);
+  WriteLocker& operator=(const WriteLocker&);
+
+  Mutex* m_mutex;
+};
 }
 }
 
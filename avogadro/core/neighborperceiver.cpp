@@ -0,0 +1,150 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "neighborperceiver.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Avogadro {
+namespace Core {
+
+NeighborPerceiver::NeighborPerceiver(const Array<Vector3>& points,
+                                     Real maxDistance)
+  : m_maxDistance(maxDistance), m_binSize(maxDistance),
+    m_minPos(Vector3::Zero()), m_binCount(1, 1, 1), m_points(points)
+{
+  if (points.empty() || maxDistance <= 0.0) {
+    m_bins.resize(1);
+    for (Index i = 0; i < points.size(); ++i)
+      m_bins[0].push_back(i);
+    return;
+  }
+
+  m_minPos = points[0];
+  Vector3 maxPos = points[0];
+  for (Index i = 1; i < points.size(); ++i) {
+    m_minPos = m_minPos.cwiseMin(points[i]);
+    maxPos = maxPos.cwiseMax(points[i]);
+  }
+  Vector3 extent = maxPos - m_minPos;
+
+  // Sparse point clouds would otherwise allocate an enormous, mostly empty
+  // grid. Larger bins are still correct, they only return more candidates.
+  const double maxBins = 8.0 * static_cast<double>(points.size()) + 64.0;
+  for (;;) {
+    double total = 1.0;
+    for (int c = 0; c < 3; ++c)
+      total *= std::floor(extent[c] / m_binSize) + 1.0;
+    if (total <= maxBins)
+      break;
+    m_binSize *= 1.5;
+  }
+
+  for (int c = 0; c < 3; ++c)
+    m_binCount[c] = static_cast<int>(std::floor(extent[c] / m_binSize)) + 1;
+
+  m_bins.resize(static_cast<size_t>(m_binCount[0]) * m_binCount[1] *
+                m_binCount[2]);
+  for (Index i = 0; i < points.size(); ++i)
+    m_bins[binIndex(binOf(points[i]))].push_back(i);
+}
+
+Vector3i NeighborPerceiver::binOf(const Vector3& point) const
+{
+  Vector3i bin;
+  for (int c = 0; c < 3; ++c) {
+    bin[c] = static_cast<int>(std::floor((point[c] - m_minPos[c]) / m_binSize));
+    bin[c] = std::max(0, std::min(bin[c], m_binCount[c] - 1));
+  }
+  return bin;
+}
+
+Index NeighborPerceiver::binIndex(const Vector3i& bin) const
+{
+  return (static_cast<Index>(bin[2]) * m_binCount[1] + bin[1]) *
+           m_binCount[0] +
+         bin[0];
+}
+
+void NeighborPerceiver::getNeighborsInclusive(Array<Index>& out,
+                                              const Vector3& point) const
+{
+  out.clear();
+  if (m_bins.size() == 1) {
+    out.assign(m_bins[0].begin(), m_bins[0].end());
+    return;
+  }
+
+  // Points outside of the binned volume are clamped onto the border bins,
+  // which would be wrong if they were farther away than a bin width.
+  for (int c = 0; c < 3; ++c) {
+    Real lo = m_minPos[c] - m_binSize;
+    Real hi = m_minPos[c] + (m_binCount[c] + 1) * m_binSize;
+    if (point[c] < lo || point[c] > hi)
+      return;
+  }
+
+  Vector3i center = binOf(point);
+  Vector3i lo = (center.array() - 1).cwiseMax(0);
+  Vector3i hi = (center.array() + 1).cwiseMin(m_binCount.array() - 1);
+  for (int z = lo[2]; z <= hi[2]; ++z) {
+    for (int y = lo[1]; y <= hi[1]; ++y) {
+      for (int x = lo[0]; x <= hi[0]; ++x) {
+        const std::vector<Index>& bin = m_bins[binIndex(Vector3i(x, y, z))];
+        for (Index k = 0; k < bin.size(); ++k)
+          out.push_back(bin[k]);
+      }
+    }
+  }
+}
+
+void NeighborPerceiver::getPairs(
+  std::vector<std::pair<Index, Index>>& out) const
+{
+  out.clear();
+  const Real maxSq = m_maxDistance * m_maxDistance;
+
+  // Visit each bin and only the "forward" half of its neighbors so that every
+  // pair of bins is considered exactly once.
+  for (int z = 0; z < m_binCount[2]; ++z) {
+    for (int y = 0; y < m_binCount[1]; ++y) {
+      for (int x = 0; x < m_binCount[0]; ++x) {
+        const std::vector<Index>& bin = m_bins[binIndex(Vector3i(x, y, z))];
+        if (bin.empty())
+          continue;
+        for (int dz = -1; dz <= 1; ++dz) {
+          for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+              Vector3i other(x + dx, y + dy, z + dz);
+              if ((other.array() < 0).any() ||
+                  (other.array() >= m_binCount.array()).any()) {
+                continue;
+              }
+              Index otherIndex = binIndex(other);
+              Index thisIndex = binIndex(Vector3i(x, y, z));
+              if (otherIndex < thisIndex)
+                continue;
+              const std::vector<Index>& otherBin = m_bins[otherIndex];
+              for (Index a = 0; a < bin.size(); ++a) {
+                Index start = otherIndex == thisIndex ? a + 1 : 0;
+                for (Index b = start; b < otherBin.size(); ++b) {
+                  Index i = bin[a];
+                  Index j = otherBin[b];
+                  if ((m_points[i] - m_points[j]).squaredNorm() < maxSq)
+                    out.push_back(i < j ? std::make_pair(i, j)
+                                        : std::make_pair(j, i));
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace Core
+} // namespace Avogadro
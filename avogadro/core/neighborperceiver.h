@@ -0,0 +1,74 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_NEIGHBORPERCEIVER_H
+#define AVOGADRO_CORE_NEIGHBORPERCEIVER_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "vector.h"
+
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @class NeighborPerceiver neighborperceiver.h
+ * <avogadro/core/neighborperceiver.h>
+ * @brief This class can be used to find physically neighboring points in
+ * linear average time.
+ *
+ * The points are hashed into a uniform grid of cubic bins with an edge length
+ * of @a maxDistance. All points within @a maxDistance of a query point are
+ * then guaranteed to be in one of the 27 bins surrounding it, so only those
+ * bins need to be scanned. The returned candidates may be farther away than
+ * @a maxDistance; callers are expected to apply their own distance test.
+ */
+class AVOGADROCORE_EXPORT NeighborPerceiver
+{
+public:
+  /**
+   * Creates a NeighborPerceiver and bins @a points.
+   * @param points The points to bin.
+   * @param maxDistance The largest distance that will be queried.
+   */
+  NeighborPerceiver(const Array<Vector3>& points, Real maxDistance);
+
+  /**
+   * Finds the candidate neighbors of @a point, including the point itself if
+   * it was part of the binned set.
+   * @param out The indices of the candidate points, replacing any contents.
+   * @param point The query point.
+   */
+  void getNeighborsInclusive(Array<Index>& out, const Vector3& point) const;
+
+  /**
+   * Finds all index pairs (i < j) of binned points that are closer than
+   * @a maxDistance to each other.
+   * @param out The pairs found, replacing any contents.
+   */
+  void getPairs(std::vector<std::pair<Index, Index>>& out) const;
+
+  /** @return The largest distance supported by the binning. */
+  Real maxDistance() const { return m_maxDistance; }
+
+private:
+  Index binIndex(const Vector3i& bin) const;
+  Vector3i binOf(const Vector3& point) const;
+
+  Real m_maxDistance;
+  Real m_binSize;
+  Vector3 m_minPos;
+  Vector3i m_binCount;
+  Array<Vector3> m_points;
+  std::vector<std::vector<Index>> m_bins;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_NEIGHBORPERCEIVER_H
@@ -41,6 +41,7 @@ Residue::Residue(std::string& name, Index& number, char& id)
 Residue::Residue(const Residue& other)
   : m_residueName(other.m_residueName)
   , m_residueId(other.m_residueId)
+  , m_chainId(other.m_chainId)
   , m_atomNameMap(other.m_atomNameMap)
 {}
 
@@ -48,6 +49,7 @@ Residue& Residue::operator=(Residue other)
 {
   m_residueName = other.m_residueName;
   m_residueId = other.m_residueId;
+  m_chainId = other.m_chainId;
   m_atomNameMap = other.m_atomNameMap;
   return *this;
 }
@@ -59,10 +61,10 @@ void Residue::addResidueAtom(std::string& name, Atom& atom)
   m_atomNameMap.insert(std::pair<std::string, Atom>(name, atom));
 }
 
-std::vector<Atom> Residue::residueAtoms()
+std::vector<Atom> Residue::residueAtoms() const
 {
   std::vector<Atom> res;
-  for (AtomNameMap::iterator it = m_atomNameMap.begin();
+  for (AtomNameMap::const_iterator it = m_atomNameMap.begin();
        it != m_atomNameMap.end(); ++it) {
     res.push_back(it->second);
   }
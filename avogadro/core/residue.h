@@ -55,15 +55,15 @@ public:
 
   virtual ~Residue();
 
-  inline std::string residueName() { return m_residueName; }
+  inline const std::string& residueName() const { return m_residueName; }
 
   inline void setResidueName(std::string& name) { m_residueName = name; }
 
-  inline Index residueId() { return m_residueId; }
+  inline Index residueId() const { return m_residueId; }
 
   inline void setResidueId(Index& number) { m_residueId = number; }
 
-  inline char chainId() { return m_chainId; }
+  inline char chainId() const { return m_chainId; }
 
   inline void setChainId(char& id) { m_chainId = id; }
 
@@ -71,7 +71,10 @@ public:
   void addResidueAtom(std::string& name, Atom& atom);
 
   /** Returns a vector containing the atoms added to the residue */
-  std::vector<Atom> residueAtoms();
+  std::vector<Atom> residueAtoms() const;
+
+  /** Returns the atoms of the residue keyed by atom name */
+  const AtomNameMap& atomNameMap() const { return m_atomNameMap; }
 
   /** Sets bonds to atoms in the residue based on data from residuedata header
    */
@@ -0,0 +1,484 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "selectionquery.h"
+
+#include "elements.h"
+#include "molecule.h"
+#include "neighborperceiver.h"
+#include "residue.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+std::string lower(std::string str)
+{
+  std::transform(str.begin(), str.end(), str.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return str;
+}
+
+bool isNumber(const std::string& str)
+{
+  if (str.empty())
+    return false;
+  for (char c : str) {
+    if (!std::isdigit(static_cast<unsigned char>(c)))
+      return false;
+  }
+  return true;
+}
+
+bool isKeyword(const std::string& token)
+{
+  static const char* keywords[] = { "and",     "or",      "not",     "all",
+                                    "none",    "selected", "hydrogen", "heavy",
+                                    "element", "index",   "resid",   "resname",
+                                    "chain",   "within",  "of" };
+  std::string word = lower(token);
+  for (const char* keyword : keywords) {
+    if (word == keyword)
+      return true;
+  }
+  return false;
+}
+
+std::vector<std::string> tokenize(const std::string& query)
+{
+  std::vector<std::string> tokens;
+  std::string current;
+  for (char c : query) {
+    if (std::isspace(static_cast<unsigned char>(c)) || c == '(' || c == ')') {
+      if (!current.empty())
+        tokens.push_back(current);
+      current.clear();
+      if (c == '(' || c == ')')
+        tokens.push_back(std::string(1, c));
+    } else {
+      current += c;
+    }
+  }
+  if (!current.empty())
+    tokens.push_back(current);
+  return tokens;
+}
+} // namespace
+
+class SelectionQuery::Parser
+{
+public:
+  Parser(const std::string& query, std::vector<Instruction>& program)
+    : m_tokens(tokenize(query)), m_pos(0), m_program(program)
+  {
+  }
+
+  bool parse()
+  {
+    if (m_tokens.empty())
+      return fail("The query is empty.");
+    if (!parseOr())
+      return false;
+    if (m_pos < m_tokens.size())
+      return fail("Unexpected '" + m_tokens[m_pos] + "'.");
+    return true;
+  }
+
+  std::string error() const { return m_error; }
+
+private:
+  bool fail(const std::string& message)
+  {
+    if (m_error.empty())
+      m_error = message;
+    return false;
+  }
+
+  bool atEnd() const { return m_pos >= m_tokens.size(); }
+
+  std::string peek() const
+  {
+    return atEnd() ? std::string() : lower(m_tokens[m_pos]);
+  }
+
+  // Arguments run until the next keyword or parenthesis.
+  bool atArgument() const
+  {
+    return !atEnd() && m_tokens[m_pos] != "(" && m_tokens[m_pos] != ")" &&
+           !isKeyword(m_tokens[m_pos]);
+  }
+
+  void emit(OpCode op)
+  {
+    Instruction instruction;
+    instruction.op = op;
+    instruction.distance = 0.0;
+    m_program.push_back(instruction);
+  }
+
+  bool parseOr()
+  {
+    if (!parseAnd())
+      return false;
+    while (peek() == "or") {
+      ++m_pos;
+      if (!parseAnd())
+        return false;
+      emit(Or);
+    }
+    return true;
+  }
+
+  bool parseAnd()
+  {
+    if (!parseNot())
+      return false;
+    while (peek() == "and") {
+      ++m_pos;
+      if (!parseNot())
+        return false;
+      emit(And);
+    }
+    return true;
+  }
+
+  bool parseNot()
+  {
+    if (peek() == "not") {
+      ++m_pos;
+      if (!parseNot())
+        return false;
+      emit(Not);
+      return true;
+    }
+    return parseTerm();
+  }
+
+  bool parseTerm()
+  {
+    if (atEnd())
+      return fail("The query ends unexpectedly.");
+
+    std::string word = peek();
+    const std::string& token = m_tokens[m_pos++];
+    if (word == "(") {
+      if (!parseOr())
+        return false;
+      if (peek() != ")")
+        return fail("Missing ')'.");
+      ++m_pos;
+      return true;
+    } else if (word == "all") {
+      emit(PushAll);
+    } else if (word == "none") {
+      emit(PushNone);
+    } else if (word == "selected") {
+      emit(PushSelected);
+    } else if (word == "hydrogen" || word == "heavy") {
+      emit(PushElements);
+      m_program.back().elements.assign(256, word == "heavy");
+      m_program.back().elements[1] = word == "hydrogen";
+    } else if (word == "element") {
+      emit(PushElements);
+      return parseElements(m_program.back());
+    } else if (word == "index") {
+      emit(PushIndices);
+      return parseRanges(m_program.back());
+    } else if (word == "resid") {
+      emit(PushResidueIds);
+      return parseRanges(m_program.back());
+    } else if (word == "resname" || word == "chain") {
+      emit(word == "chain" ? PushChains : PushResidueNames);
+      return parseNames(m_program.back());
+    } else if (word == "within") {
+      return parseWithin();
+    } else {
+      return fail("Unknown term '" + token + "'.");
+    }
+    return true;
+  }
+
+  bool parseElements(Instruction& instruction)
+  {
+    instruction.elements.assign(256, false);
+    if (!atArgument())
+      return fail("'element' needs at least one element.");
+    while (atArgument()) {
+      std::string symbol = lower(m_tokens[m_pos++]);
+      unsigned char number = InvalidElement;
+      if (isNumber(symbol)) {
+        long value = std::strtol(symbol.c_str(), nullptr, 10);
+        if (value < static_cast<long>(Elements::elementCount()))
+          number = static_cast<unsigned char>(value);
+      } else {
+        symbol[0] = static_cast<char>(
+          std::toupper(static_cast<unsigned char>(symbol[0])));
+        number = Elements::atomicNumberFromSymbol(symbol);
+      }
+      if (number == InvalidElement)
+        return fail("Unknown element '" + m_tokens[m_pos - 1] + "'.");
+      instruction.elements[number] = true;
+    }
+    return true;
+  }
+
+  bool parseRanges(Instruction& instruction)
+  {
+    if (!atArgument())
+      return fail("'" + m_tokens[m_pos - 1] + "' needs at least one number.");
+    while (atArgument()) {
+      const std::string& token = m_tokens[m_pos++];
+      size_t dash = token.find('-', 1);
+      std::string first = token.substr(0, dash);
+      std::string last =
+        dash == std::string::npos ? first : token.substr(dash + 1);
+      if (!isNumber(first) || !isNumber(last))
+        return fail("Invalid number or range '" + token + "'.");
+      Index begin = static_cast<Index>(std::strtoull(first.c_str(), 0, 10));
+      Index end = static_cast<Index>(std::strtoull(last.c_str(), 0, 10));
+      if (end < begin)
+        std::swap(begin, end);
+      instruction.ranges.push_back(std::make_pair(begin, end));
+    }
+    return true;
+  }
+
+  bool parseNames(Instruction& instruction)
+  {
+    if (!atArgument())
+      return fail("'" + m_tokens[m_pos - 1] + "' needs at least one name.");
+    while (atArgument())
+      instruction.names.push_back(m_tokens[m_pos++]);
+    return true;
+  }
+
+  bool parseWithin()
+  {
+    if (atEnd())
+      return fail("'within' needs a distance.");
+    const std::string& token = m_tokens[m_pos++];
+    char* end = nullptr;
+    double distance = std::strtod(token.c_str(), &end);
+    if (end == token.c_str() || *end != '\0' || distance < 0.0)
+      return fail("Invalid distance '" + token + "'.");
+    if (peek() != "of")
+      return fail("Expected 'of' after 'within " + token + "'.");
+    ++m_pos;
+    if (!parseNot())
+      return false;
+    emit(Within);
+    m_program.back().distance = static_cast<Real>(distance);
+    return true;
+  }
+
+  std::vector<std::string> m_tokens;
+  size_t m_pos;
+  std::vector<Instruction>& m_program;
+  std::string m_error;
+};
+
+SelectionQuery::SelectionQuery() : m_valid(false)
+{
+}
+
+SelectionQuery::SelectionQuery(const std::string& query_) : m_valid(false)
+{
+  compile(query_);
+}
+
+bool SelectionQuery::compile(const std::string& query_)
+{
+  m_query = query_;
+  m_program.clear();
+  Parser parser(query_, m_program);
+  m_valid = parser.parse();
+  m_error = parser.error();
+  if (!m_valid)
+    m_program.clear();
+  return m_valid;
+}
+
+namespace {
+typedef AtomSelection::Word Word;
+
+AtomSelection selectElements(const Molecule& molecule,
+                             const std::vector<bool>& elements)
+{
+  unsigned char table[256];
+  for (int i = 0; i < 256; ++i)
+    table[i] = elements[i] ? 1 : 0;
+
+  // Build whole words at a time rather than setting bits one by one.
+  const Array<unsigned char>& numbers = molecule.atomicNumbers();
+  const Index n = numbers.size();
+  const Index bits = AtomSelection::WordBits;
+  AtomSelection result(n);
+  for (Index w = 0; w < result.words().size(); ++w) {
+    const Index begin = w * bits;
+    const Index count = std::min(bits, n - begin);
+    Word word = 0;
+    for (Index b = 0; b < count; ++b)
+      word |= static_cast<Word>(table[numbers[begin + b]]) << b;
+    result.setWord(w, word);
+  }
+  return result;
+}
+
+template <typename Predicate>
+AtomSelection selectResidues(const Molecule& molecule, Predicate matches)
+{
+  AtomSelection result(molecule.atomCount());
+  const Array<Residue>& residues = molecule.residues();
+  for (Index r = 0; r < residues.size(); ++r) {
+    const Residue& residue = residues[r];
+    if (!matches(residue))
+      continue;
+    const Residue::AtomNameMap& atoms = residue.atomNameMap();
+    for (Residue::AtomNameMap::const_iterator it = atoms.begin();
+         it != atoms.end(); ++it) {
+      if (it->second.index() < result.size())
+        result.set(it->second.index());
+    }
+  }
+  return result;
+}
+
+bool inRanges(Index value, const std::vector<std::pair<Index, Index>>& ranges)
+{
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    if (value >= ranges[i].first && value <= ranges[i].second)
+      return true;
+  }
+  return false;
+}
+
+bool inNames(const std::string& name, const std::vector<std::string>& names)
+{
+  return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+bool inChains(char chain, const std::vector<std::string>& names)
+{
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (names[i].size() == 1 && names[i][0] == chain)
+      return true;
+  }
+  return false;
+}
+
+AtomSelection selectWithin(const Molecule& molecule,
+                           const AtomSelection& center, Real distance)
+{
+  AtomSelection result(center);
+  const Array<Vector3>& positions = molecule.atomPositions3d();
+  if (positions.size() != molecule.atomCount() || center.none() ||
+      distance <= 0.0) {
+    return result;
+  }
+
+  // Bin only the center atoms, and skip atoms outside of their bounding box
+  // before querying the bins.
+  Array<Vector3> centerPositions;
+  center.forEach([&](Index i) { centerPositions.push_back(positions[i]); });
+  Vector3 lo = centerPositions[0];
+  Vector3 hi = centerPositions[0];
+  for (Index i = 1; i < centerPositions.size(); ++i) {
+    lo = lo.cwiseMin(centerPositions[i]);
+    hi = hi.cwiseMax(centerPositions[i]);
+  }
+  lo.array() -= distance;
+  hi.array() += distance;
+
+  NeighborPerceiver perceiver(centerPositions, distance);
+  const Real distanceSq = distance * distance;
+  Array<Index> candidates;
+  for (Index i = 0; i < positions.size(); ++i) {
+    const Vector3& p = positions[i];
+    if (p.x() < lo.x() || p.y() < lo.y() || p.z() < lo.z() ||
+        p.x() > hi.x() || p.y() > hi.y() || p.z() > hi.z() || result.test(i)) {
+      continue;
+    }
+    perceiver.getNeighborsInclusive(candidates, p);
+    for (Index c = 0; c < candidates.size(); ++c) {
+      if ((centerPositions[candidates[c]] - p).squaredNorm() <=
+          distanceSq) {
+        result.set(i);
+        break;
+      }
+    }
+  }
+  return result;
+}
+} // namespace
+
+AtomSelection SelectionQuery::evaluate(const Molecule& molecule) const
+{
+  const Index n = molecule.atomCount();
+  std::vector<AtomSelection> stack;
+  for (size_t p = 0; p < m_program.size(); ++p) {
+    const Instruction& instruction = m_program[p];
+    switch (instruction.op) {
+      case PushAll:
+        stack.push_back(AtomSelection(n, true));
+        break;
+      case PushNone:
+        stack.push_back(AtomSelection(n));
+        break;
+      case PushSelected:
+        stack.push_back(molecule.atomSelection());
+        stack.back().resize(n);
+        break;
+      case PushElements:
+        stack.push_back(selectElements(molecule, instruction.elements));
+        break;
+      case PushIndices:
+        stack.push_back(AtomSelection(n));
+        for (size_t r = 0; r < instruction.ranges.size(); ++r) {
+          stack.back().setRange(instruction.ranges[r].first,
+                                instruction.ranges[r].second + 1);
+        }
+        break;
+      case PushResidueIds:
+        stack.push_back(selectResidues(molecule, [&](const Residue& res) {
+          return inRanges(res.residueId(), instruction.ranges);
+        }));
+        break;
+      case PushResidueNames:
+        stack.push_back(selectResidues(molecule, [&](const Residue& res) {
+          return inNames(res.residueName(), instruction.names);
+        }));
+        break;
+      case PushChains:
+        stack.push_back(selectResidues(molecule, [&](const Residue& res) {
+          return inChains(res.chainId(), instruction.names);
+        }));
+        break;
+      case And:
+        stack[stack.size() - 2] &= stack.back();
+        stack.pop_back();
+        break;
+      case Or:
+        stack[stack.size() - 2] |= stack.back();
+        stack.pop_back();
+        break;
+      case Not:
+        stack.back().invert();
+        break;
+      case Within:
+        stack.back() =
+          selectWithin(molecule, stack.back(), instruction.distance);
+        break;
+    }
+  }
+
+  return stack.empty() ? AtomSelection(n) : stack.back();
+}
+
+} // namespace Core
+} // namespace Avogadro
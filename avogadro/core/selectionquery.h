@@ -0,0 +1,112 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_SELECTIONQUERY_H
+#define AVOGADRO_CORE_SELECTIONQUERY_H
+
+#include "avogadrocore.h"
+
+#include "atomselection.h"
+
+#include <string>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class Molecule;
+
+/**
+ * @class SelectionQuery selectionquery.h <avogadro/core/selectionquery.h>
+ * @brief Selects atoms with a small query language.
+ *
+ * A query is compiled once into a short postfix program, which can then be
+ * evaluated against any number of molecules. Each instruction produces or
+ * combines whole AtomSelection bitsets, so evaluation never goes through
+ * per-atom calls on the molecule. Examples:
+ *
+ * @code
+ * element C and within 5 of resid 42
+ * chain A and not hydrogen
+ * (resname HOH or element Na Cl) and index 0-999
+ * @endcode
+ *
+ * The terms are:
+ * - @c all, @c none, @c selected (the current selection of the molecule)
+ * - @c hydrogen, @c heavy
+ * - @c element followed by symbols or atomic numbers
+ * - @c index, @c resid followed by numbers or ranges such as @c 10-20
+ * - @c resname, @c chain followed by names
+ * - @c within @a distance @c of @a term, for atoms closer than @a distance
+ *   (in Angstrom) to any atom of @a term
+ *
+ * Terms combine with @c not, @c and, @c or and parentheses, binding in that
+ * order. Keywords are case insensitive, names are not.
+ */
+class AVOGADROCORE_EXPORT SelectionQuery
+{
+public:
+  SelectionQuery();
+
+  /** Creates a query and compiles @a query. Check isValid() afterwards. */
+  explicit SelectionQuery(const std::string& query);
+
+  /**
+   * Compile @a query, replacing the previous program.
+   * @return True on success. On failure error() describes the problem and
+   * the query selects nothing.
+   */
+  bool compile(const std::string& query);
+
+  /** @return True if the last compile() succeeded. */
+  bool isValid() const { return m_valid; }
+
+  /** @return A description of the last compilation error, if any. */
+  std::string error() const { return m_error; }
+
+  /** @return The text of the query. */
+  std::string query() const { return m_query; }
+
+  /** @return The atoms of @a molecule that match the query. */
+  AtomSelection evaluate(const Molecule& molecule) const;
+
+private:
+  enum OpCode
+  {
+    PushAll,
+    PushNone,
+    PushSelected,
+    PushElements,
+    PushIndices,
+    PushResidueIds,
+    PushResidueNames,
+    PushChains,
+    And,
+    Or,
+    Not,
+    Within
+  };
+
+  struct Instruction
+  {
+    OpCode op;
+    Real distance;
+    std::vector<std::pair<Index, Index>> ranges;
+    std::vector<std::string> names;
+    std::vector<bool> elements;
+  };
+
+  class Parser;
+
+  std::string m_query;
+  std::string m_error;
+  bool m_valid;
+  std::vector<Instruction> m_program;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_SELECTIONQUERY_H
@@ -14,8 +14,6 @@
 
 ******************************************************************************/
 
-#include <algorithm> // for std::count()
-#include <cassert>
 #include <cctype> // for isdigit()
 #include <iostream>
 
@@ -139,99 +137,115 @@ const char* SpaceGroups::setting(unsigned short hallNumber)
 
 unsigned short SpaceGroups::transformsCount(unsigned short hallNumber)
 {
-  if (hallNumber <= 530) {
-    std::string s = transformsString(hallNumber);
-    return std::count(s.begin(), s.end(), ' ') + 1;
-  } else {
-    return 0;
-  }
+  return static_cast<unsigned short>(symmetryOperations(hallNumber).size());
 }
 
-Real readTransformCoordinate(const std::string& coordinate, const Vector3& v)
+namespace {
+// Parse one coordinate of a transform such as "1/2+x" or "-y+z" into a row
+// of the rotation and the matching translation.
+bool readTransformCoordinate(const std::string& coordinate, int row,
+                             SymmetryOperation& op)
 {
-  // The coordinate should be at least 1 character
-  assert(coordinate.size() != 0);
-
-  Real ret = 0.0;
   Index i = 0;
   while (i < coordinate.size()) {
-    bool isNeg = false;
-    if (coordinate[i] == '-') {
-      isNeg = true;
-      ++i;
-      assert(i < coordinate.size());
-    }
-    // We assume we are adding, so no need for a boolean here
-    else if (coordinate[i] == '+') {
-      ++i;
-      assert(i < coordinate.size());
+    Real sign = 1.0;
+    if (coordinate[i] == '-' || coordinate[i] == '+') {
+      sign = coordinate[i] == '-' ? -1.0 : 1.0;
+      if (++i == coordinate.size())
+        return false;
     }
 
-    // Check to see if we have a digit
+    // Translations are single digit fractions.
     if (isdigit(coordinate[i])) {
-      // We SHOULD have a fraction. Also, we SHOULD only deal with single
-      // digit numbers. Add assertions to make sure this is the case.
-      assert(i + 2 < coordinate.size());
-      assert(coordinate[i + 1] == '/');
-      assert(isdigit(coordinate[i + 2]));
-      // Assert that this is a single digit number
-      if (coordinate.size() > i + 3)
-        assert(!isdigit(coordinate[i + 3]));
-      // Ancient methods used by our forefathers to cast a char to an int
+      if (i + 2 >= coordinate.size() || coordinate[i + 1] != '/' ||
+          !isdigit(coordinate[i + 2])) {
+        return false;
+      }
       Real numerator = coordinate[i] - '0';
       Real denominator = coordinate[i + 2] - '0';
-      Real fraction = numerator / denominator;
-      fraction *= (isNeg) ? -1.0 : 1.0;
-
-      ret += fraction;
+      op.translation[row] += sign * numerator / denominator;
       i += 3;
-    } else if (coordinate[i] == 'x') {
-      ret += (isNeg) ? -1.0 * v[0] : v[0];
-      ++i;
-    } else if (coordinate[i] == 'y') {
-      ret += (isNeg) ? -1.0 * v[1] : v[1];
-      ++i;
-    } else if (coordinate[i] == 'z') {
-      ret += (isNeg) ? -1.0 * v[2] : v[2];
+    } else if (coordinate[i] >= 'x' && coordinate[i] <= 'z') {
+      op.rotation(row, coordinate[i] - 'x') += sign;
       ++i;
     } else {
-      std::cerr << "In " << __FUNCTION__ << ", error reading string: '"
-                << coordinate << "'\n";
-      return 0;
+      return false;
     }
   }
-  return ret;
+  return true;
 }
 
-Vector3 getSingleTransform(const std::string& transform, const Vector3& v)
+SymmetryOperation readTransform(const std::string& transform)
 {
-  Vector3 ret;
+  SymmetryOperation op;
+  op.rotation.setZero();
+  op.translation.setZero();
+
   std::vector<std::string> coordinates = split(transform, ',');
+  bool ok = coordinates.size() == 3;
+  for (int row = 0; ok && row < 3; ++row)
+    ok = readTransformCoordinate(coordinates[row], row, op);
+  if (!ok) {
+    std::cerr << "In " << __FUNCTION__ << ", error reading string: '"
+              << transform << "'\n";
+  }
+  return op;
+}
 
-  // This should be 3 in size. Something very bad happened if it is not.
-  assert(coordinates.size() == 3);
+std::vector<std::vector<SymmetryOperation>> readAllOperations()
+{
+  std::vector<std::vector<SymmetryOperation>> table(531);
+  for (unsigned short hall = 1; hall <= 530; ++hall) {
+    // These transforms are separated by spaces
+    std::vector<std::string> transforms =
+      split(space_group_transforms[hall], ' ');
+    table[hall].reserve(transforms.size());
+    for (size_t i = 0; i < transforms.size(); ++i)
+      table[hall].push_back(readTransform(transforms[i]));
+  }
+  return table;
+}
+} // namespace
 
-  ret[0] = readTransformCoordinate(coordinates[0], v);
-  ret[1] = readTransformCoordinate(coordinates[1], v);
-  ret[2] = readTransformCoordinate(coordinates[2], v);
-  return ret;
+const std::vector<SymmetryOperation>& SpaceGroups::symmetryOperations(
+  unsigned short hallNumber)
+{
+  // Parsing all of the transform strings takes well under a millisecond, and
+  // the initialization of a local static is thread safe.
+  static const std::vector<std::vector<SymmetryOperation>> table =
+    readAllOperations();
+  return hallNumber < table.size() ? table[hallNumber] : table[0];
 }
 
 Array<Vector3> SpaceGroups::getTransforms(unsigned short hallNumber,
                                           const Vector3& v)
 {
-  if (hallNumber == 0 || hallNumber > 530)
-    return Array<Vector3>();
-
+  const std::vector<SymmetryOperation>& ops = symmetryOperations(hallNumber);
   Array<Vector3> ret;
+  ret.reserve(ops.size());
+  for (size_t i = 0; i < ops.size(); ++i)
+    ret.push_back(ops[i].rotation * v + ops[i].translation);
+  return ret;
+}
 
-  std::string transformsStr = transformsString(hallNumber);
-  // These transforms are separated by spaces
-  std::vector<std::string> transforms = split(transformsStr, ' ');
-
-  for (Index i = 0; i < transforms.size(); ++i)
-    ret.push_back(getSingleTransform(transforms[i], v));
-
+Array<Vector3> SpaceGroups::getTransforms(unsigned short hallNumber,
+                                          const Array<Vector3>& positions)
+{
+  typedef Eigen::Matrix<Real, 3, Eigen::Dynamic> Matrix3X;
+  const std::vector<SymmetryOperation>& ops = symmetryOperations(hallNumber);
+  const Index n = positions.size();
+  Array<Vector3> ret(ops.size() * n);
+  if (n == 0)
+    return ret;
+
+  // Vector3 is three packed Reals, so the arrays can be viewed as 3xN
+  // matrices and each operation is applied to all positions at once.
+  Eigen::Map<const Matrix3X> in(positions[0].data(), 3, n);
+  for (size_t i = 0; i < ops.size(); ++i) {
+    Eigen::Map<Matrix3X> out(ret[i * n].data(), 3, n);
+    out.noalias() = ops[i].rotation * in;
+    out.colwise() += ops[i].translation;
+  }
   return ret;
 }
 
@@ -245,19 +259,22 @@ void SpaceGroups::fillUnitCell(Molecule& mol, unsigned short hallNumber,
   Array<unsigned char> atomicNumbers = mol.atomicNumbers();
   Array<Vector3> positions = mol.atomPositions3d();
   Index numAtoms = mol.atomCount();
+  Index numTransforms = transformsCount(hallNumber);
+
+  Array<Vector3> fractional(numAtoms);
+  for (Index i = 0; i < numAtoms; ++i)
+    fractional[i] = uc->toFractional(positions[i]);
+  Array<Vector3> newAtoms = getTransforms(hallNumber, fractional);
 
   // We are going to loop through the original atoms. That is why
   // we have numAtoms cached instead of using atomCount().
   for (Index i = 0; i < numAtoms; ++i) {
     unsigned char atomicNum = atomicNumbers[i];
-    Vector3 pos = uc->toFractional(positions[i]);
-
-    Array<Vector3> newAtoms = getTransforms(hallNumber, pos);
 
     // We skip 0 because it is the original atom.
-    for (Index j = 1; j < newAtoms.size(); ++j) {
+    for (Index j = 1; j < numTransforms; ++j) {
       // The new atoms are in fractional coordinates. Convert to cartesian.
-      Vector3 newCandidate = uc->toCartesian(newAtoms[j]);
+      Vector3 newCandidate = uc->toCartesian(newAtoms[j * numAtoms + i]);
 
       // If there is already an atom in this location within a
       // certain tolerance, do not add the atom.
@@ -19,8 +19,15 @@
 
 #include "avogadrocore.h"
 
+#include "array.h"
+#include "matrix.h"
+#include "vector.h"
+
+#include <vector>
+
 namespace Avogadro {
 namespace Core {
+class Molecule;
 
 /**
  * Enumeration of the crystal system.
@@ -38,6 +45,19 @@ enum CrystalSystem
   Cubic
 };
 
+/**
+ * @brief A space group symmetry operation acting on fractional coordinates,
+ * x' = rotation * x + translation.
+ *
+ * The rotation only has entries of -1, 0 and 1, and the translation is a
+ * multiple of 1/12.
+ */
+struct SymmetryOperation
+{
+  Matrix3 rotation;
+  Vector3 translation;
+};
+
 /**
  * @class SpaceGroups spacegroups.h <avogadro/core/spacegroups.h>
  * @brief The Spacegroups class stores basic data about crystal spacegroups.
@@ -116,6 +136,25 @@ public:
   static Array<Vector3> getTransforms(unsigned short hallNumber,
                                       const Vector3& v);
 
+  /**
+   * Apply all transforms for a given hall number to each of @a positions.
+   * The positions should be in fractional coordinates. The image of
+   * positions[i] under transform j is at index j * positions.size() + i.
+   * If an invalid hall number is given, an empty array will be returned.
+   */
+  static Array<Vector3> getTransforms(unsigned short hallNumber,
+                                      const Array<Vector3>& positions);
+
+  /**
+   * Get the symmetry operations for a given hall number, in the order used
+   * by getTransforms(). The first one is the identity. The operations of all
+   * hall numbers are parsed once, on first use, and may be shared between
+   * threads. If an invalid hall number is given, an empty list will be
+   * returned.
+   */
+  static const std::vector<SymmetryOperation>& symmetryOperations(
+    unsigned short hallNumber);
+
   /**
    * Fill a crystal with atoms by using transforms from a hall number.
    * Nothing will be done if the molecule does not have a unit cell.
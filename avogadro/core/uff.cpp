@@ -0,0 +1,649 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "uff.h"
+
+#include "elements.h"
+#include "molecule.h"
+#include "neighborperceiver.h"
+#include "uffdata.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+
+// Below this many terms, spawning threads costs more than it saves.
+const size_t MinTermsPerThread = 2048;
+
+struct AtomEnvironment
+{
+  unsigned char element;
+  int neighbors;
+  int maxOrder;
+  int orderSum;
+};
+
+int findParameters(const char* label)
+{
+  for (unsigned int i = 0; i < uff_parameter_count; ++i) {
+    if (std::string(uff_parameters[i].label) == label)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+// Choose the UFF type for an atom from its element and bonding environment.
+int assignType(const AtomEnvironment& env)
+{
+  const char* label = nullptr;
+  switch (env.element) {
+    case 5:
+      label = env.neighbors >= 4 ? "B_3" : "B_2";
+      break;
+    case 6:
+      if (env.maxOrder >= 3 || (env.neighbors == 2 && env.orderSum >= 4))
+        label = "C_1";
+      else if (env.maxOrder == 2 || env.neighbors == 3)
+        label = "C_2";
+      else
+        label = "C_3";
+      break;
+    case 7:
+      if (env.maxOrder >= 3)
+        label = "N_1";
+      else if (env.maxOrder == 2)
+        label = "N_2";
+      else
+        label = "N_3";
+      break;
+    case 8:
+      label = env.maxOrder >= 2 ? "O_2" : "O_3";
+      break;
+    case 15:
+      label = env.neighbors >= 4 ? "P_3+5" : "P_3+3";
+      break;
+    case 16:
+      if (env.neighbors >= 3)
+        label = "S_3+6";
+      else if (env.maxOrder >= 2 && env.neighbors == 1)
+        label = "S_2";
+      else
+        label = "S_3+2";
+      break;
+    default:
+      break;
+  }
+  if (label)
+    return findParameters(label);
+
+  for (unsigned int i = 0; i < uff_parameter_count; ++i) {
+    if (uff_parameters[i].element == env.element)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+// Parameters for elements without a UFF type, derived from the element data.
+UFFParameters genericParameters(unsigned char element)
+{
+  UFFParameters p = { "Xx", element, 3, 0.0, 109.47, 0.0, 0.1, 12.0,
+                      1.0, 0.0, 0.0, 5.0 };
+  p.r1 = Elements::radiusCovalent(element);
+  if (p.r1 <= 0.0)
+    p.r1 = 1.0;
+  p.x1 = 2.0 * Elements::radiusVDW(element);
+  if (p.x1 <= 0.0)
+    p.x1 = 4.0;
+  return p;
+}
+
+Real bondRestLength(const UFFParameters& a, const UFFParameters& b,
+                    Real order)
+{
+  Real rBO = -0.1332 * (a.r1 + b.r1) * std::log(order);
+  Real sqrtDiff = std::sqrt(a.Xi) - std::sqrt(b.Xi);
+  Real rEN =
+    a.r1 * b.r1 * sqrtDiff * sqrtDiff / (a.Xi * a.r1 + b.Xi * b.r1);
+  return a.r1 + b.r1 + rBO - rEN;
+}
+
+inline Vector3 position(const Eigen::VectorXd& x, Index i)
+{
+  return Vector3(x[3 * i], x[3 * i + 1], x[3 * i + 2]);
+}
+
+inline void addGradient(Eigen::VectorXd& grad, Index i, const Vector3& g)
+{
+  grad[3 * i] += g[0];
+  grad[3 * i + 1] += g[1];
+  grad[3 * i + 2] += g[2];
+}
+
+Real bondEnergy(const std::vector<UFF::BondTerm>& terms, size_t begin,
+                size_t end, const Eigen::VectorXd& x, Eigen::VectorXd* grad)
+{
+  Real energy = 0.0;
+  for (size_t t = begin; t < end; ++t) {
+    const UFF::BondTerm& b = terms[t];
+    Vector3 d = position(x, b.i) - position(x, b.j);
+    Real r = d.norm();
+    Real dr = r - b.r0;
+    energy += 0.5 * b.kb * dr * dr;
+    if (grad && r > 1.0e-8) {
+      Vector3 g = (b.kb * dr / r) * d;
+      addGradient(*grad, b.i, g);
+      addGradient(*grad, b.j, -g);
+    }
+  }
+  return energy;
+}
+
+Real angleEnergy(const std::vector<UFF::AngleTerm>& terms, size_t begin,
+                 size_t end, const Eigen::VectorXd& x, Eigen::VectorXd* grad)
+{
+  Real energy = 0.0;
+  for (size_t t = begin; t < end; ++t) {
+    const UFF::AngleTerm& a = terms[t];
+    Vector3 u = position(x, a.i) - position(x, a.j);
+    Vector3 v = position(x, a.k) - position(x, a.j);
+    Real lu = u.norm();
+    Real lv = v.norm();
+    if (lu < 1.0e-8 || lv < 1.0e-8)
+      continue;
+    Real c = std::max(-1.0, std::min(1.0, u.dot(v) / (lu * lv)));
+
+    // Energy and its derivative with respect to cos(theta).
+    Real e = 0.0;
+    Real dEdc = 0.0;
+    switch (a.n) {
+      case 1:
+        e = 1.0 + c;
+        dEdc = 1.0;
+        break;
+      case 3:
+        e = (1.0 - (4.0 * c * c * c - 3.0 * c)) / 9.0;
+        dEdc = -(12.0 * c * c - 3.0) / 9.0;
+        break;
+      case 4:
+        e = (1.0 - (8.0 * c * c * c * c - 8.0 * c * c + 1.0)) / 16.0;
+        dEdc = -(32.0 * c * c * c - 16.0 * c) / 16.0;
+        break;
+      default:
+        e = a.c0 + a.c1 * c + a.c2 * (2.0 * c * c - 1.0);
+        dEdc = a.c1 + 4.0 * a.c2 * c;
+        break;
+    }
+    energy += a.ka * e;
+
+    if (grad) {
+      Real f = a.ka * dEdc;
+      Vector3 gi = f * (v / (lu * lv) - c * u / (lu * lu));
+      Vector3 gk = f * (u / (lu * lv) - c * v / (lv * lv));
+      addGradient(*grad, a.i, gi);
+      addGradient(*grad, a.k, gk);
+      addGradient(*grad, a.j, -(gi + gk));
+    }
+  }
+  return energy;
+}
+
+Real torsionEnergy(const std::vector<UFF::TorsionTerm>& terms, size_t begin,
+                   size_t end, const Eigen::VectorXd& x, Eigen::VectorXd* grad)
+{
+  Real energy = 0.0;
+  for (size_t t = begin; t < end; ++t) {
+    const UFF::TorsionTerm& tor = terms[t];
+    Vector3 b1 = position(x, tor.j) - position(x, tor.i);
+    Vector3 b2 = position(x, tor.k) - position(x, tor.j);
+    Vector3 b3 = position(x, tor.l) - position(x, tor.k);
+    Vector3 m = b1.cross(b2);
+    Vector3 n = b2.cross(b3);
+    Real mSq = m.squaredNorm();
+    Real nSq = n.squaredNorm();
+    Real lb2 = b2.norm();
+    if (mSq < 1.0e-12 || nSq < 1.0e-12 || lb2 < 1.0e-8)
+      continue;
+
+    Real phi = std::atan2(lb2 * b1.dot(n), m.dot(n));
+    energy += 0.5 * tor.v * (1.0 - tor.cosTerm * std::cos(tor.n * phi));
+
+    if (grad) {
+      Real dEdphi = 0.5 * tor.v * tor.cosTerm * tor.n * std::sin(tor.n * phi);
+      Vector3 gi = -(lb2 / mSq) * m;
+      Vector3 gl = (lb2 / nSq) * n;
+      Real p = -b1.dot(b2) / (lb2 * lb2);
+      Real q = -b3.dot(b2) / (lb2 * lb2);
+      Vector3 gj = (p - 1.0) * gi - q * gl;
+      Vector3 gk = (q - 1.0) * gl - p * gi;
+      addGradient(*grad, tor.i, dEdphi * gi);
+      addGradient(*grad, tor.j, dEdphi * gj);
+      addGradient(*grad, tor.k, dEdphi * gk);
+      addGradient(*grad, tor.l, dEdphi * gl);
+    }
+  }
+  return energy;
+}
+
+Real vdwEnergy(const std::vector<UFF::VdwTerm>& terms, size_t begin,
+               size_t end, Real cutoffSq, const Eigen::VectorXd& x,
+               Eigen::VectorXd* grad)
+{
+  Real energy = 0.0;
+  for (size_t t = begin; t < end; ++t) {
+    const UFF::VdwTerm& w = terms[t];
+    Vector3 d = position(x, w.i) - position(x, w.j);
+    Real rSq = d.squaredNorm();
+    if (rSq > cutoffSq || rSq < 1.0e-8)
+      continue;
+    Real s = w.x2 / rSq;
+    Real s3 = s * s * s;
+    Real s6 = s3 * s3;
+    energy += w.depth * (s6 - 2.0 * s3);
+    if (grad) {
+      // dE/d(r^2), multiplied by d(r^2)/dx = 2 d.
+      Vector3 g = (-12.0 * w.depth * (s6 - s3) / rSq) * d;
+      addGradient(*grad, w.i, g);
+      addGradient(*grad, w.j, -g);
+    }
+  }
+  return energy;
+}
+
+} // namespace
+
+UFF::UFF()
+  : m_atomCount(0), m_cutoff(8.0), m_skin(1.0), m_threadCount(0)
+{
+}
+
+UFF::~UFF() {}
+
+bool UFF::setMolecule(const Molecule& mol)
+{
+  m_atomCount = 0;
+  m_typeLabels.clear();
+  m_vdwDistance.clear();
+  m_vdwDepth.clear();
+  m_bonds.clear();
+  m_angles.clear();
+  m_torsions.clear();
+  m_vdw.clear();
+  m_exclusions.clear();
+  m_listPositions.resize(0);
+  m_active.clear();
+  m_regionBonds.clear();
+  m_regionAngles.clear();
+  m_regionTorsions.clear();
+  m_mask.resize(0);
+
+  if (mol.atomPositions3d().size() != mol.atomCount())
+    return false;
+
+  Index n = mol.atomCount();
+  m_atomCount = n;
+
+  // Connectivity and bonding environment.
+  std::vector<std::vector<Index>> neighbors(n);
+  std::vector<std::vector<Real>> orders(n);
+  std::vector<AtomEnvironment> env(n);
+  for (Index i = 0; i < n; ++i) {
+    env[i].element = mol.atomicNumber(i);
+    env[i].neighbors = 0;
+    env[i].maxOrder = 0;
+    env[i].orderSum = 0;
+  }
+  const Array<std::pair<Index, Index>>& pairs = mol.bondPairs();
+  for (Index b = 0; b < pairs.size(); ++b) {
+    Index i = pairs[b].first;
+    Index j = pairs[b].second;
+    int order = std::max(1, static_cast<int>(mol.bondOrder(b)));
+    neighbors[i].push_back(j);
+    neighbors[j].push_back(i);
+    orders[i].push_back(order);
+    orders[j].push_back(order);
+    for (Index a : { i, j }) {
+      ++env[a].neighbors;
+      env[a].maxOrder = std::max(env[a].maxOrder, order);
+      env[a].orderSum += order;
+    }
+  }
+
+  // Atom types.
+  std::vector<UFFParameters> params(n);
+  for (Index i = 0; i < n; ++i) {
+    int type = assignType(env[i]);
+    params[i] =
+      type >= 0 ? uff_parameters[type] : genericParameters(env[i].element);
+    m_typeLabels.push_back(params[i].label);
+    m_vdwDistance.push_back(params[i].x1);
+    m_vdwDepth.push_back(params[i].D1);
+  }
+
+  // Bond stretching.
+  for (Index b = 0; b < pairs.size(); ++b) {
+    Index i = pairs[b].first;
+    Index j = pairs[b].second;
+    Real order = std::max(1, static_cast<int>(mol.bondOrder(b)));
+    BondTerm term;
+    term.i = i;
+    term.j = j;
+    term.r0 = bondRestLength(params[i], params[j], order);
+    term.kb = 664.12 * params[i].Z1 * params[j].Z1 /
+              (term.r0 * term.r0 * term.r0);
+    m_bonds.push_back(term);
+    m_exclusions.push_back(std::make_pair(std::min(i, j), std::max(i, j)));
+  }
+
+  // Angle bending around each central atom j.
+  for (Index j = 0; j < n; ++j) {
+    const UFFParameters& pj = params[j];
+    Real theta0 = pj.theta0 * DEG_TO_RAD;
+    Real cosT0 = std::cos(theta0);
+    Real sinT0Sq = 1.0 - cosT0 * cosT0;
+    for (size_t a = 0; a < neighbors[j].size(); ++a) {
+      for (size_t c = a + 1; c < neighbors[j].size(); ++c) {
+        Index i = neighbors[j][a];
+        Index k = neighbors[j][c];
+        Real rij = bondRestLength(params[i], pj, orders[j][a]);
+        Real rjk = bondRestLength(pj, params[k], orders[j][c]);
+        Real rikSq = rij * rij + rjk * rjk - 2.0 * rij * rjk * cosT0;
+        Real rik = std::sqrt(rikSq);
+        AngleTerm term;
+        term.i = i;
+        term.j = j;
+        term.k = k;
+        term.ka = 664.12 / (rij * rjk) * params[i].Z1 * params[k].Z1 /
+                  (rikSq * rikSq * rik) * rij * rjk *
+                  (3.0 * rij * rjk * sinT0Sq - rikSq * cosT0);
+        term.c0 = term.c1 = term.c2 = 0.0;
+        if (pj.theta0 > 179.0) {
+          term.n = 1;
+        } else if (std::fabs(pj.theta0 - 120.0) < 0.01) {
+          term.n = 3;
+        } else if (std::fabs(pj.theta0 - 90.0) < 0.01) {
+          term.n = 4;
+        } else {
+          term.n = 0;
+          term.c2 = 1.0 / (4.0 * sinT0Sq);
+          term.c1 = -4.0 * term.c2 * cosT0;
+          term.c0 = term.c2 * (2.0 * cosT0 * cosT0 + 1.0);
+        }
+        m_angles.push_back(term);
+        m_exclusions.push_back(
+          std::make_pair(std::min(i, k), std::max(i, k)));
+      }
+    }
+  }
+
+  // Torsions around each bond j-k.
+  for (Index b = 0; b < pairs.size(); ++b) {
+    Index j = pairs[b].first;
+    Index k = pairs[b].second;
+    const UFFParameters& pj = params[j];
+    const UFFParameters& pk = params[k];
+    if (pj.hyb < 2 || pk.hyb < 2)
+      continue;
+    size_t count = (neighbors[j].size() - 1) * (neighbors[k].size() - 1);
+    if (count == 0)
+      continue;
+
+    TorsionTerm term;
+    term.j = j;
+    term.k = k;
+    if (pj.hyb == 3 && pk.hyb == 3) {
+      term.v = std::sqrt(pj.Vi * pk.Vi);
+      term.n = 3;
+      term.cosTerm = -1.0;
+    } else if (pj.hyb == 2 && pk.hyb == 2) {
+      Real order = std::max(1, static_cast<int>(mol.bondOrder(b)));
+      term.v = 5.0 * std::sqrt(pj.Uj * pk.Uj) * (1.0 + 4.18 * std::log(order));
+      term.n = 2;
+      term.cosTerm = 1.0;
+    } else {
+      term.v = 1.0;
+      term.n = 6;
+      term.cosTerm = 1.0;
+    }
+    term.v /= static_cast<Real>(count);
+    if (term.v <= 0.0)
+      continue;
+
+    for (Index i : neighbors[j]) {
+      if (i == k)
+        continue;
+      for (Index l : neighbors[k]) {
+        if (l == j || l == i)
+          continue;
+        term.i = i;
+        term.l = l;
+        m_torsions.push_back(term);
+      }
+    }
+  }
+
+  std::sort(m_exclusions.begin(), m_exclusions.end());
+  m_exclusions.erase(std::unique(m_exclusions.begin(), m_exclusions.end()),
+                     m_exclusions.end());
+
+  return true;
+}
+
+std::string UFF::atomType(Index index) const
+{
+  return index < m_typeLabels.size() ? m_typeLabels[index] : std::string();
+}
+
+void UFF::setActiveAtoms(const std::vector<bool>& active)
+{
+  if (active == m_active)
+    return;
+
+  m_active = active;
+  m_regionBonds.clear();
+  m_regionAngles.clear();
+  m_regionTorsions.clear();
+  m_listPositions.resize(0);
+
+  if (m_active.empty() || m_active.size() != m_atomCount) {
+    m_active.clear();
+    m_mask.resize(0);
+    return;
+  }
+
+  m_mask.resize(3 * m_atomCount);
+  for (Index i = 0; i < m_atomCount; ++i)
+    m_mask.segment<3>(3 * i).setConstant(m_active[i] ? 1.0 : 0.0);
+
+  for (const BondTerm& b : m_bonds) {
+    if (m_active[b.i] || m_active[b.j])
+      m_regionBonds.push_back(b);
+  }
+  for (const AngleTerm& a : m_angles) {
+    if (m_active[a.i] || m_active[a.j] || m_active[a.k])
+      m_regionAngles.push_back(a);
+  }
+  for (const TorsionTerm& t : m_torsions) {
+    if (m_active[t.i] || m_active[t.j] || m_active[t.k] || m_active[t.l])
+      m_regionTorsions.push_back(t);
+  }
+}
+
+void UFF::setNonbondedCutoff(Real cutoff)
+{
+  m_cutoff = cutoff;
+  m_listPositions.resize(0);
+}
+
+unsigned int UFF::threadCount() const
+{
+  if (m_threadCount > 0)
+    return m_threadCount;
+  unsigned int hardware = std::thread::hardware_concurrency();
+  return hardware > 0 ? hardware : 1;
+}
+
+void UFF::updateNeighborList(const Eigen::VectorXd& x)
+{
+  if (m_listPositions.size() == x.size()) {
+    Real limitSq = 0.25 * m_skin * m_skin;
+    bool moved = false;
+    for (Index i = 0; i < m_atomCount && !moved; ++i) {
+      if ((position(x, i) - position(m_listPositions, i)).squaredNorm() >
+          limitSq) {
+        moved = true;
+      }
+    }
+    if (!moved)
+      return;
+  }
+
+  m_listPositions = x;
+  m_vdw.clear();
+
+  Array<Vector3> points;
+  fromCoordinates(x, points);
+  const Real listDistance = m_cutoff + m_skin;
+  NeighborPerceiver perceiver(points, listDistance);
+  std::vector<std::pair<Index, Index>> pairs;
+  if (m_active.empty()) {
+    perceiver.getPairs(pairs);
+  } else {
+    // Only pairs with an active atom matter, look those up directly.
+    const Real listSq = listDistance * listDistance;
+    Array<Index> candidates;
+    for (Index i = 0; i < m_atomCount; ++i) {
+      if (!m_active[i])
+        continue;
+      perceiver.getNeighborsInclusive(candidates, points[i]);
+      for (Index c = 0; c < candidates.size(); ++c) {
+        Index j = candidates[c];
+        // Pairs of two active atoms are added from the lower index only.
+        if (j == i || (m_active[j] && j < i))
+          continue;
+        if ((points[i] - points[j]).squaredNorm() < listSq)
+          pairs.push_back(i < j ? std::make_pair(i, j) : std::make_pair(j, i));
+      }
+    }
+  }
+
+  for (size_t p = 0; p < pairs.size(); ++p) {
+    if (std::binary_search(m_exclusions.begin(), m_exclusions.end(),
+                           pairs[p])) {
+      continue;
+    }
+    VdwTerm term;
+    term.i = pairs[p].first;
+    term.j = pairs[p].second;
+    term.depth = std::sqrt(m_vdwDepth[term.i] * m_vdwDepth[term.j]);
+    term.x2 = m_vdwDistance[term.i] * m_vdwDistance[term.j];
+    m_vdw.push_back(term);
+  }
+}
+
+Real UFF::evaluate(const Eigen::VectorXd& x, Eigen::VectorXd* grad)
+{
+  if (grad)
+    grad->setZero(x.size());
+  if (x.size() != static_cast<Eigen::Index>(3 * m_atomCount))
+    return 0.0;
+
+  updateNeighborList(x);
+  const Real cutoffSq = m_cutoff * m_cutoff;
+
+  const bool region = !m_active.empty();
+  const std::vector<BondTerm>& bonds = region ? m_regionBonds : m_bonds;
+  const std::vector<AngleTerm>& angles = region ? m_regionAngles : m_angles;
+  const std::vector<TorsionTerm>& torsions =
+    region ? m_regionTorsions : m_torsions;
+
+  size_t totalTerms =
+    bonds.size() + angles.size() + torsions.size() + m_vdw.size();
+  unsigned int threads = std::min<size_t>(
+    threadCount(), std::max<size_t>(1, totalTerms / MinTermsPerThread));
+
+  // Each worker handles one contiguous slice of every term list.
+  auto work = [&](unsigned int t, unsigned int count, Eigen::VectorXd* g) {
+    auto slice = [t, count](size_t size, size_t& begin, size_t& end) {
+      begin = size * t / count;
+      end = size * (t + 1) / count;
+    };
+    size_t b, e;
+    Real energy = 0.0;
+    slice(bonds.size(), b, e);
+    energy += bondEnergy(bonds, b, e, x, g);
+    slice(angles.size(), b, e);
+    energy += angleEnergy(angles, b, e, x, g);
+    slice(torsions.size(), b, e);
+    energy += torsionEnergy(torsions, b, e, x, g);
+    slice(m_vdw.size(), b, e);
+    energy += vdwEnergy(m_vdw, b, e, cutoffSq, x, g);
+    return energy;
+  };
+
+  Real energy = 0.0;
+  if (threads <= 1) {
+    energy = work(0, 1, grad);
+  } else {
+    std::vector<Real> energies(threads, 0.0);
+    std::vector<Eigen::VectorXd> grads(threads);
+    std::vector<std::thread> pool;
+    for (unsigned int t = 0; t < threads; ++t) {
+      if (grad)
+        grads[t].setZero(x.size());
+      pool.push_back(std::thread([&, t]() {
+        energies[t] = work(t, threads, grad ? &grads[t] : nullptr);
+      }));
+    }
+    for (unsigned int t = 0; t < threads; ++t) {
+      pool[t].join();
+      energy += energies[t];
+      if (grad)
+        *grad += grads[t];
+    }
+  }
+
+  if (grad)
+    cleanGradients(*grad);
+  return energy;
+}
+
+Real UFF::value(const Eigen::VectorXd& x)
+{
+  return evaluate(x, nullptr);
+}
+
+void UFF::gradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad)
+{
+  evaluate(x, &grad);
+}
+
+Real UFF::valueAndGradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad)
+{
+  return evaluate(x, &grad);
+}
+
+Eigen::VectorXd UFF::toCoordinates(const Array<Vector3>& positions)
+{
+  Eigen::VectorXd x(3 * positions.size());
+  for (Index i = 0; i < positions.size(); ++i)
+    x.segment<3>(3 * i) = positions[i];
+  return x;
+}
+
+void UFF::fromCoordinates(const Eigen::VectorXd& x, Array<Vector3>& positions)
+{
+  Index n = static_cast<Index>(x.size() / 3);
+  positions.resize(n);
+  for (Index i = 0; i < n; ++i)
+    positions[i] = x.segment<3>(3 * i);
+}
+
+} // namespace Core
+} // namespace Avogadro
@@ -0,0 +1,153 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_UFF_H
+#define AVOGADRO_CORE_UFF_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "energyfunction.h"
+#include "vector.h"
+
+#include <string>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class Molecule;
+
+/**
+ * @class UFF uff.h <avogadro/core/uff.h>
+ * @brief An in-process implementation of the Universal Force Field.
+ *
+ * Implements the bond stretching, angle bending, torsional and van der Waals
+ * terms of UFF (Rappé et al., J. Am. Chem. Soc. 1992, 114, 10024) with
+ * analytic gradients. Atom types are assigned from the element, the number of
+ * bonded neighbors and the bond orders stored in the molecule. Inversion and
+ * electrostatic terms are not included.
+ *
+ * Nonbonded pairs are taken from a Verlet neighbor list built with a
+ * NeighborPerceiver. The list includes a skin distance and is only rebuilt
+ * when an atom has moved farther than half of the skin since the last build.
+ *
+ * Energies and gradients are evaluated on threadCount() threads, each of which
+ * accumulates a private gradient that is summed at the end.
+ *
+ * Energies are in kcal/mol, distances in Angstrom.
+ */
+class AVOGADROCORE_EXPORT UFF : public EnergyFunction
+{
+public:
+  UFF();
+  ~UFF() override;
+
+  /**
+   * Assign atom types and set up all energy terms for @a mol. This must be
+   * called again whenever atoms or bonds of the molecule change.
+   * @return False if the molecule has no 3D coordinates.
+   */
+  bool setMolecule(const Molecule& mol);
+
+  /** @return The number of atoms in the current setup. */
+  Index atomCount() const { return m_atomCount; }
+
+  /** @return The UFF atom type assigned to atom @a index. */
+  std::string atomType(Index index) const;
+
+  /**
+   * Restrict the force field to a local region for interactive use. Only terms
+   * involving at least one atom with @a active[i] true are evaluated, and all
+   * other atoms are frozen through the mask, so the cost scales with the size
+   * of the region rather than the molecule. Energies are then only meaningful
+   * relative to each other. An empty vector restores the full force field.
+   */
+  void setActiveAtoms(const std::vector<bool>& active);
+  const std::vector<bool>& activeAtoms() const { return m_active; }
+
+  /**
+   * Set the cutoff used for van der Waals interactions. Default 8.0 A.
+   */
+  void setNonbondedCutoff(Real cutoff);
+  Real nonbondedCutoff() const { return m_cutoff; }
+
+  /**
+   * Set the number of threads used to evaluate the energy and gradient. Zero
+   * (the default) uses the hardware concurrency.
+   */
+  void setThreadCount(unsigned int threads) { m_threadCount = threads; }
+  unsigned int threadCount() const;
+
+  Real value(const Eigen::VectorXd& x) override;
+  void gradient(const Eigen::VectorXd& x, Eigen::VectorXd& grad) override;
+  Real valueAndGradient(const Eigen::VectorXd& x,
+                        Eigen::VectorXd& grad) override;
+
+  /** Pack @a positions into the flat coordinate layout used by this class. */
+  static Eigen::VectorXd toCoordinates(const Array<Vector3>& positions);
+
+  /** Unpack a flat coordinate vector into @a positions. */
+  static void fromCoordinates(const Eigen::VectorXd& x,
+                              Array<Vector3>& positions);
+
+  struct BondTerm
+  {
+    Index i, j;
+    Real kb, r0;
+  };
+
+  struct AngleTerm
+  {
+    Index i, j, k;
+    Real ka, c0, c1, c2;
+    int n; // 0 for the general Fourier form, periodicity otherwise
+  };
+
+  struct TorsionTerm
+  {
+    Index i, j, k, l;
+    Real v, cosTerm; // E = v / 2 * (1 - cosTerm * cos(n phi))
+    int n;
+  };
+
+  struct VdwTerm
+  {
+    Index i, j;
+    Real depth, x2; // well depth and squared minimum distance
+  };
+
+private:
+  void updateNeighborList(const Eigen::VectorXd& x);
+  Real evaluate(const Eigen::VectorXd& x, Eigen::VectorXd* grad);
+
+  Index m_atomCount;
+  std::vector<std::string> m_typeLabels;
+  // Per-atom nonbonded parameters, combined when the neighbor list is built.
+  std::vector<Real> m_vdwDistance;
+  std::vector<Real> m_vdwDepth;
+  std::vector<BondTerm> m_bonds;
+  std::vector<AngleTerm> m_angles;
+  std::vector<TorsionTerm> m_torsions;
+  std::vector<VdwTerm> m_vdw;
+
+  // Terms touching the active region, see setActiveAtoms().
+  std::vector<bool> m_active;
+  std::vector<BondTerm> m_regionBonds;
+  std::vector<AngleTerm> m_regionAngles;
+  std::vector<TorsionTerm> m_regionTorsions;
+
+  // Sorted (i < j) atom pairs excluded from nonbonded interactions.
+  std::vector<std::pair<Index, Index>> m_exclusions;
+  Eigen::VectorXd m_listPositions;
+  Real m_cutoff;
+  Real m_skin;
+  unsigned int m_threadCount;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_UFF_H
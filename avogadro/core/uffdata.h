@@ -0,0 +1,100 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_UFF_DATA
+#define AVOGADRO_CORE_UFF_DATA
+
+namespace Avogadro {
+namespace Core {
+
+// Parameters from Rappe et al., J. Am. Chem. Soc. 1992, 114, 10024.
+// hyb is the hybridization used to select torsional parameters (1, 2, 3) or
+// zero for atoms that are never the center of a torsion.
+struct UFFParameters
+{
+  const char* label;
+  unsigned char element;
+  int hyb;
+  double r1;     // bond radius
+  double theta0; // natural angle, degrees
+  double x1;     // nonbond distance
+  double D1;     // nonbond energy
+  double zeta;   // nonbond scale
+  double Z1;     // effective charge
+  double Vi;     // sp3 torsional barrier
+  double Uj;     // sp2 torsional barrier
+  double Xi;     // GMP electronegativity
+};
+
+const UFFParameters uff_parameters[] = {
+  { "H_", 1, 0, 0.354, 180.0, 2.886, 0.044, 12.0, 0.712, 0.0, 0.0, 4.528 },
+  { "He4+4", 2, 0, 0.849, 90.0, 2.362, 0.056, 15.24, 0.098, 0.0, 0.0, 9.66 },
+  { "Li", 3, 0, 1.336, 180.0, 2.451, 0.025, 12.0, 1.026, 0.0, 2.0, 3.006 },
+  { "Be3+2", 4, 3, 1.074, 109.47, 2.745, 0.085, 12.0, 1.565, 0.0, 2.0, 4.877 },
+  { "B_3", 5, 3, 0.838, 109.47, 4.083, 0.18, 12.052, 1.755, 0.0, 2.0, 5.11 },
+  { "B_2", 5, 2, 0.828, 120.0, 4.083, 0.18, 12.052, 1.755, 0.0, 2.0, 5.11 },
+  { "C_3", 6, 3, 0.757, 109.47, 3.851, 0.105, 12.73, 1.912, 2.119, 2.0,
+    5.343 },
+  { "C_R", 6, 2, 0.729, 120.0, 3.851, 0.105, 12.73, 1.912, 0.0, 2.0, 5.343 },
+  { "C_2", 6, 2, 0.732, 120.0, 3.851, 0.105, 12.73, 1.912, 0.0, 2.0, 5.343 },
+  { "C_1", 6, 1, 0.706, 180.0, 3.851, 0.105, 12.73, 1.912, 0.0, 2.0, 5.343 },
+  { "N_3", 7, 3, 0.7, 106.7, 3.66, 0.069, 13.407, 2.544, 0.45, 2.0, 6.899 },
+  { "N_R", 7, 2, 0.699, 120.0, 3.66, 0.069, 13.407, 2.544, 0.0, 2.0, 6.899 },
+  { "N_2", 7, 2, 0.685, 111.2, 3.66, 0.069, 13.407, 2.544, 0.0, 2.0, 6.899 },
+  { "N_1", 7, 1, 0.656, 180.0, 3.66, 0.069, 13.407, 2.544, 0.0, 2.0, 6.899 },
+  { "O_3", 8, 3, 0.658, 104.51, 3.5, 0.06, 14.085, 2.3, 0.018, 2.0, 8.741 },
+  { "O_R", 8, 2, 0.68, 110.0, 3.5, 0.06, 14.085, 2.3, 0.0, 2.0, 8.741 },
+  { "O_2", 8, 2, 0.634, 120.0, 3.5, 0.06, 14.085, 2.3, 0.0, 2.0, 8.741 },
+  { "O_1", 8, 1, 0.639, 180.0, 3.5, 0.06, 14.085, 2.3, 0.0, 2.0, 8.741 },
+  { "F_", 9, 0, 0.668, 180.0, 3.364, 0.05, 14.762, 1.735, 0.0, 2.0, 10.874 },
+  { "Ne4+4", 10, 0, 0.92, 90.0, 3.243, 0.042, 15.44, 0.194, 0.0, 2.0, 11.04 },
+  { "Na", 11, 0, 1.539, 180.0, 2.983, 0.03, 12.0, 1.081, 0.0, 1.25, 2.843 },
+  { "Mg3+2", 12, 3, 1.421, 109.47, 3.021, 0.111, 12.0, 1.787, 0.0, 1.25,
+    3.951 },
+  { "Al3", 13, 3, 1.244, 109.47, 4.499, 0.505, 11.278, 1.792, 0.0, 1.25,
+    4.06 },
+  { "Si3", 14, 3, 1.117, 109.47, 4.295, 0.402, 12.175, 2.323, 1.225, 1.25,
+    4.168 },
+  { "P_3+3", 15, 3, 1.101, 93.8, 4.147, 0.305, 13.072, 2.863, 2.4, 1.25,
+    5.463 },
+  { "P_3+5", 15, 3, 1.056, 109.47, 4.147, 0.305, 13.072, 2.863, 2.4, 1.25,
+    5.463 },
+  { "S_3+2", 16, 3, 1.064, 92.1, 4.035, 0.274, 13.969, 2.703, 0.484, 1.25,
+    6.928 },
+  { "S_3+6", 16, 3, 1.027, 109.47, 4.035, 0.274, 13.969, 2.703, 0.484, 1.25,
+    6.928 },
+  { "S_R", 16, 2, 1.077, 92.2, 4.035, 0.274, 13.969, 2.703, 0.0, 1.25,
+    6.928 },
+  { "S_2", 16, 2, 0.854, 120.0, 4.035, 0.274, 13.969, 2.703, 0.0, 1.25,
+    6.928 },
+  { "Cl", 17, 0, 1.044, 180.0, 3.947, 0.227, 14.866, 2.348, 0.0, 1.25,
+    8.564 },
+  { "Ar4+4", 18, 0, 1.032, 90.0, 3.868, 0.185, 15.763, 0.3, 0.0, 1.25,
+    9.465 },
+  { "K_", 19, 0, 1.953, 180.0, 3.812, 0.035, 12.0, 1.165, 0.0, 0.7, 2.421 },
+  { "Ca6+2", 20, 0, 1.761, 90.0, 3.399, 0.238, 12.0, 2.141, 0.0, 0.7, 3.231 },
+  { "Zn3+2", 30, 3, 1.193, 109.47, 2.763, 0.124, 12.0, 1.308, 0.0, 0.7,
+    5.106 },
+  { "Ge3", 32, 3, 1.197, 109.47, 4.28, 0.379, 12.0, 2.442, 0.701, 0.7,
+    4.6 },
+  { "As3+3", 33, 3, 1.211, 92.1, 4.23, 0.309, 13.0, 2.864, 1.5, 0.7,
+    5.3 },
+  { "Se3+2", 34, 3, 1.19, 90.6, 4.205, 0.291, 14.0, 2.764, 0.335, 0.7,
+    5.776 },
+  { "Br", 35, 0, 1.192, 180.0, 4.189, 0.251, 15.0, 2.519, 0.0, 0.7, 7.79 },
+  { "Kr4+4", 36, 0, 1.147, 90.0, 4.141, 0.22, 16.0, 0.452, 0.0, 0.7, 8.505 },
+  { "Sn3", 50, 3, 1.366, 109.47, 4.392, 0.567, 12.0, 2.961, 0.199, 0.2,
+    3.987 },
+  { "I_", 53, 0, 1.382, 180.0, 4.5, 0.339, 15.0, 2.65, 0.0, 0.2, 6.822 },
+  { "Xe4+4", 54, 0, 1.267, 90.0, 4.404, 0.332, 12.0, 0.556, 0.0, 0.2, 7.595 }
+};
+
+const unsigned int uff_parameter_count =
+  sizeof(uff_parameters) / sizeof(uff_parameters[0]);
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif
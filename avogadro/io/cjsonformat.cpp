@@ -20,6 +20,7 @@
 #include <avogadro/core/elements.h>
 #include <avogadro/core/gaussianset.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/mutex.h>
 #include <avogadro/core/unitcell.h>
 #include <avogadro/core/utilities.h>
 
@@ -474,6 +475,7 @@ bool CjsonFormat::write(std::ostream& file, const Molecule& molecule)
   // Write out any cubes that are present in the molecule.
   if (molecule.cubeCount() > 0) {
     const Cube* cube = molecule.cube(0);
+    Core::ReadLocker locker(cube->lock());
     json cubeData;
     for (vector<double>::const_iterator it = cube->data()->begin(),
                                         itEnd = cube->data()->end();
@@ -360,6 +360,8 @@ bool DcdFormat::read(std::istream& inStream, Core::Molecule& mol)
   int coordSet = 1;
   while ((static_cast<int>(inStream.tellg()) != fileLen) &&
          (static_cast<int>(inStream.tellg()) != DCD_EOF)) {
+    if (!updateProgress(inStream))
+      return false;
     // Reading the atom coordinates
     Array<Vector3> positions;
     positions.reserve(NATOMS);
@@ -27,7 +27,16 @@ using std::ifstream;
 using std::locale;
 using std::ofstream;
 
-FileFormat::FileFormat() : m_mode(None), m_in(nullptr), m_out(nullptr)
+namespace {
+// Report progress after at least this many bytes were read, checking the
+// position of the stream only every few records since that can be a syscall.
+const std::streamoff ProgressInterval = 64 * 1024;
+const unsigned int ProgressCallInterval = 64;
+}
+
+FileFormat::FileFormat()
+  : m_mode(None), m_in(nullptr), m_out(nullptr), m_inputSize(0),
+    m_reportedSize(0), m_progressCalls(0), m_canceled(false)
 {
 }
 
@@ -50,6 +59,10 @@ bool FileFormat::open(const std::string& fileName_, Operation mode_)
       m_in = file;
       if (file->is_open()) {
         m_in->imbue(cLocale);
+        file->seekg(0, std::ios_base::end);
+        m_inputSize = file->tellg();
+        file->seekg(0, std::ios_base::beg);
+        m_reportedSize = 0;
         return true;
       } else {
         appendError("Error opening file: " + fileName_);
@@ -81,6 +94,7 @@ void FileFormat::close()
     m_out = nullptr;
   }
   m_mode = None;
+  m_inputSize = 0;
 }
 
 bool FileFormat::readMolecule(Core::Molecule& molecule)
@@ -127,7 +141,11 @@ bool FileFormat::readString(const std::string& string, Core::Molecule& molecule)
   // Imbue the standard C locale.
   locale cLocale("C");
   stream.imbue(cLocale);
-  return read(stream, molecule);
+  m_inputSize = static_cast<std::streamoff>(string.size());
+  m_reportedSize = 0;
+  bool result = read(stream, molecule);
+  m_inputSize = 0;
+  return result;
 }
 
 bool FileFormat::writeString(std::string& string,
@@ -146,6 +164,7 @@ void FileFormat::clear()
 {
   m_fileName.clear();
   m_error.clear();
+  m_canceled = false;
 }
 
 void FileFormat::appendError(const std::string& errorString, bool newLine)
@@ -155,5 +174,22 @@ void FileFormat::appendError(const std::string& errorString, bool newLine)
     m_error += "\n";
 }
 
+bool FileFormat::updateProgress(std::istream& in)
+{
+  if (m_canceled) {
+    appendError("Reading was canceled.");
+    return false;
+  }
+  if (!m_progressFunction || ++m_progressCalls % ProgressCallInterval != 0)
+    return true;
+
+  std::streamoff position = in.tellg();
+  if (position < 0 || position - m_reportedSize < ProgressInterval)
+    return true;
+  m_reportedSize = position;
+  m_progressFunction(position, m_inputSize);
+  return true;
+}
+
 } // namespace Io
 } // namespace Avogadro
@@ -20,6 +20,8 @@
 #include "avogadroioexport.h"
 #include <avogadro/core/avogadrocore.h>
 
+#include <atomic>
+#include <functional>
 #include <istream>
 #include <ostream>
 #include <string>
@@ -190,6 +192,36 @@ public:
    */
   std::string options() const { return m_options; }
 
+  /**
+   * Function called while reading, with the number of bytes consumed and the
+   * size of the input, or zero if the size is not known. It is called from
+   * the thread doing the reading.
+   */
+  typedef std::function<void(std::streamoff read, std::streamoff total)>
+    ProgressFunction;
+
+  /**
+   * @brief Set the function used to report progress while reading. Formats
+   * report progress once per record, such as a line or a trajectory frame,
+   * and the function is called at most every few kilobytes.
+   */
+  void setProgressFunction(ProgressFunction function)
+  {
+    m_progressFunction = function;
+  }
+
+  /**
+   * @brief Ask a read running in another thread to stop. The read returns
+   * false at the next record, and the molecule is left partially read. This
+   * is the only method that is safe to call while another thread is reading.
+   */
+  void cancel() { m_canceled = true; }
+
+  /**
+   * @return True if cancel() was called since the format was last cleared.
+   */
+  bool isCanceled() const { return m_canceled; }
+
   /**
    * Clear the format and reset all state.
    */
@@ -245,6 +277,14 @@ protected:
    */
   void appendError(const std::string& errorString, bool newLine = true);
 
+  /**
+   * @brief Report how far reading @p in has come. Formats call this once per
+   * record while reading.
+   * @return False if reading was canceled, in which case the format should
+   * stop and return false.
+   */
+  bool updateProgress(std::istream& in);
+
 private:
   std::string m_error;
   std::string m_fileName;
@@ -254,6 +294,13 @@ private:
   Operation m_mode;
   std::istream* m_in;
   std::ostream* m_out;
+
+  // Progress reporting and cancellation while reading.
+  ProgressFunction m_progressFunction;
+  std::streamoff m_inputSize;
+  std::streamoff m_reportedSize;
+  unsigned int m_progressCalls;
+  std::atomic<bool> m_canceled;
 };
 
 inline FileFormat::Operation operator|(FileFormat::Operation a,
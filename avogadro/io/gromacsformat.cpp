@@ -88,6 +88,8 @@ bool GromacsFormat::read(std::istream& in, Molecule& molecule)
   unsigned char customElementCounter = CustomElementMin;
   Vector3 pos;
   while (numAtoms-- > 0) {
+    if (!updateProgress(in))
+      return false;
     getline(in, buffer);
     // Figure out the distance between decimal points, implement support for
     // variable precision as specified:
@@ -16,6 +16,8 @@
 
 #include "lammpsformat.h"
 
+#include "textwriter.h"
+
 #include <avogadro/core/crystaltools.h>
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
@@ -23,7 +25,6 @@
 #include <avogadro/core/utilities.h>
 #include <avogadro/core/vector.h>
 
-#include <iomanip>
 #include <istream>
 #include <ostream>
 #include <sstream>
@@ -241,6 +242,8 @@ bool LammpsTrajectoryFormat::read(std::istream& inStream, Core::Molecule& mol)
   size_t numAtoms2;
   int coordSet = 1;
   while (getline(inStream, buffer) && trimmed(buffer) == "ITEM: TIMESTEP") {
+    if (!updateProgress(inStream))
+      return false;
     x_idx = -1;
     y_idx = -1;
     z_idx = -1;
@@ -428,20 +431,19 @@ bool LammpsDataFormat::write(std::ostream& outStream, const Core::Molecule& mol)
   Core::Molecule mol2(mol);
   CrystalTools::rotateToStandardOrientation(mol2, CrystalTools::TransformAtoms);
 
+  TextWriter out(outStream);
+
   // Title
   if (mol2.data("name").toString().length())
-    outStream << mol2.data("name").toString() << std::endl;
+    out.write(mol2.data("name").toString()).write('\n');
   else
-    outStream << "LAMMPS data file generated by Avogadro" << std::endl;
-
-  std::ostringstream massStream, atomStream, bondStream;
-  double xmin, xmax, ymin, ymax, zmin, zmax;
+    out.write("LAMMPS data file generated by Avogadro\n");
 
   size_t numAtoms = mol2.atomCount();
-  outStream << to_string(numAtoms) << " atoms\n";
+  out.writeInteger(static_cast<long long>(numAtoms)).write(" atoms\n");
 
   size_t numBonds = mol2.bondCount();
-  outStream << to_string(numBonds) << " bonds\n";
+  out.writeInteger(static_cast<long long>(numBonds)).write(" bonds\n");
 
   // A map of atomic symbols to their quantity.
   size_t idx = 1;
@@ -455,121 +457,107 @@ bool LammpsDataFormat::write(std::ostream& outStream, const Core::Molecule& mol)
     }
   }
 
-  outStream << composition.size() << " atom types\n";
+  out.writeInteger(static_cast<long long>(composition.size()))
+    .write(" atom types\n");
+
+  // The box comes before the atoms, so find the extent of the atoms first.
+  Vector3 minimum(Vector3::Zero());
+  Vector3 maximum(Vector3::Zero());
+  for (Index i = 0; i < numAtoms; ++i) {
+    Atom atom = mol2.atom(i);
+    if (!atom.isValid()) {
+      appendError("Internal error: Atom invalid.");
+      return false;
+    }
+    const Vector3 coords = atom.position3d();
+    if (i == 0) {
+      minimum = maximum = coords;
+    } else {
+      minimum = minimum.cwiseMin(coords);
+      maximum = maximum.cwiseMax(coords);
+    }
+  }
+
+  Vector3 low, high, tilt;
+  UnitCell* unitcell = mol2.unitCell();
+  if (unitcell) {
+    const Matrix3& mat = unitcell->cellMatrix().transpose();
+    low = Vector3::Zero();
+    high = mat.diagonal();
+    tilt = Vector3(mat(1, 0), mat(2, 0), mat(2, 1));
+  } else {
+    low = minimum - Vector3::Constant(0.5);
+    high = maximum - Vector3::Constant(0.5);
+    tilt = Vector3::Zero();
+  }
+  const char* const boxLabels[3] = { " xlo xhi\n", " ylo yhi\n",
+                                     " zlo zhi\n" };
+  for (int i = 0; i < 3; ++i) {
+    out.writeFixed(low[i], 6, 10).write(' ').writeFixed(high[i], 6, 10);
+    out.write(boxLabels[i]);
+  }
+  out.writeFixed(tilt[0], 6, 10).write(' ').writeFixed(tilt[1], 6, 10);
+  out.write(' ').writeFixed(tilt[2], 6, 10).write(" xy xz yz\n\n\n");
 
   // Masses
-  massStream << "Masses\n\n";
+  out.write("Masses\n\n");
   std::map<unsigned char, size_t>::iterator iter = composition.begin();
   while (iter != composition.end()) {
-    massStream << iter->second << "   " << Elements::mass(iter->first) << "\n";
+    out.writeInteger(static_cast<long long>(iter->second)).write("   ");
+    out.writeShortest(Elements::mass(iter->first)).write('\n');
     ++iter;
   }
-  massStream << std::endl << std::endl << std::endl;
+  out.write("\n\n\n");
+
+  const int indexWidth = numAtoms ? static_cast<int>(log(numAtoms)) + 1 : 1;
 
   if (numAtoms) {
     // Atomic coordinates
-    atomStream << "Atoms\n\n";
+    out.write("Atoms\n\n");
     for (Index i = 0; i < numAtoms; ++i) {
-      Atom atom = mol2.atom(i);
-      if (!atom.isValid()) {
-        appendError("Internal error: Atom invalid.");
-        return false;
-      }
-      Vector3 coords = atom.position3d();
-      if (i == 0) {
-        xmin = coords[0];
-        xmax = coords[0];
-        ymin = coords[1];
-        ymax = coords[1];
-        zmin = coords[2];
-        zmax = coords[2];
-      } else {
-        xmin = std::min(coords[0], xmin);
-        xmax = std::max(coords[0], xmax);
-        ymin = std::min(coords[1], ymin);
-        ymax = std::max(coords[1], ymax);
-        zmin = std::min(coords[2], zmin);
-        zmax = std::max(coords[2], zmax);
-      }
-
-      char atomline[200];
-      sprintf(atomline, "%-*d %d %10f %10f %10f\n",
-              static_cast<int>(log(numAtoms)) + 1, static_cast<int>(i + 1),
-              static_cast<int>(composition[atomicNumbers[i]]), coords.x(),
-              coords.y(), coords.z());
-      atomStream << atomline;
+      const Vector3 coords = mol2.atomPosition3d(i);
+      out.writeInteger(static_cast<long long>(i + 1), indexWidth,
+                       TextWriter::Left);
+      out.write(' ').writeInteger(
+        static_cast<long long>(composition[atomicNumbers[i]]));
+      out.write(' ').writeFixed(coords.x(), 6, 10);
+      out.write(' ').writeFixed(coords.y(), 6, 10);
+      out.write(' ').writeFixed(coords.z(), 6, 10).write('\n');
     }
 
-    atomStream << std::endl << std::endl;
+    out.write("\n\n");
   }
 
   if (numBonds) {
-    // Bonds
+    // Bonds, typed by the pair of elements they join.
     std::map<std::pair<unsigned char, unsigned char>, int> bondIds;
     int bondItr = 1;
-    bondStream << "Bonds\n\n";
+    out.write("Bonds\n\n");
     for (Index i = 0; i < numBonds; ++i) {
-      char bondline[200];
       Bond b = mol2.bond(i);
-      if (bondIds.find(std::make_pair(b.atom1().atomicNumber(),
-                                      b.atom2().atomicNumber())) !=
-          bondIds.end()) {
-        sprintf(bondline, "%-*d %7d %7d %7d\n",
-                static_cast<int>(log(numAtoms) + 1), static_cast<int>(i + 1),
-                bondIds[std::make_pair(b.atom1().atomicNumber(),
-                                       b.atom2().atomicNumber())],
-                static_cast<int>(b.atom1().index() + 1),
-                static_cast<int>(b.atom2().index() + 1));
-        bondStream << bondline;
-      } else if (bondIds.find(std::make_pair(b.atom2().atomicNumber(),
-                                             b.atom1().atomicNumber())) !=
-                 bondIds.end()) {
-        sprintf(bondline, "%-*d %7d %7d %7d\n",
-                static_cast<int>(log(numAtoms) + 1), static_cast<int>(i + 1),
-                bondIds[std::make_pair(b.atom1().atomicNumber(),
-                                       b.atom2().atomicNumber())],
-                static_cast<int>(b.atom2().index() + 1),
-                static_cast<int>(b.atom1().index() + 1));
-        bondStream << bondline;
-      } else {
-        bondIds.insert(std::make_pair(
-          std::make_pair(b.atom1().atomicNumber(), b.atom2().atomicNumber()),
-          bondItr++));
-        sprintf(bondline, "%-*d %7d %7d %7d\n",
-                static_cast<int>(log(numAtoms) + 1), static_cast<int>(i + 1),
-                bondIds[std::make_pair(b.atom1().atomicNumber(),
-                                       b.atom2().atomicNumber())],
-                static_cast<int>(b.atom1().index() + 1),
-                static_cast<int>(b.atom2().index() + 1));
-        bondStream << bondline;
+      Index first = b.atom1().index();
+      Index second = b.atom2().index();
+      std::pair<unsigned char, unsigned char> key(b.atom1().atomicNumber(),
+                                                  b.atom2().atomicNumber());
+      std::map<std::pair<unsigned char, unsigned char>, int>::const_iterator
+        type = bondIds.find(key);
+      if (type == bondIds.end()) {
+        type = bondIds.find(std::make_pair(key.second, key.first));
+        if (type != bondIds.end())
+          std::swap(first, second);
+        else
+          type = bondIds.insert(std::make_pair(key, bondItr++)).first;
       }
+      out.writeInteger(static_cast<long long>(i + 1), indexWidth,
+                       TextWriter::Left);
+      out.write(' ').writeInteger(type->second, 7);
+      out.write(' ').writeInteger(static_cast<long long>(first + 1), 7);
+      out.write(' ').writeInteger(static_cast<long long>(second + 1), 7);
+      out.write('\n');
     }
   }
 
-  UnitCell* unitcell = mol2.unitCell();
-  char simBoxBlock[200];
-  if (unitcell) {
-    const Matrix3& mat = unitcell->cellMatrix().transpose();
-    sprintf(simBoxBlock,
-            "%10f %10f xlo xhi\n%10f %10f ylo yhi\n%10f %10f zlo zhi\n%10f "
-            "%10f %10f xy xz yz",
-            0.0, mat(0, 0), 0.0, mat(1, 1), 0.0, mat(2, 2), mat(1, 0),
-            mat(2, 0), mat(2, 1));
-    outStream << simBoxBlock;
-  } else {
-    sprintf(simBoxBlock,
-            "%10f %10f xlo xhi\n%10f %10f ylo yhi\n%10f %10f zlo zhi\n%10f "
-            "%10f %10f xy xz yz",
-            xmin - 0.5, xmax - 0.5, ymin - 0.5, ymax - 0.5, zmin - 0.5,
-            zmax - 0.5, 0.0, 0.0, 0.0);
-    outStream << simBoxBlock;
-  }
-  outStream << std::endl << std::endl << std::endl;
-  outStream << massStream.str();
-  outStream << atomStream.str();
-  outStream << bondStream.str();
-
-  return true;
+  return out.good();
 }
 
 std::vector<std::string> LammpsDataFormat::fileExtensions() const
@@ -16,12 +16,13 @@
 
 #include "mdlformat.h"
 
+#include "textwriter.h"
+
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/utilities.h>
 #include <avogadro/core/vector.h>
 
-#include <iomanip>
 #include <istream>
 #include <ostream>
 #include <sstream>
@@ -38,8 +39,6 @@ using Avogadro::Core::trimmed;
 using std::string;
 using std::istringstream;
 using std::getline;
-using std::setw;
-using std::setprecision;
 
 namespace Avogadro {
 namespace Io {
@@ -202,36 +201,40 @@ bool MdlFormat::read(std::istream& in, Core::Molecule& mol)
   return true;
 }
 
-bool MdlFormat::write(std::ostream& out, const Core::Molecule& mol)
+bool MdlFormat::write(std::ostream& stream, const Core::Molecule& mol)
 {
+  TextWriter out(stream);
   // Header lines.
-  out << mol.data("name").toString() << "\n  Avogadro\n\n";
+  out.write(mol.data("name").toString()).write("\n  Avogadro\n\n");
   // Counts line.
-  out << setw(3) << std::right << mol.atomCount() << setw(3) << mol.bondCount()
-      << "  0  0  0  0  0  0  0  0999 V2000\n";
+  out.writeInteger(static_cast<long long>(mol.atomCount()), 3)
+    .writeInteger(static_cast<long long>(mol.bondCount()), 3)
+    .write("  0  0  0  0  0  0  0  0999 V2000\n");
   // Atom block.
   for (size_t i = 0; i < mol.atomCount(); ++i) {
     Atom atom = mol.atom(i);
-    out << setw(10) << std::right << std::fixed << setprecision(4)
-        << atom.position3d().x() << setw(10) << atom.position3d().y()
-        << setw(10) << atom.position3d().z() << " " << setw(3) << std::left
-        << Elements::symbol(atom.atomicNumber())
-        << "  0  0  0  0  0  0  0  0  0  0  0  0\n";
+    const Vector3 pos = atom.position3d();
+    out.writeFixed(pos.x(), 4, 10)
+      .writeFixed(pos.y(), 4, 10)
+      .writeFixed(pos.z(), 4, 10)
+      .write(' ')
+      .writePadded(Elements::symbol(atom.atomicNumber()), 3)
+      .write("  0  0  0  0  0  0  0  0  0  0  0  0\n");
   }
   // Bond block.
   for (size_t i = 0; i < mol.bondCount(); ++i) {
     Bond bond = mol.bond(i);
-    out.unsetf(std::ios::floatfield);
-    out << setw(3) << std::right << bond.atom1().index() + 1 << setw(3)
-        << bond.atom2().index() + 1 << setw(3) << static_cast<int>(bond.order())
-        << "  0  0  0  0\n";
+    out.writeInteger(static_cast<long long>(bond.atom1().index() + 1), 3)
+      .writeInteger(static_cast<long long>(bond.atom2().index() + 1), 3)
+      .writeInteger(bond.order(), 3)
+      .write("  0  0  0  0\n");
   }
-  out << "M  END\n";
+  out.write("M  END\n");
 
   if (isMode(FileFormat::MultiMolecule))
-    out << "$$$$\n";
+    out.write("$$$$\n");
 
-  return true;
+  return out.good();
 }
 
 std::vector<std::string> MdlFormat::fileExtensions() const
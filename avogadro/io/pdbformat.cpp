@@ -42,6 +42,8 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
   Array<Vector3> positions;
 
   while (getline(in, buffer)) { // Read Each line one by one
+    if (!updateProgress(in))
+      return false;
 
     if (startsWith(buffer, "ENDMDL")) {
       if (coordSet == 0) {
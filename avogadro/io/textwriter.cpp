@@ -0,0 +1,272 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "textwriter.h"
+
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+
+namespace Avogadro {
+namespace Io {
+
+namespace {
+
+const int maxFastPrecision = 15;
+const double powersOfTen[maxFastPrecision + 1] = {
+  1e0, 1e1, 1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+  1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+// Enough for any number formatted without printf.
+const size_t fieldSize = 32;
+
+// Write the digits of n so that they end at end, returning the first digit.
+inline char* formatUnsigned(unsigned long long n, char* end)
+{
+  do {
+    *--end = static_cast<char>('0' + n % 10);
+    n /= 10;
+  } while (n);
+  return end;
+}
+
+inline size_t formatInteger(long long value, char* out)
+{
+  char digits[fieldSize];
+  char* end = digits + fieldSize;
+  unsigned long long n = static_cast<unsigned long long>(value);
+  if (value < 0)
+    n = 0ull - n;
+  char* begin = formatUnsigned(n, end);
+  if (value < 0)
+    *--begin = '-';
+  std::memcpy(out, begin, end - begin);
+  return end - begin;
+}
+
+// Format as printf's "%.*f" does, or return 0 if printf is needed. The value
+// is scaled and rounded to an integer, which is only different from rounding
+// the exact decimal expansion as printf does when the scaled value is within
+// rounding error of a tie, those values and large ones are left to printf.
+size_t formatFixed(double value, int precision, char* out)
+{
+  if (precision < 0 || precision > maxFastPrecision || !std::isfinite(value))
+    return 0;
+  double scaled = std::fabs(value) * powersOfTen[precision];
+  if (scaled >= 1e15)
+    return 0;
+  double whole = std::floor(scaled);
+  double fraction = scaled - whole;
+  if (std::fabs(fraction - 0.5) <= scaled * 4e-16)
+    return 0;
+
+  unsigned long long n =
+    static_cast<unsigned long long>(whole) + (fraction > 0.5 ? 1 : 0);
+  char digits[fieldSize];
+  char* end = digits + fieldSize;
+  char* begin = formatUnsigned(n, end);
+  int count = static_cast<int>(end - begin);
+
+  char* p = out;
+  if (std::signbit(value))
+    *p++ = '-';
+  if (count <= precision) {
+    *p++ = '0';
+    if (precision > 0) {
+      *p++ = '.';
+      for (int i = count; i < precision; ++i)
+        *p++ = '0';
+      std::memcpy(p, begin, count);
+      p += count;
+    }
+  } else {
+    std::memcpy(p, begin, count - precision);
+    p += count - precision;
+    if (precision > 0) {
+      *p++ = '.';
+      std::memcpy(p, end - precision, precision);
+      p += precision;
+    }
+  }
+  return p - out;
+}
+
+// printf follows LC_NUMERIC, which applications may set from the user's
+// environment, file formats always use a period.
+void fixDecimalPoint(std::string& text)
+{
+  const char point = *std::localeconv()->decimal_point;
+  if (point != '.')
+    std::replace(text.begin(), text.end(), point, '.');
+}
+
+std::string printfFixed(double value, int precision)
+{
+  int length = std::snprintf(nullptr, 0, "%.*f", precision, value);
+  if (length <= 0)
+    return std::string();
+  std::string text(length + 1, '\0');
+  std::snprintf(&text[0], text.size(), "%.*f", precision, value);
+  text.resize(length);
+  fixDecimalPoint(text);
+  return text;
+}
+
+std::string printfShortest(double value)
+{
+  char text[fieldSize];
+  if (!std::isfinite(value)) {
+    std::snprintf(text, fieldSize, "%g", value);
+  } else {
+    for (int digits = 15; digits <= 17; ++digits) {
+      std::snprintf(text, fieldSize, "%.*g", digits, value);
+      if (std::strtod(text, nullptr) == value)
+        break;
+    }
+  }
+  std::string result(text);
+  fixDecimalPoint(result);
+  return result;
+}
+
+} // namespace
+
+TextWriter::TextWriter(std::ostream& stream, size_t bufferSize)
+  : m_stream(stream), m_buffer(std::max(bufferSize, 4 * fieldSize)), m_size(0),
+    m_written(0)
+{
+}
+
+TextWriter::~TextWriter()
+{
+  flush();
+}
+
+TextWriter& TextWriter::write(char c)
+{
+  *reserve(1) = c;
+  return *this;
+}
+
+TextWriter& TextWriter::write(const char* text)
+{
+  return write(text, std::strlen(text));
+}
+
+TextWriter& TextWriter::write(const char* text, size_t length)
+{
+  if (length > m_buffer.size()) {
+    flush();
+    m_stream.write(text, length);
+    m_written += length;
+  } else {
+    std::memcpy(reserve(length), text, length);
+  }
+  return *this;
+}
+
+TextWriter& TextWriter::write(const std::string& text)
+{
+  return write(text.data(), text.size());
+}
+
+TextWriter& TextWriter::writePadded(const std::string& text, int width,
+                                    Alignment alignment)
+{
+  append(text.data(), text.size(), width, alignment);
+  return *this;
+}
+
+TextWriter& TextWriter::writeInteger(long long value, int width,
+                                     Alignment alignment)
+{
+  char text[fieldSize];
+  append(text, formatInteger(value, text), width, alignment);
+  return *this;
+}
+
+TextWriter& TextWriter::writeFixed(double value, int precision, int width,
+                                   Alignment alignment)
+{
+  char text[fieldSize];
+  size_t length = formatFixed(value, precision, text);
+  if (length) {
+    append(text, length, width, alignment);
+  } else {
+    std::string slow = printfFixed(value, precision);
+    append(slow.data(), slow.size(), width, alignment);
+  }
+  return *this;
+}
+
+TextWriter& TextWriter::writeShortest(double value, int width,
+                                      Alignment alignment)
+{
+  // Whole numbers are common (charges, counts stored as doubles), and need no
+  // search for the number of digits.
+  if (std::fabs(value) < 1e15 && value == std::floor(value) &&
+      !(value == 0.0 && std::signbit(value))) {
+    return writeInteger(static_cast<long long>(value), width, alignment);
+  }
+  std::string text = printfShortest(value);
+  append(text.data(), text.size(), width, alignment);
+  return *this;
+}
+
+void TextWriter::flush()
+{
+  if (m_size) {
+    m_stream.write(m_buffer.data(), m_size);
+    m_written += m_size;
+    m_size = 0;
+  }
+}
+
+bool TextWriter::good()
+{
+  flush();
+  return m_stream.good();
+}
+
+char* TextWriter::reserve(size_t length)
+{
+  if (m_size + length > m_buffer.size())
+    flush();
+  char* result = m_buffer.data() + m_size;
+  m_size += length;
+  return result;
+}
+
+void TextWriter::append(const char* text, size_t length, int width,
+                        Alignment alignment)
+{
+  size_t padding =
+    width > 0 && length < static_cast<size_t>(width) ? width - length : 0;
+  if (length + padding > m_buffer.size()) {
+    if (alignment == Right)
+      write(std::string(padding, ' '));
+    write(text, length);
+    if (alignment == Left)
+      write(std::string(padding, ' '));
+    return;
+  }
+
+  char* out = reserve(length + padding);
+  if (alignment == Right) {
+    std::memset(out, ' ', padding);
+    out += padding;
+  }
+  std::memcpy(out, text, length);
+  if (alignment == Left)
+    std::memset(out + length, ' ', padding);
+}
+
+} // end Io namespace
+} // end Avogadro namespace
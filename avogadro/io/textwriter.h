@@ -0,0 +1,103 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_IO_TEXTWRITER_H
+#define AVOGADRO_IO_TEXTWRITER_H
+
+#include "avogadroioexport.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace Avogadro {
+namespace Io {
+
+/**
+ * @class TextWriter textwriter.h <avogadro/io/textwriter.h>
+ * @brief Buffered writer for the numeric columns of text file formats.
+ *
+ * Numbers are formatted straight into a character buffer that is passed to
+ * the stream in large blocks, instead of going through the locale and
+ * manipulator machinery of std::ostream for every field. The output matches
+ * printf: writeFixed(x, 5, 10) writes the same characters as "%10.5f".
+ *
+ * The buffer is flushed when it fills up, by flush() and on destruction. Do
+ * not write to the stream directly while a TextWriter holds unflushed text.
+ */
+class AVOGADROIO_EXPORT TextWriter
+{
+public:
+  /** How a field is padded to its width. */
+  enum Alignment
+  {
+    Left,
+    Right
+  };
+
+  explicit TextWriter(std::ostream& stream, size_t bufferSize = 65536);
+  ~TextWriter();
+
+  /** Write text verbatim. @{ */
+  TextWriter& write(char c);
+  TextWriter& write(const char* text);
+  TextWriter& write(const char* text, size_t length);
+  TextWriter& write(const std::string& text);
+  /** @} */
+
+  /** Write @a text padded with spaces to at least @a width characters. */
+  TextWriter& writePadded(const std::string& text, int width,
+                          Alignment alignment = Left);
+
+  /** Write an integer, padded to at least @a width characters. */
+  TextWriter& writeInteger(long long value, int width = 0,
+                           Alignment alignment = Right);
+
+  /**
+   * Write @a value with @a precision digits after the decimal point, padded
+   * to at least @a width characters, as printf's "%*.*f" does.
+   */
+  TextWriter& writeFixed(double value, int precision, int width = 0,
+                         Alignment alignment = Right);
+
+  /**
+   * Write @a value with the fewest significant digits, from 15 to 17, that
+   * read back as the same double. Values that need no more than 15 digits,
+   * such as those typed in by hand, are written as typed: 0.1 is "0.1".
+   */
+  TextWriter& writeShortest(double value, int width = 0,
+                            Alignment alignment = Right);
+
+  /** Pass the buffered text to the stream. */
+  void flush();
+
+  /** @return The number of characters written so far. */
+  size_t bytesWritten() const { return m_written + m_size; }
+
+  /** @return The state of the stream, after flushing the buffer. */
+  bool good();
+
+private:
+  TextWriter(const TextWriter&);            // Not implemented.
+  TextWriter& operator=(const TextWriter&); // Not implemented.
+
+  /** @return Space for @a length characters at the end of the buffer. */
+  char* reserve(size_t length);
+
+  /** Pad the @a length characters at @a text and append them. */
+  void append(const char* text, size_t length, int width,
+              Alignment alignment);
+
+  std::ostream& m_stream;
+  std::vector<char> m_buffer;
+  size_t m_size;
+  size_t m_written;
+};
+
+} // end Io namespace
+} // end Avogadro namespace
+
+#endif // AVOGADRO_IO_TEXTWRITER_H
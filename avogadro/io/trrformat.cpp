@@ -277,6 +277,8 @@ bool TrrFormat::read(std::istream& inStream, Core::Molecule& mol)
   // EOF check
   int coordSet = 1;
   while (static_cast<int>(inStream.tellg()) != fileLen) {
+    if (!updateProgress(inStream))
+      return false;
     // Binary header must start with 1993
     snprintf(fmt, sizeof(fmt), "%c1i", endian);
     inStream.read(buff, struct_calcsize(fmt));
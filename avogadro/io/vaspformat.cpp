@@ -16,6 +16,8 @@
 
 #include "vaspformat.h"
 
+#include "textwriter.h"
+
 #include <avogadro/core/elements.h> // for atomicNumberFromSymbol()
 #include <avogadro/core/matrix.h>   // for matrix3
 #include <avogadro/core/molecule.h>
@@ -24,7 +26,6 @@
 #include <avogadro/core/vector.h>    // for Vector3
 
 #include <algorithm> // for std::count()
-#include <iomanip>
 #include <iostream>
 
 namespace Avogadro {
@@ -241,23 +242,23 @@ bool PoscarFormat::read(std::istream& inStream, Core::Molecule& mol)
 
 bool PoscarFormat::write(std::ostream& outStream, const Core::Molecule& mol)
 {
+  TextWriter out(outStream);
+
   // Title
   if (mol.data("name").toString().length())
-    outStream << mol.data("name").toString() << std::endl;
+    out.write(mol.data("name").toString()).write('\n');
   else
-    outStream << "POSCAR" << std::endl;
+    out.write("POSCAR\n");
 
   // Scaling factor
-  outStream << " 1.00000000" << std::endl;
+  out.write(" 1.00000000\n");
 
   // 3x3 matrix. Transpose is needed to orient the matrix correctly.
   const Matrix3& mat = mol.unitCell()->cellMatrix().transpose();
   for (size_t i = 0; i < 3; ++i) {
-    for (size_t j = 0; j < 3; ++j) {
-      outStream << "   " << std::setw(10) << std::right << std::fixed
-                << std::setprecision(8) << mat(i, j);
-    }
-    outStream << std::endl;
+    for (size_t j = 0; j < 3; ++j)
+      out.write("   ").writeFixed(mat(i, j), 8, 10);
+    out.write('\n');
   }
 
   // Adapted from chemkit:
@@ -273,21 +274,21 @@ bool PoscarFormat::write(std::ostream& outStream, const Core::Molecule& mol)
   // Atom symbols
   std::map<unsigned char, size_t>::iterator iter = composition.begin();
   while (iter != composition.end()) {
-    outStream << "   " << Elements::symbol(iter->first);
+    out.write("   ").write(Elements::symbol(iter->first));
     ++iter;
   }
-  outStream << std::endl;
+  out.write('\n');
 
   // Numbers of each type
   iter = composition.begin();
   while (iter != composition.end()) {
-    outStream << "   " << iter->second;
+    out.write("   ").writeInteger(static_cast<long long>(iter->second));
     ++iter;
   }
-  outStream << std::endl;
+  out.write('\n');
 
   // Direct or cartesian?
-  outStream << "Direct" << std::endl;
+  out.write("Direct\n");
 
   // Final section is atomic coordinates
   size_t numAtoms = mol.atomCount();
@@ -308,17 +309,14 @@ bool PoscarFormat::write(std::ostream& outStream, const Core::Molecule& mol)
         return false;
       }
       Vector3 fracCoords = mol.unitCell()->toFractional(atom.position3d());
-      outStream << "  " << std::setw(10) << std::right << std::fixed
-                << std::setprecision(8) << fracCoords.x() << "  "
-                << std::setw(10) << std::right << std::fixed
-                << std::setprecision(8) << fracCoords.y() << "  "
-                << std::setw(10) << std::right << std::fixed
-                << std::setprecision(8) << fracCoords.z() << "\n";
+      out.write("  ").writeFixed(fracCoords.x(), 8, 10);
+      out.write("  ").writeFixed(fracCoords.y(), 8, 10);
+      out.write("  ").writeFixed(fracCoords.z(), 8, 10).write('\n');
     }
     ++iter;
   }
 
-  return true;
+  return out.good();
 }
 
 std::vector<std::string> PoscarFormat::fileExtensions() const
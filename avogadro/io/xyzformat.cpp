@@ -16,6 +16,8 @@
 
 #include "xyzformat.h"
 
+#include "textwriter.h"
+
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/utilities.h>
@@ -23,7 +25,6 @@
 
 #include <nlohmann/json.hpp>
 
-#include <iomanip>
 #include <istream>
 #include <ostream>
 #include <sstream>
@@ -82,6 +83,8 @@ bool XyzFormat::read(std::istream& inStream, Core::Molecule& mol)
 
   // Parse atoms
   for (size_t i = 0; i < numAtoms; ++i) {
+    if (!updateProgress(inStream))
+      return false;
     getline(inStream, buffer);
     vector<string> tokens(split(buffer, ' '));
 
@@ -121,6 +124,8 @@ bool XyzFormat::read(std::istream& inStream, Core::Molecule& mol)
     mol.setCoordinate3d(mol.atomPositions3d(), 0);
     int coordSet = 1;
     while (numAtoms == numAtoms2) {
+      if (!updateProgress(inStream))
+        return false;
       Array<Vector3> positions;
       positions.reserve(numAtoms);
 
@@ -160,12 +165,13 @@ bool XyzFormat::read(std::istream& inStream, Core::Molecule& mol)
 bool XyzFormat::write(std::ostream& outStream, const Core::Molecule& mol)
 {
   size_t numAtoms = mol.atomCount();
+  TextWriter out(outStream);
 
-  outStream << numAtoms << std::endl;
+  out.writeInteger(static_cast<long long>(numAtoms)).write('\n');
   if (mol.data("name").toString().length())
-    outStream << mol.data("name").toString() << endl;
+    out.write(mol.data("name").toString()).write('\n');
   else
-    outStream << "XYZ file generated by Avogadro.\n";
+    out.write("XYZ file generated by Avogadro.\n");
 
   for (size_t i = 0; i < numAtoms; ++i) {
     Atom atom = mol.atom(i);
@@ -174,16 +180,14 @@ bool XyzFormat::write(std::ostream& outStream, const Core::Molecule& mol)
       return false;
     }
 
-    outStream << std::setw(3) << std::left
-              << Elements::symbol(atom.atomicNumber()) << " " << std::setw(10)
-              << std::right << std::fixed << std::setprecision(5)
-              << atom.position3d().x() << " " << std::setw(10) << std::right
-              << std::fixed << std::setprecision(5) << atom.position3d().y()
-              << " " << std::setw(10) << std::right << std::fixed
-              << std::setprecision(5) << atom.position3d().z() << "\n";
+    const Vector3 pos = atom.position3d();
+    out.writePadded(Elements::symbol(atom.atomicNumber()), 3).write(' ');
+    out.writeFixed(pos.x(), 5, 10).write(' ');
+    out.writeFixed(pos.y(), 5, 10).write(' ');
+    out.writeFixed(pos.z(), 5, 10).write('\n');
   }
 
-  return true;
+  return out.good();
 }
 
 std::vector<std::string> XyzFormat::fileExtensions() const
@@ -15,6 +15,7 @@
 ******************************************************************************/
 
 #include "batchjob.h"
+#include "localjobexecutor.h"
 #include "molequeuemanager.h"
 
 #include <QtCore/QDebug>
@@ -32,13 +33,13 @@ const BatchJob::RequestId BatchJob::InvalidRequestId = -1;
 const BatchJob::ServerId BatchJob::InvalidServerId =
   std::numeric_limits<BatchJob::ServerId>::max();
 
-BatchJob::BatchJob(QObject* par) : QObject(par)
+BatchJob::BatchJob(QObject* par) : QObject(par), m_localExecutor(nullptr)
 {
   setup();
 }
 
 BatchJob::BatchJob(const QString& scriptFilePath, QObject* par)
-  : QObject(par), m_inputGenerator(scriptFilePath)
+  : QObject(par), m_inputGenerator(scriptFilePath), m_localExecutor(nullptr)
 {
   setup();
 }
@@ -48,6 +49,12 @@ BatchJob::~BatchJob()
 }
 
 BatchJob::BatchId BatchJob::submitNextJob(const Core::Molecule& mol)
+{
+  return submitNextJob(mol, QList<BatchId>());
+}
+
+BatchJob::BatchId BatchJob::submitNextJob(const Core::Molecule& mol,
+                                          const QList<BatchId>& dependencies)
 {
   // Is everything configured?
   if (!m_inputGenerator.isValid() || m_inputGeneratorOptions.empty() ||
@@ -55,43 +62,45 @@ BatchJob::BatchId BatchJob::submitNextJob(const Core::Molecule& mol)
     return InvalidBatchId;
   }
 
-  // Verify that molequeue is running:
-  MoleQueueManager& mqManager = MoleQueueManager::instance();
-  if (!mqManager.connectIfNeeded())
-    return InvalidBatchId;
-
-  // Generate the input:
-  if (!m_inputGenerator.generateInput(m_inputGeneratorOptions, mol)) {
-    if (!m_inputGenerator.errorList().isEmpty()) {
-      qWarning() << "BatchJob::submitNextJob() error:\n\t"
-                 << m_inputGenerator.errorList().join("\n\t");
+  if (m_localExecutor) {
+    QList<int> localDependencies;
+    foreach (BatchId dependency, dependencies) {
+      if (!m_localJobIds.contains(dependency))
+        return InvalidBatchId;
+      localDependencies << m_localJobIds.value(dependency);
     }
-    return InvalidBatchId;
+
+    BatchId bId = m_jobObjects.size();
+    ::MoleQueue::JobObject job;
+    if (!generateJob(mol, bId, job))
+      return InvalidBatchId;
+
+    int localId = m_localExecutor->submit(job, localDependencies);
+    if (localId < 0)
+      return InvalidBatchId;
+
+    m_jobObjects.push_back(m_localExecutor->job(localId));
+    m_states.push_back(stringToState(m_localExecutor->jobState(localId)));
+    m_localIds.insert(localId, bId);
+    m_localJobIds.insert(bId, localId);
+    return bId;
   }
 
-  // Warnings are non-fatal -- just print them for now:
-  if (!m_inputGenerator.warningList().isEmpty()) {
-    qWarning() << "BatchJob::submitNextJob() warning:\n\t"
-               << m_inputGenerator.warningList().join("\n\t");
+  if (!dependencies.isEmpty()) {
+    qWarning() << "BatchJob::submitNextJob(): job dependencies require a "
+                  "local executor.";
+    return InvalidBatchId;
   }
 
-  BatchId bId = m_jobObjects.size();
+  // Verify that molequeue is running:
+  MoleQueueManager& mqManager = MoleQueueManager::instance();
+  if (!mqManager.connectIfNeeded())
+    return InvalidBatchId;
 
-  // Create the job object:
+  BatchId bId = m_jobObjects.size();
   ::MoleQueue::JobObject job;
-  job.fromJson(m_moleQueueOptions);
-  job.setDescription(
-    tr("Batch Job #%L1 (%2)").arg(bId + 1).arg(job.description()));
-
-  // Main input file:
-  const QString mainFileName = m_inputGenerator.mainFileName();
-  job.setInputFile(mainFileName, m_inputGenerator.fileContents(mainFileName));
-
-  // Any additional input files:
-  QStringList fileNames = m_inputGenerator.fileNames();
-  fileNames.removeOne(mainFileName);
-  foreach (const QString& fn, fileNames)
-    job.appendAdditionalInputFile(fn, m_inputGenerator.fileContents(fn));
+  if (!generateJob(mol, bId, job))
+    return InvalidBatchId;
 
   // Submit the job
   RequestId rId = mqManager.client().submitJob(job);
@@ -108,8 +117,30 @@ BatchJob::BatchId BatchJob::submitNextJob(const Core::Molecule& mol)
   return bId;
 }
 
+void BatchJob::setLocalExecutor(LocalJobExecutor* executor)
+{
+  if (m_localExecutor == executor)
+    return;
+  if (m_localExecutor)
+    m_localExecutor->disconnect(this);
+
+  m_localExecutor = executor;
+  m_localIds.clear();
+  m_localJobIds.clear();
+  if (m_localExecutor) {
+    connect(m_localExecutor, SIGNAL(jobStateChanged(int, QString, QString)),
+            SLOT(handleLocalJobStateChange(int, QString, QString)));
+  }
+}
+
 bool BatchJob::lookupJob(BatchId bId)
 {
+  if (m_localExecutor && m_localJobIds.contains(bId)) {
+    m_jobObjects[bId] = m_localExecutor->job(m_localJobIds.value(bId));
+    emit jobUpdated(bId, true);
+    return true;
+  }
+
   ServerId sId = serverId(static_cast<BatchId>(bId));
   if (sId == InvalidServerId)
     return false;
@@ -209,6 +240,58 @@ void BatchJob::handleErrorResponse(int requestId, int errorCode,
   }
 }
 
+void BatchJob::handleLocalJobStateChange(int localId, const QString&,
+                                         const QString& newState)
+{
+  BatchId bId = m_localIds.value(localId, InvalidBatchId);
+  if (bId == InvalidBatchId || bId >= m_jobObjects.size())
+    return;
+
+  m_jobObjects[bId] = m_localExecutor->job(localId);
+  JobState oldState = m_states[bId];
+  JobState state = stringToState(newState);
+  m_states[bId] = state;
+  emit jobUpdated(bId, true);
+  if (!isTerminal(oldState) && isTerminal(state))
+    emit jobCompleted(bId, state);
+}
+
+bool BatchJob::generateJob(const Core::Molecule& mol, BatchId bId,
+                           ::MoleQueue::JobObject& job)
+{
+  // Generate the input:
+  if (!m_inputGenerator.generateInput(m_inputGeneratorOptions, mol)) {
+    if (!m_inputGenerator.errorList().isEmpty()) {
+      qWarning() << "BatchJob::submitNextJob() error:\n\t"
+                 << m_inputGenerator.errorList().join("\n\t");
+    }
+    return false;
+  }
+
+  // Warnings are non-fatal -- just print them for now:
+  if (!m_inputGenerator.warningList().isEmpty()) {
+    qWarning() << "BatchJob::submitNextJob() warning:\n\t"
+               << m_inputGenerator.warningList().join("\n\t");
+  }
+
+  // Create the job object:
+  job.fromJson(m_moleQueueOptions);
+  job.setDescription(
+    tr("Batch Job #%L1 (%2)").arg(bId + 1).arg(job.description()));
+
+  // Main input file:
+  const QString mainFileName = m_inputGenerator.mainFileName();
+  job.setInputFile(mainFileName, m_inputGenerator.fileContents(mainFileName));
+
+  // Any additional input files:
+  QStringList fileNames = m_inputGenerator.fileNames();
+  fileNames.removeOne(mainFileName);
+  foreach (const QString& fn, fileNames)
+    job.appendAdditionalInputFile(fn, m_inputGenerator.fileContents(fn));
+
+  return true;
+}
+
 void BatchJob::setup()
 {
   static bool metaTypesRegistered = false;
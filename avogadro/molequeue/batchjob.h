@@ -27,6 +27,7 @@
 
 #include <QtCore/QJsonObject>
 #include <QtCore/QMap>
+#include <QtCore/QPointer>
 #include <QtCore/QVector>
 
 namespace Avogadro {
@@ -35,11 +36,17 @@ class Molecule;
 } // end namespace Core
 
 namespace MoleQueue {
+class LocalJobExecutor;
 
 /**
  * @brief The BatchJob class manages a collection of jobs that are configured
  * using the same InputGenerator and MoleQueue options. For use with
  * InputGeneratorDialog::configureBatchJob(BatchJob&).
+ *
+ * Jobs are submitted to the MoleQueue server by default. After
+ * setLocalExecutor() they run as local processes instead, which avoids a
+ * server round trip per job for large batches and lets jobs depend on each
+ * other. The rest of the interface behaves the same for both.
  */
 class AVOGADROMOLEQUEUE_EXPORT BatchJob : public QObject
 {
@@ -110,6 +117,17 @@ public:
   ::MoleQueue::JobObject moleQueueJobTemplate() const;
   /**@}*/
 
+  /**
+   * Run the jobs submitted from now on with @a executor instead of the
+   * MoleQueue server. The executor is not owned by the batch job. Pass
+   * nullptr to go back to MoleQueue. Jobs already submitted to a previous
+   * executor are no longer updated, so set this before submitting.
+   * @{
+   */
+  void setLocalExecutor(LocalJobExecutor* executor);
+  LocalJobExecutor* localExecutor() const { return m_localExecutor; }
+  /**@}*/
+
   /**
    * The internal InputGenerator.
    * @{
@@ -172,9 +190,19 @@ public slots:
    */
   virtual BatchId submitNextJob(const Core::Molecule& mol);
 
+  /**
+   * Submit a job for @a mol that only starts once all jobs in @a dependencies
+   * finished, and is canceled if any of them fails. Dependencies need a
+   * local executor, as the MoleQueue server does not support them.
+   * @return The BatchId of the job, or InvalidBatchId if there was an error.
+   */
+  BatchId submitNextJob(const Core::Molecule& mol,
+                        const QList<BatchId>& dependencies);
+
   /**
    * Request updated job details from the MoleQueue server for the job with
-   * the batch id @a batchId.
+   * the batch id @a batchId. Jobs run by the local executor are updated at
+   * once.
    *
    * jobUpdated is emitted when the request is complete.
    *
@@ -206,6 +234,8 @@ private slots:
   void handleErrorResponse(int requestId, int errorCode,
                            const QString& errorMessage,
                            const QJsonValue& errorData);
+  void handleLocalJobStateChange(int localId, const QString& oldState,
+                                 const QString& newState);
 
 private: // structs
   /**
@@ -228,6 +258,8 @@ private: // structs
 
 private: // methods
   void setup();
+  bool generateJob(const Core::Molecule& mol, BatchId batchId,
+                   ::MoleQueue::JobObject& job);
   static JobState stringToState(const QString& string);
   static QString stateToString(JobState state);
 
@@ -244,6 +276,11 @@ private: // variables
   QVector<JobState> m_states;
   /// Pending requests.
   QMap<RequestId, Request> m_requests;
+  /// Runs jobs locally when set.
+  QPointer<LocalJobExecutor> m_localExecutor;
+  /// Lookup batch ids from local executor job ids, and back.
+  QMap<int, BatchId> m_localIds;
+  QMap<BatchId, int> m_localJobIds;
 };
 
 inline BatchJob::Request::Request(Type t, BatchId b) : type(t), batchId(b)
@@ -361,7 +398,7 @@ inline int BatchJob::finishedJobCount() const
 
 inline int BatchJob::jobCount() const
 {
-  return m_serverIds.size();
+  return m_serverIds.size() + m_localIds.size();
 }
 
 inline BatchJob::JobState BatchJob::stringToState(const QString& str)
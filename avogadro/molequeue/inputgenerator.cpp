@@ -25,10 +25,12 @@
 #include <avogadro/qtgui/generichighlighter.h>
 #include <avogadro/qtgui/pythonscript.h>
 
+#include <QtCore/QCryptographicHash>
 #include <QtCore/QDebug>
 #include <QtCore/QFile>
 #include <QtCore/QJsonArray>
 #include <QtCore/QJsonDocument>
+#include <QtConcurrent/QtConcurrentRun>
 
 namespace Avogadro {
 namespace MoleQueue {
@@ -36,20 +38,31 @@ namespace MoleQueue {
 using QtGui::PythonScript;
 using QtGui::GenericHighlighter;
 
+namespace {
+// The number of script outputs kept by each generator.
+const int outputCacheSize = 32;
+} // namespace
+
 InputGenerator::InputGenerator(const QString& scriptFilePath_, QObject* parent_)
   : QObject(parent_), m_interpreter(new PythonScript(scriptFilePath_, this)),
-    m_moleculeExtension("Unknown")
+    m_moleculeExtension("Unknown"), m_outputCache(outputCacheSize),
+    m_requestQueued(false), m_runningSuperseded(false)
 {
+  connect(&m_watcher, SIGNAL(finished()), SLOT(scriptFinished()));
 }
 
 InputGenerator::InputGenerator(QObject* parent_)
   : QObject(parent_), m_interpreter(new PythonScript(this)),
-    m_moleculeExtension("Unknown")
+    m_moleculeExtension("Unknown"), m_outputCache(outputCacheSize),
+    m_requestQueued(false), m_runningSuperseded(false)
 {
+  connect(&m_watcher, SIGNAL(finished()), SLOT(scriptFinished()));
 }
 
 InputGenerator::~InputGenerator()
 {
+  // The worker only uses its own copies, but must not outlive the watcher.
+  m_watcher.waitForFinished();
 }
 
 bool InputGenerator::debug() const
@@ -130,6 +143,10 @@ void InputGenerator::setScriptFilePath(const QString& scriptFile)
 
 void InputGenerator::reset()
 {
+  m_outputCache.clear();
+  m_runningKey.clear();
+  m_requestQueued = false;
+  m_runningSuperseded = true;
   m_interpreter->setDefaultPythonInterpretor();
   m_interpreter->setScriptFilePath(QString());
   m_moleculeExtension = "Unknown";
@@ -146,6 +163,124 @@ void InputGenerator::reset()
 
 bool InputGenerator::generateInput(const QJsonObject& options_,
                                    const Core::Molecule& mol)
+{
+  clearGeneratedInput();
+
+  QByteArray input;
+  QByteArray cacheKey;
+  if (!prepareInput(options_, mol, input, cacheKey))
+    return false;
+
+  const QByteArray* cached = m_outputCache.object(cacheKey);
+  if (cached)
+    return processOutput(*cached, mol);
+
+  QByteArray json(
+    m_interpreter->execute(QStringList() << "--generate-input", input));
+
+  if (m_interpreter->hasErrors()) {
+    m_errors << m_interpreter->errorList();
+    return false;
+  }
+
+  m_outputCache.insert(cacheKey, new QByteArray(json));
+  return processOutput(json, mol);
+}
+
+void InputGenerator::generateInputAsync(const QJsonObject& options_,
+                                        const Core::Molecule& mol)
+{
+  m_requestMolecule.reset(new Core::Molecule(mol));
+  m_requestQueued = false;
+  m_runningSuperseded = m_watcher.isRunning();
+
+  // Keep the previous results until the new ones are ready, unless the
+  // request can be answered right away.
+  QStringList previousErrors;
+  previousErrors.swap(m_errors);
+  QByteArray input;
+  QByteArray cacheKey;
+  if (!prepareInput(options_, mol, input, cacheKey)) {
+    QStringList errors(m_errors);
+    clearGeneratedInput();
+    m_errors = errors;
+    emit inputGenerated(false);
+    return;
+  }
+  m_errors.swap(previousErrors);
+
+  if (const QByteArray* cached = m_outputCache.object(cacheKey)) {
+    QByteArray json(*cached);
+    clearGeneratedInput();
+    emit inputGenerated(processOutput(json, *m_requestMolecule));
+    return;
+  }
+
+  if (m_watcher.isRunning()) {
+    // Only the latest request matters, run it once the script returns.
+    m_requestQueued = true;
+    m_queuedInput = input;
+    m_queuedKey = cacheKey;
+    return;
+  }
+  runScriptAsync(input, cacheKey);
+}
+
+void InputGenerator::scriptFinished()
+{
+  ScriptOutput result = m_watcher.result();
+  // The key is cleared if the generator was reset while the script ran.
+  if (result.errors.isEmpty() && !m_runningKey.isEmpty())
+    m_outputCache.insert(m_runningKey, new QByteArray(result.output));
+
+  if (m_requestQueued) {
+    m_requestQueued = false;
+    m_runningSuperseded = false;
+    const QByteArray* cached = m_outputCache.object(m_queuedKey);
+    if (!cached) {
+      runScriptAsync(m_queuedInput, m_queuedKey);
+      return;
+    }
+    result.output = *cached;
+    result.errors.clear();
+  } else if (m_runningSuperseded) {
+    // A newer request was answered from the cache meanwhile.
+    m_runningSuperseded = false;
+    return;
+  }
+
+  clearGeneratedInput();
+  if (!result.errors.isEmpty() || !m_requestMolecule) {
+    m_errors << result.errors;
+    emit inputGenerated(false);
+    return;
+  }
+  emit inputGenerated(processOutput(result.output, *m_requestMolecule));
+}
+
+void InputGenerator::runScriptAsync(const QByteArray& input,
+                                    const QByteArray& cacheKey)
+{
+  m_runningKey = cacheKey;
+  m_runningSuperseded = false;
+
+  // The worker runs the script through its own interpreter object so that
+  // the generator can keep answering other calls in the meantime.
+  const QString scriptPath = scriptFilePath();
+  const bool debugScript = debug();
+  m_watcher.setFuture(QtConcurrent::run(
+    [scriptPath, debugScript, input]() -> ScriptOutput {
+      PythonScript script(scriptPath);
+      script.setDebug(debugScript);
+      ScriptOutput result;
+      result.output =
+        script.execute(QStringList() << "--generate-input", input);
+      result.errors = script.errorList();
+      return result;
+    }));
+}
+
+void InputGenerator::clearGeneratedInput()
 {
   m_errors.clear();
   m_warnings.clear();
@@ -154,20 +289,27 @@ bool InputGenerator::generateInput(const QJsonObject& options_,
   m_fileHighlighters.clear();
   m_mainFileName.clear();
   m_files.clear();
+}
 
+bool InputGenerator::prepareInput(const QJsonObject& options_,
+                                  const Core::Molecule& mol, QByteArray& input,
+                                  QByteArray& cacheKey)
+{
   // Add the molecule file to the options
   QJsonObject allOptions(options_);
   if (!insertMolecule(allOptions, mol))
     return false;
 
-  QByteArray json(m_interpreter->execute(QStringList() << "--generate-input",
-                                         QJsonDocument(allOptions).toJson()));
-
-  if (m_interpreter->hasErrors()) {
-    m_errors << m_interpreter->errorList();
-    return false;
-  }
+  input = QJsonDocument(allOptions).toJson();
+  cacheKey = QCryptographicHash::hash(input, QCryptographicHash::Sha1);
+  if (debug())
+    cacheKey += 'd';
+  return true;
+}
 
+bool InputGenerator::processOutput(const QByteArray& json,
+                                   const Core::Molecule& mol)
+{
   QJsonDocument doc;
   if (!parseJson(json, doc))
     return false;
@@ -22,8 +22,12 @@
 
 #include <avogadro/core/avogadrocore.h>
 
+#include <QtCore/QByteArray>
+#include <QtCore/QCache>
+#include <QtCore/QFutureWatcher>
 #include <QtCore/QJsonObject>
 #include <QtCore/QMap>
+#include <QtCore/QScopedPointer>
 #include <QtCore/QStringList>
 
 class QJsonDocument;
@@ -530,6 +534,27 @@ public:
    */
   bool generateInput(const QJsonObject& options_, const Core::Molecule& mol);
 
+  /**
+   * Like generateInput(), but runs the generator script in a worker thread
+   * and returns at once. inputGenerated() is emitted once the files are
+   * ready, after which the accessors below return them. If this is called
+   * again before the previous request finished, only the latest request is
+   * reported.
+   *
+   * The script output is cached for the most recent inputs, so returning to
+   * earlier options does not run the script again. Scripts that do not
+   * request the molecule (inputMoleculeFormat "None") are also not rerun
+   * when only the geometry changes, as their coordinate blocks are filled in
+   * here.
+   */
+  void generateInputAsync(const QJsonObject& options_,
+                          const Core::Molecule& mol);
+
+  /**
+   * @return True while a request from generateInputAsync() is running.
+   */
+  bool isGenerating() const { return m_watcher.isRunning(); }
+
   /**
    * @return The number of input files stored by generateInput().
    * @note This function is only valid after a successful call to
@@ -598,9 +623,31 @@ public slots:
    */
   void setDebug(bool d);
 
+signals:
+  /**
+   * Emitted when a request from generateInputAsync() completes. @a success
+   * has the same meaning as the return value of generateInput().
+   */
+  void inputGenerated(bool success);
+
+private slots:
+  void scriptFinished();
+
 private:
+  /// Output and errors of one run of the generator script.
+  struct ScriptOutput
+  {
+    QByteArray output;
+    QStringList errors;
+  };
+
   QtGui::PythonScript* m_interpreter;
 
+  void clearGeneratedInput();
+  bool prepareInput(const QJsonObject& options_, const Core::Molecule& mol,
+                    QByteArray& input, QByteArray& cacheKey);
+  bool processOutput(const QByteArray& json, const Core::Molecule& mol);
+  void runScriptAsync(const QByteArray& input, const QByteArray& cacheKey);
   void setDefaultPythonInterpretor();
   QByteArray execute(const QStringList& args,
                      const QByteArray& scriptStdin = QByteArray()) const;
@@ -629,6 +676,21 @@ private:
   QMap<QString, QtGui::GenericHighlighter*> m_fileHighlighters;
 
   mutable QMap<QString, QtGui::GenericHighlighter*> m_highlightStyles;
+
+  /// Script output keyed by a hash of the script input.
+  QCache<QByteArray, QByteArray> m_outputCache;
+
+  QFutureWatcher<ScriptOutput> m_watcher;
+  /// Cache key of the running script.
+  QByteArray m_runningKey;
+  /// The latest asynchronous request, which waits if a script is running.
+  bool m_requestQueued;
+  QByteArray m_queuedInput;
+  QByteArray m_queuedKey;
+  /// True once a request newer than the running script has been answered.
+  bool m_runningSuperseded;
+  /// Copy of the molecule of the latest request, for the keywords.
+  QScopedPointer<Core::Molecule> m_requestMolecule;
 };
 
 inline bool InputGenerator::isValid() const
@@ -55,6 +55,8 @@ InputGeneratorWidget::InputGeneratorWidget(QWidget* parent_)
   m_ui->warningTextButton->setIcon(QIcon::fromTheme("dialog-warning"));
 
   connectButtons();
+  connect(&m_inputGenerator, SIGNAL(inputGenerated(bool)),
+          SLOT(showGeneratedInput(bool)));
 }
 
 InputGeneratorWidget::~InputGeneratorWidget()
@@ -191,10 +193,22 @@ void InputGeneratorWidget::updatePreviewTextImmediately()
   if (!m_molecule)
     return;
 
-  // Generate the input files
+  // The buffers are overwritten with the new files, unless they are edited
+  // again before the generator returns.
+  m_dirtyTextEdits.clear();
+
+  // Generate the input files without blocking the GUI.
+  m_requestedOptions = collectOptions();
   QJsonObject inputOptions;
-  inputOptions["options"] = collectOptions();
-  bool success = m_inputGenerator.generateInput(inputOptions, *m_molecule);
+  inputOptions["options"] = m_requestedOptions;
+  m_inputGenerator.generateInputAsync(inputOptions, *m_molecule);
+}
+
+void InputGeneratorWidget::showGeneratedInput(bool success)
+{
+  // Keep the edits made while the files were being generated.
+  if (!m_dirtyTextEdits.isEmpty())
+    return;
 
   if (!m_inputGenerator.warningList().isEmpty()) {
     QString warningHtml;
@@ -269,7 +283,7 @@ void InputGeneratorWidget::updatePreviewTextImmediately()
 
   // Reset dirty buffer list and cached option list
   m_dirtyTextEdits.clear();
-  m_optionCache = collectOptions();
+  m_optionCache = m_requestedOptions;
 
   // Restore current tab
   if (!currentWidget.isNull())
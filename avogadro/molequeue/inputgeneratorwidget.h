@@ -135,10 +135,16 @@ private slots:
 
   /**
    * Immediately update the input files, bypassing (and resetting) the throttle
-   * mechanism.
+   * mechanism. The generator script runs in the background, and the files are
+   * shown by showGeneratedInput() when it returns.
    */
   void updatePreviewTextImmediately();
 
+  /**
+   * Show the files produced by the input generator, or its errors.
+   */
+  void showGeneratedInput(bool success);
+
   /**
    * Triggered when the user resets the default values.
    */
@@ -291,6 +297,7 @@ private:
   QtGui::Molecule* m_molecule;
   QJsonObject m_options;
   QJsonObject m_optionCache; // For reverting changes
+  QJsonObject m_requestedOptions; // Options of the pending preview update
   bool m_updatePending;
   bool m_batchMode;
   QList<QTextEdit*> m_dirtyTextEdits;
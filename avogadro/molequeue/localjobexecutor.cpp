@@ -0,0 +1,293 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "localjobexecutor.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QThread>
+
+namespace Avogadro {
+namespace MoleQueue {
+
+const LocalJobExecutor::JobId LocalJobExecutor::InvalidJobId = -1;
+
+namespace {
+const QString QueuedLocal = QStringLiteral("QueuedLocal");
+const QString RunningLocal = QStringLiteral("RunningLocal");
+const QString Finished = QStringLiteral("Finished");
+const QString Error = QStringLiteral("Error");
+const QString Canceled = QStringLiteral("Canceled");
+
+// Write a MoleQueue file specification, either inline contents or a path to
+// copy, into @a dir. Returns the file name, or an empty string on error.
+QString writeFileSpec(const QJsonObject& spec, const QDir& dir)
+{
+  if (spec.contains("path")) {
+    QFileInfo source(spec.value("path").toString());
+    QString target = dir.filePath(source.fileName());
+    if (!QFile::copy(source.absoluteFilePath(), target))
+      return QString();
+    return source.fileName();
+  }
+
+  QString fileName = spec.value("filename").toString();
+  if (fileName.isEmpty())
+    return QString();
+  QFile file(dir.filePath(fileName));
+  if (!file.open(QFile::WriteOnly | QFile::Truncate))
+    return QString();
+  file.write(spec.value("contents").toString().toUtf8());
+  return fileName;
+}
+} // namespace
+
+LocalJobExecutor::LocalJobExecutor(QObject* parent_)
+  : QObject(parent_),
+    m_temporaryDirectory(QDir::temp().filePath("avogadro-jobs-XXXXXX")),
+    m_workingDirectory(m_temporaryDirectory.path()),
+    m_maximumConcurrentJobs(qMax(1, QThread::idealThreadCount())),
+    m_startScheduled(false)
+{
+}
+
+LocalJobExecutor::~LocalJobExecutor()
+{
+  // The default working directory is removed with m_temporaryDirectory.
+  foreach (QProcess* process, m_processes.keys())
+    killProcess(process);
+}
+
+void LocalJobExecutor::setProgram(const QString& program,
+                                  const QStringList& arguments)
+{
+  m_program = program;
+  m_arguments = arguments;
+}
+
+void LocalJobExecutor::setMaximumConcurrentJobs(int count)
+{
+  m_maximumConcurrentJobs = qMax(1, count);
+  scheduleStart();
+}
+
+LocalJobExecutor::JobId LocalJobExecutor::submit(
+  const ::MoleQueue::JobObject& job, const QList<JobId>& dependencies)
+{
+  JobId jobId = m_jobs.size();
+  // Only earlier jobs are accepted, so the dependencies can never form a
+  // cycle.
+  foreach (JobId dependency, dependencies) {
+    if (dependency < 0 || dependency >= jobId)
+      return InvalidJobId;
+  }
+
+  Job newJob;
+  newJob.object = job;
+  newJob.object.setValue("jobState", QueuedLocal);
+  newJob.dependencies = dependencies;
+  m_jobs.push_back(newJob);
+  m_pending.push_back(jobId);
+  scheduleStart();
+  return jobId;
+}
+
+void LocalJobExecutor::cancel(JobId jobId)
+{
+  if (jobId < 0 || jobId >= m_jobs.size())
+    return;
+
+  if (m_pending.removeOne(jobId)) {
+    setJobState(jobId, Canceled);
+    // Jobs depending on this one are canceled when the queue is next checked.
+    scheduleStart();
+    return;
+  }
+
+  QProcess* process = m_processes.key(jobId, nullptr);
+  if (process)
+    finishJob(process, Canceled, -1);
+}
+
+::MoleQueue::JobObject LocalJobExecutor::job(JobId jobId) const
+{
+  return jobId >= 0 && jobId < m_jobs.size() ? m_jobs[jobId].object
+                                             : ::MoleQueue::JobObject();
+}
+
+QString LocalJobExecutor::jobState(JobId jobId) const
+{
+  return job(jobId).value("jobState", QString("Unknown")).toString();
+}
+
+void LocalJobExecutor::startJobs()
+{
+  m_startScheduled = false;
+
+  QList<JobId>::iterator it = m_pending.begin();
+  while (it != m_pending.end()) {
+    JobId jobId = *it;
+    bool ready = true;
+    bool failed = false;
+    foreach (JobId dependency, m_jobs[jobId].dependencies) {
+      QString state = jobState(dependency);
+      if (state == Error || state == Canceled)
+        failed = true;
+      else if (state != Finished)
+        ready = false;
+    }
+
+    // Pending jobs are checked in submission order, and dependencies are
+    // always earlier jobs, so a cancellation cascades in a single pass.
+    if (failed) {
+      it = m_pending.erase(it);
+      setJobState(jobId, Canceled);
+    } else if (ready && m_processes.size() < m_maximumConcurrentJobs) {
+      it = m_pending.erase(it);
+      if (!startJob(jobId))
+        setJobState(jobId, Error);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void LocalJobExecutor::processFinished(int exitCode,
+                                       QProcess::ExitStatus exitStatus)
+{
+  QProcess* process = qobject_cast<QProcess*>(sender());
+  if (!process || !m_processes.contains(process))
+    return;
+  bool success = exitStatus == QProcess::NormalExit && exitCode == 0;
+  finishJob(process, success ? Finished : Error, exitCode);
+}
+
+void LocalJobExecutor::processError(QProcess::ProcessError error)
+{
+  // Other errors are followed by finished().
+  if (error != QProcess::FailedToStart)
+    return;
+  QProcess* process = qobject_cast<QProcess*>(sender());
+  if (!process || !m_processes.contains(process))
+    return;
+  qWarning() << "LocalJobExecutor: failed to start" << m_program << ":"
+             << process->errorString();
+  finishJob(process, Error, -1);
+}
+
+void LocalJobExecutor::scheduleStart()
+{
+  // Starting from the event loop lets callers register a job before any of
+  // its state changes are reported.
+  if (m_startScheduled)
+    return;
+  m_startScheduled = true;
+  QMetaObject::invokeMethod(this, "startJobs", Qt::QueuedConnection);
+}
+
+bool LocalJobExecutor::startJob(JobId jobId)
+{
+  ::MoleQueue::JobObject& job = m_jobs[jobId].object;
+  if (m_program.isEmpty()) {
+    qWarning() << "LocalJobExecutor: no program set.";
+    return false;
+  }
+
+  // Empty if the default temporary directory could not be created.
+  if (m_workingDirectory.isEmpty()) {
+    qWarning() << "LocalJobExecutor: no working directory.";
+    return false;
+  }
+
+  QDir dir(m_workingDirectory);
+  QString jobDirName = QString("job-%1").arg(jobId + 1);
+  if (!dir.mkpath(jobDirName) || !dir.cd(jobDirName)) {
+    qWarning() << "LocalJobExecutor: cannot create"
+               << dir.filePath(jobDirName);
+    return false;
+  }
+  job.setValue("localWorkingDirectory", dir.absolutePath());
+  job.setValue("outputDirectory", dir.absolutePath());
+
+  QJsonObject json = job.json();
+  QString inputFileName =
+    writeFileSpec(json.value("inputFile").toObject(), dir);
+  if (inputFileName.isEmpty()) {
+    qWarning() << "LocalJobExecutor: cannot write the input of job" << jobId;
+    return false;
+  }
+  foreach (const QJsonValue& spec,
+           json.value("additionalInputFiles").toArray()) {
+    if (writeFileSpec(spec.toObject(), dir).isEmpty()) {
+      qWarning() << "LocalJobExecutor: cannot write the input of job"
+                 << jobId;
+      return false;
+    }
+  }
+
+  QString baseName = QFileInfo(inputFileName).completeBaseName();
+  QStringList arguments;
+  foreach (QString argument, m_arguments) {
+    argument.replace("$$inputFileName$$", inputFileName);
+    argument.replace("$$inputFileBaseName$$", baseName);
+    arguments << argument;
+  }
+
+  QProcess* process = new QProcess(this);
+  process->setWorkingDirectory(dir.absolutePath());
+  process->setStandardOutputFile(dir.filePath(baseName + ".out"));
+  process->setStandardErrorFile(dir.filePath(baseName + ".err"));
+  connect(process, SIGNAL(finished(int, QProcess::ExitStatus)),
+          SLOT(processFinished(int, QProcess::ExitStatus)));
+  connect(process, SIGNAL(error(QProcess::ProcessError)),
+          SLOT(processError(QProcess::ProcessError)));
+  m_processes.insert(process, jobId);
+  setJobState(jobId, RunningLocal);
+  process->start(m_program, arguments);
+  return true;
+}
+
+void LocalJobExecutor::setJobState(JobId jobId, const QString& state)
+{
+  QString oldState = jobState(jobId);
+  if (oldState == state)
+    return;
+  m_jobs[jobId].object.setValue("jobState", state);
+  emit jobStateChanged(jobId, oldState, state);
+}
+
+void LocalJobExecutor::finishJob(QProcess* process, const QString& state,
+                                 int exitCode)
+{
+  JobId jobId = m_processes.take(process);
+  if (process->state() == QProcess::NotRunning)
+    process->deleteLater();
+  else
+    killProcess(process);
+  m_jobs[jobId].object.setValue("exitCode", exitCode);
+  setJobState(jobId, state);
+  scheduleStart();
+}
+
+void LocalJobExecutor::killProcess(QProcess* process)
+{
+  // Killing is asynchronous. Rather than block until the process exited, it
+  // is left to delete itself then, which may be after the executor is gone.
+  process->disconnect(this);
+  if (process->state() == QProcess::NotRunning) {
+    delete process;
+    return;
+  }
+  process->setParent(nullptr);
+  connect(process, SIGNAL(finished(int, QProcess::ExitStatus)), process,
+          SLOT(deleteLater()));
+  process->kill();
+}
+
+} // namespace MoleQueue
+} // namespace Avogadro
@@ -0,0 +1,160 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_MOLEQUEUE_LOCALJOBEXECUTOR_H
+#define AVOGADRO_MOLEQUEUE_LOCALJOBEXECUTOR_H
+
+#include "avogadromolequeueexport.h"
+
+#include <QtCore/QObject>
+
+#include <molequeue/client/jobobject.h>
+
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QProcess>
+#include <QtCore/QStringList>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QVector>
+
+namespace Avogadro {
+namespace MoleQueue {
+
+/**
+ * @brief The LocalJobExecutor class runs MoleQueue jobs as local processes,
+ * without a MoleQueue server.
+ *
+ * Each job gets its own directory below workingDirectory(), where its input
+ * files are written and the program is started. Standard output and error
+ * are saved there as "<base name>.out" and "<base name>.err". At most
+ * maximumConcurrentJobs() processes run at once, the rest wait in submission
+ * order. A job may depend on earlier jobs; it starts once they have all
+ * finished, and is canceled if any of them fails.
+ *
+ * Job states use the MoleQueue names ("QueuedLocal", "RunningLocal",
+ * "Finished", "Error", "Canceled") and are stored in the "jobState" value of
+ * the job objects, together with "localWorkingDirectory", "outputDirectory"
+ * and "exitCode" once the job ends.
+ *
+ * A BatchJob uses a LocalJobExecutor in place of the MoleQueue server once
+ * it is passed to BatchJob::setLocalExecutor().
+ */
+class AVOGADROMOLEQUEUE_EXPORT LocalJobExecutor : public QObject
+{
+  Q_OBJECT
+public:
+  /** Identifies a job within this executor. */
+  typedef int JobId;
+  static const JobId InvalidJobId;
+
+  explicit LocalJobExecutor(QObject* parent = nullptr);
+
+  /**
+   * Kills the jobs that are still running, without waiting for them, and
+   * removes the default working directory.
+   */
+  ~LocalJobExecutor() override;
+
+  /**
+   * The program started for each job and its arguments. The keywords
+   * $$inputFileName$$ and $$inputFileBaseName$$ in the arguments are replaced
+   * by the name of the main input file of the job, with and without its
+   * extension.
+   * @{
+   */
+  void setProgram(const QString& program,
+                  const QStringList& arguments = QStringList());
+  QString program() const { return m_program; }
+  QStringList arguments() const { return m_arguments; }
+  /** @} */
+
+  /**
+   * The directory below which the job directories are created. Defaults to a
+   * new directory in the system temporary path, which is removed together
+   * with the executor. Other directories are left in place.
+   * @{
+   */
+  void setWorkingDirectory(const QString& path) { m_workingDirectory = path; }
+  QString workingDirectory() const { return m_workingDirectory; }
+  /** @} */
+
+  /**
+   * The number of jobs allowed to run at the same time. Defaults to the
+   * number of processor cores.
+   * @{
+   */
+  void setMaximumConcurrentJobs(int count);
+  int maximumConcurrentJobs() const { return m_maximumConcurrentJobs; }
+  /** @} */
+
+  /**
+   * Queue @a job, which will run after all jobs in @a dependencies finished.
+   * The job starts once control returns to the event loop.
+   * @return The id of the job, or InvalidJobId if a dependency is not a job
+   * of this executor.
+   */
+  JobId submit(const ::MoleQueue::JobObject& job,
+               const QList<JobId>& dependencies = QList<JobId>());
+
+  /**
+   * Cancel job @a jobId. A running process is killed and cleaned up once it
+   * exited, this does not wait for it.
+   */
+  void cancel(JobId jobId);
+
+  /**
+   * @return The job object of @a jobId, including its current "jobState".
+   */
+  ::MoleQueue::JobObject job(JobId jobId) const;
+
+  /** @return The MoleQueue name of the state of @a jobId. */
+  QString jobState(JobId jobId) const;
+
+  /** @return The number of jobs submitted. */
+  int jobCount() const { return m_jobs.size(); }
+
+  /** @return The number of jobs that are running. */
+  int runningJobCount() const { return m_processes.size(); }
+
+signals:
+  /** Emitted when the state of @a jobId changes. */
+  void jobStateChanged(int jobId, const QString& oldState,
+                       const QString& newState);
+
+private slots:
+  void startJobs();
+  void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
+  void processError(QProcess::ProcessError error);
+
+private:
+  struct Job
+  {
+    ::MoleQueue::JobObject object;
+    QList<JobId> dependencies;
+  };
+
+  void scheduleStart();
+  bool startJob(JobId jobId);
+  void setJobState(JobId jobId, const QString& state);
+  void finishJob(QProcess* process, const QString& state, int exitCode);
+  void killProcess(QProcess* process);
+
+  QString m_program;
+  QStringList m_arguments;
+  QTemporaryDir m_temporaryDirectory;
+  QString m_workingDirectory;
+  int m_maximumConcurrentJobs;
+  bool m_startScheduled;
+
+  QVector<Job> m_jobs;
+  /// Jobs waiting to start, in submission order.
+  QList<JobId> m_pending;
+  QMap<QProcess*, JobId> m_processes;
+};
+
+} // namespace MoleQueue
+} // namespace Avogadro
+
+#endif // AVOGADRO_MOLEQUEUE_LOCALJOBEXECUTOR_H
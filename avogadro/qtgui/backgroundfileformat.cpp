@@ -0,0 +1,93 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "backgroundfileformat.h"
+
+#include "molecule.h"
+
+#include <avogadro/io/fileformat.h>
+
+namespace Avogadro {
+namespace QtGui {
+
+BackgroundFileFormat::BackgroundFileFormat(Io::FileFormat* format,
+                                           QObject* parent_)
+  : QThread(parent_), m_format(format), m_perceiveBonds(false),
+    m_success(false), m_percent(-1)
+{
+  if (m_format) {
+    m_format->setProgressFunction(
+      [this](std::streamoff done, std::streamoff total) {
+        if (total <= 0)
+          return;
+        int percent = static_cast<int>(100 * done / total);
+        // Only emit when the value changed, the signal is queued.
+        if (m_percent.exchange(percent) != percent)
+          emit progress(percent);
+      });
+  }
+}
+
+BackgroundFileFormat::~BackgroundFileFormat()
+{
+  cancel();
+  wait();
+}
+
+bool BackgroundFileFormat::takeMolecule(Molecule& mol)
+{
+  if (!m_success || isRunning())
+    return false;
+
+  // Core::Array shares its data, so the assignment is cheap. Clear our copy
+  // afterwards so the arrays are not shared with a molecule we keep.
+  mol = m_molecule;
+  m_molecule = Core::Molecule();
+  m_success = false;
+  mol.emitChanged(Molecule::Atoms | Molecule::Bonds | Molecule::UnitCell |
+                  Molecule::Added);
+  return true;
+}
+
+void BackgroundFileFormat::startRead()
+{
+  if (isRunning())
+    return;
+  // A previous cancel() would stop the new read straight away.
+  if (m_format)
+    m_format->clear();
+  start();
+}
+
+void BackgroundFileFormat::cancel()
+{
+  if (m_format)
+    m_format->cancel();
+}
+
+void BackgroundFileFormat::run()
+{
+  m_success = false;
+  m_error.clear();
+  m_percent = -1;
+  m_molecule = Core::Molecule();
+  if (!m_format) {
+    m_error = tr("No file format was given.");
+    return;
+  }
+
+  m_success = m_format->readFile(m_fileName.toStdString(), m_molecule);
+  if (m_success && m_perceiveBonds && m_molecule.bondCount() == 0 &&
+      !m_format->isCanceled()) {
+    m_molecule.perceiveBondsSimple();
+  }
+  m_success = m_success && !m_format->isCanceled();
+  m_error = QString::fromStdString(m_format->error());
+  if (m_success)
+    emit progress(100);
+}
+
+} // End QtGui namespace
+} // End Avogadro namespace
@@ -0,0 +1,116 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_QTGUI_BACKGROUNDFILEFORMAT_H
+#define AVOGADRO_QTGUI_BACKGROUNDFILEFORMAT_H
+
+#include "avogadroqtguiexport.h"
+
+#include <avogadro/core/molecule.h>
+
+#include <QtCore/QString>
+#include <QtCore/QThread>
+
+#include <atomic>
+#include <memory>
+
+namespace Avogadro {
+
+namespace Io {
+class FileFormat;
+}
+
+namespace QtGui {
+class Molecule;
+
+/**
+ * @class BackgroundFileFormat backgroundfileformat.h
+ * <avogadro/qtgui/backgroundfileformat.h>
+ * @brief Reads a file into a molecule on a worker thread.
+ *
+ * Parsing, and optionally bond perception, run in a private Core::Molecule
+ * so the GUI stays responsive while large files load. Progress is reported
+ * through progress() and the read can be stopped with cancel(). Once the
+ * thread has finished, takeMolecule() moves the result into a QtGui::Molecule
+ * on the GUI thread.
+ */
+class AVOGADROQTGUI_EXPORT BackgroundFileFormat : public QThread
+{
+  Q_OBJECT
+public:
+  /**
+   * @param format The format used to read the file. Ownership passes to this
+   * object.
+   */
+  explicit BackgroundFileFormat(Io::FileFormat* format, QObject* parent = 0);
+  ~BackgroundFileFormat() override;
+
+  /** @return The format used to read the file. */
+  Io::FileFormat* fileFormat() const { return m_format.get(); }
+
+  /** The file to read. Must not be called while the thread is running. */
+  void setFileName(const QString& fileName) { m_fileName = fileName; }
+  QString fileName() const { return m_fileName; }
+
+  /**
+   * Perceive bonds after reading if the file did not contain any. Must not be
+   * called while the thread is running. Default false.
+   */
+  void setPerceiveBonds(bool perceive) { m_perceiveBonds = perceive; }
+  bool perceiveBonds() const { return m_perceiveBonds; }
+
+  /** @return True if the last read succeeded. */
+  bool success() const { return m_success; }
+
+  /** @return The errors reported by the format during the last read. */
+  QString error() const { return m_error; }
+
+  /**
+   * Replace the contents of @a mol with the molecule that was read and emit
+   * its changed() signal. Call on the thread that owns @a mol, after the
+   * thread has finished.
+   * @return False if the last read did not succeed.
+   */
+  bool takeMolecule(Molecule& mol);
+
+public slots:
+  /**
+   * Start reading the file on the worker thread. Use this rather than
+   * start(), which does not reset an earlier cancel(). QThread::finished() is
+   * emitted when the read is done.
+   */
+  void startRead();
+
+  /**
+   * Stop a running read at the next record. The read then fails and
+   * finished() is emitted as usual.
+   */
+  void cancel();
+
+signals:
+  /**
+   * Emitted from the worker thread as the read advances, with the percentage
+   * of the file read so far.
+   */
+  void progress(int percent);
+
+protected:
+  /** Read the file, called by QThread::start(). */
+  void run() override;
+
+private:
+  std::unique_ptr<Io::FileFormat> m_format;
+  QString m_fileName;
+  bool m_perceiveBonds;
+  Core::Molecule m_molecule;
+  bool m_success;
+  QString m_error;
+  std::atomic<int> m_percent;
+};
+
+} // End QtGui namespace
+} // End Avogadro namespace
+
+#endif // AVOGADRO_QTGUI_BACKGROUNDFILEFORMAT_H
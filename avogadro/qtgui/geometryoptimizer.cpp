@@ -0,0 +1,105 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "geometryoptimizer.h"
+
+#include <avogadro/core/molecule.h>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutexLocker>
+
+namespace Avogadro {
+namespace QtGui {
+
+using Core::Array;
+using Core::UFF;
+
+GeometryOptimizer::GeometryOptimizer(QObject* p)
+  : QThread(p), m_maxSteps(500), m_updateInterval(40), m_energy(0.0)
+{
+}
+
+GeometryOptimizer::~GeometryOptimizer()
+{
+  stop();
+  wait();
+}
+
+bool GeometryOptimizer::setMolecule(const Core::Molecule& mol)
+{
+  if (!m_forceField.setMolecule(mol))
+    return false;
+  m_forceField.setMask(Eigen::VectorXd());
+  setPositions(mol.atomPositions3d());
+  return true;
+}
+
+void GeometryOptimizer::setPositions(const Array<Vector3>& positions)
+{
+  m_start = UFF::toCoordinates(positions);
+  QMutexLocker locker(&m_mutex);
+  // Core::Array reference counts are not atomic, so never share storage
+  // between the threads.
+  m_positions = Array<Vector3>(positions.begin(), positions.end());
+}
+
+void GeometryOptimizer::setFrozenAtoms(const std::vector<bool>& frozen)
+{
+  if (frozen.empty()) {
+    m_forceField.setMask(Eigen::VectorXd());
+    return;
+  }
+  Eigen::VectorXd mask(3 * frozen.size());
+  for (size_t i = 0; i < frozen.size(); ++i)
+    mask.segment<3>(3 * i).setConstant(frozen[i] ? 0.0 : 1.0);
+  m_forceField.setMask(mask);
+}
+
+Array<Vector3> GeometryOptimizer::positions() const
+{
+  QMutexLocker locker(&m_mutex);
+  return Array<Vector3>(m_positions.begin(), m_positions.end());
+}
+
+double GeometryOptimizer::energy() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_energy;
+}
+
+void GeometryOptimizer::publish(const Eigen::VectorXd& x, Real energy,
+                                int step)
+{
+  {
+    QMutexLocker locker(&m_mutex);
+    UFF::fromCoordinates(x, m_positions);
+    m_energy = energy;
+  }
+  emit positionsUpdated(step, energy);
+}
+
+void GeometryOptimizer::run()
+{
+  if (m_start.size() == 0)
+    return;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  m_lbfgs.initialize(m_forceField, m_start);
+  while (m_lbfgs.iteration() < m_maxSteps && !isInterruptionRequested()) {
+    bool more = m_lbfgs.step();
+    if (!more || timer.elapsed() >= m_updateInterval) {
+      publish(m_lbfgs.coordinates(), m_lbfgs.energy(), m_lbfgs.iteration());
+      timer.restart();
+    }
+    if (!more)
+      return;
+  }
+  publish(m_lbfgs.coordinates(), m_lbfgs.energy(), m_lbfgs.iteration());
+}
+
+} // End QtGui namespace
+} // End Avogadro namespace
@@ -0,0 +1,112 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_QTGUI_GEOMETRYOPTIMIZER_H
+#define AVOGADRO_QTGUI_GEOMETRYOPTIMIZER_H
+
+#include "avogadroqtguiexport.h"
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/lbfgs.h>
+#include <avogadro/core/uff.h>
+#include <avogadro/core/vector.h>
+
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+
+namespace Avogadro {
+
+namespace Core {
+class Molecule;
+}
+
+namespace QtGui {
+
+/**
+ * @class GeometryOptimizer geometryoptimizer.h
+ * <avogadro/qtgui/geometryoptimizer.h>
+ * @brief Minimizes a molecule with the in-process UFF force field on a worker
+ * thread.
+ *
+ * The optimizer works on its own copy of the coordinates. Intermediate
+ * coordinates are published through positionsUpdated() at most once per
+ * updateInterval(), and the receiver fetches them with positions(). This lets
+ * the GUI apply each step to the RWMolecule in interactive mode, so a whole
+ * minimization collapses into a single undo command.
+ */
+class AVOGADROQTGUI_EXPORT GeometryOptimizer : public QThread
+{
+  Q_OBJECT
+public:
+  explicit GeometryOptimizer(QObject* parent = 0);
+  ~GeometryOptimizer() override;
+
+  /**
+   * Set up the force field for @a mol and copy its coordinates. Must not be
+   * called while the thread is running.
+   * @return False if the molecule cannot be handled by the force field.
+   */
+  bool setMolecule(const Core::Molecule& mol);
+
+  /**
+   * Replace the starting coordinates without re-typing the molecule. Must not
+   * be called while the thread is running.
+   */
+  void setPositions(const Core::Array<Vector3>& positions);
+
+  /**
+   * Freeze atoms: @a frozen[i] true keeps atom i fixed. An empty array frees
+   * all atoms. Must not be called while the thread is running.
+   */
+  void setFrozenAtoms(const std::vector<bool>& frozen);
+
+  /** Maximum number of optimizer steps per run. Default 500. */
+  void setMaxSteps(int steps) { m_maxSteps = steps; }
+  int maxSteps() const { return m_maxSteps; }
+
+  /** Minimum time between two positionsUpdated() signals. Default 40 ms. */
+  void setUpdateInterval(int msec) { m_updateInterval = msec; }
+  int updateInterval() const { return m_updateInterval; }
+
+  /** @return The force field used by the optimizer. */
+  Core::UFF& forceField() { return m_forceField; }
+
+  /** @return The most recently published coordinates. Thread safe. */
+  Core::Array<Vector3> positions() const;
+
+  /** @return The energy of the most recently published coordinates. */
+  double energy() const;
+
+  /** Ask a running optimization to stop after the current step. */
+  void stop() { requestInterruption(); }
+
+  /** Run the minimization, called by QThread::start(). */
+  void run() override;
+
+signals:
+  /**
+   * New coordinates are available from positions(). Emitted from the worker
+   * thread, so connections are queued to the receiver's thread.
+   */
+  void positionsUpdated(int step, double energy);
+
+private:
+  void publish(const Eigen::VectorXd& x, Real energy, int step);
+
+  Core::UFF m_forceField;
+  Core::LBFGS m_lbfgs;
+  Eigen::VectorXd m_start;
+  int m_maxSteps;
+  int m_updateInterval;
+
+  mutable QMutex m_mutex;
+  Core::Array<Vector3> m_positions;
+  double m_energy;
+};
+
+} // End QtGui namespace
+} // End Avogadro namespace
+
+#endif // AVOGADRO_QTGUI_GEOMETRYOPTIMIZER_H
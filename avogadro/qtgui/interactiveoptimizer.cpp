@@ -0,0 +1,205 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "interactiveoptimizer.h"
+
+#include "geometryoptimizer.h"
+#include "molecule.h"
+#include "rwmolecule.h"
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/neighborperceiver.h>
+
+#include <functional>
+
+namespace Avogadro {
+namespace QtGui {
+
+using Core::Array;
+using Core::NeighborPerceiver;
+
+InteractiveOptimizer::InteractiveOptimizer(QObject* p)
+  : QObject(p), m_molecule(nullptr), m_optimizer(new GeometryOptimizer(this)),
+    m_enabled(false), m_radius(5.0), m_stepsPerFrame(5), m_topologyKey(0),
+    m_typed(false), m_hasPending(false), m_running(false)
+{
+  connect(m_optimizer, SIGNAL(finished()), SLOT(optimizerFinished()));
+}
+
+InteractiveOptimizer::~InteractiveOptimizer()
+{
+  m_optimizer->stop();
+  m_optimizer->wait();
+}
+
+void InteractiveOptimizer::setMolecule(RWMolecule* mol)
+{
+  if (mol == m_molecule)
+    return;
+  m_optimizer->stop();
+  m_optimizer->wait();
+  m_molecule = mol;
+  m_typed = false;
+  m_hasPending = false;
+  m_active.clear();
+}
+
+void InteractiveOptimizer::setEnabled(bool enable)
+{
+  m_enabled = enable;
+  if (!m_enabled) {
+    m_optimizer->stop();
+    m_optimizer->wait();
+    m_hasPending = false;
+    m_active.clear();
+  }
+}
+
+void InteractiveOptimizer::relax(const std::vector<Index>& movedAtoms)
+{
+  if (!m_enabled || !m_molecule || movedAtoms.empty())
+    return;
+
+  m_pending = movedAtoms;
+  m_hasPending = true;
+  // The thread may have stopped before its finished() signal arrives, the
+  // request is then started from optimizerFinished().
+  if (!m_running)
+    start();
+}
+
+void InteractiveOptimizer::finish()
+{
+  m_hasPending = false;
+  m_optimizer->stop();
+  m_optimizer->wait();
+  // Also covers a run whose finished() signal has not been delivered yet.
+  apply();
+}
+
+void InteractiveOptimizer::optimizerFinished()
+{
+  m_running = false;
+  // finish() may already have consumed the result.
+  if (!m_active.empty())
+    apply();
+  if (m_hasPending)
+    start();
+}
+
+void InteractiveOptimizer::start()
+{
+  m_hasPending = false;
+  m_moved.swap(m_pending);
+
+  const Array<Vector3>& positions = m_molecule->atomPositions3d();
+  Index atomCount = m_molecule->atomCount();
+  if (positions.size() != atomCount)
+    return;
+
+  size_t key = topologyKey();
+  if (!m_typed || key != m_topologyKey) {
+    m_typed = m_optimizer->setMolecule(m_molecule->molecule());
+    m_topologyKey = key;
+    if (!m_typed)
+      return;
+  }
+
+  // The active region: every atom within the radius of a moved atom, except
+  // the moved atoms themselves, which follow the mouse.
+  std::vector<bool> moved(atomCount, false);
+  Array<Vector3> movedPositions;
+  for (Index i : m_moved) {
+    if (i < atomCount && !moved[i]) {
+      moved[i] = true;
+      movedPositions.push_back(positions[i]);
+    }
+  }
+  if (movedPositions.empty())
+    return;
+
+  std::vector<bool> active(atomCount, false);
+  bool any = false;
+  NeighborPerceiver perceiver(movedPositions, m_radius);
+  Array<Index> candidates;
+  Real radiusSquared = m_radius * m_radius;
+  for (Index i = 0; i < atomCount; ++i) {
+    if (moved[i])
+      continue;
+    perceiver.getNeighborsInclusive(candidates, positions[i]);
+    for (Index c : candidates) {
+      if ((movedPositions[c] - positions[i]).squaredNorm() <= radiusSquared) {
+        active[i] = any = true;
+        break;
+      }
+    }
+  }
+  if (!any)
+    return;
+
+  m_active.swap(active);
+  m_optimizer->forceField().setActiveAtoms(m_active);
+  m_optimizer->setPositions(positions);
+  m_optimizer->setMaxSteps(m_stepsPerFrame);
+  m_running = true;
+  m_optimizer->start();
+}
+
+void InteractiveOptimizer::apply()
+{
+  std::vector<bool> active;
+  active.swap(m_active);
+  if (active.empty() || !m_molecule || topologyKey() != m_topologyKey)
+    return;
+
+  Array<Vector3> relaxed = m_optimizer->positions();
+  if (relaxed.size() != active.size())
+    return;
+
+  // Atoms the tool is about to move again keep the position it gave them.
+  if (m_hasPending) {
+    for (Index i : m_pending) {
+      if (i < active.size())
+        active[i] = false;
+    }
+  }
+
+  Array<Index> ids;
+  Array<Vector3> newPositions;
+  for (Index i = 0; i < active.size(); ++i) {
+    if (active[i]) {
+      ids.push_back(i);
+      newPositions.push_back(relaxed[i]);
+    }
+  }
+  if (ids.empty())
+    return;
+
+  m_molecule->setAtomPositions3d(ids, newPositions, tr("Auto Optimize"));
+  m_molecule->emitChanged(Molecule::Atoms | Molecule::Modified);
+}
+
+size_t InteractiveOptimizer::topologyKey() const
+{
+  // Changes in atoms or bonds require the force field to be set up again.
+  std::hash<size_t> hasher;
+  size_t key = hasher(m_molecule->atomCount());
+  auto combine = [&key, &hasher](size_t value) {
+    key ^= hasher(value) + 0x9e3779b9 + (key << 6) + (key >> 2);
+  };
+  for (unsigned char number : m_molecule->atomicNumbers())
+    combine(number);
+  const Array<std::pair<Index, Index>>& pairs = m_molecule->bondPairs();
+  const Array<unsigned char>& orders = m_molecule->bondOrders();
+  for (Index i = 0; i < pairs.size(); ++i) {
+    combine(pairs[i].first);
+    combine(pairs[i].second);
+    combine(orders[i]);
+  }
+  return key;
+}
+
+} // End QtGui namespace
+} // End Avogadro namespace
@@ -0,0 +1,101 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_QTGUI_INTERACTIVEOPTIMIZER_H
+#define AVOGADRO_QTGUI_INTERACTIVEOPTIMIZER_H
+
+#include "avogadroqtguiexport.h"
+
+#include <avogadro/core/avogadrocore.h>
+
+#include <QtCore/QObject>
+
+#include <vector>
+
+namespace Avogadro {
+namespace QtGui {
+
+class GeometryOptimizer;
+class RWMolecule;
+
+/**
+ * @class InteractiveOptimizer interactiveoptimizer.h
+ * <avogadro/qtgui/interactiveoptimizer.h>
+ * @brief Relaxes the surroundings of atoms while they are being edited.
+ *
+ * Tools call relax() every time they move atoms during a drag. A bounded
+ * number of UFF steps is then run on a worker thread, restricted to the atoms
+ * within radius() of the moved ones; the moved atoms themselves and everything
+ * outside the region stay fixed. The force field keeps its atom types and
+ * neighbor list between frames and is only set up again when the topology
+ * changes. Results are written back through the interactive-drag path of the
+ * RWMolecule, so they merge with the tool's own position changes instead of
+ * producing an undo entry per step. While a run is in flight, further requests
+ * are coalesced and the newest one is started when the worker becomes idle.
+ *
+ * Call finish() before the tool leaves interactive mode.
+ */
+class AVOGADROQTGUI_EXPORT InteractiveOptimizer : public QObject
+{
+  Q_OBJECT
+public:
+  explicit InteractiveOptimizer(QObject* parent = 0);
+  ~InteractiveOptimizer() override;
+
+  /** The molecule being edited. */
+  void setMolecule(RWMolecule* mol);
+  RWMolecule* molecule() const { return m_molecule; }
+
+  /** Whether relax() does anything. Disabling stops a running relaxation. */
+  void setEnabled(bool enable);
+  bool isEnabled() const { return m_enabled; }
+
+  /** Radius of the relaxed region around the moved atoms. Default 5 A. */
+  void setRadius(Real radius) { m_radius = radius; }
+  Real radius() const { return m_radius; }
+
+  /** Optimizer steps run for each relax() request. Default 5. */
+  void setStepsPerFrame(int steps) { m_stepsPerFrame = steps; }
+  int stepsPerFrame() const { return m_stepsPerFrame; }
+
+  /**
+   * Relax the environment of @a movedAtoms, which keep their current
+   * positions. Returns immediately.
+   */
+  void relax(const std::vector<Index>& movedAtoms);
+
+  /**
+   * Wait for a running relaxation, apply its result and drop pending requests.
+   */
+  void finish();
+
+private slots:
+  void optimizerFinished();
+
+private:
+  void start();
+  void apply();
+  size_t topologyKey() const;
+
+  RWMolecule* m_molecule;
+  GeometryOptimizer* m_optimizer;
+  bool m_enabled;
+  Real m_radius;
+  int m_stepsPerFrame;
+
+  size_t m_topologyKey;
+  bool m_typed;
+  std::vector<bool> m_active;
+  std::vector<Index> m_moved;
+  std::vector<Index> m_pending;
+  bool m_hasPending;
+  /** A run was started and its finished() signal is not handled yet. */
+  bool m_running;
+};
+
+} // End QtGui namespace
+} // End Avogadro namespace
+
+#endif // AVOGADRO_QTGUI_INTERACTIVEOPTIMIZER_H
@@ -59,7 +59,7 @@ bool MeshGenerator::initialize(const Cube* cube_, Mesh* mesh_, float iso,
   m_mesh = mesh_;
   m_iso = iso;
   m_reverseWinding = reverse;
-  if (!m_cube->lock()->tryLock()) {
+  if (!m_cube->lock()->tryLockShared()) {
     qDebug() << "Cannot get a read lock...";
     return false;
   }
@@ -68,7 +68,7 @@ bool MeshGenerator::initialize(const Cube* cube_, Mesh* mesh_, float iso,
   m_min = m_cube->min().cast<float>();
   m_dim = m_cube->dimensions();
   m_progmax = m_dim.x();
-  m_cube->lock()->unlock();
+  m_cube->lock()->unlockShared();
   return true;
 }
 
@@ -79,13 +79,16 @@ void MeshGenerator::run()
     return;
   }
 
-  // Attempt to obtain a lock, wait one second between attempts.
-  while (!m_cube->lock()->tryLock())
-    sleep(1);
+  // Other readers of the cube may run at the same time, only a calculation
+  // writing to it is waited for.
+  Core::ReadLocker cubeLocker(m_cube->lock());
 
   // Mark the mesh as being worked on and clear it
-  m_mesh->setStable(false);
-  m_mesh->clear();
+  {
+    Core::WriteLocker meshLocker(m_mesh->lock());
+    m_mesh->setStable(false);
+    m_mesh->clear();
+  }
 
   m_vertices.reserve(m_dim.x() * m_dim.y() * m_dim.z() * 3);
   m_normals.reserve(m_dim.x() * m_dim.y() * m_dim.z() * 3);
@@ -104,12 +107,13 @@ void MeshGenerator::run()
     emit progressValueChanged(i);
   }
 
-  m_cube->lock()->unlock();
-
   // Copy the data across
-  m_mesh->setVertices(m_vertices);
-  m_mesh->setNormals(m_normals);
-  m_mesh->setStable(true);
+  {
+    Core::WriteLocker meshLocker(m_mesh->lock());
+    m_mesh->setVertices(m_vertices);
+    m_mesh->setNormals(m_normals);
+    m_mesh->setStable(true);
+  }
 
   // Now we are done give all that memory back
   m_vertices.resize(0);
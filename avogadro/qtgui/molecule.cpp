@@ -21,13 +21,14 @@ namespace Avogadro {
 namespace QtGui {
 
 Molecule::Molecule(QObject* parent_)
-  : QObject(parent_), m_undoMolecule(new RWMolecule(*this, this))
+  : QObject(parent_), m_displacementScale(0.0f),
+    m_undoMolecule(new RWMolecule(*this, this))
 {
   m_undoMolecule->setInteractive(true);
 }
 
 Molecule::Molecule(const Molecule& other)
-  : QObject(), Core::Molecule(other),
+  : QObject(), Core::Molecule(other), m_displacementScale(0.0f),
     m_undoMolecule(new RWMolecule(*this, this))
 {
   m_undoMolecule->setInteractive(true);
@@ -40,7 +41,7 @@ Molecule::Molecule(const Molecule& other)
 }
 
 Molecule::Molecule(const Core::Molecule& other)
-  : QObject(), Core::Molecule(other)
+  : QObject(), Core::Molecule(other), m_displacementScale(0.0f)
 {
   // Now assign the unique ids
   for (Index i = 0; i < atomCount(); i++)
@@ -212,6 +213,14 @@ Molecule::BondType Molecule::addBond(const AtomType& a, const AtomType& b,
   return Core::Molecule::addBond(a, b, order);
 }
 
+void Molecule::addBonds(const Core::Array<std::pair<Index, Index>>& pairs,
+                        unsigned char order)
+{
+  for (Index i = 0; i < pairs.size(); ++i)
+    m_bondUniqueIds.push_back(bondCount() + i);
+  Core::Molecule::addBonds(pairs, order);
+}
+
 bool Molecule::removeBond(Index index)
 {
   if (index >= bondCount())
@@ -255,6 +264,16 @@ bool Molecule::removeBond(Index a, Index b)
   return removeBond(bond(a, b).index());
 }
 
+void Molecule::clearBonds()
+{
+  // Removing the bonds one by one would look up every unique ID in turn.
+  for (Index i = 0; i < m_bondUniqueIds.size(); ++i)
+    m_bondUniqueIds[i] = MaxIndex;
+  m_bondOrders.clear();
+  m_bondPairs.clear();
+  m_graphDirty = true;
+}
+
 Molecule::BondType Molecule::bondByUniqueId(Index uniqueId)
 {
   if (uniqueId >= static_cast<Index>(m_bondUniqueIds.size()) ||
@@ -283,6 +302,12 @@ void Molecule::emitChanged(unsigned int change)
     emit changed(change);
 }
 
+void Molecule::setDisplacementScale(float scale)
+{
+  m_displacementScale = scale;
+  emit displacementScaleChanged(scale);
+}
+
 Index Molecule::findAtomUniqueId(Index index) const
 {
   for (Index i = 0; i < static_cast<Index>(m_atomUniqueIds.size()); ++i)
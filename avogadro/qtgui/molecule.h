@@ -169,6 +169,15 @@ public:
   virtual BondType addBond(const AtomType& a, const AtomType& b,
                            unsigned char bondOrder, Index uniqueId);
 
+  /**
+   * @brief Add bonds between each of the atom pairs, which must not be bonded
+   * yet.
+   * @param pairs The atom pairs to bond.
+   * @param bondOrder The order of the new bonds.
+   */
+  void addBonds(const Core::Array<std::pair<Index, Index>>& pairs,
+                unsigned char bondOrder = 1) override;
+
   /**
    * @brief Remove the specified bond.
    * @param index The index of the bond to be removed.
@@ -196,6 +205,11 @@ public:
   bool removeBond(Index atom1, Index atom2) override;
   /** @} */
 
+  /**
+   * @brief Remove all bonds from the molecule.
+   */
+  void clearBonds() override;
+
   /**
    * @brief Get the bond referenced by the @p uniqueId, the isValid method
    * should be queried to ensure the id still referenced a valid bond.
@@ -223,6 +237,12 @@ public:
 
   RWMolecule* undoMolecule();
 
+  /**
+   * The factor, in [-1, 1], that views apply to vibrationDisplacements() when
+   * rendering the molecule.
+   */
+  float displacementScale() const { return m_displacementScale; }
+
 public slots:
   /**
    * @brief Force the molecule to emit the changed() signal.
@@ -230,6 +250,13 @@ public slots:
    */
   void emitChanged(unsigned int change);
 
+  /**
+   * @brief Set the displacement scale and emit displacementScaleChanged().
+   * Unlike changed(), this only requires views to redraw, which is what keeps
+   * vibration animations cheap for large molecules.
+   */
+  void setDisplacementScale(float scale);
+
 signals:
   /**
    * @brief Indicates that the molecule has changed.
@@ -241,9 +268,15 @@ signals:
    */
   void changed(unsigned int change);
 
+  /**
+   * @brief Indicates that the displacement scale has changed.
+   */
+  void displacementScaleChanged(float scale);
+
 private:
   Core::Array<Index> m_atomUniqueIds;
   Core::Array<Index> m_bondUniqueIds;
+  float m_displacementScale;
 
   friend class RWMolecule;
 
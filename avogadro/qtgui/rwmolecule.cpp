@@ -465,6 +465,15 @@ public:
     , m_newPosition3ds(1, newPosition3d)
   {}
 
+  SetPosition3dCommand(RWMolecule& m, const Array<Index>& atomIds,
+                       const Array<Vector3>& oldPosition3ds,
+                       const Array<Vector3>& newPosition3ds)
+    : MergeUndoCommand<SetPosition3dMergeId>(m)
+    , m_atomIds(atomIds)
+    , m_oldPosition3ds(oldPosition3ds)
+    , m_newPosition3ds(newPosition3ds)
+  {}
+
   void redo() override
   {
     for (size_t i = 0; i < m_atomIds.size(); ++i)
@@ -535,6 +544,31 @@ bool RWMolecule::setAtomPosition3d(Index atomId, const Vector3& pos,
   return true;
 }
 
+bool RWMolecule::setAtomPositions3d(const Core::Array<Index>& atomIds,
+                                    const Core::Array<Vector3>& pos,
+                                    const QString& undoText)
+{
+  if (atomIds.size() != pos.size() ||
+      m_molecule.m_positions3d.size() != m_molecule.m_atomicNumbers.size()) {
+    return false;
+  }
+
+  Core::Array<Vector3> oldPos;
+  oldPos.reserve(atomIds.size());
+  for (Index i = 0; i < atomIds.size(); ++i) {
+    if (atomIds[i] >= atomCount())
+      return false;
+    oldPos.push_back(m_molecule.m_positions3d[atomIds[i]]);
+  }
+
+  SetPosition3dCommand* comm =
+    new SetPosition3dCommand(*this, atomIds, oldPos, pos);
+  comm->setText(undoText);
+  comm->setCanMerge(m_interactive);
+  m_undoStack.push(comm);
+  return true;
+}
+
 void RWMolecule::setAtomSelected(Index atomId, bool selected)
 {
   // FIXME: Add in an implementation (and use it from the selection tool).
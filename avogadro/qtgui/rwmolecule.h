@@ -235,6 +235,18 @@ public:
     Index atomId, const Vector3& pos,
     const QString& undoText = QStringLiteral("Change Atom Position"));
 
+  /**
+   * Set the 3D positions of several atoms in one undo command. In interactive
+   * mode the command merges with those of setAtomPosition3d().
+   * @param atomIds The indices of the atoms to modify.
+   * @param pos The new positions, in the same order as @a atomIds.
+   * @param undoText The undo text to be displayed for undo commands.
+   * @return True on success, false otherwise.
+   */
+  bool setAtomPositions3d(
+    const Core::Array<Index>& atomIds, const Core::Array<Vector3>& pos,
+    const QString& undoText = QStringLiteral("Change Atom Positions"));
+
   /**
    * Set whether the specified atom is selected or not.
    */
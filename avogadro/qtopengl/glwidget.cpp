@@ -28,6 +28,7 @@
 #include <QtCore/QTimer>
 #include <QtGui/QKeyEvent>
 #include <QtGui/QMouseEvent>
+#include <QtGui/QOpenGLContext>
 #include <QtGui/QWheelEvent>
 #include <QtWidgets/QAction>
 #include <QtWidgets/QApplication>
@@ -35,31 +36,73 @@
 namespace Avogadro {
 namespace QtOpenGL {
 
+/**
+ * The scene rendered by all of the GLWidgets with the same molecule, scene
+ * plugins and OpenGL context group.
+ */
+class SharedScene
+{
+public:
+  SharedScene() : molecule(nullptr), contextGroup(nullptr), builder(nullptr)
+  {
+  }
+
+  Rendering::Scene scene;
+  const QtGui::Molecule* molecule;
+  QStringList plugins;
+  QOpenGLContextGroup* contextGroup;
+  QList<GLWidget*> views;
+  /** The view whose scene plugins built the scene, nullptr until built. */
+  GLWidget* builder;
+};
+
+namespace {
+QList<SharedScene*> sharedScenes;
+
+QStringList activePluginNames(const QtGui::ScenePluginModel& model)
+{
+  QStringList names;
+  foreach (QtGui::ScenePlugin* plugin, model.activeScenePlugins())
+    names << plugin->name();
+  return names;
+}
+}
+
 GLWidget::GLWidget(QWidget* p)
   : QOpenGLWidget(p), m_activeTool(nullptr), m_defaultTool(nullptr),
-    m_renderTimer(nullptr)
+    m_sharedScene(nullptr), m_renderTimer(nullptr)
 {
   setFocusPolicy(Qt::ClickFocus);
   connect(&m_scenePlugins,
           SIGNAL(pluginStateChanged(Avogadro::QtGui::ScenePlugin*)),
-          SLOT(updateScene()));
+          SLOT(scenePluginsChanged()));
   connect(&m_scenePlugins, SIGNAL(pluginConfigChanged()), SLOT(updateScene()));
   m_renderer.setTextRenderStrategy(new QtTextRenderStrategy);
 }
 
 GLWidget::~GLWidget()
 {
+  // Release the scene while the context still exists, other views may keep
+  // rendering a shared scene.
+  if (context())
+    disconnect(context(), 0, this, 0);
+  makeCurrent();
+  leaveSharedScene();
+  m_renderer.scene().clear();
+  m_renderer.viewNode().clear();
 }
 
 void GLWidget::setMolecule(QtGui::Molecule* mol)
 {
   clearScene();
   if (m_molecule)
-    disconnect(m_molecule, 0, 0, 0);
+    disconnect(m_molecule, 0, this, 0);
   m_molecule = mol;
   foreach (QtGui::ToolPlugin* tool, m_tools)
     tool->setMolecule(m_molecule);
-  connect(m_molecule, SIGNAL(changed(unsigned int)), SLOT(updateScene()));
+  connect(m_molecule, SIGNAL(changed(unsigned int)), SLOT(moleculeChanged()));
+  connect(m_molecule, SIGNAL(displacementScaleChanged(float)),
+          SLOT(updateDisplacementScale()));
 }
 
 QtGui::Molecule* GLWidget::molecule()
@@ -79,6 +122,10 @@ void GLWidget::updateScene()
   if (!mol)
     mol = new QtGui::Molecule(this);
   if (mol) {
+    // Another view may have uploaded the geometry being replaced, make sure a
+    // context of the group is current to release it.
+    makeCurrent();
+    updateSharedScene();
     Rendering::GroupNode& node = m_renderer.scene().rootNode();
     node.clear();
     Rendering::GroupNode* moleculeNode = new Rendering::GroupNode(&node);
@@ -89,27 +136,57 @@ void GLWidget::updateScene()
       scenePlugin->process(*mol, *engineNode);
     }
 
-    // Let the tools perform any drawing they need to do.
-    if (m_activeTool) {
-      Rendering::GroupNode* toolNode = new Rendering::GroupNode(moleculeNode);
-      m_activeTool->draw(*toolNode);
-    }
+    m_renderer.scene().setDisplacementScale(mol->displacementScale());
 
-    if (m_defaultTool) {
-      Rendering::GroupNode* toolNode = new Rendering::GroupNode(moleculeNode);
-      m_defaultTool->draw(*toolNode);
+    if (m_sharedScene) {
+      m_sharedScene->builder = this;
+      foreach (GLWidget* view, m_sharedScene->views) {
+        view->m_renderer.resetGeometry();
+        view->update();
+      }
+    } else {
+      m_renderer.resetGeometry();
     }
-
-    m_renderer.resetGeometry();
-    update();
+    updateTools();
   }
   if (mol != m_molecule)
     delete mol;
 }
 
+void GLWidget::updateTools()
+{
+  makeCurrent();
+  Rendering::GroupNode& node = m_renderer.viewNode();
+  node.clear();
+
+  // Let the tools perform any drawing they need to do.
+  if (m_activeTool) {
+    Rendering::GroupNode* toolNode = new Rendering::GroupNode(&node);
+    m_activeTool->draw(*toolNode);
+  }
+
+  if (m_defaultTool) {
+    Rendering::GroupNode* toolNode = new Rendering::GroupNode(&node);
+    m_defaultTool->draw(*toolNode);
+  }
+  update();
+}
+
+void GLWidget::updateDisplacementScale()
+{
+  // The geometry already holds the displacements, so just redraw.
+  if (m_molecule) {
+    m_renderer.scene().setDisplacementScale(m_molecule->displacementScale());
+    update();
+  }
+}
+
 void GLWidget::clearScene()
 {
+  makeCurrent();
+  leaveSharedScene();
   m_renderer.scene().clear();
+  m_renderer.viewNode().clear();
 }
 
 void GLWidget::resetCamera()
@@ -162,7 +239,7 @@ void GLWidget::setActiveTool(QtGui::ToolPlugin* tool)
 
   if (m_activeTool && m_activeTool != m_defaultTool) {
     disconnect(m_activeTool, SIGNAL(drawablesChanged()), this,
-               SLOT(updateScene()));
+               SLOT(updateTools()));
   }
 
   if (tool)
@@ -171,7 +248,7 @@ void GLWidget::setActiveTool(QtGui::ToolPlugin* tool)
 
   if (m_activeTool && m_activeTool != m_defaultTool) {
     connect(m_activeTool, SIGNAL(drawablesChanged()), this,
-            SLOT(updateScene()));
+            SLOT(updateTools()));
   }
 }
 
@@ -193,7 +270,7 @@ void GLWidget::setDefaultTool(QtGui::ToolPlugin* tool)
 
   if (m_defaultTool && m_activeTool != m_defaultTool) {
     disconnect(m_defaultTool, SIGNAL(drawablesChanged()), this,
-               SLOT(updateScene()));
+               SLOT(updateTools()));
   }
 
   if (tool)
@@ -202,7 +279,7 @@ void GLWidget::setDefaultTool(QtGui::ToolPlugin* tool)
 
   if (m_defaultTool && m_activeTool != m_defaultTool) {
     connect(m_defaultTool, SIGNAL(drawablesChanged()), this,
-            SLOT(updateScene()));
+            SLOT(updateTools()));
   }
 }
 
@@ -225,11 +302,111 @@ void GLWidget::updateTimeout()
   update();
 }
 
+void GLWidget::moleculeChanged()
+{
+  // Every view of the molecule is notified, only one of them rebuilds the
+  // scene they share.
+  if (m_sharedScene && m_sharedScene->builder &&
+      m_sharedScene->builder != this) {
+    updateTools();
+    return;
+  }
+  updateScene();
+}
+
+void GLWidget::scenePluginsChanged()
+{
+  makeCurrent();
+  bool built = updateSharedScene();
+  if (built)
+    updateTools();
+  else
+    updateScene();
+}
+
+void GLWidget::contextAboutToBeDestroyed()
+{
+  // The widget is moving to another window, the scene is rebuilt for its new
+  // context in initializeGL().
+  makeCurrent();
+  leaveSharedScene();
+  m_renderer.scene().clear();
+  m_renderer.viewNode().clear();
+}
+
+bool GLWidget::updateSharedScene()
+{
+  QOpenGLContextGroup* group =
+    context() && m_renderer.isValid() ? context()->shareGroup() : nullptr;
+  QStringList plugins(activePluginNames(m_scenePlugins));
+  if (m_sharedScene && m_sharedScene->molecule == m_molecule &&
+      m_sharedScene->plugins == plugins &&
+      m_sharedScene->contextGroup == group) {
+    return false;
+  }
+
+  leaveSharedScene();
+  if (!m_molecule || !group)
+    return false;
+
+  foreach (SharedScene* shared, sharedScenes) {
+    if (shared->molecule == m_molecule && shared->plugins == plugins &&
+        shared->contextGroup == group) {
+      m_sharedScene = shared;
+      break;
+    }
+  }
+  if (!m_sharedScene) {
+    m_sharedScene = new SharedScene;
+    m_sharedScene->molecule = m_molecule;
+    m_sharedScene->plugins = plugins;
+    m_sharedScene->contextGroup = group;
+    sharedScenes << m_sharedScene;
+  }
+  m_sharedScene->views << this;
+
+  // The widget's own scene is not needed while it is sharing.
+  m_renderer.scene().clear();
+  m_renderer.setScene(&m_sharedScene->scene);
+  return m_sharedScene->builder != nullptr;
+}
+
+void GLWidget::leaveSharedScene()
+{
+  if (!m_sharedScene)
+    return;
+
+  m_sharedScene->views.removeOne(this);
+  if (m_sharedScene->views.isEmpty()) {
+    sharedScenes.removeOne(m_sharedScene);
+    delete m_sharedScene;
+  } else if (m_sharedScene->builder == this) {
+    m_sharedScene->builder = m_sharedScene->views.first();
+  }
+  m_sharedScene = nullptr;
+  m_renderer.setScene(nullptr);
+}
+
 void GLWidget::initializeGL()
 {
   m_renderer.initialize();
-  if (!m_renderer.isValid())
+  if (!m_renderer.isValid()) {
     emit rendererInvalid();
+    return;
+  }
+
+  connect(context(), SIGNAL(aboutToBeDestroyed()),
+          SLOT(contextAboutToBeDestroyed()));
+
+  // The context group is known now, so the scene can be shared.
+  if (m_molecule) {
+    if (updateSharedScene()) {
+      m_renderer.resetGeometry();
+      updateTools();
+    } else {
+      updateScene();
+    }
+  }
 }
 
 void GLWidget::resizeGL(int width_, int height_)
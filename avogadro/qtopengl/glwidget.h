@@ -35,6 +35,7 @@ class ToolPlugin;
 }
 
 namespace QtOpenGL {
+class SharedScene;
 
 /**
  * @class GLWidget glwidget.h <avogadro/qtopengl/glwidget.h>
@@ -50,6 +51,14 @@ namespace QtOpenGL {
  * will be given the opportunity to handle input events first. If the active
  * tool does not handle the event, the default tool will be used. If the default
  * tool also ignores the event, it will be passed to QOpenGLWidget's handlers.
+ *
+ * GLWidgets showing the same molecule with the same scene plugins, and whose
+ * contexts share OpenGL objects, render one shared scene. It is built and
+ * uploaded once, while each widget keeps its own camera and tool overlays.
+ * Widgets in the same window share contexts, set the
+ * Qt::AA_ShareOpenGLContexts application attribute to share them across
+ * windows. The shared scene is built with the scene plugins of the widget that
+ * last updated it, so configuring a plugin in one view applies to them all.
  */
 
 class AVOGADROQTOPENGL_EXPORT GLWidget : public QOpenGLWidget
@@ -122,6 +131,17 @@ public slots:
    */
   void updateScene();
 
+  /**
+   * Let the tools redraw their overlays, without regenerating the scene.
+   */
+  void updateTools();
+
+  /**
+   * Apply the molecule's displacement scale to the scene and redraw, without
+   * regenerating any geometry.
+   */
+  void updateDisplacementScale();
+
   /**
    * Clear the contents of the scene.
    */
@@ -176,6 +196,16 @@ protected slots:
    */
   void updateTimeout();
 
+private slots:
+  /** Rebuild the scene once for all of the views sharing it. */
+  void moleculeChanged();
+
+  /** Join the scene of other views using the same scene plugins, if any. */
+  void scenePluginsChanged();
+
+  /** Release the GL objects of the scene before the context goes away. */
+  void contextAboutToBeDestroyed();
+
 protected:
   /** This is where the GL context is initialized. */
   void initializeGL() override;
@@ -197,12 +227,24 @@ protected:
   /** @} */
 
 private:
+  /**
+   * Join the shared scene matching the molecule, scene plugins and context of
+   * the widget, creating it if needed. Must be called with the context
+   * current.
+   * @return True if the scene was already built by another view.
+   */
+  bool updateSharedScene();
+
+  /** Stop sharing a scene, the context must be current. */
+  void leaveSharedScene();
+
   QPointer<QtGui::Molecule> m_molecule;
   QList<QtGui::ToolPlugin*> m_tools;
   QtGui::ToolPlugin* m_activeTool;
   QtGui::ToolPlugin* m_defaultTool;
   Rendering::GLRenderer m_renderer;
   QtGui::ScenePluginModel m_scenePlugins;
+  SharedScene* m_sharedScene;
 
   QTimer* m_renderTimer;
 };
@@ -64,6 +64,12 @@ void BallAndStick::process(const Molecule& molecule, Rendering::GroupNode& node)
   spheres->identifier().type = Rendering::AtomType;
   geometry->addDrawable(spheres);
 
+  // An animated vibration is applied by the shaders, see Spectra.
+  const Core::Array<Vector3>& displacements =
+    molecule.vibrationDisplacements();
+  bool animated = displacements.size() == molecule.atomCount();
+  Core::Array<Vector3f> sphereDisplacements;
+
   for (Index i = 0; i < molecule.atomCount(); ++i) {
     Core::Atom atom = molecule.atom(i);
     unsigned char atomicNumber = atom.atomicNumber();
@@ -77,13 +83,18 @@ void BallAndStick::process(const Molecule& molecule, Rendering::GroupNode& node)
       radius *= 1.2;
     }
     spheres->addSphere(atom.position3d().cast<float>(), color, radius * 0.3f);
+    if (animated)
+      sphereDisplacements.push_back(displacements[i].cast<float>());
   }
+  if (animated)
+    spheres->setDisplacements(sphereDisplacements);
 
   float bondRadius = 0.1f;
   CylinderGeometry* cylinders = new CylinderGeometry;
   cylinders->identifier().molecule = &molecule;
   cylinders->identifier().type = Rendering::BondType;
   geometry->addDrawable(cylinders);
+  std::vector<Vector3f> cylinderDisplacements;
   for (Index i = 0; i < molecule.bondCount(); ++i) {
     Core::Bond bond = molecule.bond(i);
     if (!m_showHydrogens && (bond.atom1().atomicNumber() == 1 ||
@@ -97,6 +108,7 @@ void BallAndStick::process(const Molecule& molecule, Rendering::GroupNode& node)
     Vector3f bondVector = pos2 - pos1;
     float bondLength = bondVector.norm();
     bondVector /= bondLength;
+    size_t firstCylinder = cylinders->size();
     switch (m_multiBonds ? bond.order() : 1) {
       case 3: {
         Vector3f delta = bondVector.unitOrthogonal() * (2.0f * bondRadius);
@@ -117,7 +129,19 @@ void BallAndStick::process(const Molecule& molecule, Rendering::GroupNode& node)
                                color2, i);
       }
     }
+    if (animated) {
+      Vector3f displacement1 =
+        displacements[bond.atom1().index()].cast<float>();
+      Vector3f displacement2 =
+        displacements[bond.atom2().index()].cast<float>();
+      for (size_t j = firstCylinder; j < cylinders->size(); ++j) {
+        cylinderDisplacements.push_back(displacement1);
+        cylinderDisplacements.push_back(displacement2);
+      }
+    }
   }
+  if (animated)
+    cylinders->setDisplacements(cylinderDisplacements);
 }
 
 void BallAndStick::processEditable(const QtGui::RWMolecule& molecule,
@@ -15,6 +15,7 @@
 ******************************************************************************/
 
 #include "coordinateeditordialog.h"
+#include "coordinatehighlighter.h"
 #include "coordinatetextedit.h"
 #include "ui_coordinateeditordialog.h"
 
@@ -25,12 +26,14 @@
 #include <avogadro/core/coordinateblockgenerator.h>
 #include <avogadro/core/crystaltools.h>
 #include <avogadro/core/elements.h>
+#include <avogadro/core/unitcell.h>
 #include <avogadro/core/vector.h>
 
 #include <QtGui/QClipboard>
 #include <QtGui/QFont>
 #include <QtGui/QIcon>
 #include <QtGui/QRegExpValidator>
+#include <QtGui/QTextBlock>
 #include <QtGui/QTextCursor>
 #include <QtGui/QTextDocument>
 #include <QtWidgets/QApplication>
@@ -42,6 +45,7 @@
 #include <QtCore/QMutableListIterator>
 #include <QtCore/QRegExp>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QTimer>
 
 // Define this to print out details of the format detection algorithm.
@@ -70,7 +74,9 @@ static const QString EDITOR_FONT = "Monospace";
 // Various integer constants.
 enum
 {
-  CustomPreset = 0
+  CustomPreset = 0,
+  // Minimum time in ms between text updates while the molecule changes.
+  TextUpdateInterval = 100
 };
 
 // Distance unit indices -- keep in sync with the .ui file.
@@ -90,7 +96,6 @@ enum TokenType
 
 // Some frequently used regexes:
 static const QRegExp TOKEN_SEPARATOR("[\\s,;]+");
-static const QRegExp VALID_TOKEN("[^\\s,;]+");
 static const QRegExp INT_CHECKER("(:?[+-])?\\d+");
 static const QRegExp DOUBLE_CHECKER("(:?[+-])?" // Leading sign
                                     "(:?" // Must match one of the following:
@@ -113,42 +118,16 @@ struct AtomStruct
 namespace Avogadro {
 namespace QtPlugins {
 
-// Storage class used to hold state while validating input.
-class CoordinateEditorDialog::ValidateStorage
-{
-public:
-  ValidateStorage()
-    : isValidating(false), restartWhenFinished(false), collectAtoms(false),
-      convertDistance(false), latticePositions(false), distanceConversion(1.f)
-  {
-  }
-
-  bool isValidating;
-  bool restartWhenFinished;
-  bool collectAtoms;
-  bool convertDistance;
-  bool latticePositions;
-  float distanceConversion;
-
-  // Format specification
-  QString spec;
-
-  // Text cursors
-  QTextCursor lineCursor;
-  QTextCursor tokenCursor;
-
-  // Accumulate atom data
-  QVector<AtomStruct> atoms;
-};
-
 CoordinateEditorDialog::CoordinateEditorDialog(QWidget* parent_)
   : QDialog(parent_), m_ui(new Ui::CoordinateEditorDialog), m_molecule(nullptr),
-    m_validate(new ValidateStorage), m_defaultSpec("SZxyz#N")
+    m_textUpdateTimer(new QTimer(this)), m_textOutdated(true),
+    m_textInSync(false), m_defaultSpec("SZxyz#N")
 {
   m_ui->setupUi(this);
 
   // Set up text editor
   m_ui->text->setFont(QFont(EDITOR_FONT, qApp->font().pointSize()));
+  m_highlighter = new CoordinateHighlighter(m_ui->text->document());
   connect(m_ui->text->document(), SIGNAL(modificationChanged(bool)),
           SLOT(textModified(bool)));
 
@@ -176,6 +155,10 @@ CoordinateEditorDialog::CoordinateEditorDialog(QWidget* parent_)
   m_ui->copy->setIcon(QIcon::fromTheme("edit-copy"));
   m_ui->paste->setIcon(QIcon::fromTheme("edit-paste"));
 
+  m_textUpdateTimer->setSingleShot(true);
+  m_textUpdateTimer->setInterval(TextUpdateInterval);
+  connect(m_textUpdateTimer, SIGNAL(timeout()), SLOT(updateText()));
+
   buildPresets();
   listenForTextEditChanges(true);
 }
@@ -200,7 +183,10 @@ void CoordinateEditorDialog::moleculeChanged(uint change)
 {
   if (static_cast<Molecule::MoleculeChange>(change) & Molecule::Atoms ||
       static_cast<Molecule::MoleculeChange>(change) & Molecule::UnitCell) {
-    updateText();
+    // Regenerate at most once per interval, e.g. during an optimization.
+    m_textInSync = false;
+    if (!m_textUpdateTimer->isActive())
+      m_textUpdateTimer->start();
   }
 }
 
@@ -232,6 +218,13 @@ void CoordinateEditorDialog::specEdited()
 
 void CoordinateEditorDialog::updateText()
 {
+  m_textUpdateTimer->stop();
+  if (!isVisible()) {
+    m_textOutdated = true;
+    return;
+  }
+  m_textOutdated = false;
+
   if (m_ui->text->document()->isModified()) {
     int reply = QMessageBox::question(
       this, tr("Overwrite changes?"),
@@ -239,8 +232,10 @@ void CoordinateEditorDialog::updateText()
          "you like to discard your changes and revert "
          "to the current molecule?"),
       QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
-    if (reply != QMessageBox::Yes)
+    if (reply != QMessageBox::Yes) {
+      m_textInSync = false;
       return;
+    }
   }
 
   Core::CoordinateBlockGenerator gen;
@@ -255,13 +250,62 @@ void CoordinateEditorDialog::updateText()
       gen.setDistanceUnit(Core::CoordinateBlockGenerator::Bohr);
       break;
   }
+  QString text(QString::fromStdString(gen.generateCoordinateBlock()));
 
-  // Disable markup for the generated text.
   listenForTextEditChanges(false);
-  m_ui->text->document()->setPlainText(
-    QString::fromStdString(gen.generateCoordinateBlock()));
+  QTextDocument* doc(m_ui->text->document());
+  if (updateChangedLines(text.split('\n'))) {
+    doc->clearUndoRedoStacks();
+  } else {
+    // Parse the new text once, with its own specification, rather than
+    // against the old one first.
+    doc->clear();
+    m_highlighter->setSpecification(QString());
+    doc->setPlainText(text);
+  }
+  updateSpecification();
+
+  // Remember which atom each line describes, and the revision of the line
+  // at that point to tell the edited lines apart when applying.
+  int atomIndex = 0;
+  for (QTextBlock block = doc->begin(); block.isValid(); block = block.next()) {
+    CoordinateLineData* line = m_highlighter->line(block);
+    line->atomIndex = line->blank ? -1 : atomIndex++;
+    line->generatedRevision = block.revision();
+  }
   listenForTextEditChanges(true);
-  m_ui->text->document()->setModified(false);
+  doc->setModified(false);
+  m_textInSync = true;
+}
+
+bool CoordinateEditorDialog::updateChangedLines(const QStringList& lines)
+{
+  QTextDocument* doc(m_ui->text->document());
+  if (doc->blockCount() != lines.size())
+    return false;
+
+  QList<int> changed;
+  QTextBlock block(doc->begin());
+  for (int i = 0; i < lines.size(); ++i, block = block.next()) {
+    if (block.text() != lines[i])
+      changed << i;
+  }
+  // Editing block by block is slower than setPlainText() once a good part of
+  // the document changes, e.g. after an optimization step.
+  if (changed.size() > lines.size() / 4)
+    return false;
+  if (changed.isEmpty())
+    return true;
+
+  QTextCursor cur(doc);
+  cur.beginEditBlock();
+  foreach (int i, changed) {
+    cur.setPosition(doc->findBlockByNumber(i).position());
+    cur.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+    cur.insertText(lines[i]);
+  }
+  cur.endEditBlock();
+  return true;
 }
 
 void CoordinateEditorDialog::helpClicked()
@@ -273,248 +317,32 @@ void CoordinateEditorDialog::helpClicked()
   QToolTip::showText(point, m_ui->spec->toolTip(), m_ui->spec);
 }
 
-void CoordinateEditorDialog::validateInput()
+void CoordinateEditorDialog::updateSpecification()
 {
-  if (m_validate->isValidating) {
-    m_validate->restartWhenFinished = true;
-    return;
-  }
-
-  // Reset formatting. Stop listening for changes since format changes will
-  // retrigger validation.
+  // Changing the specification reformats the text, which must not trigger
+  // another update.
   listenForTextEditChanges(false);
-  m_ui->text->resetMarks();
+  m_highlighter->setSpecification(detectInputFormat());
   listenForTextEditChanges(true);
-
-  // No text, nothing to do! Trim the plain text - this fixes a crashing
-  // bug if the user accidentally presses return in a blank document.
-  if (m_ui->text->document()->toPlainText().trimmed().isEmpty()) {
-    emit validationFinished(true);
-    return;
-  }
-
-  // Try to detect the input format
-  QString inputFormat(detectInputFormat());
-  if (inputFormat.isEmpty()) {
-    emit validationFinished(false);
-    return;
-  }
-
-  // Initialize
-  m_validate->latticePositions = inputFormat.contains('a');
-  m_validate->isValidating = true;
-  m_validate->spec = inputFormat;
-  m_validate->lineCursor = QTextCursor(m_ui->text->document());
-
-  // Start the worker
-  validateInputWorker();
 }
 
-void CoordinateEditorDialog::validateInputWorker()
+bool CoordinateEditorDialog::validateInput()
 {
-  if (!m_validate->isValidating)
-    return;
+  updateSpecification();
 
-  // Disable revalidation due to formatting changes.
+  // Only lines edited since they were last highlighted are parsed here.
   listenForTextEditChanges(false);
-
-  // Setup some aliases to keep code concise:
-  const QString& spec(m_validate->spec);
-  QTextCursor& lineCursor(m_validate->lineCursor);
-  QTextCursor& tokenCursor(m_validate->tokenCursor);
-
   QTextDocument* doc(m_ui->text->document());
-  QString::const_iterator begin(spec.constBegin());
-  QString::const_iterator end(spec.constEnd());
-  QString::const_iterator iter;
-
-  // Only do a few lines at a time, then return control to the event loop.
-  int lineThisIteration = 0;
-
-  while (++lineThisIteration <= 10 && !lineCursor.atEnd()) {
-    // Place the entire line in the line cursor's selection.
-    lineCursor.movePosition(QTextCursor::StartOfLine, QTextCursor::MoveAnchor);
-    lineCursor.movePosition(QTextCursor::EndOfLine, QTextCursor::KeepAnchor);
-
-    // Skip empty lines - this is nice if the user accidentally left some
-    // empty lines at the end of the input
-    if (lineCursor.selectedText().trimmed().isEmpty()) {
-      // So that we don't have an infinite loop...
-      if (!lineCursor.atEnd()) {
-        lineCursor.movePosition(QTextCursor::Down);
-        lineCursor.movePosition(QTextCursor::StartOfLine);
-      }
-      continue;
-    }
-
-    // Start the token cursor at the beginning of the current line.
-    tokenCursor.setPosition(lineCursor.anchor(), QTextCursor::MoveAnchor);
-
-    // This is used when applying changes to store the atom specifications.
-    AtomStruct atom;
-
-    // Iterate through spec characters
-    for (iter = begin; iter != end; ++iter) {
-      // Place the next valid token in tokenCursor's selection:
-      tokenCursor = doc->find(VALID_TOKEN, tokenCursor);
-
-      // If the token cursor has moved off of the current line, mark the entire
-      // line as invalid and move on.
-      if (tokenCursor.isNull() ||
-          tokenCursor.position() > lineCursor.position()) {
-        m_ui->text->markInvalid(lineCursor, tr("Too few entries on line."));
-        break;
-      }
-
-      switch (iter->toLatin1()) {
-        case '?': // Nothing to validate other than that this is a valid token.
-          break;
-
-        case 'N': {
-          // Validate name:
-          QString cleanToken(tokenCursor.selectedText().toLower());
-          if (!cleanToken.isEmpty())
-            cleanToken.replace(0, 1, cleanToken[0].toUpper());
-          std::string tokenStd(cleanToken.toStdString());
-          atom.atomicNumber = Elements::atomicNumberFromName(tokenStd);
-          if (atom.atomicNumber == Avogadro::InvalidElement)
-            m_ui->text->markInvalid(tokenCursor, tr("Invalid element name."));
-          else
-            m_ui->text->markValid(tokenCursor, tr("Element name."));
-          break;
-        }
-
-        case 'S': {
-          // Validate symbol:
-          QString cleanToken(tokenCursor.selectedText().toLower());
-          if (!cleanToken.isEmpty())
-            cleanToken.replace(0, 1, cleanToken[0].toUpper());
-          std::string tokenStd(cleanToken.toStdString());
-          atom.atomicNumber = Elements::atomicNumberFromSymbol(tokenStd);
-          if (atom.atomicNumber == Avogadro::InvalidElement)
-            m_ui->text->markInvalid(tokenCursor, tr("Invalid element symbol."));
-          else
-            m_ui->text->markValid(tokenCursor, tr("Element symbol."));
-          break;
-        }
-
-        case 'Z': {
-          // Validate integer:
-          bool isInt;
-          atom.atomicNumber = static_cast<unsigned char>(
-            tokenCursor.selectedText().toInt(&isInt));
-          if (!isInt)
-            m_ui->text->markInvalid(tokenCursor, tr("Invalid atomic number."));
-          else
-            m_ui->text->markValid(tokenCursor, tr("Atomic number."));
-          break;
-        }
-
-        case 'x': {
-          // Validate real:
-          bool isReal;
-          atom.pos.x() = tokenCursor.selectedText().toDouble(&isReal);
-          if (!isReal)
-            m_ui->text->markInvalid(tokenCursor, tr("Invalid coordinate."));
-          else
-            m_ui->text->markValid(tokenCursor, tr("X coordinate."));
-          break;
-        }
-
-        case 'y': {
-          // Validate real:
-          bool isReal;
-          atom.pos.y() = tokenCursor.selectedText().toDouble(&isReal);
-          if (!isReal)
-            m_ui->text->markInvalid(tokenCursor, tr("Invalid coordinate."));
-          else
-            m_ui->text->markValid(tokenCursor, tr("Y coordinate."));
-          break;
-        }
-
-        case 'z': {
-          // Validate real:
-          bool isReal;
-          atom.pos.z() = tokenCursor.selectedText().toDouble(&isReal);
-          if (!isReal)
-            m_ui->text->markInvalid(tokenCursor, tr("Invalid coordinate."));
-          else
-            m_ui->text->markValid(tokenCursor, tr("Z coordinate."));
-          break;
-        }
-
-        case 'a': {
-          // Validate real:
-          bool isReal;
-          atom.pos.x() = tokenCursor.selectedText().toDouble(&isReal);
-          if (!isReal)
-            m_ui->text->markInvalid(tokenCursor, tr("Invalid coordinate."));
-          else
-            m_ui->text->markValid(tokenCursor, tr("'a' lattice coordinate."));
-          break;
-        }
-
-        case 'b': {
-          // Validate real:
-          bool isReal;
-          atom.pos.y() = tokenCursor.selectedText().toDouble(&isReal);
-          if (!isReal)
-            m_ui->text->markInvalid(tokenCursor, tr("Invalid coordinate."));
-          else
-            m_ui->text->markValid(tokenCursor, tr("'b' lattice coordinate."));
-          break;
-        }
-
-        case 'c': {
-          // Validate real:
-          bool isReal;
-          atom.pos.z() = tokenCursor.selectedText().toDouble(&isReal);
-          if (!isReal)
-            m_ui->text->markInvalid(tokenCursor, tr("Invalid coordinate."));
-          else
-            m_ui->text->markValid(tokenCursor, tr("'c' coordinate."));
-          break;
-        }
-
-        default:
-          qWarning() << "Unhandled character in detected spec: " << *iter;
-          break;
-      }
-    }
-
-    // Store this atom info if collecting.
-    if (m_validate->collectAtoms) {
-      if (m_validate->convertDistance && !m_validate->latticePositions)
-        atom.pos *= m_validate->distanceConversion;
-      m_validate->atoms << atom;
-    }
-
-    // Move down to the next line if we are not at the end. Moving to the
-    // start of the line after moving down is necessary in case moving down
-    // puts us at the end of the document.
-    if (!lineCursor.atEnd()) {
-      lineCursor.movePosition(QTextCursor::Down);
-      lineCursor.movePosition(QTextCursor::StartOfLine);
-    }
+  bool valid(true);
+  for (QTextBlock block = doc->begin(); block.isValid(); block = block.next()) {
+    const CoordinateLineData* line = m_highlighter->line(block);
+    if (!line->blank && !line->valid)
+      valid = false;
   }
-
-  // Reenable validation.
   listenForTextEditChanges(true);
 
-  // If we're not at the end, post this method back into the event loop.
-  if (!lineCursor.atEnd()) {
-    QTimer::singleShot(0, this, SLOT(validateInputWorker()));
-  } else {
-    // Otherwise emit the finished signal.
-    emit validationFinished(!m_ui->text->hasInvalidMarks());
-    m_validate->isValidating = false;
-
-    // If a validation request came in while already validating, revalidate.
-    if (m_validate->restartWhenFinished) {
-      m_validate->restartWhenFinished = false;
-      validateInput();
-    }
-  }
+  emit validationFinished(valid);
+  return valid;
 }
 
 void CoordinateEditorDialog::applyClicked()
@@ -522,45 +350,62 @@ void CoordinateEditorDialog::applyClicked()
   if (!m_molecule)
     return;
 
-  // If we're in the middle of a validation, abort it
-  if (m_validate->isValidating) {
-    m_validate->isValidating = false;
-    qApp->processEvents();
+  if (!validateInput()) {
+    QMessageBox::critical(this, tr("Error applying geometry"),
+                          tr("Could not parse geometry specification. Fix the "
+                             "highlighted errors and try again.\n\n"
+                             "(Hint: Hold the mouse over red text for a "
+                             "description of the error.)"));
+    return;
   }
 
-  m_validate->collectAtoms = true;
-  m_validate->atoms.clear();
+  bool latticePositions(m_highlighter->specification().contains('a'));
+  bool convertDistance(!latticePositions &&
+                       m_ui->distanceUnit->currentIndex() == Bohr);
+  const Core::UnitCell* cell(m_molecule->unitCell());
 
-  switch (m_ui->distanceUnit->currentIndex()) {
-    case Bohr:
-      m_validate->convertDistance = true;
-      m_validate->distanceConversion = BOHR_TO_ANGSTROM_F;
-      break;
-    default:
-      m_validate->convertDistance = false;
-      m_validate->distanceConversion = 1.f;
-      break;
+  // Collect the atoms, and while the lines still map one to one onto the
+  // atoms of the molecule, the positions of the edited ones.
+  QVector<AtomStruct> atoms;
+  bool incremental(m_textInSync && (!latticePositions || cell));
+  Core::Array<Index> changedAtoms;
+  Core::Array<Vector3> changedPositions;
+  QTextDocument* doc(m_ui->text->document());
+  for (QTextBlock block = doc->begin(); block.isValid(); block = block.next()) {
+    const CoordinateLineData* line = m_highlighter->line(block);
+    if (line->blank)
+      continue;
+
+    AtomStruct atom;
+    atom.atomicNumber = line->atomicNumber;
+    atom.pos = line->position;
+    if (convertDistance)
+      atom.pos *= BOHR_TO_ANGSTROM;
+
+    Index index(static_cast<Index>(atoms.size()));
+    if (incremental && (line->atomIndex != atoms.size() ||
+                        index >= m_molecule->atomCount() ||
+                        m_molecule->atomicNumber(index) != atom.atomicNumber)) {
+      incremental = false;
+    } else if (incremental && block.revision() != line->generatedRevision) {
+      changedAtoms.push_back(index);
+      changedPositions.push_back(latticePositions ? cell->toCartesian(atom.pos)
+                                                  : atom.pos);
+    }
+    atoms << atom;
   }
+  if (static_cast<Index>(atoms.size()) != m_molecule->atomCount())
+    incremental = false;
 
-  connect(this, SIGNAL(validationFinished(bool)), SLOT(applyFinish(bool)));
-  validateInput();
-}
+  m_ui->text->document()->setModified(false);
 
-void CoordinateEditorDialog::applyFinish(bool valid)
-{
-  // Clean up
-  m_validate->collectAtoms = false;
-  QVector<AtomStruct> atoms(m_validate->atoms);
-  m_validate->atoms.clear();
-  disconnect(this, SIGNAL(validationFinished(bool)), this,
-             SLOT(applyFinish(bool)));
-
-  if (!valid) {
-    QMessageBox::critical(this, tr("Error applying geometry"),
-                          tr("Could not parse geometry specification. Fix the "
-                             "highlighted errors and try again.\n\n"
-                             "(Hint: Hold the mouse over red text for a "
-                             "description of the error.)"));
+  QString undoText = tr("Edit Atomic Coordinates");
+  if (incremental) {
+    // Only coordinates changed, keep the rest of the molecule and its bonds.
+    if (!changedAtoms.empty()) {
+      m_molecule->undoMolecule()->setAtomPositions3d(
+        changedAtoms, changedPositions, undoText);
+    }
     return;
   }
 
@@ -572,15 +417,13 @@ void CoordinateEditorDialog::applyFinish(bool valid)
   newMolecule.clearAtoms();
   foreach (const AtomStruct& atom, atoms)
     newMolecule.addAtom(atom.atomicNumber).setPosition3d(atom.pos);
-  if (m_validate->latticePositions) {
+  if (latticePositions) {
     Core::CrystalTools::setFractionalCoordinates(newMolecule,
                                                  newMolecule.atomPositions3d());
   } else {
     newMolecule.perceiveBondsSimple();
   }
 
-  m_ui->text->document()->setModified(false);
-
   Molecule::MoleculeChanges change = Molecule::NoChange;
   if (hadAtoms)
     change |= Molecule::Atoms | Molecule::Removed;
@@ -591,7 +434,6 @@ void CoordinateEditorDialog::applyFinish(bool valid)
   if (newMolecule.bondCount() > 0)
     change |= Molecule::Bonds | Molecule::Added;
 
-  QString undoText = tr("Edit Atomic Coordinates");
   m_molecule->undoMolecule()->modifyMolecule(newMolecule, change, undoText);
 }
 
@@ -601,6 +443,14 @@ void CoordinateEditorDialog::textModified(bool modified)
   m_ui->revert->setEnabled(modified);
 }
 
+void CoordinateEditorDialog::showEvent(QShowEvent* e)
+{
+  QDialog::showEvent(e);
+  // Regenerate once the dialog is actually visible.
+  if (m_textOutdated)
+    m_textUpdateTimer->start(0);
+}
+
 void CoordinateEditorDialog::buildPresets()
 {
   // Custom must be first:
@@ -623,25 +473,23 @@ void CoordinateEditorDialog::buildPresets()
 void CoordinateEditorDialog::listenForTextEditChanges(bool enable)
 {
   if (enable)
-    connect(m_ui->text, SIGNAL(textChanged()), this, SLOT(validateInput()));
+    connect(m_ui->text, SIGNAL(textChanged()), this,
+            SLOT(updateSpecification()));
   else
-    disconnect(m_ui->text, SIGNAL(textChanged()), this, SLOT(validateInput()));
+    disconnect(m_ui->text, SIGNAL(textChanged()), this,
+               SLOT(updateSpecification()));
 }
 
 QString CoordinateEditorDialog::detectInputFormat() const
 {
-  if (m_ui->text->document()->isEmpty())
-    return QString();
-
   // Extract the first non-empty line of text from the document.
-  QTextCursor cur(m_ui->text->document());
   QString sample;
-  while (sample.isEmpty()) {
-    cur.movePosition(QTextCursor::StartOfLine, QTextCursor::MoveAnchor);
-    cur.movePosition(QTextCursor::EndOfLine, QTextCursor::KeepAnchor);
-    sample = cur.selectedText();
-    cur.movePosition(QTextCursor::Down);
+  for (QTextBlock block = m_ui->text->document()->begin();
+       block.isValid() && sample.isEmpty(); block = block.next()) {
+    sample = block.text().trimmed();
   }
+  if (sample.isEmpty())
+    return QString();
 
   FORMAT_DEBUG(qDebug() << "\n\nExamining sample:" << sample;)
 
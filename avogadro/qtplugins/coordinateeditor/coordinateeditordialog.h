@@ -19,6 +19,9 @@
 
 #include <QtWidgets/QDialog>
 
+class QStringList;
+class QTimer;
+
 namespace Avogadro {
 namespace QtGui {
 class Molecule;
@@ -26,6 +29,8 @@ class Molecule;
 
 namespace QtPlugins {
 
+class CoordinateHighlighter;
+
 namespace Ui {
 class CoordinateEditorDialog;
 }
@@ -33,6 +38,12 @@ class CoordinateEditorDialog;
 /**
  * @brief The CoordinateEditorDialog class implements a free-text coordinate
  * editor.
+ *
+ * Lines are parsed as they are edited and remember the atom they were
+ * generated from. Applying only moves the atoms whose lines were edited, as
+ * long as the lines still map one to one onto the atoms of the molecule, and
+ * rebuilds the molecule otherwise. Regenerating the text only replaces the
+ * lines that changed, and waits until the dialog is shown.
  */
 class CoordinateEditorDialog : public QDialog
 {
@@ -55,8 +66,7 @@ private slots:
 
   void helpClicked();
 
-  void validateInput();
-  void validateInputWorker();
+  void updateSpecification();
 
   void cutClicked();
   void copyClicked();
@@ -65,13 +75,22 @@ private slots:
   void clearClicked();
 
   void applyClicked();
-  void applyFinish(bool valid);
 
   void textModified(bool modified);
 
+protected:
+  void showEvent(QShowEvent* e) override;
+
 private:
   void buildPresets();
 
+  // Parse the whole document and emit validationFinished().
+  bool validateInput();
+
+  // Replace the lines that differ from @a lines. Returns false, leaving the
+  // document as it is, if replacing the whole text is cheaper.
+  bool updateChangedLines(const QStringList& lines);
+
   // Enable/disable input validation when the text edit is modified.
   void listenForTextEditChanges(bool enable);
 
@@ -79,10 +98,15 @@ private:
 
   Ui::CoordinateEditorDialog* m_ui;
   QtGui::Molecule* m_molecule;
-
-  // State storage for validateInput methods. PIMPL'd for organization.
-  class ValidateStorage;
-  ValidateStorage* m_validate;
+  CoordinateHighlighter* m_highlighter;
+
+  // Throttles the regeneration of the text while the molecule changes.
+  QTimer* m_textUpdateTimer;
+  // The molecule changed while the dialog was hidden.
+  bool m_textOutdated;
+  // The text was generated from the current state of the molecule, so the
+  // unedited lines match their atoms.
+  bool m_textInSync;
 
   QString m_defaultSpec;
 };
@@ -0,0 +1,208 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "coordinatehighlighter.h"
+
+#include <avogadro/core/avogadrocore.h>
+#include <avogadro/core/elements.h>
+
+#include <QtCore/QDebug>
+
+#include <string>
+
+using Avogadro::Core::Elements;
+
+namespace Avogadro {
+namespace QtPlugins {
+
+namespace {
+
+inline bool isSeparator(QChar c)
+{
+  return c.isSpace() || c == QLatin1Char(',') || c == QLatin1Char(';');
+}
+
+// Look up an element name or symbol, ignoring the case of the token.
+unsigned char atomicNumberFromToken(const QStringRef& token, bool name)
+{
+  std::string clean;
+  clean.reserve(token.size());
+  for (int i = 0; i < token.size(); ++i) {
+    QChar c = token.at(i).toLower();
+    clean += (i == 0 ? c.toUpper() : c).toLatin1();
+  }
+  return name ? Elements::atomicNumberFromName(clean)
+              : Elements::atomicNumberFromSymbol(clean);
+}
+
+} // namespace
+
+const CoordinateLineData::Mark* CoordinateLineData::markAt(int column) const
+{
+  // Search backwards, so that "too few entries" errors are found before the
+  // token-specific marks of that line.
+  for (int i = marks.size() - 1; i >= 0; --i) {
+    if (marks[i].contains(column))
+      return &marks[i];
+  }
+  return nullptr;
+}
+
+CoordinateHighlighter::CoordinateHighlighter(QTextDocument* parent_)
+  : QSyntaxHighlighter(parent_), m_generation(0)
+{
+  m_invalidFormat.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
+  m_invalidFormat.setForeground(Qt::darkRed);
+  m_invalidFormat.setBackground(Qt::lightGray);
+
+  m_validFormat.setForeground(Qt::darkGreen);
+}
+
+void CoordinateHighlighter::setSpecification(const QString& spec)
+{
+  if (spec == m_spec)
+    return;
+  m_spec = spec;
+  ++m_generation;
+  rehighlight();
+}
+
+CoordinateLineData* CoordinateHighlighter::line(const QTextBlock& block)
+{
+  CoordinateLineData* data = static_cast<CoordinateLineData*>(block.userData());
+  if (!isCurrent(block, data)) {
+    rehighlightBlock(block);
+    data = static_cast<CoordinateLineData*>(block.userData());
+  }
+  return data;
+}
+
+QString CoordinateHighlighter::toolTip(const CoordinateLineData::Mark& mark)
+{
+  switch (mark.field) {
+    case 'N':
+      return mark.valid ? tr("Element name.") : tr("Invalid element name.");
+    case 'S':
+      return mark.valid ? tr("Element symbol.") : tr("Invalid element symbol.");
+    case 'Z':
+      return mark.valid ? tr("Atomic number.") : tr("Invalid atomic number.");
+    case 'x':
+      return mark.valid ? tr("X coordinate.") : tr("Invalid coordinate.");
+    case 'y':
+      return mark.valid ? tr("Y coordinate.") : tr("Invalid coordinate.");
+    case 'z':
+      return mark.valid ? tr("Z coordinate.") : tr("Invalid coordinate.");
+    case 'a':
+      return mark.valid ? tr("'a' lattice coordinate.")
+                        : tr("Invalid coordinate.");
+    case 'b':
+      return mark.valid ? tr("'b' lattice coordinate.")
+                        : tr("Invalid coordinate.");
+    case 'c':
+      return mark.valid ? tr("'c' lattice coordinate.")
+                        : tr("Invalid coordinate.");
+    default:
+      return tr("Too few entries on line.");
+  }
+}
+
+void CoordinateHighlighter::highlightBlock(const QString& text)
+{
+  QTextBlock block = currentBlock();
+  CoordinateLineData* data =
+    static_cast<CoordinateLineData*>(currentBlockUserData());
+  if (!data) {
+    data = new CoordinateLineData;
+    setCurrentBlockUserData(data);
+  }
+
+  // Blocks are also revisited when they merely lie within an edited range,
+  // their formats are then rebuilt from the cache.
+  if (!isCurrent(block, data)) {
+    parse(text, *data);
+    data->parsedRevision = block.revision();
+    data->parsedGeneration = m_generation;
+  }
+
+  foreach (const CoordinateLineData::Mark& mark, data->marks) {
+    setFormat(mark.start, mark.length,
+              mark.valid ? m_validFormat : m_invalidFormat);
+  }
+}
+
+bool CoordinateHighlighter::isCurrent(const QTextBlock& block,
+                                      const CoordinateLineData* data) const
+{
+  return data && data->parsedRevision == block.revision() &&
+         data->parsedGeneration == m_generation;
+}
+
+void CoordinateHighlighter::parse(const QString& text,
+                                  CoordinateLineData& line) const
+{
+  line.marks.clear();
+  line.atomicNumber = 0;
+  line.position = Vector3::Zero();
+
+  const int size = text.size();
+  int pos = 0;
+  while (pos < size && isSeparator(text.at(pos)))
+    ++pos;
+  line.blank = pos == size;
+  line.valid = !line.blank && !m_spec.isEmpty();
+  if (!line.valid)
+    return;
+
+  foreach (QChar field, m_spec) {
+    while (pos < size && isSeparator(text.at(pos)))
+      ++pos;
+    if (pos == size) {
+      CoordinateLineData::Mark mark = { 0, size, 0, false };
+      line.marks.append(mark);
+      line.valid = false;
+      break;
+    }
+    int start = pos;
+    while (pos < size && !isSeparator(text.at(pos)))
+      ++pos;
+    QStringRef token(text.midRef(start, pos - start));
+
+    CoordinateLineData::Mark mark = { start, pos - start, field.toLatin1(),
+                                      true };
+    switch (mark.field) {
+      case '?': // Nothing to validate other than that this is a valid token.
+        continue;
+      case 'N':
+      case 'S':
+        line.atomicNumber = atomicNumberFromToken(token, mark.field == 'N');
+        mark.valid = line.atomicNumber != Avogadro::InvalidElement;
+        break;
+      case 'Z':
+        line.atomicNumber =
+          static_cast<unsigned char>(token.toInt(&mark.valid));
+        break;
+      case 'x':
+      case 'a':
+        line.position.x() = token.toDouble(&mark.valid);
+        break;
+      case 'y':
+      case 'b':
+        line.position.y() = token.toDouble(&mark.valid);
+        break;
+      case 'z':
+      case 'c':
+        line.position.z() = token.toDouble(&mark.valid);
+        break;
+      default:
+        qWarning() << "Unhandled character in detected spec: " << field;
+        continue;
+    }
+    line.valid = line.valid && mark.valid;
+    line.marks.append(mark);
+  }
+}
+
+} // namespace QtPlugins
+} // namespace Avogadro
@@ -0,0 +1,117 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_QTPLUGINS_COORDINATEHIGHLIGHTER_H
+#define AVOGADRO_QTPLUGINS_COORDINATEHIGHLIGHTER_H
+
+#include <QtGui/QSyntaxHighlighter>
+
+#include <avogadro/core/vector.h>
+
+#include <QtGui/QTextBlock>
+#include <QtGui/QTextCharFormat>
+#include <QtCore/QVector>
+
+namespace Avogadro {
+namespace QtPlugins {
+
+/**
+ * @brief The CoordinateLineData class caches the parsed contents of one line
+ * of the coordinate editor. It is attached to the line's QTextBlock, so it
+ * follows the line as the text around it is edited.
+ */
+class CoordinateLineData : public QTextBlockUserData
+{
+public:
+  /** A token of the line, or the whole line if it has too few tokens. */
+  struct Mark
+  {
+    int start;
+    int length;
+    /** The specification character of the token, 0 for the whole line. */
+    char field;
+    bool valid;
+    bool contains(int column) const
+    {
+      return column >= start && column <= start + length;
+    }
+  };
+
+  CoordinateLineData()
+    : atomIndex(-1), generatedRevision(-1), parsedRevision(-1),
+      parsedGeneration(-1), blank(true), valid(false), atomicNumber(0),
+      position(Vector3::Zero())
+  {
+  }
+
+  /** @return The last mark containing @a column, or nullptr. */
+  const Mark* markAt(int column) const;
+
+  /** The atom the line was generated from, or -1. */
+  int atomIndex;
+  /** The block revision when the line was generated from the molecule. */
+  int generatedRevision;
+
+  /** The block revision and specification the line was parsed against. */
+  int parsedRevision;
+  int parsedGeneration;
+
+  bool blank;
+  bool valid;
+  unsigned char atomicNumber;
+  /** The parsed coordinates, in the units and frame of the text. */
+  Vector3 position;
+  QVector<Mark> marks;
+};
+
+/**
+ * @brief The CoordinateHighlighter class parses and highlights the lines of
+ * the coordinate editor.
+ *
+ * QSyntaxHighlighter only revisits the lines touched by an edit, and lines
+ * whose text did not change reuse their cached CoordinateLineData, so typing
+ * in a large document costs the same as typing in a small one.
+ */
+class CoordinateHighlighter : public QSyntaxHighlighter
+{
+  Q_OBJECT
+public:
+  explicit CoordinateHighlighter(QTextDocument* parent_);
+
+  /**
+   * The format of each line, using the characters of
+   * CoordinateBlockGenerator ('?' skips a token). Changing it reparses the
+   * whole document; an empty specification only checks for blank lines.
+   * @{
+   */
+  void setSpecification(const QString& spec);
+  QString specification() const { return m_spec; }
+  /** @} */
+
+  /** @return The parsed contents of @a block, parsing it if needed. */
+  CoordinateLineData* line(const QTextBlock& block);
+
+  /** @return The tooltip describing @a mark. */
+  static QString toolTip(const CoordinateLineData::Mark& mark);
+
+protected:
+  void highlightBlock(const QString& text) override;
+
+private:
+  bool isCurrent(const QTextBlock& block,
+                 const CoordinateLineData* line) const;
+  void parse(const QString& text, CoordinateLineData& line) const;
+
+  QString m_spec;
+  int m_generation;
+
+  QTextCharFormat m_invalidFormat;
+  QTextCharFormat m_validFormat;
+};
+
+} // namespace QtPlugins
+} // namespace Avogadro
+
+#endif // AVOGADRO_QTPLUGINS_COORDINATEHIGHLIGHTER_H
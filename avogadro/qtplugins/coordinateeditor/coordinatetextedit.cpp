@@ -15,56 +15,19 @@
 ******************************************************************************/
 
 #include "coordinatetextedit.h"
+#include "coordinatehighlighter.h"
 
 #include <QtGui/QHelpEvent>
+#include <QtGui/QTextBlock>
 #include <QtGui/QTextCursor>
-#include <QtWidgets/QApplication>
 #include <QtWidgets/QToolTip>
 
-#include <QtCore/QListIterator>
-
 namespace Avogadro {
 namespace QtPlugins {
 
-CoordinateTextEdit::CoordinateTextEdit(QWidget* p)
-  : QTextEdit(p), m_hasInvalidMarks(false)
+CoordinateTextEdit::CoordinateTextEdit(QWidget* p) : QTextEdit(p)
 {
   setMouseTracking(true);
-
-  m_unmarkedFormat.setUnderlineStyle(QTextCharFormat::NoUnderline);
-  m_unmarkedFormat.setForeground(qApp->palette().foreground().color());
-  m_unmarkedFormat.setBackground(qApp->palette().base().color());
-
-  m_invalidFormat.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
-  m_invalidFormat.setForeground(Qt::darkRed);
-  m_invalidFormat.setBackground(Qt::lightGray);
-
-  m_validFormat.setUnderlineStyle(QTextCharFormat::NoUnderline);
-  m_validFormat.setForeground(Qt::darkGreen);
-}
-
-void CoordinateTextEdit::resetMarks()
-{
-  m_hasInvalidMarks = false;
-  m_marks.clear();
-  if (!document()->isEmpty()) {
-    QTextCursor cur(document());
-    cur.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
-    cur.mergeCharFormat(m_unmarkedFormat);
-  }
-}
-
-void CoordinateTextEdit::markInvalid(QTextCursor& cur, const QString& tooltip)
-{
-  m_hasInvalidMarks = true;
-  cur.mergeCharFormat(m_invalidFormat);
-  m_marks.append(Mark(cur.anchor(), cur.position(), tooltip));
-}
-
-void CoordinateTextEdit::markValid(QTextCursor& cur, const QString& tooltip)
-{
-  cur.mergeCharFormat(m_validFormat);
-  m_marks.append(Mark(cur.anchor(), cur.position(), tooltip));
 }
 
 bool CoordinateTextEdit::event(QEvent* e)
@@ -79,25 +42,15 @@ bool CoordinateTextEdit::event(QEvent* e)
 
 void CoordinateTextEdit::showToolTip(QHelpEvent* e) const
 {
-  int position(cursorForPosition(e->pos()).position());
-  bool handled(false);
-
-  if (position >= 0) {
-    // Iterate backwards -- this ensures that "line too short" errors are shown
-    // instead of the token-specific messages in that line.
-    QListIterator<Mark> iter(m_marks);
-    iter.toBack();
-    while (iter.hasPrevious()) {
-      const Mark& mark = iter.previous();
-      if (mark.contains(position)) {
-        QToolTip::showText(e->globalPos(), mark.tooltip);
-        handled = true;
-        break;
-      }
-    }
-  }
-
-  if (!handled) {
+  QTextCursor cur(cursorForPosition(e->pos()));
+  const CoordinateLineData* line =
+    static_cast<const CoordinateLineData*>(cur.block().userData());
+  const CoordinateLineData::Mark* mark =
+    line ? line->markAt(cur.positionInBlock()) : nullptr;
+
+  if (mark) {
+    QToolTip::showText(e->globalPos(), CoordinateHighlighter::toolTip(*mark));
+  } else {
     QToolTip::hideText();
     e->ignore();
   }
@@ -19,8 +19,6 @@
 
 #include <QtWidgets/QTextEdit>
 
-#include <QtGui/QTextCharFormat>
-
 class QHelpEvent;
 
 namespace Avogadro {
@@ -28,7 +26,7 @@ namespace QtPlugins {
 
 /**
  * @brief The CoordinateTextEdit class extends QTextEdit to provide context
- * tooltips and highlighting for syntax errors.
+ * tooltips for the marks placed by CoordinateHighlighter.
  */
 class CoordinateTextEdit : public QTextEdit
 {
@@ -36,37 +34,11 @@ class CoordinateTextEdit : public QTextEdit
 public:
   explicit CoordinateTextEdit(QWidget* p = 0);
 
-  bool hasInvalidMarks() const { return m_hasInvalidMarks; }
-
-public slots:
-  void resetMarks();
-  void markInvalid(QTextCursor& cur, const QString& tooltip);
-  void markValid(QTextCursor& cur, const QString& tooltip);
-
 protected:
   bool event(QEvent* e) override;
 
 private:
   void showToolTip(QHelpEvent* e) const;
-
-  struct Mark
-  {
-    int start;
-    int end;
-    QString tooltip;
-    Mark(int s, int e, const QString& t)
-      : start(s)
-      , end(e)
-      , tooltip(t)
-    {}
-    bool contains(int i) const { return i >= start && i <= end; }
-  };
-  QList<Mark> m_marks;
-  bool m_hasInvalidMarks;
-
-  QTextCharFormat m_unmarkedFormat;
-  QTextCharFormat m_invalidFormat;
-  QTextCharFormat m_validFormat;
 };
 
 } // namespace QtPlugins
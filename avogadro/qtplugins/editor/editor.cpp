@@ -24,6 +24,7 @@
 #include <avogadro/core/vector.h>
 
 #include <avogadro/qtgui/hydrogentools.h>
+#include <avogadro/qtgui/interactiveoptimizer.h>
 #include <avogadro/qtgui/molecule.h>
 #include <avogadro/qtgui/rwmolecule.h>
 
@@ -77,6 +78,7 @@ Editor::Editor(QObject* parent_)
   : QtGui::ToolPlugin(parent_), m_activateAction(new QAction(this)),
     m_molecule(nullptr), m_glWidget(nullptr), m_renderer(nullptr),
     m_toolWidget(new EditorToolWidget(qobject_cast<QWidget*>(parent_))),
+    m_optimizer(new QtGui::InteractiveOptimizer(this)),
     m_pressedButtons(Qt::NoButton),
     m_clickedAtomicNumber(INVALID_ATOMIC_NUMBER), m_bondAdded(false),
     m_fixValenceLater(false)
@@ -95,6 +97,12 @@ QWidget* Editor::toolWidget() const
   return m_toolWidget;
 }
 
+void Editor::setEditMolecule(QtGui::RWMolecule* mol)
+{
+  m_molecule = mol;
+  m_optimizer->setMolecule(mol);
+}
+
 QUndoCommand* Editor::mousePressEvent(QMouseEvent* e)
 {
   clearKeyPressBuffer();
@@ -103,6 +111,7 @@ QUndoCommand* Editor::mousePressEvent(QMouseEvent* e)
 
   updatePressedButtons(e, false);
   m_clickPosition = e->pos();
+  m_optimizer->setEnabled(m_toolWidget->autoOptimize());
 
   if (m_pressedButtons & Qt::LeftButton) {
     m_clickedObject = m_renderer->hit(e->pos().x(), e->pos().y());
@@ -156,6 +165,9 @@ QUndoCommand* Editor::mouseReleaseEvent(QMouseEvent* e)
   switch (e->button()) {
     case Qt::LeftButton:
     case Qt::RightButton:
+      // Apply the last relaxation before fixing valences, so both end up in
+      // the same undo command.
+      m_optimizer->finish();
       reset();
       e->accept();
       m_molecule->endMergeMode();
@@ -607,7 +619,13 @@ void Editor::atomLeftDrag(QMouseEvent* e)
   }
 
   m_molecule->emitChanged(changes);
-  return;
+
+  if (newAtom.isValid()) {
+    std::vector<Index> moved;
+    moved.push_back(newAtom.index());
+    moved.push_back(m_clickedObject.index);
+    m_optimizer->relax(moved);
+  }
 }
 
 } // namespace QtOpenGL
@@ -26,6 +26,10 @@
 #include <QtCore/QPoint>
 
 namespace Avogadro {
+namespace QtGui {
+class InteractiveOptimizer;
+}
+
 namespace QtPlugins {
 class EditorToolWidget;
 
@@ -50,10 +54,10 @@ public:
   void setMolecule(QtGui::Molecule* mol) override
   {
     if (mol)
-      m_molecule = mol->undoMolecule();
+      setEditMolecule(mol->undoMolecule());
   }
 
-  void setEditMolecule(QtGui::RWMolecule* mol) override { m_molecule = mol; }
+  void setEditMolecule(QtGui::RWMolecule* mol) override;
 
   void setGLWidget(QtOpenGL::GLWidget* widget) override { m_glWidget = widget; }
 
@@ -98,6 +102,7 @@ private:
   QtOpenGL::GLWidget* m_glWidget;
   Rendering::GLRenderer* m_renderer;
   EditorToolWidget* m_toolWidget;
+  QtGui::InteractiveOptimizer* m_optimizer;
   Rendering::Identifier m_clickedObject;
   Rendering::Identifier m_newObject;
   Rendering::Identifier m_bondedAtom;
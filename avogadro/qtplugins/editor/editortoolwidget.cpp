@@ -44,6 +44,11 @@ EditorToolWidget::EditorToolWidget(QWidget* parent_)
   connect(m_ui->element, SIGNAL(currentIndexChanged(int)), this,
           SLOT(elementChanged(int)));
 
+  m_ui->autoOptimize->setChecked(
+    QSettings().value("editortool/autoOptimize", false).toBool());
+  connect(m_ui->autoOptimize, SIGNAL(toggled(bool)), this,
+          SLOT(saveAutoOptimize(bool)));
+
   // Show carbon at startup.
   selectElement(6);
 }
@@ -93,6 +98,11 @@ bool EditorToolWidget::adjustHydrogens() const
   return m_ui->adjustHydrogens->isChecked();
 }
 
+bool EditorToolWidget::autoOptimize() const
+{
+  return m_ui->autoOptimize->isChecked();
+}
+
 void EditorToolWidget::elementChanged(int index)
 {
   QVariant itemData = m_ui->element->itemData(index);
@@ -229,5 +239,10 @@ void EditorToolWidget::saveElements()
   QSettings().setValue("editortool/userElements", atomicNums);
 }
 
+void EditorToolWidget::saveAutoOptimize(bool enable)
+{
+  QSettings().setValue("editortool/autoOptimize", enable);
+}
+
 } // namespace QtPlugins
 } // namespace Avogadro
@@ -46,12 +46,15 @@ public:
 
   bool adjustHydrogens() const;
 
+  bool autoOptimize() const;
+
 private slots:
   void elementChanged(int index);
   void updateElementCombo();
   void addUserElement(unsigned char element);
   void elementSelectedFromTable(int element);
   void selectElement(unsigned char element);
+  void saveAutoOptimize(bool enable);
 
 private:
   void buildElements();
@@ -0,0 +1,133 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "forcefield.h"
+
+#include <avogadro/qtgui/geometryoptimizer.h>
+#include <avogadro/qtgui/molecule.h>
+#include <avogadro/qtgui/rwmolecule.h>
+
+#include <QtWidgets/QAction>
+#include <QtWidgets/QMessageBox>
+
+namespace Avogadro {
+namespace QtPlugins {
+
+using QtGui::GeometryOptimizer;
+
+ForceField::ForceField(QObject* parent_)
+  : QtGui::ExtensionPlugin(parent_), m_molecule(nullptr),
+    m_optimizer(new GeometryOptimizer(this)),
+    m_optimizeAction(new QAction(tr("Optimize Geometry"), this)),
+    m_active(false), m_updating(false)
+{
+  m_optimizeAction->setShortcut(QKeySequence("Ctrl+Alt+O"));
+  connect(m_optimizeAction, SIGNAL(triggered()), SLOT(optimize()));
+
+  connect(m_optimizer, SIGNAL(positionsUpdated(int, double)),
+          SLOT(updatePositions()));
+  connect(m_optimizer, SIGNAL(finished()), SLOT(optimizationFinished()));
+}
+
+ForceField::~ForceField() {}
+
+QList<QAction*> ForceField::actions() const
+{
+  QList<QAction*> result;
+  return result << m_optimizeAction;
+}
+
+QStringList ForceField::menuPath(QAction*) const
+{
+  return QStringList() << tr("&Extensions") << tr("&Force Field");
+}
+
+void ForceField::setMolecule(QtGui::Molecule* mol)
+{
+  if (m_molecule == mol)
+    return;
+
+  if (m_optimizer->isRunning()) {
+    m_optimizer->stop();
+    m_optimizer->wait();
+  }
+
+  if (m_molecule) {
+    if (m_active)
+      m_molecule->undoMolecule()->setInteractive(false);
+    m_molecule->disconnect(this);
+  }
+  m_active = false;
+
+  m_molecule = mol;
+
+  if (m_molecule)
+    connect(m_molecule, SIGNAL(changed(unsigned int)),
+            SLOT(moleculeChanged(unsigned int)));
+}
+
+void ForceField::optimize()
+{
+  // A second trigger stops a running optimization.
+  if (m_optimizer->isRunning()) {
+    m_optimizer->stop();
+    return;
+  }
+
+  if (!m_molecule || m_molecule->atomCount() == 0)
+    return;
+
+  if (!m_optimizer->setMolecule(*m_molecule)) {
+    QMessageBox::warning(qobject_cast<QWidget*>(parent()), tr("Error"),
+                         tr("The molecule has no 3D coordinates to optimize."));
+    return;
+  }
+
+  m_optimizeAction->setText(tr("Stop Optimization"));
+  m_active = true;
+  m_molecule->undoMolecule()->setInteractive(true);
+  m_optimizer->start();
+}
+
+void ForceField::moleculeChanged(unsigned int changes)
+{
+  if (m_updating || !m_optimizer->isRunning())
+    return;
+
+  // The force field setup is only valid for the original atoms and bonds.
+  if (changes & (QtGui::Molecule::Added | QtGui::Molecule::Removed) ||
+      changes & QtGui::Molecule::Bonds) {
+    m_optimizer->stop();
+  }
+}
+
+void ForceField::updatePositions()
+{
+  if (!m_molecule || !m_active)
+    return;
+
+  Core::Array<Vector3> positions = m_optimizer->positions();
+  if (positions.size() != m_molecule->atomCount())
+    return;
+
+  m_updating = true;
+  m_molecule->undoMolecule()->setAtomPositions3d(positions,
+                                                 tr("Optimize Geometry"));
+  m_molecule->emitChanged(QtGui::Molecule::Atoms | QtGui::Molecule::Modified);
+  m_updating = false;
+}
+
+void ForceField::optimizationFinished()
+{
+  m_optimizeAction->setText(tr("Optimize Geometry"));
+  if (m_molecule && m_active) {
+    updatePositions();
+    m_molecule->undoMolecule()->setInteractive(false);
+  }
+  m_active = false;
+}
+
+} // namespace QtPlugins
+} // namespace Avogadro
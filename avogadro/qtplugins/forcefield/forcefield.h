@@ -0,0 +1,65 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_QTPLUGINS_FORCEFIELD_H
+#define AVOGADRO_QTPLUGINS_FORCEFIELD_H
+
+#include <avogadro/qtgui/extensionplugin.h>
+
+namespace Avogadro {
+
+namespace QtGui {
+class GeometryOptimizer;
+}
+
+namespace QtPlugins {
+
+/**
+ * @brief The ForceField class minimizes the molecule in-process with UFF.
+ *
+ * The minimization runs on a worker thread and every published step is
+ * applied to the molecule, so the structure relaxes live in the view. All
+ * steps of one run are merged into a single undo command.
+ */
+class ForceField : public QtGui::ExtensionPlugin
+{
+  Q_OBJECT
+public:
+  explicit ForceField(QObject* parent_ = 0);
+  ~ForceField() override;
+
+  QString name() const override { return tr("Force Field"); }
+
+  QString description() const override
+  {
+    return tr("Optimize molecular geometry with the built-in force field.");
+  }
+
+  QList<QAction*> actions() const override;
+
+  QStringList menuPath(QAction* action) const override;
+
+public slots:
+  void setMolecule(QtGui::Molecule* mol) override;
+
+private slots:
+  void optimize();
+  void moleculeChanged(unsigned int changes);
+  void updatePositions();
+  void optimizationFinished();
+
+private:
+  QtGui::Molecule* m_molecule;
+  QtGui::GeometryOptimizer* m_optimizer;
+  QAction* m_optimizeAction;
+  // True while a run started on m_molecule has not been finished.
+  bool m_active;
+  bool m_updating;
+};
+
+} // namespace QtPlugins
+} // namespace Avogadro
+
+#endif // AVOGADRO_QTPLUGINS_FORCEFIELD_H
@@ -59,10 +59,23 @@ void Licorice::process(const Molecule& molecule, Rendering::GroupNode& node)
     spheres->addSphere(atom.position3d().cast<float>(), color, radius);
   }
 
+  // An animated vibration is applied by the shaders, see Spectra.
+  const Core::Array<Vector3>& displacements =
+    molecule.vibrationDisplacements();
+  bool animated = displacements.size() == molecule.atomCount();
+  if (animated) {
+    Core::Array<Vector3f> sphereDisplacements;
+    sphereDisplacements.reserve(displacements.size());
+    for (Index i = 0; i < displacements.size(); ++i)
+      sphereDisplacements.push_back(displacements[i].cast<float>());
+    spheres->setDisplacements(sphereDisplacements);
+  }
+
   CylinderGeometry* cylinders = new CylinderGeometry;
   cylinders->identifier().molecule = &molecule;
   cylinders->identifier().type = Rendering::BondType;
   geometry->addDrawable(cylinders);
+  std::vector<Vector3f> cylinderDisplacements;
   for (Index i = 0; i < molecule.bondCount(); ++i) {
     Core::Bond bond = molecule.bond(i);
     Vector3f pos1 = bond.atom1().position3d().cast<float>();
@@ -74,7 +87,15 @@ void Licorice::process(const Molecule& molecule, Rendering::GroupNode& node)
     bondVector /= bondLength;
 
     cylinders->addCylinder(pos1, pos2, radius, color1, color2, i);
+    if (animated) {
+      cylinderDisplacements.push_back(
+        displacements[bond.atom1().index()].cast<float>());
+      cylinderDisplacements.push_back(
+        displacements[bond.atom2().index()].cast<float>());
+    }
   }
+  if (animated)
+    cylinders->setDisplacements(cylinderDisplacements);
 }
 
 bool Licorice::isEnabled() const
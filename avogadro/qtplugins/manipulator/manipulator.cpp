@@ -18,6 +18,7 @@
 
 #include <avogadro/core/vector.h>
 
+#include <avogadro/qtgui/interactiveoptimizer.h>
 #include <avogadro/qtgui/molecule.h>
 #include <avogadro/qtgui/rwmolecule.h>
 
@@ -26,11 +27,14 @@
 #include <avogadro/rendering/camera.h>
 #include <avogadro/rendering/glrenderer.h>
 
+#include <QtCore/QSettings>
 #include <QtGui/QIcon>
 #include <QtGui/QKeyEvent>
 #include <QtGui/QMouseEvent>
 #include <QtGui/QWheelEvent>
 #include <QtWidgets/QAction>
+#include <QtWidgets/QCheckBox>
+#include <QtWidgets/QVBoxLayout>
 
 using Avogadro::Core::Atom;
 using Avogadro::Core::Bond;
@@ -47,10 +51,29 @@ using Rendering::Identifier;
 
 Manipulator::Manipulator(QObject* parent_)
   : QtGui::ToolPlugin(parent_), m_activateAction(new QAction(this)),
-    m_molecule(nullptr), m_renderer(nullptr), m_pressedButtons(Qt::NoButton)
+    m_molecule(nullptr), m_renderer(nullptr), m_pressedButtons(Qt::NoButton),
+    m_toolWidget(new QWidget(qobject_cast<QWidget*>(parent_))),
+    m_autoOptimizeBox(nullptr),
+    m_optimizer(new QtGui::InteractiveOptimizer(this))
 {
   m_activateAction->setText(tr("Manipulate"));
   m_activateAction->setIcon(QIcon(":/icons/manipulator.png"));
+
+  m_autoOptimizeBox = new QCheckBox(tr("Auto-optimize"), m_toolWidget);
+  m_autoOptimizeBox->setToolTip(
+    tr("Relax the surroundings of the dragged atoms with the UFF force field."));
+  QVBoxLayout* layout = new QVBoxLayout;
+  layout->addWidget(m_autoOptimizeBox);
+  layout->addStretch(1);
+  m_toolWidget->setLayout(layout);
+
+  QSettings settings;
+  bool autoOptimize =
+    settings.value("manipulator/autoOptimize", false).toBool();
+  m_autoOptimizeBox->setChecked(autoOptimize);
+  m_optimizer->setEnabled(autoOptimize);
+  connect(m_autoOptimizeBox, SIGNAL(toggled(bool)),
+          SLOT(setAutoOptimize(bool)));
 }
 
 Manipulator::~Manipulator()
@@ -59,7 +82,20 @@ Manipulator::~Manipulator()
 
 QWidget* Manipulator::toolWidget() const
 {
-  return nullptr;
+  return m_toolWidget;
+}
+
+void Manipulator::setEditMolecule(QtGui::RWMolecule* mol)
+{
+  m_molecule = mol;
+  m_optimizer->setMolecule(mol);
+}
+
+void Manipulator::setAutoOptimize(bool enable)
+{
+  m_optimizer->setEnabled(enable);
+  QSettings settings;
+  settings.setValue("manipulator/autoOptimize", enable);
 }
 
 QUndoCommand* Manipulator::mousePressEvent(QMouseEvent* e)
@@ -102,6 +138,9 @@ QUndoCommand* Manipulator::mouseReleaseEvent(QMouseEvent* e)
     return nullptr;
 
   if (m_molecule) {
+    // Flush the last relaxation while its changes can still merge with the
+    // drag.
+    m_optimizer->finish();
     m_molecule->setInteractive(false);
   }
 
@@ -126,6 +165,7 @@ QUndoCommand* Manipulator::mouseMoveEvent(QMouseEvent* e)
 
   const Core::Molecule* mol = &m_molecule->molecule();
   Vector2f windowPos(e->localPos().x(), e->localPos().y());
+  std::vector<Index> moved;
 
   if (mol->isSelectionEmpty() && m_object.type == Rendering::AtomType &&
       m_object.molecule == mol) {
@@ -134,6 +174,7 @@ QUndoCommand* Manipulator::mouseMoveEvent(QMouseEvent* e)
     Vector3f oldPos(atom.position3d().cast<float>());
     Vector3f newPos = m_renderer->camera().unProject(windowPos, oldPos);
     atom.setPosition3d(newPos.cast<double>());
+    moved.push_back(atom.index());
   } else if (!mol->isSelectionEmpty()) {
     // update all selected atoms
     Vector3f newPos = m_renderer->camera().unProject(windowPos);
@@ -144,6 +185,7 @@ QUndoCommand* Manipulator::mouseMoveEvent(QMouseEvent* e)
 
       Vector3 currentPos = m_molecule->atomPosition3d(i);
       m_molecule->setAtomPosition3d(i, currentPos + delta.cast<double>());
+      moved.push_back(i);
     }
 
     // now that we've moved things, save the position
@@ -151,6 +193,7 @@ QUndoCommand* Manipulator::mouseMoveEvent(QMouseEvent* e)
   }
 
   m_molecule->emitChanged(Molecule::Atoms | Molecule::Modified);
+  m_optimizer->relax(moved);
   e->accept();
   return nullptr;
 }
@@ -25,7 +25,13 @@
 #include <QtCore/QPoint>
 #include <QtCore/Qt> // for Qt:: namespace
 
+class QCheckBox;
+
 namespace Avogadro {
+namespace QtGui {
+class InteractiveOptimizer;
+}
+
 namespace QtPlugins {
 
 /**
@@ -50,10 +56,10 @@ public:
   void setMolecule(QtGui::Molecule* mol) override
   {
     if (mol)
-      m_molecule = mol->undoMolecule();
+      setEditMolecule(mol->undoMolecule());
   }
 
-  void setEditMolecule(QtGui::RWMolecule* mol) override { m_molecule = mol; }
+  void setEditMolecule(QtGui::RWMolecule* mol) override;
 
   void setGLRenderer(Rendering::GLRenderer* renderer) override
   {
@@ -64,6 +70,9 @@ public:
   QUndoCommand* mouseReleaseEvent(QMouseEvent* e) override;
   QUndoCommand* mouseMoveEvent(QMouseEvent* e) override;
 
+private slots:
+  void setAutoOptimize(bool enable);
+
 private:
   /**
    * Update the currently pressed buttons, accounting for modifier keys.
@@ -80,6 +89,9 @@ private:
   Qt::MouseButtons m_pressedButtons;
   QPoint m_lastMousePosition;
   Vector3f m_lastMouse3D;
+  QWidget* m_toolWidget;
+  QCheckBox* m_autoOptimizeBox;
+  QtGui::InteractiveOptimizer* m_optimizer;
 };
 
 } // namespace QtOpenGL
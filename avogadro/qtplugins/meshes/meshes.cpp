@@ -19,13 +19,13 @@
 #include <avogadro/core/array.h>
 #include <avogadro/core/mesh.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/mutex.h>
 #include <avogadro/rendering/geometrynode.h>
 #include <avogadro/rendering/groupnode.h>
 #include <avogadro/rendering/meshgeometry.h>
 
 #include <QtCore/QDebug>
-
-#include <algorithm>
+#include <QtGui/QOpenGLContext>
 
 namespace Avogadro {
 namespace QtPlugins {
@@ -36,19 +36,17 @@ using Rendering::GeometryNode;
 using Rendering::GroupNode;
 using Rendering::MeshGeometry;
 
-Meshes::Meshes(QObject* p) : ScenePlugin(p), m_enabled(true) {}
-
-Meshes::~Meshes() {}
+Meshes::Meshes(QObject* p)
+  : ScenePlugin(p), m_enabled(true), m_context(nullptr),
+    m_contextGroup(nullptr)
+{
+  m_geometry[0] = m_geometry[1] = nullptr;
+  m_revision[0] = m_revision[1] = 0;
+}
 
-// Generator for std::generate call below:
-namespace {
-struct Sequence
+Meshes::~Meshes()
 {
-  Sequence() : i(0) {}
-  unsigned int operator()() { return i++; }
-  void reset() { i = 0; }
-  unsigned int i;
-};
+  clearCache();
 }
 
 void Meshes::process(const Molecule& mol, GroupNode& node)
@@ -56,45 +54,73 @@ void Meshes::process(const Molecule& mol, GroupNode& node)
   GeometryNode* geometry = new GeometryNode;
   node.addChild(geometry);
 
-  unsigned char opacity = 100;
-
-  if (mol.meshCount()) {
-    const Mesh* mesh = mol.mesh(0);
-
-    /// @todo Allow use of MeshGeometry without an index array when all vertices
-    /// form explicit triangles.
-    // Create index array:
-    Sequence indexGenerator;
-    Core::Array<unsigned int> indices(mesh->numVertices());
-    std::generate(indices.begin(), indices.end(), indexGenerator);
-
-    MeshGeometry* mesh1 = new MeshGeometry;
-    geometry->addDrawable(mesh1);
-    mesh1->setColor(Vector3ub(255, 0, 0));
-    mesh1->setOpacity(opacity);
-    mesh1->addVertices(mesh->vertices(), mesh->normals());
-    mesh1->addTriangles(indices);
-    mesh1->setRenderPass(opacity == 255 ? Rendering::OpaquePass
-                                        : Rendering::TranslucentPass);
-
-    if (mol.meshCount() >= 2) {
-      MeshGeometry* mesh2 = new MeshGeometry;
-      geometry->addDrawable(mesh2);
-      mesh = mol.mesh(1);
-      if (mesh->numVertices() < indices.size()) {
-        indices.resize(mesh->numVertices());
-      } else if (mesh->numVertices() > indices.size()) {
-        indexGenerator.reset();
-        indices.resize(mesh->numVertices());
-        std::generate(indices.begin(), indices.end(), indexGenerator);
-      }
-      mesh2->setColor(Vector3ub(0, 0, 255));
-      mesh2->setOpacity(opacity);
-      mesh2->addVertices(mesh->vertices(), mesh->normals());
-      mesh2->addTriangles(indices);
-      mesh2->setRenderPass(opacity == 255 ? Rendering::OpaquePass
-                                          : Rendering::TranslucentPass);
+  // The cached buffers can only be drawn in contexts sharing them. Watch the
+  // context, so they are deleted while it is still there to delete them in.
+  QOpenGLContext* context = QOpenGLContext::currentContext();
+  if (context != m_context) {
+    QOpenGLContextGroup* group = context ? context->shareGroup() : nullptr;
+    if (group != m_contextGroup) {
+      clearCache();
+      m_contextGroup = group;
+    }
+    if (m_context) {
+      disconnect(m_context, SIGNAL(aboutToBeDestroyed()), this,
+                 SLOT(contextDestroyed()));
+    }
+    m_context = context;
+    if (m_context) {
+      connect(m_context, SIGNAL(aboutToBeDestroyed()),
+              SLOT(contextDestroyed()));
+    }
+  }
+
+  const unsigned char opacity = 100;
+  const Vector3ub colors[2] = { Vector3ub(255, 0, 0), Vector3ub(0, 0, 255) };
+
+  for (Index i = 0; i < 2; ++i) {
+    if (i >= mol.meshCount()) {
+      delete m_geometry[i];
+      m_geometry[i] = nullptr;
+      continue;
     }
+
+    const Mesh* mesh = mol.mesh(i);
+    Core::ReadLocker locker(mesh->lock());
+    if (!m_geometry[i] || m_revision[i] != mesh->revision()) {
+      // Every three vertices of the mesh are a triangle, so no indices are
+      // needed.
+      delete m_geometry[i];
+      m_geometry[i] = new MeshGeometry;
+      m_geometry[i]->setColor(colors[i]);
+      m_geometry[i]->setOpacity(opacity);
+      m_geometry[i]->addVertices(mesh->vertices(), mesh->normals());
+      m_geometry[i]->setRenderPass(opacity == 255 ? Rendering::OpaquePass
+                                                  : Rendering::TranslucentPass);
+      m_revision[i] = mesh->revision();
+    }
+    geometry->addDrawable(new MeshGeometry(*m_geometry[i]));
+  }
+}
+
+void Meshes::contextDestroyed()
+{
+  clearCache();
+  m_context = nullptr;
+  m_contextGroup = nullptr;
+}
+
+void Meshes::clearCache()
+{
+  // Deleting the buffers with no context of their group current would hit
+  // whatever context is, or none. That happens when the plugin is destroyed
+  // before its view at exit, or a view with an unshared context takes over. The
+  // geometry is leaked then, and the driver frees its buffers with the group.
+  QOpenGLContext* context = QOpenGLContext::currentContext();
+  bool current = context && context->shareGroup() == m_contextGroup;
+  for (int i = 0; i < 2; ++i) {
+    if (current)
+      delete m_geometry[i];
+    m_geometry[i] = nullptr;
   }
 }
 
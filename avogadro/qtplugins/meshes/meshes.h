@@ -19,12 +19,23 @@
 
 #include <avogadro/qtgui/sceneplugin.h>
 
+class QOpenGLContext;
+class QOpenGLContextGroup;
+
 namespace Avogadro {
+namespace Rendering {
+class MeshGeometry;
+}
+
 namespace QtPlugins {
 
 /**
  * @brief Render one or more triangular meshes.
  * @author Marcus D. Hanwell
+ *
+ * The geometry built from each mesh is kept until the mesh changes, scenes
+ * get copies of it that share its GPU buffers, so rebuilding the scene for
+ * unrelated edits does not copy or upload the meshes again.
  */
 class Meshes : public QtGui::ScenePlugin
 {
@@ -45,8 +56,23 @@ public:
 
   void setEnabled(bool enable) override;
 
+private slots:
+  /** The context the cache was built in is going away, and is current. */
+  void contextDestroyed();
+
 private:
+  /**
+   * Drop the cached geometry. Its GPU buffers are only deleted while a
+   * context of m_contextGroup is current, and leaked otherwise.
+   */
+  void clearCache();
+
   bool m_enabled;
+
+  Rendering::MeshGeometry* m_geometry[2];
+  Index m_revision[2];
+  QOpenGLContext* m_context;
+  QOpenGLContextGroup* m_contextGroup;
 };
 
 } // end namespace QtPlugins
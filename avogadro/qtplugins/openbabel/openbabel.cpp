@@ -26,8 +26,11 @@
 #include <avogadro/qtgui/rwmolecule.h>
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
 #include <QtCore/QDebug>
+#include <QtCore/QFileInfo>
 #include <QtCore/QSettings>
+#include <QtCore/QStandardPaths>
 #include <QtCore/QTimer>
 
 #include <QtWidgets/QAction>
@@ -43,9 +46,28 @@ using Avogadro::QtGui::Molecule;
 namespace Avogadro {
 namespace QtPlugins {
 
+namespace {
+QVariantMap toVariantMap(const QMap<QString, QString>& map)
+{
+  QVariantMap result;
+  for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+    result.insert(it.key(), it.value());
+  return result;
+}
+
+QMap<QString, QString> fromVariantMap(const QVariantMap& map)
+{
+  QMap<QString, QString> result;
+  for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+    result.insert(it.key(), it.value().toString());
+  return result;
+}
+}
+
 OpenBabel::OpenBabel(QObject* p)
   : ExtensionPlugin(p), m_molecule(nullptr), m_process(new OBProcess(this)),
-    m_readFormatsPending(true), m_writeFormatsPending(true), m_progress(nullptr)
+    m_readFormatsPending(true), m_writeFormatsPending(true),
+    m_formatsFromCache(false), m_progress(nullptr)
 {
   QAction* action = new QAction(this);
   action->setEnabled(true);
@@ -84,11 +106,27 @@ OpenBabel::OpenBabel(QObject* p)
   connect(action, SIGNAL(triggered()), SLOT(onRemoveHydrogens()));
   m_actions.push_back(action);
 
+  // Querying obabel takes several process round trips, so use the results
+  // from the last session if the executable has not changed, and refresh the
+  // cache in the background.
+  m_executableKey = executableKey();
+  QString info;
+  if (loadCache()) {
+    m_formatsFromCache = true;
+    info = QSettings().value("openbabel/cache/info").toString();
+    QTimer::singleShot(0, this, SLOT(useCachedFormats()));
+  } else if (!m_executableKey.isEmpty()) {
+    info = openBabelInfo();
+    QSettings settings;
+    settings.remove("openbabel/cache");
+    settings.setValue("openbabel/cache/executable", m_executableKey);
+    settings.setValue("openbabel/cache/info", info);
+  }
+
   refreshReadFormats();
   refreshWriteFormats();
   refreshForceFields();
 
-  QString info = openBabelInfo();
   if (info.isEmpty()) {
     qWarning() << tr("%1 not found! Disabling Open Babel plugin actions.")
                     .arg(OBProcess().obabelExecutable());
@@ -228,6 +266,53 @@ bool OpenBabel::readMolecule(QtGui::Molecule& mol)
   return result;
 }
 
+QString OpenBabel::executableKey() const
+{
+  QString executable = OBProcess().obabelExecutable();
+  if (QFileInfo(executable).isRelative())
+    executable = QStandardPaths::findExecutable(executable);
+  QFileInfo info(executable);
+  if (executable.isEmpty() || !info.exists())
+    return QString();
+  return QString("%1:%2").arg(info.canonicalFilePath(),
+                              info.lastModified().toString(Qt::ISODate));
+}
+
+bool OpenBabel::loadCache()
+{
+  QSettings settings;
+  settings.beginGroup("openbabel/cache");
+  if (m_executableKey.isEmpty() ||
+      settings.value("executable").toString() != m_executableKey ||
+      !settings.contains("readFormats") || !settings.contains("writeFormats")) {
+    return false;
+  }
+
+  m_readFormats = fromVariantMap(settings.value("readFormats").toMap());
+  m_writeFormats = fromVariantMap(settings.value("writeFormats").toMap());
+  m_forceFields = fromVariantMap(settings.value("forceFields").toMap());
+  return !m_readFormats.isEmpty() && !m_writeFormats.isEmpty();
+}
+
+void OpenBabel::storeCache(const QString& name,
+                           const QMap<QString, QString>& map)
+{
+  // Do not cache the result of a failed query.
+  if (m_executableKey.isEmpty() || map.isEmpty())
+    return;
+  QSettings settings;
+  settings.beginGroup("openbabel/cache");
+  if (settings.value("executable").toString() == m_executableKey)
+    settings.setValue(name, toVariantMap(map));
+}
+
+void OpenBabel::useCachedFormats()
+{
+  m_readFormatsPending = false;
+  m_writeFormatsPending = false;
+  emit fileFormatsReady();
+}
+
 void OpenBabel::refreshReadFormats()
 {
   // No need to check if the member process is in use -- we use a temporary
@@ -242,12 +327,17 @@ void OpenBabel::refreshReadFormats()
 
 void OpenBabel::handleReadFormatUpdate(const QMap<QString, QString>& fmts)
 {
-  m_readFormatsPending = false;
-
   OBProcess* proc = qobject_cast<OBProcess*>(sender());
   if (proc)
     proc->deleteLater();
 
+  storeCache("readFormats", fmts);
+  // The cached formats have already been handed out, the refreshed list is
+  // used from the next session on.
+  if (m_formatsFromCache)
+    return;
+
+  m_readFormatsPending = false;
   m_readFormats = fmts;
 
   // Emit a signal indicating the file formats are ready if read and write
@@ -270,12 +360,15 @@ void OpenBabel::refreshWriteFormats()
 
 void OpenBabel::handleWriteFormatUpdate(const QMap<QString, QString>& fmts)
 {
-  m_writeFormatsPending = false;
-
   OBProcess* proc = qobject_cast<OBProcess*>(sender());
   if (proc)
     proc->deleteLater();
 
+  storeCache("writeFormats", fmts);
+  if (m_formatsFromCache)
+    return;
+
+  m_writeFormatsPending = false;
   m_writeFormats = fmts;
 
   // Emit a signal indicating the file formats are ready if read and write
@@ -302,6 +395,7 @@ void OpenBabel::handleForceFieldsUpdate(const QMap<QString, QString>& ffMap)
   if (proc)
     proc->deleteLater();
 
+  storeCache("forceFields", ffMap);
   m_forceFields = ffMap;
 }
 
@@ -65,6 +65,8 @@ public slots:
   bool readMolecule(QtGui::Molecule& mol) override;
 
 private slots:
+  void useCachedFormats();
+
   void refreshReadFormats();
   void handleReadFormatUpdate(const QMap<QString, QString>& fmts);
 
@@ -96,12 +98,23 @@ private:
   void showProcessInUseError(const QString& title) const;
   QString autoDetectForceField() const;
 
+  /**
+   * Identify the obabel executable by its path and modification time.
+   * @return An empty string if the executable cannot be found.
+   */
+  QString executableKey() const;
+  bool loadCache();
+  void storeCache(const QString& name, const QMap<QString, QString>& map);
+
   QtGui::Molecule* m_molecule;
   OBProcess* m_process;
   QList<QAction*> m_actions;
   QList<QByteArray> m_moleculeQueue;
   bool m_readFormatsPending;
   bool m_writeFormatsPending;
+  // The format lists came from the settings and are being revalidated.
+  bool m_formatsFromCache;
+  QString m_executableKey;
   QMap<QString, QString> m_readFormats;
   QMap<QString, QString> m_writeFormats;
   QMap<QString, QString> m_forceFields;
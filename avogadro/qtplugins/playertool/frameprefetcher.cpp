@@ -0,0 +1,169 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "frameprefetcher.h"
+
+#include <avogadro/core/dynamicbondperceiver.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/qtgui/molecule.h>
+
+#include <QtCore/QMutexLocker>
+
+namespace Avogadro {
+namespace QtPlugins {
+
+using Core::Array;
+
+FramePrefetcher::FramePrefetcher(QObject* parent_)
+  : QThread(parent_), m_molecule(nullptr), m_depth(8), m_frameCount(0),
+    m_nextRequest(0), m_stop(false)
+{
+}
+
+FramePrefetcher::~FramePrefetcher()
+{
+  stopPrefetch();
+}
+
+void FramePrefetcher::startPrefetch(QtGui::Molecule* mol, int frame)
+{
+  stopPrefetch();
+  if (!mol || mol->coordinate3dCount() < 2)
+    return;
+
+  m_molecule = mol;
+  m_frameCount = mol->coordinate3dCount();
+  const Array<unsigned char>& numbers = mol->atomicNumbers();
+  m_atomicNumbers.assign(numbers.begin(), numbers.end());
+  m_nextRequest = (frame + 1) % m_frameCount;
+  m_stop = false;
+  start();
+  requestFrames(frame);
+}
+
+void FramePrefetcher::stopPrefetch()
+{
+  {
+    QMutexLocker locker(&m_mutex);
+    m_stop = true;
+    m_wake.wakeAll();
+  }
+  wait();
+  clearQueues();
+  m_molecule = nullptr;
+}
+
+bool FramePrefetcher::takeFrame(int frame,
+                                Array<std::pair<Index, Index>>& bonds)
+{
+  if (!m_molecule || !isRunning() || frame < 0 || frame >= m_frameCount ||
+      m_molecule->coordinate3dCount() != m_frameCount ||
+      m_molecule->atomCount() != m_atomicNumbers.size()) {
+    return false;
+  }
+
+  std::vector<std::pair<Index, Index>> ready;
+  bool found = false;
+  {
+    QMutexLocker locker(&m_mutex);
+    auto entry = m_ready.find(frame);
+    if (entry != m_ready.end()) {
+      ready.swap(entry->second);
+      found = true;
+    }
+
+    // Frames that are no longer ahead of this one were skipped.
+    for (auto r = m_ready.begin(); r != m_ready.end();) {
+      int ahead = distance(frame, r->first);
+      if (ahead == 0 || ahead > m_depth)
+        r = m_ready.erase(r);
+      else
+        ++r;
+    }
+    for (auto r = m_requests.begin(); r != m_requests.end();) {
+      int ahead = distance(frame, r->frame);
+      if (ahead == 0 || ahead > m_depth)
+        r = m_requests.erase(r);
+      else
+        ++r;
+    }
+  }
+
+  // Playback jumped, e.g. because frames were dropped or the slider moved.
+  int next = distance(frame, m_nextRequest);
+  if (next == 0 || next > m_depth + 1)
+    m_nextRequest = (frame + 1) % m_frameCount;
+  requestFrames(frame);
+
+  if (found)
+    bonds = Array<std::pair<Index, Index>>(ready.begin(), ready.end());
+  return found;
+}
+
+void FramePrefetcher::run()
+{
+  Core::Molecule mol;
+  for (unsigned char number : m_atomicNumbers)
+    mol.addAtom(number);
+  Core::DynamicBondPerceiver perceiver;
+
+  forever {
+    Request request;
+    {
+      QMutexLocker locker(&m_mutex);
+      while (m_requests.empty() && !m_stop)
+        m_wake.wait(&m_mutex);
+      if (m_stop)
+        return;
+      request = std::move(m_requests.front());
+      m_requests.pop_front();
+    }
+
+    mol.setAtomPositions3d(
+      Array<Vector3>(request.positions.begin(), request.positions.end()));
+    perceiver.update(mol);
+    const Array<std::pair<Index, Index>>& pairs = mol.bondPairs();
+    std::vector<std::pair<Index, Index>> bonds(pairs.begin(), pairs.end());
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_stop)
+      m_ready[request.frame].swap(bonds);
+  }
+}
+
+int FramePrefetcher::distance(int from, int to) const
+{
+  return ((to - from) % m_frameCount + m_frameCount) % m_frameCount;
+}
+
+void FramePrefetcher::requestFrames(int current)
+{
+  for (;;) {
+    int ahead = distance(current, m_nextRequest);
+    if (ahead == 0 || ahead > m_depth)
+      break;
+
+    Request request;
+    request.frame = m_nextRequest;
+    Array<Vector3> coords = m_molecule->coordinate3d(m_nextRequest);
+    request.positions.assign(coords.begin(), coords.end());
+    {
+      QMutexLocker locker(&m_mutex);
+      m_requests.push_back(std::move(request));
+      m_wake.wakeOne();
+    }
+    m_nextRequest = (m_nextRequest + 1) % m_frameCount;
+  }
+}
+
+void FramePrefetcher::clearQueues()
+{
+  QMutexLocker locker(&m_mutex);
+  m_requests.clear();
+  m_ready.clear();
+}
+
+} // namespace QtPlugins
+} // namespace Avogadro
@@ -0,0 +1,99 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_QTPLUGINS_FRAMEPREFETCHER_H
+#define AVOGADRO_QTPLUGINS_FRAMEPREFETCHER_H
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/vector.h>
+
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace Avogadro {
+
+namespace QtGui {
+class Molecule;
+}
+
+namespace QtPlugins {
+
+/**
+ * @brief Perceives the bonds of upcoming trajectory frames on a worker thread.
+ *
+ * During playback with dynamic bonding, the GUI thread hands the coordinates
+ * of the next depth() frames to the worker, which runs a
+ * Core::DynamicBondPerceiver over them in playback order and keeps the
+ * resulting bond lists until they are taken. Each tick the GUI thread then
+ * only swaps in the coordinate set and the finished bond list. If the worker
+ * has fallen behind, takeFrame() fails and the caller perceives the bonds
+ * itself.
+ *
+ * Data crossing the threads is held in std::vector, since the reference
+ * counts of Core::Array are not atomic.
+ */
+class FramePrefetcher : public QThread
+{
+  Q_OBJECT
+public:
+  explicit FramePrefetcher(QObject* parent = nullptr);
+  ~FramePrefetcher() override;
+
+  /** Number of frames perceived ahead of the current one. Default 8. */
+  void setDepth(int frames) { m_depth = frames > 0 ? frames : 1; }
+  int depth() const { return m_depth; }
+
+  /**
+   * Start prefetching the frames of @a mol that follow @a frame, wrapping
+   * around at the end of the trajectory.
+   */
+  void startPrefetch(QtGui::Molecule* mol, int frame);
+
+  /** Stop the worker and drop everything prefetched. */
+  void stopPrefetch();
+
+  /**
+   * Take the bonds perceived for @a frame and queue further frames.
+   * @return False if the frame is not ready, or the molecule no longer
+   * matches the one prefetching was started for.
+   */
+  bool takeFrame(int frame, Core::Array<std::pair<Index, Index>>& bonds);
+
+protected:
+  void run() override;
+
+private:
+  struct Request
+  {
+    int frame;
+    std::vector<Vector3> positions;
+  };
+
+  int distance(int from, int to) const;
+  void requestFrames(int current);
+  void clearQueues();
+
+  QtGui::Molecule* m_molecule;
+  int m_depth;
+  int m_frameCount;
+  int m_nextRequest;
+  std::vector<unsigned char> m_atomicNumbers;
+
+  QMutex m_mutex;
+  QWaitCondition m_wake;
+  bool m_stop;
+  std::deque<Request> m_requests;
+  std::map<int, std::vector<std::pair<Index, Index>>> m_ready;
+};
+
+} // namespace QtPlugins
+} // namespace Avogadro
+
+#endif // AVOGADRO_QTPLUGINS_FRAMEPREFETCHER_H
@@ -0,0 +1,420 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "movieexporter.h"
+
+#include "gif.h"
+#include "gwavi.h"
+
+#include <avogadro/qtgui/molecule.h>
+#include <avogadro/rendering/glrenderer.h>
+
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QBuffer>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QTimer>
+#include <QtGui/QOpenGLBuffer>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFramebufferObject>
+#include <QtGui/QOpenGLFunctions>
+#include <QtWidgets/QOpenGLWidget>
+
+#include <cmath>
+#include <cstring>
+
+namespace Avogadro {
+namespace QtPlugins {
+
+using QtGui::Molecule;
+
+namespace {
+// Frames that can be in flight between glReadPixels and mapping the buffer.
+const int PixelBufferCount = 3;
+}
+
+struct MovieExporter::EncodedFrame
+{
+  EncodedFrame() : ok(false) {}
+
+  bool ok;
+  QString error;
+  GifPalette palette;
+  // Palette indices in the alpha channel for GIF, compressed image for AVI.
+  QByteArray data;
+};
+
+MovieExporter::MovieExporter(QObject* parent_)
+  : QObject(parent_), m_molecule(nullptr), m_glWidget(nullptr),
+    m_renderer(nullptr), m_width(800), m_height(600), m_frameRate(5),
+    m_dynamicBonding(true), m_format(Gif), m_numberWidth(1), m_running(false),
+    m_capturing(false), m_frameCount(0), m_nextFrame(0), m_readFrame(0),
+    m_submitted(0), m_written(0), m_fbo(nullptr), m_gif(nullptr),
+    m_avi(nullptr), m_maxInFlight(2)
+{
+  // Frames must reach the file in order, so there is only one writer.
+  m_writer.setMaxThreadCount(1);
+}
+
+MovieExporter::~MovieExporter()
+{
+  m_canceled.store(1);
+  m_encoders.waitForDone();
+  m_writer.waitForDone();
+  if (m_capturing)
+    releaseBuffers();
+  if (m_gif) {
+    GifEnd(m_gif);
+    delete m_gif;
+  }
+  if (m_avi)
+    gwavi_close(m_avi);
+}
+
+void MovieExporter::setSize(int width, int height)
+{
+  if (m_running)
+    return;
+  m_width = width;
+  m_height = height;
+}
+
+bool MovieExporter::start(Format format, const QString& baseName)
+{
+  if (m_running || !m_molecule || !m_glWidget || !m_renderer ||
+      m_molecule->coordinate3dCount() < 1) {
+    return false;
+  }
+
+  m_format = format;
+  m_baseName = baseName;
+  m_frameCount = m_molecule->coordinate3dCount();
+  m_numberWidth = static_cast<int>(
+    std::ceil(std::log10(static_cast<float>(m_frameCount) + 1)));
+  m_nextFrame = m_readFrame = m_submitted = m_written = 0;
+  m_previousImage = QImage();
+  m_bondPerceiver.reset();
+  m_inFlight.store(0);
+  m_canceled.store(0);
+  m_error.clear();
+  m_maxInFlight = 2 * qMax(1, m_encoders.maxThreadCount());
+
+  if (m_format == Gif) {
+    m_gif = new GifWriter;
+    if (!GifBegin(m_gif, (m_baseName + ".gif").toLocal8Bit().data(), m_width,
+                  m_height, 100 / m_frameRate)) {
+      delete m_gif;
+      m_gif = nullptr;
+      return false;
+    }
+  } else if (m_format == Avi) {
+    m_avi = gwavi_open((m_baseName + ".avi").toLocal8Bit().data(), m_width,
+                       m_height, "MJPG", m_frameRate, nullptr);
+    if (!m_avi)
+      return false;
+  }
+
+  m_glWidget->makeCurrent();
+  bool buffers = createBuffers();
+  m_glWidget->doneCurrent();
+  if (!buffers) {
+    if (m_gif) {
+      GifEnd(m_gif);
+      delete m_gif;
+      m_gif = nullptr;
+    }
+    if (m_avi) {
+      gwavi_close(m_avi);
+      m_avi = nullptr;
+    }
+    return false;
+  }
+
+  m_running = true;
+  m_capturing = true;
+  QTimer::singleShot(0, this, SLOT(captureNext()));
+  return true;
+}
+
+void MovieExporter::cancel()
+{
+  if (m_running)
+    fail(tr("The export was canceled."));
+}
+
+void MovieExporter::captureNext()
+{
+  if (!m_capturing)
+    return;
+  if (m_canceled.load()) {
+    stopCapture();
+    return;
+  }
+  // Let the encoders catch up before more frames are held in memory.
+  if (m_inFlight.load() >= m_maxInFlight) {
+    QTimer::singleShot(5, this, SLOT(captureNext()));
+    return;
+  }
+
+  // Updating the scene must happen before the context is taken over.
+  if (m_nextFrame < m_frameCount)
+    loadFrame(m_nextFrame);
+
+  m_glWidget->makeCurrent();
+  if (m_nextFrame < m_frameCount)
+    renderFrame(m_nextFrame++);
+
+  // A buffer is only mapped once the ring is full, which gives its transfer
+  // the time it took to render the frames after it. Without pixel buffers
+  // every frame is read back right away.
+  int ring = static_cast<int>(m_pixelBuffers.size());
+  while (m_readFrame < m_nextFrame &&
+         (m_nextFrame - m_readFrame >= ring || m_nextFrame == m_frameCount)) {
+    QImage image = readFrame(m_readFrame);
+    submitFrame(m_readFrame++, image);
+  }
+  m_glWidget->doneCurrent();
+
+  if (m_readFrame < m_frameCount)
+    QTimer::singleShot(0, this, SLOT(captureNext()));
+  else
+    stopCapture();
+}
+
+void MovieExporter::frameWritten()
+{
+  ++m_written;
+  emit progress(m_written, m_frameCount);
+  if (!m_capturing && m_written == m_submitted)
+    finish();
+}
+
+bool MovieExporter::createBuffers()
+{
+  QOpenGLFramebufferObjectFormat fboFormat;
+  fboFormat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+  m_fbo = new QOpenGLFramebufferObject(m_width, m_height, fboFormat);
+  if (!m_fbo->isValid()) {
+    delete m_fbo;
+    m_fbo = nullptr;
+    return false;
+  }
+
+  // Mapping pack buffers is not available in OpenGL ES 2, where frames are
+  // read back synchronously instead.
+  QOpenGLContext* context = QOpenGLContext::currentContext();
+  if (context && !context->isOpenGLES()) {
+    for (int i = 0; i < PixelBufferCount; ++i) {
+      QOpenGLBuffer* buffer = new QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer);
+      buffer->setUsagePattern(QOpenGLBuffer::StreamRead);
+      if (!buffer->create()) {
+        delete buffer;
+        break;
+      }
+      buffer->bind();
+      buffer->allocate(m_width * m_height * 4);
+      buffer->release();
+      m_pixelBuffers.push_back(buffer);
+    }
+    if (static_cast<int>(m_pixelBuffers.size()) != PixelBufferCount) {
+      for (QOpenGLBuffer* buffer : m_pixelBuffers)
+        delete buffer;
+      m_pixelBuffers.clear();
+    }
+  }
+  return true;
+}
+
+void MovieExporter::releaseBuffers()
+{
+  m_glWidget->makeCurrent();
+  for (QOpenGLBuffer* buffer : m_pixelBuffers)
+    delete buffer;
+  m_pixelBuffers.clear();
+  delete m_fbo;
+  m_fbo = nullptr;
+  m_glWidget->doneCurrent();
+}
+
+void MovieExporter::loadFrame(int frame)
+{
+  m_molecule->setCoordinate3d(frame);
+  if (m_dynamicBonding)
+    m_bondPerceiver.update(*m_molecule);
+  m_molecule->emitChanged(Molecule::Atoms | Molecule::Modified);
+}
+
+void MovieExporter::renderFrame(int frame)
+{
+  m_fbo->bind();
+  m_renderer->resize(m_width, m_height);
+  m_renderer->render();
+  if (!m_pixelBuffers.empty()) {
+    QOpenGLBuffer* buffer = m_pixelBuffers[frame % m_pixelBuffers.size()];
+    buffer->bind();
+    // Returns immediately, the transfer completes in the background.
+    QOpenGLContext::currentContext()->functions()->glReadPixels(
+      0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    buffer->release();
+  }
+  m_fbo->release();
+  // The view keeps painting while the export runs.
+  m_renderer->resize(m_glWidget->width(), m_glWidget->height());
+}
+
+QImage MovieExporter::readFrame(int frame)
+{
+  // The rows are stored bottom to top, the encoders flip them.
+  QImage image(m_width, m_height, QImage::Format_RGBA8888);
+  if (m_pixelBuffers.empty()) {
+    m_fbo->bind();
+    QOpenGLContext::currentContext()->functions()->glReadPixels(
+      0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, image.bits());
+    m_fbo->release();
+    return image;
+  }
+
+  QOpenGLBuffer* buffer = m_pixelBuffers[frame % m_pixelBuffers.size()];
+  buffer->bind();
+  void* pixels = buffer->map(QOpenGLBuffer::ReadOnly);
+  if (pixels) {
+    std::memcpy(image.bits(), pixels, m_width * m_height * 4);
+    buffer->unmap();
+  } else {
+    image.fill(Qt::black);
+  }
+  buffer->release();
+  return image;
+}
+
+void MovieExporter::submitFrame(int frame, const QImage& image)
+{
+  QString fileName;
+  if (m_format == PngSequence) {
+    fileName = QString("%1%2.png")
+                 .arg(m_baseName)
+                 .arg(frame, m_numberWidth, 10, QChar('0'));
+  }
+
+  // GIF frames only store the pixels that changed, which is decided against
+  // the previous captured frame so frames can be quantized independently.
+  QImage previous = m_format == Gif ? m_previousImage : QImage();
+  m_previousImage = image;
+
+  m_inFlight.ref();
+  ++m_submitted;
+  QFuture<EncodedFrame> encoded =
+    QtConcurrent::run(&m_encoders, &MovieExporter::encodeFrame, m_format,
+                      image, previous, fileName);
+  QtConcurrent::run(&m_writer, [this, encoded]() {
+    EncodedFrame result = encoded.result();
+    if (!m_canceled.load())
+      writeFrame(result);
+    m_inFlight.deref();
+    QMetaObject::invokeMethod(this, "frameWritten", Qt::QueuedConnection);
+  });
+}
+
+MovieExporter::EncodedFrame MovieExporter::encodeFrame(Format format,
+                                                       QImage image,
+                                                       QImage previous,
+                                                       QString fileName)
+{
+  EncodedFrame result;
+  if (format == Gif) {
+    uint32_t width = static_cast<uint32_t>(image.width());
+    uint32_t height = static_cast<uint32_t>(image.height());
+    const uint8_t* last = previous.isNull() ? nullptr : previous.constBits();
+    GifMakePalette(last, image.constBits(), width, height, 8, false,
+                   &result.palette);
+    QByteArray indexed(image.bytesPerLine() * image.height(),
+                       Qt::Uninitialized);
+    uint8_t* out = reinterpret_cast<uint8_t*>(indexed.data());
+    GifThresholdImage(last, image.constBits(), out, width, height,
+                      &result.palette);
+    // The frame was read bottom to top.
+    result.data.resize(indexed.size());
+    int rowSize = image.bytesPerLine();
+    for (int row = 0; row < image.height(); ++row) {
+      std::memcpy(result.data.data() + row * rowSize,
+                  indexed.constData() + (image.height() - row - 1) * rowSize,
+                  rowSize);
+    }
+    result.ok = true;
+  } else if (format == Avi) {
+    QBuffer buffer(&result.data);
+    buffer.open(QIODevice::WriteOnly);
+    result.ok = image.mirrored().save(&buffer, "JPG");
+    if (!result.ok)
+      result.error = tr("Error: cannot add frame to video.");
+  } else {
+    result.ok = image.mirrored().save(fileName);
+    if (!result.ok)
+      result.error = tr("Cannot save file %1.").arg(fileName);
+  }
+  return result;
+}
+
+void MovieExporter::writeFrame(EncodedFrame& encoded)
+{
+  if (!encoded.ok) {
+    fail(encoded.error);
+    return;
+  }
+  if (m_format == Gif) {
+    GifWriteLzwImage(m_gif->f, reinterpret_cast<uint8_t*>(encoded.data.data()),
+                     0, 0, m_width, m_height, 100 / m_frameRate,
+                     &encoded.palette);
+  } else if (m_format == Avi) {
+    if (gwavi_add_frame(
+          m_avi, reinterpret_cast<const unsigned char*>(encoded.data.data()),
+          encoded.data.size()) == -1) {
+      fail(tr("Error: cannot add frame to video."));
+    }
+  }
+}
+
+void MovieExporter::fail(const QString& error)
+{
+  QMutexLocker locker(&m_errorMutex);
+  if (m_error.isEmpty())
+    m_error = error;
+  m_canceled.store(1);
+}
+
+void MovieExporter::stopCapture()
+{
+  m_capturing = false;
+  releaseBuffers();
+  m_previousImage = QImage();
+  m_glWidget->update();
+  if (m_written == m_submitted)
+    finish();
+}
+
+void MovieExporter::finish()
+{
+  m_encoders.waitForDone();
+  m_writer.waitForDone();
+  if (m_gif) {
+    GifEnd(m_gif);
+    delete m_gif;
+    m_gif = nullptr;
+  }
+  if (m_avi) {
+    gwavi_close(m_avi);
+    m_avi = nullptr;
+  }
+  m_running = false;
+
+  QString error;
+  {
+    QMutexLocker locker(&m_errorMutex);
+    error = m_error;
+  }
+  emit finished(error.isEmpty(), error);
+}
+
+} // namespace QtPlugins
+} // namespace Avogadro
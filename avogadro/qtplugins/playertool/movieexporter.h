@@ -0,0 +1,164 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_QTPLUGINS_MOVIEEXPORTER_H
+#define AVOGADRO_QTPLUGINS_MOVIEEXPORTER_H
+
+#include <avogadro/core/dynamicbondperceiver.h>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QThreadPool>
+#include <QtGui/QImage>
+
+#include <vector>
+
+class QOpenGLBuffer;
+class QOpenGLFramebufferObject;
+class QOpenGLWidget;
+
+struct GifWriter;
+struct gwavi_t;
+
+namespace Avogadro {
+
+namespace Rendering {
+class GLRenderer;
+}
+
+namespace QtGui {
+class Molecule;
+}
+
+namespace QtPlugins {
+
+/**
+ * @brief Exports the frames of a trajectory to a movie without blocking the
+ * user interface.
+ *
+ * Every frame is rendered into an offscreen framebuffer of the export size, so
+ * the view is neither resized nor repainted for the capture. The pixels are
+ * read back through a small ring of pixel buffer objects, and a frame is only
+ * mapped a couple of frames after its read was queued, so the GPU transfer
+ * overlaps with rendering the following frames. Color quantization (GIF) and
+ * image compression (AVI, PNG) run on a thread pool, and a single writer
+ * thread appends the encoded frames to the file in order. The capture is
+ * driven from the event loop one frame at a time, and pauses whenever too
+ * many frames are waiting for the encoders.
+ */
+class MovieExporter : public QObject
+{
+  Q_OBJECT
+public:
+  enum Format
+  {
+    Gif,
+    Avi,
+    /** Numbered PNG files, e.g. as input for an external video encoder. */
+    PngSequence
+  };
+
+  explicit MovieExporter(QObject* parent = nullptr);
+  ~MovieExporter() override;
+
+  void setMolecule(QtGui::Molecule* mol) { m_molecule = mol; }
+  void setGLWidget(QOpenGLWidget* widget) { m_glWidget = widget; }
+  void setRenderer(Rendering::GLRenderer* renderer) { m_renderer = renderer; }
+
+  /** Size of the exported frames. Default 800x600. */
+  void setSize(int width, int height);
+
+  /** Playback rate stored in the movie. Default 5. */
+  void setFrameRate(int fps) { m_frameRate = fps > 0 ? fps : 5; }
+
+  /** Perceive bonds again for each frame. Default true. */
+  void setDynamicBonding(bool dynamic) { m_dynamicBonding = dynamic; }
+
+  /**
+   * Start exporting all coordinate sets of the molecule. @a baseName gets the
+   * ".gif" or ".avi" suffix, or the zero-padded frame number and ".png" for
+   * each frame of a PNG sequence. Returns immediately; progress() and
+   * finished() report the outcome.
+   * @return False if an export is already running or cannot be started.
+   */
+  bool start(Format format, const QString& baseName);
+
+  bool isRunning() const { return m_running; }
+
+  /** Number of digits used for the frame numbers of a PNG sequence. */
+  int frameNumberWidth() const { return m_numberWidth; }
+
+public slots:
+  /** Stop capturing new frames, the export finishes with an error. */
+  void cancel();
+
+signals:
+  /** @a written of @a count frames are stored in the output. */
+  void progress(int written, int count);
+
+  /** The export is done, @a error describes why it failed. */
+  void finished(bool success, const QString& error);
+
+private slots:
+  void captureNext();
+  void frameWritten();
+
+private:
+  struct EncodedFrame;
+
+  bool createBuffers();
+  void releaseBuffers();
+  void loadFrame(int frame);
+  void renderFrame(int frame);
+  QImage readFrame(int frame);
+  void submitFrame(int frame, const QImage& image);
+  void writeFrame(EncodedFrame& encoded);
+  static EncodedFrame encodeFrame(Format format, QImage image, QImage previous,
+                                  QString fileName);
+  void fail(const QString& error);
+  void stopCapture();
+  void finish();
+
+  QtGui::Molecule* m_molecule;
+  QOpenGLWidget* m_glWidget;
+  Rendering::GLRenderer* m_renderer;
+  int m_width;
+  int m_height;
+  int m_frameRate;
+  bool m_dynamicBonding;
+  Core::DynamicBondPerceiver m_bondPerceiver;
+
+  Format m_format;
+  QString m_baseName;
+  int m_numberWidth;
+  bool m_running;
+  bool m_capturing;
+  int m_frameCount;
+  int m_nextFrame;
+  int m_readFrame;
+  int m_submitted;
+  int m_written;
+
+  QOpenGLFramebufferObject* m_fbo;
+  std::vector<QOpenGLBuffer*> m_pixelBuffers;
+  QImage m_previousImage;
+
+  GifWriter* m_gif;
+  gwavi_t* m_avi;
+
+  QThreadPool m_encoders;
+  QThreadPool m_writer;
+  QAtomicInt m_inFlight;
+  QAtomicInt m_canceled;
+  int m_maxInFlight;
+  QMutex m_errorMutex;
+  QString m_error;
+};
+
+} // namespace QtPlugins
+} // namespace Avogadro
+
+#endif // AVOGADRO_QTPLUGINS_MOVIEEXPORTER_H
@@ -15,17 +15,16 @@
 ******************************************************************************/
 
 #include "playertool.h"
-#include "gif.h"
-
-#include "gwavi.h"
+#include "frameprefetcher.h"
+#include "movieexporter.h"
 
 #include <avogadro/core/vector.h>
 #include <avogadro/qtgui/molecule.h>
 
-#include <QtCore/QBuffer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QProcess>
 #include <QtGui/QIcon>
-#include <QtGui/QOpenGLFramebufferObject>
 #include <QtWidgets/QAction>
 #include <QtWidgets/QCheckBox>
 #include <QtWidgets/QFileDialog>
@@ -34,6 +33,7 @@
 #include <QtWidgets/QLineEdit>
 #include <QtWidgets/QMessageBox>
 #include <QtWidgets/QOpenGLWidget>
+#include <QtWidgets/QProgressDialog>
 #include <QtWidgets/QPushButton>
 #include <QtWidgets/QSlider>
 #include <QtWidgets/QSpinBox>
@@ -41,8 +41,6 @@
 
 #include <QDebug>
 
-#include <cmath>
-
 namespace Avogadro {
 namespace QtPlugins {
 
@@ -55,11 +53,24 @@ PlayerTool::PlayerTool(QObject* parent_)
   , m_renderer(nullptr)
   , m_currentFrame(0)
   , m_toolWidget(nullptr)
+  , m_ticksPlayed(0)
+  , m_prefetcher(new FramePrefetcher(this))
   , m_frameIdx(nullptr)
   , m_slider(nullptr)
+  , m_exporter(new MovieExporter(this))
+  , m_progressDialog(nullptr)
+  , m_movieFrameCount(0)
+  , m_encodeMp4(false)
+  , m_encoder(nullptr)
 {
   m_activateAction->setText(tr("Player"));
   m_activateAction->setIcon(QIcon(":/icons/player.png"));
+  connect(m_exporter, SIGNAL(progress(int, int)),
+          SLOT(movieProgress(int, int)));
+  connect(m_exporter, SIGNAL(finished(bool, QString)),
+          SLOT(movieFinished(bool, QString)));
+  m_timer.setTimerType(Qt::PreciseTimer);
+  connect(&m_timer, SIGNAL(timeout()), SLOT(playbackTick()));
 }
 
 PlayerTool::~PlayerTool() {}
@@ -152,7 +163,6 @@ QWidget* PlayerTool::toolWidget() const
 
     m_toolWidget->setLayout(layout);
   }
-  connect(&m_timer, SIGNAL(timeout()), SLOT(animate()));
 
   return m_toolWidget;
 }
@@ -172,6 +182,17 @@ QUndoCommand* PlayerTool::mouseDoubleClickEvent(QMouseEvent*)
   return nullptr;
 }
 
+void PlayerTool::setMolecule(QtGui::Molecule* mol)
+{
+  if (m_molecule != mol) {
+    m_prefetcher->stopPrefetch();
+    m_molecule = mol;
+    m_currentFrame = 0;
+    m_bondPerceiver.reset();
+    setSliderLimit();
+  }
+}
+
 void PlayerTool::setActiveWidget(QWidget* widget)
 {
   m_glWidget = qobject_cast<QOpenGLWidget*>(widget);
@@ -197,6 +218,10 @@ void PlayerTool::play()
   int timeOut = static_cast<int>(1000 / fps);
   if (m_timer.isActive())
     m_timer.stop();
+  m_playClock.start();
+  m_ticksPlayed = 0;
+  if (m_molecule && m_dynamicBonding->isChecked())
+    m_prefetcher->startPrefetch(m_molecule, m_currentFrame);
   m_timer.start(timeOut);
 }
 
@@ -205,6 +230,7 @@ void PlayerTool::stop()
   playButton->setEnabled(true);
   stopButton->setEnabled(false);
   m_timer.stop();
+  m_prefetcher->stopPrefetch();
 }
 
 void PlayerTool::animate(int advance)
@@ -219,8 +245,15 @@ void PlayerTool::animate(int advance)
       m_molecule->setCoordinate3d(m_currentFrame);
     }
     if (m_dynamicBonding->isChecked()) {
-      m_molecule->clearBonds();
-      m_molecule->perceiveBondsSimple();
+      Core::Array<std::pair<Index, Index>> bonds;
+      if (m_prefetcher->takeFrame(m_currentFrame, bonds)) {
+        m_molecule->clearBonds();
+        m_molecule->addBonds(bonds);
+        // Keep the perceiver in step, so a later miss stays incremental.
+        m_bondPerceiver.adoptBonds(*m_molecule);
+      } else {
+        m_bondPerceiver.update(*m_molecule);
+      }
     }
     m_molecule->emitChanged(Molecule::Atoms | Molecule::Added);
     m_slider->setValue(m_currentFrame);
@@ -228,15 +261,31 @@ void PlayerTool::animate(int advance)
   }
 }
 
+void PlayerTool::playbackTick()
+{
+  // Advance by the number of frames that are due, so playback keeps its pace
+  // when rendering a frame takes longer than the timer interval.
+  int interval = m_timer.interval() > 0 ? m_timer.interval() : 1;
+  qint64 due = m_playClock.elapsed() / interval;
+  if (due <= m_ticksPlayed)
+    return;
+  int advance = static_cast<int>(due - m_ticksPlayed);
+  m_ticksPlayed = due;
+  animate(advance);
+}
+
 void PlayerTool::recordMovie()
 {
-  int EXPORT_WIDTH = 800, EXPORT_HEIGHT = 600;
   if (m_timer.isActive())
     m_timer.stop();
-
-  QString baseFileName;
-  if (m_molecule)
-    baseFileName = m_molecule->data("fileName").toString().c_str();
+  m_prefetcher->stopPrefetch();
+  if (!m_molecule || !m_glWidget || !m_renderer || m_exporter->isRunning())
+    return;
+  if (m_encoder && m_encoder->state() != QProcess::NotRunning) {
+    QMessageBox::information(qobject_cast<QWidget*>(parent()), tr("Avogadro"),
+                             tr("The previous movie is still being encoded."));
+    return;
+  }
 
   QString selfFilter = tr("Movie (*.mp4)");
   QString baseName = QFileDialog::getSaveFileName(
@@ -250,141 +299,140 @@ void PlayerTool::recordMovie()
   if (!fileInfo.suffix().isEmpty())
     baseName = fileInfo.absolutePath() + "/" + fileInfo.baseName();
 
-  bool bonding = m_dynamicBonding->isChecked();
-  int numberLength = static_cast<int>(
-    ceil(log10(static_cast<float>(m_molecule->coordinate3dCount()) + 1)));
-  m_glWidget->resize(EXPORT_WIDTH, EXPORT_HEIGHT);
-
-  if (selfFilter == tr("GIF (*.gif)")) {
-    GifWriter writer;
-    GifBegin(&writer, (baseName + ".gif").toLatin1().data(), EXPORT_WIDTH,
-             EXPORT_HEIGHT, 100 / m_animationFPS->value());
-    for (int i = 0; i < m_molecule->coordinate3dCount(); ++i) {
-      m_molecule->setCoordinate3d(i);
-      if (bonding) {
-        m_molecule->clearBonds();
-        m_molecule->perceiveBondsSimple();
-      }
-      m_molecule->emitChanged(Molecule::Atoms | Molecule::Modified);
+  MovieExporter::Format format = MovieExporter::PngSequence;
+  if (selfFilter == tr("GIF (*.gif)"))
+    format = MovieExporter::Gif;
+  else if (selfFilter == tr("Movie (*.avi)"))
+    format = MovieExporter::Avi;
+  m_encodeMp4 = format == MovieExporter::PngSequence;
+  m_movieBaseName = baseName;
+  m_movieFrameCount = m_molecule->coordinate3dCount();
+
+  // Frames are rendered offscreen at the export size, the view is untouched.
+  m_exporter->setMolecule(m_molecule);
+  m_exporter->setGLWidget(m_glWidget);
+  m_exporter->setRenderer(m_renderer);
+  m_exporter->setSize(800, 600);
+  m_exporter->setFrameRate(m_animationFPS->value());
+  m_exporter->setDynamicBonding(m_dynamicBonding->isChecked());
+  if (!m_exporter->start(format, baseName)) {
+    QMessageBox::warning(qobject_cast<QWidget*>(parent()), tr("Avogadro"),
+                         tr("Cannot start the movie export."));
+    return;
+  }
 
-      QImage exportImage;
-      m_glWidget->raise();
-      m_glWidget->repaint();
-      if (QOpenGLFramebufferObject::hasOpenGLFramebufferObjects()) {
-        exportImage = m_glWidget->grabFramebuffer();
-      } else {
-        QPixmap pixmap = QPixmap::grabWindow(m_glWidget->winId());
-        exportImage = pixmap.toImage();
-      }
+  // The exporter steps the molecule through its frames, so the window stays
+  // blocked by the progress dialog until it is done to prevent any edits.
+  if (!m_progressDialog) {
+    m_progressDialog = new QProgressDialog(qobject_cast<QWidget*>(parent()));
+    m_progressDialog->setWindowTitle(tr("Record Movie"));
+    m_progressDialog->setLabelText(tr("Exporting frames..."));
+    m_progressDialog->setWindowModality(Qt::WindowModal);
+    m_progressDialog->setMinimumDuration(0);
+    m_progressDialog->setAutoReset(false);
+    m_progressDialog->setAutoClose(false);
+    connect(m_progressDialog, SIGNAL(canceled()), m_exporter, SLOT(cancel()));
+  }
+  m_progressDialog->setRange(0, m_molecule->coordinate3dCount());
+  m_progressDialog->setValue(0);
+}
 
-      int frameWidth = exportImage.width();
-      int frameHeight = exportImage.height();
-      int numbPixels = frameWidth * frameHeight;
-
-      uint8_t* imageData = new uint8_t[numbPixels * 4];
-      int imageIndex = 0;
-      for (int j = 0; j < frameHeight; ++j) {
-        for (int k = 0; k < frameWidth; ++k) {
-          QColor color = exportImage.pixel(k, j);
-          imageData[imageIndex] = (uint8_t)color.red();
-          imageData[imageIndex + 1] = (uint8_t)color.green();
-          imageData[imageIndex + 2] = (uint8_t)color.blue();
-          imageData[imageIndex + 3] = (uint8_t)color.alpha();
-          imageIndex += 4;
-        }
-      }
-      GifWriteFrame(&writer, imageData, EXPORT_WIDTH, EXPORT_HEIGHT,
-                    100 / m_animationFPS->value());
-      delete[] imageData;
-    }
-    GifEnd(&writer);
-  } else if (selfFilter == tr("Movie (*.avi)")) {
-    gwavi_t* gwavi;
-    gwavi = gwavi_open((baseName + ".avi").toLatin1().data(), EXPORT_WIDTH,
-                       EXPORT_HEIGHT, "MJPG", m_animationFPS->value(), NULL);
-    for (int i = 0; i < m_molecule->coordinate3dCount(); ++i) {
-      m_molecule->setCoordinate3d(i);
-      if (bonding) {
-        m_molecule->clearBonds();
-        m_molecule->perceiveBondsSimple();
-      }
-      m_molecule->emitChanged(Molecule::Atoms | Molecule::Modified);
+void PlayerTool::movieProgress(int written, int)
+{
+  if (m_progressDialog)
+    m_progressDialog->setValue(written);
+}
 
-      QImage exportImage;
-      m_glWidget->raise();
-      m_glWidget->repaint();
-      if (QOpenGLFramebufferObject::hasOpenGLFramebufferObjects()) {
-        exportImage = m_glWidget->grabFramebuffer();
-      } else {
-        QPixmap pixmap = QPixmap::grabWindow(m_glWidget->winId());
-        exportImage = pixmap.toImage();
-      }
-      QByteArray ba;
-      QBuffer buffer(&ba);
-      buffer.open(QIODevice::WriteOnly);
-      exportImage.save(&buffer, "JPG");
-
-      if (gwavi_add_frame(
-            gwavi, reinterpret_cast<const unsigned char*>(buffer.data().data()),
-            buffer.size()) == -1) {
-        QMessageBox::warning(qobject_cast<QWidget*>(parent()), tr("Avogadro"),
-                             tr("Error: cannot add frame to video."));
-      }
-    }
-    gwavi_close(gwavi);
-  } else if (selfFilter == tr("Movie (*.mp4)")) {
-    for (int i = 0; i < m_molecule->coordinate3dCount(); ++i) {
-      m_molecule->setCoordinate3d(i);
-      if (bonding) {
-        m_molecule->clearBonds();
-        m_molecule->perceiveBondsSimple();
-      }
-      m_molecule->emitChanged(Molecule::Atoms | Molecule::Modified);
-      QString fileName = QString::number(i);
-      while (fileName.length() < numberLength)
-        fileName.prepend('0');
-      fileName.prepend(baseName);
-      fileName.append(".png");
-
-      QImage exportImage;
-      m_glWidget->raise();
-      m_glWidget->repaint();
-      if (QOpenGLFramebufferObject::hasOpenGLFramebufferObjects()) {
-        exportImage = m_glWidget->grabFramebuffer();
-      } else {
-        QPixmap pixmap = QPixmap::grabWindow(m_glWidget->winId());
-        exportImage = pixmap.toImage();
-      }
+void PlayerTool::movieFinished(bool success, const QString& error)
+{
+  if (m_progressDialog) {
+    m_progressDialog->reset();
+    m_progressDialog->hide();
+  }
+  if (!success) {
+    QMessageBox::warning(qobject_cast<QWidget*>(parent()), tr("Avogadro"),
+                         error);
+    return;
+  }
 
-      if (!exportImage.save(fileName)) {
-        QMessageBox::warning(qobject_cast<QWidget*>(parent()), tr("Avogadro"),
-                             tr("Cannot save file %1.").arg(fileName));
-        return;
-      }
-      QProcess proc;
-      QStringList args;
-      args << "-y"
-           << "-r" << QString::number(m_animationFPS->value()) << "-i"
-           << baseName + "%0" + QString::number(numberLength) + "d.png"
-           << "-c:v"
-           << "libx264"
-           << "-r"
-           << "30"
-           << "-pix_fmt"
-           << "yuv420p" << baseName + ".mp4";
-      proc.execute("avconv", args);
-    }
+  if (m_encodeMp4)
+    encodeMovie();
+}
+
+void PlayerTool::encodeMovie()
+{
+  if (!m_encoder) {
+    m_encoder = new QProcess(this);
+    m_encoder->setProcessChannelMode(QProcess::MergedChannels);
+    connect(m_encoder, SIGNAL(finished(int, QProcess::ExitStatus)),
+            SLOT(encoderFinished(int, QProcess::ExitStatus)));
+    connect(m_encoder, SIGNAL(error(QProcess::ProcessError)),
+            SLOT(encoderError(QProcess::ProcessError)));
+  }
+
+  // All frames are on disk, encode them in one go.
+  QStringList args;
+  args << "-y"
+       << "-r" << QString::number(m_animationFPS->value()) << "-i"
+       << m_movieBaseName + "%0" +
+            QString::number(m_exporter->frameNumberWidth()) + "d.png"
+       << "-c:v"
+       << "libx264"
+       << "-r"
+       << "30"
+       << "-pix_fmt"
+       << "yuv420p" << m_movieBaseName + ".mp4";
+  m_encoder->start("avconv", args);
+}
+
+void PlayerTool::encoderFinished(int exitCode, QProcess::ExitStatus status)
+{
+  if (status == QProcess::NormalExit && exitCode == 0) {
+    removeMovieFrames();
+    return;
+  }
+
+  // Keep the frames, so that they can still be encoded by hand.
+  QString output = QString::fromLocal8Bit(m_encoder->readAll()).trimmed();
+  QMessageBox::warning(
+    qobject_cast<QWidget*>(parent()), tr("Avogadro"),
+    tr("Encoding the movie %1 failed, the frames were kept in %2.\n\n%3")
+      .arg(m_movieBaseName + ".mp4")
+      .arg(QFileInfo(m_movieBaseName).absolutePath())
+      .arg(output.right(1000)));
+}
+
+void PlayerTool::encoderError(QProcess::ProcessError error)
+{
+  // Other errors end the process, and are reported by encoderFinished().
+  if (error != QProcess::FailedToStart)
+    return;
+  QMessageBox::warning(
+    qobject_cast<QWidget*>(parent()), tr("Avogadro"),
+    tr("Cannot run avconv to encode the movie, the frames were kept in %1.")
+      .arg(QFileInfo(m_movieBaseName).absolutePath()));
+}
+
+void PlayerTool::removeMovieFrames()
+{
+  int width = m_exporter->frameNumberWidth();
+  for (int i = 0; i < m_movieFrameCount; ++i) {
+    QFile::remove(
+      QString("%1%2.png").arg(m_movieBaseName).arg(i, width, 10, QChar('0')));
   }
 }
 
 void PlayerTool::sliderPositionChanged(int k)
 {
-  animate(k - m_currentFrame);
+  // animate() updates the slider itself, which must not render again.
+  if (k != m_currentFrame)
+    animate(k - m_currentFrame);
 }
 
 void PlayerTool::spinnerPositionChanged(int k)
 {
-  animate(k - m_currentFrame - 1);
+  if (k - 1 != m_currentFrame)
+    animate(k - m_currentFrame - 1);
 }
 
 void PlayerTool::setSliderLimit()
@@ -20,19 +20,26 @@
 #include <avogadro/qtgui/toolplugin.h>
 
 #include <avogadro/core/avogadrocore.h>
+#include <avogadro/core/dynamicbondperceiver.h>
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QProcess>
 #include <QtCore/QTimer>
 
 class QLabel;
 class QSpinBox;
 class QCheckBox;
 class QOpenGLWidget;
+class QProgressDialog;
 class QPushButton;
 class QSlider;
 
 namespace Avogadro {
 namespace QtPlugins {
 
+class FramePrefetcher;
+class MovieExporter;
+
 /**
  * @brief PlayerTool enables playback of trajectories.
  */
@@ -64,19 +71,32 @@ protected slots:
   void play();
   void stop();
   void animate(int advance = 1);
+  void playbackTick();
 
   void recordMovie();
+  void movieProgress(int written, int count);
+  void movieFinished(bool success, const QString& error);
+  void encoderFinished(int exitCode, QProcess::ExitStatus status);
+  void encoderError(QProcess::ProcessError error);
   void sliderPositionChanged(int k);
   void spinnerPositionChanged(int k);
   void setSliderLimit();
 
 private:
+  /** Encode the exported PNG frames into an MP4 movie with avconv. */
+  void encodeMovie();
+  void removeMovieFrames();
+
   QAction* m_activateAction;
   QtGui::Molecule* m_molecule;
   Rendering::GLRenderer* m_renderer;
   int m_currentFrame;
   mutable QWidget* m_toolWidget;
   QTimer m_timer;
+  QElapsedTimer m_playClock;
+  qint64 m_ticksPlayed;
+  Core::DynamicBondPerceiver m_bondPerceiver;
+  FramePrefetcher* m_prefetcher;
   mutable QSpinBox* m_animationFPS;
   mutable QSpinBox* m_frameIdx;
   mutable QCheckBox* m_dynamicBonding;
@@ -84,17 +104,14 @@ private:
   mutable QSlider* m_slider;
   mutable QPushButton* playButton;
   mutable QPushButton* stopButton;
+  MovieExporter* m_exporter;
+  QProgressDialog* m_progressDialog;
+  QString m_movieBaseName;
+  int m_movieFrameCount;
+  bool m_encodeMp4;
+  QProcess* m_encoder;
 };
 
-inline void PlayerTool::setMolecule(QtGui::Molecule* mol)
-{
-  if (m_molecule != mol) {
-    m_molecule = mol;
-    m_currentFrame = 0;
-    setSliderLimit();
-  }
-}
-
 inline void PlayerTool::setGLRenderer(Rendering::GLRenderer* renderer)
 {
   m_renderer = renderer;
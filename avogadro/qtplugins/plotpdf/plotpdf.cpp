@@ -20,6 +20,7 @@
 #include <QString>
 
 #include <avogadro/core/crystaltools.h>
+#include <avogadro/core/geometrytools.h>
 #include <avogadro/core/unitcell.h>
 #include <avogadro/qtgui/molecule.h>
 #include <avogadro/vtk/vtkplot.h>
@@ -28,11 +29,10 @@
 #include "plotpdf.h"
 
 using Avogadro::Core::CrystalTools;
+using Avogadro::Core::GeometryTools;
 using Avogadro::Core::UnitCell;
 using Avogadro::QtGui::Molecule;
 
-using std::map;
-
 namespace Avogadro {
 namespace QtPlugins {
 
@@ -182,25 +182,25 @@ bool PlotPdf::generatePdfPattern(QtGui::Molecule& mol, PdfData& results,
   CrystalTools::buildSupercell(newMolecule, 2 * a + 1, 2 * b + 1, 2 * c + 1);
 
   Array<Vector3> newAtomCoords = newMolecule.atomPositions3d();
+  GeometryTools::Positions newPositions =
+    GeometryTools::toStructureOfArrays(newAtomCoords);
 
-  map<size_t, size_t> pdfCount;
-  double dist, rStep = step;
-  size_t k, binIdx;
+  double rStep = step;
+  size_t k, binCount = static_cast<size_t>(maxRadius / rStep);
+  std::vector<size_t> pdfCount(binCount, 0);
 
   for (i = 0; i < refAtomCoords.size(); ++i) {
+    GeometryTools::Values dists =
+      GeometryTools::distances(newPositions, refAtomCoords.at(i));
     for (j = 0; j < newAtomCoords.size(); ++j) {
-      dist = (refAtomCoords.at(i) - newAtomCoords.at(j)).norm();
-      binIdx = static_cast<size_t>(dist / rStep);
-      if (pdfCount.find(binIdx) == pdfCount.end()) {
-        pdfCount.insert(std::make_pair(binIdx, 1));
-      } else {
-        pdfCount[binIdx]++;
-      }
+      size_t binIdx = static_cast<size_t>(dists[j] / rStep);
+      if (binIdx < binCount)
+        ++pdfCount[binIdx];
     }
   }
 
-  for (k = 0; k < static_cast<size_t>(maxRadius / rStep); k++) {
-    if (pdfCount.find(k) == pdfCount.end()) {
+  for (k = 0; k < binCount; k++) {
+    if (pdfCount[k] == 0) {
       results.push_back(std::make_pair(k * rStep, 0.0));
     } else {
       results.push_back(std::make_pair(
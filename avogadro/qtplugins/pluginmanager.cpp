@@ -19,9 +19,12 @@
 
 #include <avogadro/qtgui/utilities.h>
 
+#include <QtConcurrent/QtConcurrentMap>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QFileInfo>
+#include <QtCore/QJsonObject>
 #include <QtCore/QMutex>
 #include <QtCore/QPluginLoader>
 
@@ -37,6 +40,7 @@ PluginManager::PluginManager(QObject* p)
   QString libDir(QtGui::Utilities::libraryDirectory());
   // http://doc.qt.digia.com/qt/deployment-plugins.html#debugging-plugins
   bool debugPlugins = !qgetenv("QT_DEBUG_PLUGINS").isEmpty();
+  m_debugPlugins = debugPlugins;
 
   // The usual base directory is the parent directory of the executable's
   // location. (exe is in "bin" or "MacOS" and plugins are under the parent
@@ -105,36 +109,145 @@ void PluginManager::load()
 
 void PluginManager::load(const QString& path)
 {
-  // Load any static plugins first.
+  // Register any static plugins first.
   if (!m_staticPluginsLoaded) {
-    QObjectList staticPlugins = QPluginLoader::staticInstances();
-    foreach (QObject* pluginInstance, staticPlugins)
-      m_plugins.append(pluginInstance);
+    foreach (const QStaticPlugin& plugin, QPluginLoader::staticPlugins()) {
+      PluginEntry entry = readMetaData(plugin.metaData());
+      entry.staticInstance = plugin.instance;
+      addEntry(entry);
+    }
     m_staticPluginsLoaded = true;
   }
 
   QDir dir(path);
-  foreach (const QString& pluginPath, dir.entryList(QDir::Files)) {
-    QPluginLoader pluginLoader(dir.absolutePath() + "/" + pluginPath);
+  QStringList fileNames;
+  foreach (const QString& pluginPath, dir.entryList(QDir::Files))
+    fileNames.append(dir.absolutePath() + "/" + pluginPath);
+
+  // Reading the metadata opens and scans every file, but does not load the
+  // libraries, so it is safe to do on several threads.
+  QList<PluginEntry> entries =
+    QtConcurrent::blockingMapped<QList<PluginEntry>>(fileNames,
+                                                     &readPluginFile);
+  foreach (const PluginEntry& entry, entries) {
+    if (!entry.failed)
+      addEntry(entry);
+  }
+}
 
-    // We only want to count plugins once, the || should not be necessary but
-    // I found that on the Mac at least isLoaded was not always reliable (and
-    // if it is we skip the second in the short-circuit).
-    if (pluginLoader.isLoaded() || m_plugins.contains(pluginLoader.instance()))
-      continue;
+QStringList PluginManager::pluginIdentifiers() const
+{
+  QStringList identifiers;
+  foreach (const PluginEntry& entry, m_entries) {
+    if (!entry.identifier.isEmpty())
+      identifiers.append(entry.identifier);
+  }
+  return identifiers;
+}
 
-    QObject* pluginInstance = pluginLoader.instance();
+QMap<QString, double> PluginManager::loadTimes() const
+{
+  QMap<QString, double> times;
+  foreach (const PluginEntry& entry, m_entries) {
+    if (entry.instance) {
+      times.insert(entry.identifier.isEmpty() ? entry.fileName
+                                              : entry.identifier,
+                   entry.loadTime);
+    }
+  }
+  return times;
+}
 
-    // Check if the plugin loaded correctly. Keep debug output for now, should
-    // go away once we have verified this (or added to a logger).
-    if (!pluginInstance) {
-      qDebug() << "Failed to load" << pluginPath << "error"
-               << pluginLoader.errorString();
-      continue;
+PluginManager::PluginEntry PluginManager::readMetaData(
+  const QJsonObject& metaData)
+{
+  PluginEntry entry;
+  entry.iid = metaData.value("IID").toString();
+  entry.identifier =
+    metaData.value("MetaData").toObject().value("identifier").toString();
+  entry.instance = nullptr;
+  entry.failed = metaData.isEmpty();
+  entry.loadTime = 0.0;
+  return entry;
+}
+
+PluginManager::PluginEntry PluginManager::readPluginFile(
+  const QString& fileName)
+{
+  QPluginLoader pluginLoader(fileName);
+  PluginEntry entry = readMetaData(pluginLoader.metaData());
+  entry.fileName = fileName;
+  // Keep debug output for now, should go away once we have verified this (or
+  // added to a logger).
+  if (entry.failed) {
+    qDebug() << "Failed to load" << fileName << "error"
+             << pluginLoader.errorString();
+  }
+  return entry;
+}
+
+void PluginManager::addEntry(const PluginEntry& entry)
+{
+  // We only want to count plugins once, whether they are found again in the
+  // same directory or were also linked in statically.
+  foreach (const PluginEntry& existing, m_entries) {
+    if (!entry.fileName.isEmpty() && existing.fileName == entry.fileName)
+      return;
+    if (!entry.identifier.isEmpty() && existing.iid == entry.iid &&
+        existing.identifier == entry.identifier) {
+      return;
     }
+  }
+  m_entries.append(entry);
+}
+
+QList<QObject*> PluginManager::instances(const char* iid,
+                                         const QString& id) const
+{
+  QString interfaceId(QString::fromLatin1(iid));
+  QList<QObject*> result;
+  for (int i = 0; i < m_entries.size(); ++i) {
+    PluginEntry& entry = m_entries[i];
+    // Plugins built without metadata are loaded to find out what they are.
+    if (!entry.iid.isEmpty() && entry.iid != interfaceId)
+      continue;
+    if (!id.isEmpty() && !entry.identifier.isEmpty() && entry.identifier != id)
+      continue;
+    if (instantiate(entry))
+      result.append(entry.instance);
+  }
+  return result;
+}
 
-    m_plugins.append(pluginInstance);
+bool PluginManager::instantiate(PluginEntry& entry) const
+{
+  if (entry.instance)
+    return true;
+  if (entry.failed)
+    return false;
+
+  QElapsedTimer timer;
+  timer.start();
+  if (entry.staticInstance) {
+    entry.instance = entry.staticInstance();
+  } else {
+    QPluginLoader pluginLoader(entry.fileName);
+    entry.instance = pluginLoader.instance();
+    if (!entry.instance) {
+      qDebug() << "Failed to load" << entry.fileName << "error"
+               << pluginLoader.errorString();
+    }
+  }
+  entry.loadTime = timer.nsecsElapsed() / 1.0e6;
+  entry.failed = entry.instance == nullptr;
+
+  if (m_debugPlugins && entry.instance) {
+    qDebug() << "Loaded plugin"
+             << (entry.identifier.isEmpty() ? entry.fileName
+                                            : entry.identifier)
+             << "in" << entry.loadTime << "ms";
   }
+  return !entry.failed;
 }
 
 } // End QtGui namespace
@@ -20,9 +20,14 @@
 #include "avogadroqtpluginsexport.h"
 
 #include <QtCore/QList>
+#include <QtCore/QMap>
 #include <QtCore/QObject>
 #include <QtCore/QStringList>
 
+#include <functional>
+
+class QJsonObject;
+
 namespace Avogadro {
 namespace QtPlugins {
 
@@ -42,6 +47,11 @@ class ExtensionPluginFactory;
  *
  * The load methods can be called multiple times, and will load any new plugins
  * while ignoring plugins that have already been loaded.
+ *
+ * Loading only reads the metadata of each plugin, which is done in parallel
+ * for the plugin directories. The plugin libraries are loaded and their
+ * factories constructed the first time a factory of their type, or with their
+ * identifier, is requested.
  */
 
 class AVOGADROQTPLUGINS_EXPORT PluginManager : public QObject
@@ -92,7 +102,42 @@ public:
   template<typename T>
   T* pluginFactory(const QString& id) const;
 
+  /**
+   * @return The identifiers of all plugins found so far, including those that
+   * have not been instantiated yet.
+   */
+  QStringList pluginIdentifiers() const;
+
+  /**
+   * @return The time in milliseconds taken to load each plugin that has been
+   * instantiated so far, keyed by plugin identifier. With QT_DEBUG_PLUGINS
+   * set the times are also printed as the plugins are loaded.
+   */
+  QMap<QString, double> loadTimes() const;
+
 private:
+  struct PluginEntry
+  {
+    QString identifier;
+    QString iid;
+    QString fileName;
+    std::function<QObject*()> staticInstance;
+    QObject* instance;
+    bool failed;
+    double loadTime;
+  };
+
+  static PluginEntry readMetaData(const QJsonObject& metaData);
+  static PluginEntry readPluginFile(const QString& fileName);
+
+  /**
+   * Instantiate the plugins with interface @a iid, and with @a id if it is
+   * not empty.
+   */
+  QList<QObject*> instances(const char* iid, const QString& id) const;
+  bool instantiate(PluginEntry& entry) const;
+  void addEntry(const PluginEntry& entry);
+
   // Hide the constructor, destructor, copy and assignment operator.
   PluginManager(QObject* parent = 0);
   ~PluginManager() override;
@@ -103,16 +148,17 @@ private:
   QString m_relativeToApp;
 
   bool m_staticPluginsLoaded;
+  bool m_debugPlugins;
 
-  // Storage for the loaded plugin instances.
-  QList<QObject*> m_plugins;
+  // The plugins found so far, instantiated on first use.
+  mutable QList<PluginEntry> m_entries;
 };
 
 template<typename T>
 QList<T*> PluginManager::pluginFactories() const
 {
   QList<T*> factories;
-  foreach (QObject* plugin, m_plugins) {
+  foreach (QObject* plugin, instances(qobject_interface_iid<T*>(), QString())) {
     T* factory = qobject_cast<T*>(plugin);
     if (factory)
       factories.append(factory);
@@ -123,13 +169,12 @@ QList<T*> PluginManager::pluginFactories() const
 template<typename T>
 T* PluginManager::pluginFactory(const QString& id) const
 {
-  T* factory;
-  foreach (QObject* plugin, m_plugins) {
-    factory = qobject_cast<T*>(plugin);
+  foreach (QObject* plugin, instances(qobject_interface_iid<T*>(), id)) {
+    T* factory = qobject_cast<T*>(plugin);
     if (factory && factory->identifier() == id)
-      break;
+      return factory;
   }
-  return factory;
+  return nullptr;
 }
 
 } // End QtPlugins namespace
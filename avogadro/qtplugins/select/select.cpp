@@ -16,13 +16,18 @@
 
 #include "select.h"
 
+#include <avogadro/core/selectionquery.h>
 #include <avogadro/qtgui/molecule.h>
 
 #include <QtGui/QKeySequence>
 #include <QtWidgets/QAction>
+#include <QtWidgets/QInputDialog>
+#include <QtWidgets/QMessageBox>
 
 #include <QtCore/QStringList>
 
+using Avogadro::Core::AtomSelection;
+using Avogadro::Core::SelectionQuery;
 using Avogadro::QtGui::Molecule;
 
 namespace Avogadro {
@@ -48,6 +53,10 @@ Select::Select(QObject* parent_)
   action = new QAction(tr("Invert Selection"), this);
   connect(action, SIGNAL(triggered()), SLOT(invertSelection()));
   m_actions.append(action);
+
+  action = new QAction(tr("Select by Query..."), this);
+  connect(action, SIGNAL(triggered()), SLOT(selectByQuery()));
+  m_actions.append(action);
 }
 
 Select::~Select()
@@ -77,9 +86,7 @@ void Select::setMolecule(QtGui::Molecule* mol)
 void Select::selectAll()
 {
   if (m_molecule) {
-    for (Index i = 0; i < m_molecule->atomCount(); ++i)
-      m_molecule->atom(i).setSelected(true);
-
+    m_molecule->setAtomSelection(AtomSelection(m_molecule->atomCount(), true));
     m_molecule->emitChanged(Molecule::Atoms);
   }
 }
@@ -87,9 +94,7 @@ void Select::selectAll()
 void Select::selectNone()
 {
   if (m_molecule) {
-    for (Index i = 0; i < m_molecule->atomCount(); ++i)
-      m_molecule->atom(i).setSelected(false);
-
+    m_molecule->setAtomSelection(AtomSelection(m_molecule->atomCount()));
     m_molecule->emitChanged(Molecule::Atoms);
   }
 }
@@ -97,12 +102,37 @@ void Select::selectNone()
 void Select::invertSelection()
 {
   if (m_molecule) {
-    for (Index i = 0; i < m_molecule->atomCount(); ++i)
-      m_molecule->atom(i).setSelected(!m_molecule->atomSelected(i));
-
+    m_molecule->invertAtomSelection();
     m_molecule->emitChanged(Molecule::Atoms);
   }
 }
 
+void Select::selectByQuery()
+{
+  if (!m_molecule)
+    return;
+
+  bool ok = false;
+  QString text = QInputDialog::getText(
+    qobject_cast<QWidget*>(parent()), tr("Select by Query"),
+    tr("Atoms matching, e.g. \"element C and within 5 of resid 42\":"),
+    QLineEdit::Normal, m_lastQuery, &ok);
+  if (!ok || text.trimmed().isEmpty())
+    return;
+  m_lastQuery = text;
+
+  SelectionQuery query(text.toStdString());
+  if (!query.isValid()) {
+    QMessageBox::warning(qobject_cast<QWidget*>(parent()),
+                         tr("Select by Query"),
+                         tr("Invalid query: %1")
+                           .arg(QString::fromStdString(query.error())));
+    return;
+  }
+
+  m_molecule->setAtomSelection(query.evaluate(*m_molecule));
+  m_molecule->emitChanged(Molecule::Atoms);
+}
+
 } // namespace QtPlugins
 } // namespace Avogadro
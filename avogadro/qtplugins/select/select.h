@@ -44,10 +44,12 @@ private slots:
   void selectAll();
   void selectNone();
   void invertSelection();
+  void selectByQuery();
 
 private:
   QList<QAction*> m_actions;
   QtGui::Molecule* m_molecule;
+  QString m_lastQuery;
 };
 
 } // namespace QtPlugins
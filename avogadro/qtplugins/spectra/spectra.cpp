@@ -26,12 +26,15 @@
 #include <QtWidgets/QFileDialog>
 #include <avogadro/qtgui/molecule.h>
 
+#include <cmath>
+
 namespace Avogadro {
 namespace QtPlugins {
 
 Spectra::Spectra(QObject* p)
   : ExtensionPlugin(p), m_molecule(nullptr), m_dialog(nullptr),
-    m_timer(nullptr), m_mode(0), m_amplitude(20)
+    m_timer(nullptr), m_phase(0.0), m_mode(0), m_amplitude(20),
+    m_hasFrames(false)
 {
   QAction* action = new QAction(this);
   action->setEnabled(false);
@@ -64,6 +67,7 @@ void Spectra::setMolecule(QtGui::Molecule* mol)
 
   m_actions[0]->setEnabled(isVibrational);
   m_molecule = mol;
+  m_hasFrames = false;
   if (m_dialog)
     m_dialog->setMolecule(mol);
 }
@@ -73,79 +77,78 @@ void Spectra::setMode(int mode)
   if (mode >= 0 &&
       mode < static_cast<int>(m_molecule->vibrationFrequencies().size())) {
     m_mode = mode;
-
-    // Now calculate the frames and set them on the molecule.
-    m_molecule->setCoordinate3d(0);
-    Core::Array<Vector3> atomPositions = m_molecule->atomPositions3d();
-    Core::Array<Vector3> atomDisplacements = m_molecule->vibrationLx(mode);
-
-    int frames = 5;
-    int frameCounter = 0;
-    m_molecule->setCoordinate3d(atomPositions, frameCounter++);
-
-    double factor = 0.01 * m_amplitude;
-
-    // Current coords + displacement.
-    for (int i = 1; i <= frames; ++i) {
-      Core::Array<Vector3> framePositions;
-      for (Index atom = 0; atom < m_molecule->atomCount(); ++atom) {
-        framePositions.push_back(atomPositions[atom] +
-                                 atomDisplacements[atom] * factor *
-                                   (double(i) / frames));
-      }
-      m_molecule->setCoordinate3d(framePositions, frameCounter++);
-    }
-    // + displacement back to original.
-    for (int i = frames - 1; i >= 0; --i) {
-      Core::Array<Vector3> framePositions;
-      for (Index atom = 0; atom < m_molecule->atomCount(); ++atom) {
-        framePositions.push_back(atomPositions[atom] +
-                                 atomDisplacements[atom] * factor *
-                                   (double(i) / frames));
-      }
-      m_molecule->setCoordinate3d(framePositions, frameCounter++);
-    }
-    // Current coords - displacement.
-    for (int i = 1; i <= frames; ++i) {
-      Core::Array<Vector3> framePositions;
-      for (Index atom = 0; atom < m_molecule->atomCount(); ++atom) {
-        framePositions.push_back(atomPositions[atom] -
-                                 atomDisplacements[atom] * factor *
-                                   (double(i) / frames));
-      }
-      m_molecule->setCoordinate3d(framePositions, frameCounter++);
-    }
-    // - displacement back to original.
-    for (int i = frames - 1; i >= 0; --i) {
-      Core::Array<Vector3> framePositions;
-      for (Index atom = 0; atom < m_molecule->atomCount(); ++atom) {
-        framePositions.push_back(atomPositions[atom] -
-                                 atomDisplacements[atom] * factor *
-                                   (double(i) / frames));
-      }
-      m_molecule->setCoordinate3d(framePositions, frameCounter++);
-    }
+    if (m_timer && m_timer->isActive())
+      updateDisplacements();
+    if (m_hasFrames)
+      updateFrames();
   }
 }
 
 void Spectra::setAmplitude(int amplitude)
 {
   m_amplitude = amplitude;
-  setMode(m_mode);
+  if (m_timer && m_timer->isActive())
+    updateDisplacements();
+  if (m_hasFrames)
+    updateFrames();
+}
+
+void Spectra::updateDisplacements()
+{
+  // The scaled normal mode is handed to the renderer once; each frame then
+  // only changes the displacement scale, which the shaders apply.
+  Core::Array<Vector3> displacements = m_molecule->vibrationLx(m_mode);
+  double factor = 0.01 * m_amplitude;
+  for (Index i = 0; i < displacements.size(); ++i)
+    displacements[i] *= factor;
+  m_molecule->setVibrationDisplacements(displacements);
+  m_molecule->emitChanged(QtGui::Molecule::Atoms | QtGui::Molecule::Added);
+}
+
+void Spectra::updateFrames()
+{
+  // One period of the mode as coordinate sets for the player tool: out to
+  // the full amplitude, back, out the other way and back again.
+  m_molecule->setCoordinate3d(0);
+  Core::Array<Vector3> atomPositions = m_molecule->atomPositions3d();
+  Core::Array<Vector3> atomDisplacements = m_molecule->vibrationLx(m_mode);
+  if (atomDisplacements.size() != atomPositions.size())
+    return;
+
+  const int frames = 5;
+  double factor = 0.01 * m_amplitude;
+  for (int i = 0; i <= 4 * frames; ++i) {
+    int step = i <= frames ? i : (i <= 3 * frames ? 2 * frames - i
+                                                  : i - 4 * frames);
+    double scale = factor * step / frames;
+    Core::Array<Vector3> framePositions(atomPositions);
+    for (Index atom = 0; atom < framePositions.size(); ++atom)
+      framePositions[atom] += atomDisplacements[atom] * scale;
+    m_molecule->setCoordinate3d(framePositions, i);
+  }
+  m_molecule->emitChanged(QtGui::Molecule::Atoms | QtGui::Molecule::Added);
+}
+
+void Spectra::createVibrationFrames()
+{
+  if (!m_molecule)
+    return;
+  m_hasFrames = true;
+  updateFrames();
 }
 
 void Spectra::startVibrationAnimation()
 {
-  // First calculate our frames, and then start our timer.
-  m_totalFrames = m_molecule->coordinate3dCount();
-  m_currentFrame = 0;
+  m_phase = 0.0;
+  updateDisplacements();
+  m_molecule->setDisplacementScale(0.0f);
 
   if (!m_timer) {
     m_timer = new QTimer(this);
     connect(m_timer, SIGNAL(timeout()), SLOT(advanceFrame()));
   }
   if (!m_timer->isActive()) {
-    m_timer->start(50);
+    m_timer->start(40);
   }
 }
 
@@ -153,8 +156,9 @@ void Spectra::stopVibrationAnimation()
 {
   if (m_timer && m_timer->isActive()) {
     m_timer->stop();
-    m_molecule->setCoordinate3d(0);
-    m_currentFrame = 0;
+    m_phase = 0.0;
+    m_molecule->setVibrationDisplacements(Core::Array<Vector3>());
+    m_molecule->setDisplacementScale(0.0f);
     m_molecule->emitChanged(QtGui::Molecule::Atoms | QtGui::Molecule::Added);
   }
 }
@@ -168,6 +172,7 @@ void Spectra::openDialog()
     connect(m_dialog, SIGNAL(startAnimation()),
             SLOT(startVibrationAnimation()));
     connect(m_dialog, SIGNAL(stopAnimation()), SLOT(stopVibrationAnimation()));
+    connect(m_dialog, SIGNAL(createFrames()), SLOT(createVibrationFrames()));
   }
   if (m_molecule)
     m_dialog->setMolecule(m_molecule);
@@ -176,10 +181,10 @@ void Spectra::openDialog()
 
 void Spectra::advanceFrame()
 {
-  if (++m_currentFrame >= m_totalFrames)
-    m_currentFrame = 0;
-  m_molecule->setCoordinate3d(m_currentFrame);
-  m_molecule->emitChanged(QtGui::Molecule::Atoms | QtGui::Molecule::Added);
+  // One full period every 25 frames, i.e. once a second.
+  const double step = 2.0 * PI_D / 25.0;
+  m_phase = std::fmod(m_phase + step, 2.0 * PI_D);
+  m_molecule->setDisplacementScale(static_cast<float>(std::sin(m_phase)));
 }
 }
 }
@@ -30,6 +30,13 @@ class VibrationDialog;
 
 /**
  * @brief The Spectra plugin handles vibrations and spectra.
+ *
+ * Vibrations are animated by the renderer: the scaled mode is stored as the
+ * molecule's vibration displacements and only the displacement scale changes
+ * from frame to frame. Ball-and-stick, licorice, van der Waals and wireframe
+ * apply the displacements. The mode can also be stored as coordinate sets on
+ * request, so the player tool can play it in every representation and export
+ * it as a movie.
  */
 
 class Spectra : public QtGui::ExtensionPlugin
@@ -58,12 +65,16 @@ public slots:
   void setAmplitude(int amplitude);
   void startVibrationAnimation();
   void stopVibrationAnimation();
+  void createVibrationFrames();
   void openDialog();
 
 private slots:
   void advanceFrame();
 
 private:
+  void updateDisplacements();
+  void updateFrames();
+
   QList<QAction*> m_actions;
 
   QtGui::Molecule* m_molecule;
@@ -72,10 +83,10 @@ private:
 
   QTimer* m_timer;
 
-  int m_currentFrame;
-  int m_totalFrames;
+  double m_phase;
   int m_mode;
   int m_amplitude;
+  bool m_hasFrames;
 };
 }
 }
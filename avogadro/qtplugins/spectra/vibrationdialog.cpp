@@ -39,6 +39,7 @@ VibrationDialog::VibrationDialog(QWidget* parent_, Qt::WindowFlags f)
           SIGNAL(amplitudeChanged(int)));
   connect(m_ui->startButton, SIGNAL(clicked(bool)), SIGNAL(startAnimation()));
   connect(m_ui->stopButton, SIGNAL(clicked(bool)), SIGNAL(stopAnimation()));
+  connect(m_ui->framesButton, SIGNAL(clicked(bool)), SIGNAL(createFrames()));
 }
 
 VibrationDialog::~VibrationDialog()
@@ -53,6 +53,7 @@ signals:
   void amplitudeChanged(int amplitude);
   void startAnimation();
   void stopAnimation();
+  void createFrames();
 
 private:
   Ui::VibrationDialog* m_ui;
@@ -92,20 +92,16 @@ Surfaces::Surfaces(QObject* p) : ExtensionPlugin(p), d(new PIMPL())
 Surfaces::~Surfaces()
 {
   delete d;
-  delete m_cube;
 }
 
 void Surfaces::setMolecule(QtGui::Molecule* mol)
 {
-  if (mol->basisSet()) {
+  if (mol->basisSet())
     m_basis = mol->basisSet();
-  } else if (mol->cubes().size() != 0) {
-    m_cubes = mol->cubes();
-  }
 
-  m_cube = nullptr;
-  m_mesh1 = nullptr;
-  m_mesh2 = nullptr;
+  m_cubeIndex = MaxIndex;
+  m_mesh1Index = MaxIndex;
+  m_mesh2Index = MaxIndex;
   m_molecule = mol;
 }
 
@@ -143,10 +139,13 @@ void Surfaces::surfacesActivated()
     m_dialog->setupBasis(m_basis->electronCount(),
                          m_basis->molecularOrbitalCount(), beta);
   }
-  if (m_cubes.size() > 0) {
+  if (!m_basis && m_molecule->cubeCount() > 0) {
+    // The cubes are only read, so don't detach them from copies of the
+    // molecule.
+    const QtGui::Molecule* molecule = m_molecule;
     QStringList cubeNames;
-    for (unsigned int i = 0; i < m_cubes.size(); ++i) {
-      cubeNames << m_cubes[i]->name().c_str();
+    for (Index i = 0; i < molecule->cubeCount(); ++i) {
+      cubeNames << molecule->cube(i)->name().c_str();
     }
     m_dialog->setupCubes(cubeNames);
   }
@@ -161,8 +160,6 @@ void Surfaces::calculateSurface()
     return;
 
   Type type = m_dialog->surfaceType();
-  if (!m_cube)
-    m_cube = m_molecule->addCube();
   // TODO we should add a name, type, etc.
 
   switch (type) {
@@ -170,7 +167,7 @@ void Surfaces::calculateSurface()
     case SolventAccessible:
     case SolventExcluded:
       calculateEDT();
-      // pass a molecule and return a Cube for m_cube
+      // pass a molecule and return a Cube for m_cubeIndex
       //   displayMesh();
       break;
 
@@ -191,7 +188,7 @@ void Surfaces::calculateSurface()
 void Surfaces::calculateEDT()
 {
   // pass the molecule to the EDT, plus the surface type
-  // get back a Cube object in m_cube
+  // get back a Cube object in m_cubeIndex
 }
 
 void Surfaces::calculateQM()
@@ -202,9 +199,9 @@ void Surfaces::calculateQM()
   // Reset state a little more frequently, minimal cost, avoid bugs.
   m_molecule->clearCubes();
   m_molecule->clearMeshes();
-  m_cube = nullptr;
-  m_mesh1 = nullptr;
-  m_mesh2 = nullptr;
+  m_cubeIndex = MaxIndex;
+  m_mesh1Index = MaxIndex;
+  m_mesh2Index = MaxIndex;
   m_molecule->emitChanged(Molecule::Atoms | Molecule::Added);
   bool connectSlots = false;
 
@@ -231,31 +228,31 @@ void Surfaces::calculateQM()
     connectSlots = true;
   }
 
-  if (!m_cube)
-    m_cube = m_molecule->addCube();
+  Cube* cube = m_molecule->addCube();
+  m_cubeIndex = m_molecule->cubeCount() - 1;
 
   Type type = m_dialog->surfaceType();
   int index = m_dialog->surfaceIndex();
   m_isoValue = m_dialog->isosurfaceValue();
-  m_cube->setLimits(*m_molecule, m_dialog->resolution(), 5.0);
+  cube->setLimits(*m_molecule, m_dialog->resolution(), 5.0);
 
   QString progressText;
   if (type == ElectronDensity) {
     progressText = tr("Calculating electron density");
     if (dynamic_cast<GaussianSet*>(m_basis)) {
-      m_gaussianConcurrent->calculateElectronDensity(m_cube);
+      m_gaussianConcurrent->calculateElectronDensity(cube);
     } else {
-      m_slaterConcurrent->calculateElectronDensity(m_cube);
+      m_slaterConcurrent->calculateElectronDensity(cube);
     }
   }
 
   else if (type == MolecularOrbital) {
     progressText = tr("Calculating molecular orbital %L1").arg(index);
     if (dynamic_cast<GaussianSet*>(m_basis)) {
-      m_gaussianConcurrent->calculateMolecularOrbital(m_cube, index,
+      m_gaussianConcurrent->calculateMolecularOrbital(cube, index,
                                                       m_dialog->beta());
     } else {
-      m_slaterConcurrent->calculateMolecularOrbital(m_cube, index);
+      m_slaterConcurrent->calculateMolecularOrbital(cube, index);
     }
   }
 
@@ -296,11 +293,14 @@ void Surfaces::calculateQM()
 
 void Surfaces::calculateCube()
 {
-  if (!m_dialog || m_cubes.size() == 0)
+  if (!m_dialog)
     return;
 
   // check bounds
-  m_cube = m_cubes[m_dialog->surfaceIndex()];
+  int index = m_dialog->surfaceIndex();
+  if (index < 0 || static_cast<Index>(index) >= m_molecule->cubeCount())
+    return;
+  m_cubeIndex = static_cast<Index>(index);
   m_isoValue = m_dialog->isosurfaceValue();
   displayMesh();
 }
@@ -316,36 +316,47 @@ void Surfaces::stepChanged(int n)
     g->setActiveSetStep(n - 1);
     m_molecule->clearCubes();
     m_molecule->clearMeshes();
-    m_cube = nullptr;
-    m_mesh1 = nullptr;
-    m_mesh2 = nullptr;
+    m_cubeIndex = MaxIndex;
+    m_mesh1Index = MaxIndex;
+    m_mesh2Index = MaxIndex;
     m_molecule->emitChanged(Molecule::Atoms | Molecule::Added);
   }
 }
 
 void Surfaces::displayMesh()
 {
-  if (!m_cube)
+  if (!m_molecule || m_cubeIndex >= m_molecule->cubeCount())
     return;
 
-  if (!m_mesh1)
-    m_mesh1 = m_molecule->addMesh();
+  // Fetch the cube and meshes again, the molecule may have been copied since
+  // they were created. The cube is only read.
+  const QtGui::Molecule* molecule = m_molecule;
+  const Cube* cube = molecule->cube(m_cubeIndex);
+
+  if (m_mesh1Index >= m_molecule->meshCount()) {
+    m_molecule->addMesh();
+    m_mesh1Index = m_molecule->meshCount() - 1;
+  }
   if (!m_meshGenerator1) {
     m_meshGenerator1 = new QtGui::MeshGenerator;
     connect(m_meshGenerator1, SIGNAL(finished()), SLOT(meshFinished()));
   }
-  m_meshGenerator1->initialize(m_cube, m_mesh1, m_isoValue);
+  m_meshGenerator1->initialize(cube, m_molecule->mesh(m_mesh1Index),
+                               m_isoValue);
 
   // TODO - only do this if we're generating an orbital
   //    and we need two meshes
   //   How do we know? - likely ask the cube if it's an MO?
-  if (!m_mesh2)
-    m_mesh2 = m_molecule->addMesh();
+  if (m_mesh2Index >= m_molecule->meshCount()) {
+    m_molecule->addMesh();
+    m_mesh2Index = m_molecule->meshCount() - 1;
+  }
   if (!m_meshGenerator2) {
     m_meshGenerator2 = new QtGui::MeshGenerator;
     connect(m_meshGenerator2, SIGNAL(finished()), SLOT(meshFinished()));
   }
-  m_meshGenerator2->initialize(m_cube, m_mesh2, -m_isoValue, true);
+  m_meshGenerator2->initialize(cube, m_molecule->mesh(m_mesh2Index),
+                               -m_isoValue, true);
 
   // Start the mesh generation - this needs an improved mutex with a read lock
   // to function as expected. Write locks are exclusive, read locks can have
@@ -17,6 +17,7 @@
 #ifndef AVOGADRO_QTPLUGINS_SURFACES_H
 #define AVOGADRO_QTPLUGINS_SURFACES_H
 
+#include <avogadro/core/avogadrocore.h>
 #include <avogadro/qtgui/extensionplugin.h>
 
 class QAction;
@@ -101,10 +102,11 @@ private:
   GaussianSetConcurrent* m_gaussianConcurrent = nullptr;
   SlaterSetConcurrent* m_slaterConcurrent = nullptr;
 
-  Core::Cube* m_cube = nullptr;
-  std::vector<Core::Cube*> m_cubes;
-  Core::Mesh* m_mesh1 = nullptr;
-  Core::Mesh* m_mesh2 = nullptr;
+  // The cube and meshes are owned by the molecule, which may replace them
+  // when it is copied, so only their indices are kept between operations.
+  Index m_cubeIndex = MaxIndex;
+  Index m_mesh1Index = MaxIndex;
+  Index m_mesh2Index = MaxIndex;
   QtGui::MeshGenerator* m_meshGenerator1 = nullptr;
   QtGui::MeshGenerator* m_meshGenerator2 = nullptr;
 
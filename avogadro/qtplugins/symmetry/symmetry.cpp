@@ -16,6 +16,7 @@
 
 #include "symmetry.h"
 
+#include "symmetryprescreen.h"
 #include "symmetrywidget.h"
 
 #include "symmetryutil.h"
@@ -31,6 +32,8 @@
 #include <QtCore/QDebug>
 #include <QtCore/QStringList>
 
+#include <algorithm>
+
 // using Avogadro::Core::CrystalTools;
 // using Avogadro::Core::UnitCell;
 using Avogadro::QtGui::Molecule;
@@ -50,6 +53,10 @@ Symmetry::Symmetry(QObject* parent_)
 
   m_ctx = msymCreateContext();
 
+  m_updateTimer.setSingleShot(true);
+  m_updateTimer.setInterval(250);
+  connect(&m_updateTimer, SIGNAL(timeout()), SLOT(detectSymmetry()));
+
   m_viewSymmetryAction->setText(tr("Symmetry Properties..."));
   connect(m_viewSymmetryAction, SIGNAL(triggered()), SLOT(viewSymmetry()));
   m_actions.push_back(m_viewSymmetryAction);
@@ -131,6 +138,10 @@ void Symmetry::moleculeChanged(unsigned int c)
       (changes & Molecule::Modified || changes & Molecule::Added ||
        changes & Molecule::Removed)) {
     m_dirty = true;
+    // Keep the panel live while editing. Most intermediate structures are
+    // rejected by the prescreen or reuse the cached result.
+    if (m_symmetryWidget && m_symmetryWidget->isVisible())
+      m_updateTimer.start();
   }
 }
 
@@ -180,11 +191,12 @@ void Symmetry::viewSymmetry()
 
 void Symmetry::detectSymmetry()
 {
+  if (m_molecule == NULL || m_symmetryWidget == NULL)
+    return;
 
   unsigned int length = m_molecule->atomCount();
 
-  if (m_molecule == NULL || m_molecule->atomPositions3d().size() != length ||
-      length < 2)
+  if (m_molecule->atomPositions3d().size() != length || length < 2)
     return; // if one atom = Kh
 
   if (length == 1) {
@@ -192,6 +204,44 @@ void Symmetry::detectSymmetry()
     return;
   }
 
+  msym_thresholds_t* thresholds = m_symmetryWidget->getThresholds();
+  const Core::Array<unsigned char>& numbers = m_molecule->atomicNumbers();
+  const Core::Array<Vector3>& positions = m_molecule->atomPositions3d();
+
+  // Images only have to be found for the prescreen to reject an operation,
+  // so err on the large side: libmsym scales its thresholds with the size of
+  // the molecule.
+  Vector3 minPos = positions[0];
+  Vector3 maxPos = positions[0];
+  for (Index i = 1; i < length; ++i) {
+    minPos = minPos.cwiseMin(positions[i]);
+    maxPos = maxPos.cwiseMax(positions[i]);
+  }
+  Real extent = std::max(Real(1.0), 0.5 * (maxPos - minPos).norm());
+  Real tolerance = std::max(0.1, 5.0 * thresholds->geometry * extent);
+  SymmetryPrescreen prescreen(numbers, positions, tolerance);
+
+  Core::Array<Vector3> centered(length);
+  for (Index i = 0; i < length; ++i)
+    centered[i] = positions[i] - prescreen.centerOfMass();
+
+  if (cachedResultValid(centered, thresholds)) {
+    // Same structure as last time, at most translated.
+    Vector3 shift = prescreen.centerOfMass() - m_cachedCenter;
+    double cm[3] = { m_cachedCm[0] + shift[0], m_cachedCm[1] + shift[1],
+                     m_cachedCm[2] + shift[2] };
+    m_symmetryWidget->setCenterOfMass(cm);
+    m_dirty = false;
+    return;
+  }
+
+  m_cacheValid = false;
+  if (prescreen.isAsymmetric()) {
+    clearResult();
+    m_dirty = false;
+    return;
+  }
+
   // interface with libmsym
   msym_error_t ret = MSYM_SUCCESS;
   msym_element_t* elements = NULL;
@@ -226,7 +276,6 @@ void Symmetry::detectSymmetry()
 
   // Set the thresholds
   // switch (m_dock->toleranceCombo->currentIndex()) {
-  msym_thresholds_t* thresholds = m_symmetryWidget->getThresholds();
   msymSetThresholds(m_ctx, thresholds);
 
   // At any point, we'll set the text to NULL which will use C1 instead
@@ -343,6 +392,45 @@ void Symmetry::detectSymmetry()
 
   free(elements);
   m_dirty = false;
+
+  m_cacheValid = true;
+  m_cachedNumbers = numbers;
+  m_cachedPositions = centered;
+  m_cachedCenter = prescreen.centerOfMass();
+  m_cachedThresholds = thresholds;
+  for (int c = 0; c < 3; ++c)
+    m_cachedCm[c] = cm[c];
+}
+
+bool Symmetry::cachedResultValid(const Core::Array<Vector3>& centered,
+                                 const msym_thresholds_t* thresholds) const
+{
+  if (!m_cacheValid || thresholds != m_cachedThresholds ||
+      centered.size() != m_cachedPositions.size() ||
+      m_molecule->atomicNumbers() != m_cachedNumbers) {
+    return false;
+  }
+
+  const double toleranceSquared = thresholds->geometry * thresholds->geometry;
+  for (Index i = 0; i < centered.size(); ++i) {
+    if ((centered[i] - m_cachedPositions[i]).squaredNorm() > toleranceSquared)
+      return false;
+  }
+  return true;
+}
+
+void Symmetry::clearResult()
+{
+  // The context must not keep elements that no longer match the molecule,
+  // they would be used for symmetrization.
+  if (m_ctx != NULL)
+    msymReleaseContext(m_ctx);
+  m_ctx = msymCreateContext();
+
+  m_symmetryWidget->setPointGroupSymbol(pointGroupSymbol(0));
+  m_symmetryWidget->setEquivalenceSets(0, NULL);
+  m_symmetryWidget->setSymmetryOperations(0, NULL);
+  m_symmetryWidget->setSubgroups(0, NULL);
 }
 
 void Symmetry::symmetrizeMolecule()
@@ -359,7 +447,10 @@ void Symmetry::symmetrizeMolecule()
   double symerr = 0.0;
   msym_error_t ret = MSYM_SUCCESS;
 
-  // detectSymmetry();
+  // A cached result may stem from slightly different or translated
+  // coordinates, symmetrize what is there now.
+  m_cacheValid = false;
+  detectSymmetry();
   if (MSYM_SUCCESS != (ret = msymSymmetrizeElements(m_ctx, &symerr)))
     return;
 
@@ -19,6 +19,11 @@
 
 #include <avogadro/qtgui/extensionplugin.h>
 
+#include <avogadro/core/array.h>
+#include <avogadro/core/vector.h>
+
+#include <QtCore/QTimer>
+
 #include "symmetrywidget.h"
 
 namespace msym {
@@ -62,6 +67,10 @@ private slots:
   void symmetrizeMolecule();
 
 private:
+  bool cachedResultValid(const Core::Array<Vector3>& centered,
+                         const msym::msym_thresholds_t* thresholds) const;
+  void clearResult();
+
   QList<QAction*> m_actions;
   QtGui::Molecule* m_molecule;
   SymmetryWidget* m_symmetryWidget;
@@ -71,6 +80,17 @@ private:
   msym::msym_context m_ctx;
 
   bool m_dirty = true;
+
+  // Input of the last successful libmsym run, relative to its center of mass.
+  bool m_cacheValid = false;
+  Core::Array<unsigned char> m_cachedNumbers;
+  Core::Array<Vector3> m_cachedPositions;
+  Vector3 m_cachedCenter;
+  const msym::msym_thresholds_t* m_cachedThresholds = nullptr;
+  double m_cachedCm[3];
+
+  // Collects molecule changes while the symmetry panel is shown.
+  QTimer m_updateTimer;
 };
 
 inline QString Symmetry::description() const
@@ -0,0 +1,138 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "symmetryprescreen.h"
+
+#include <avogadro/core/elements.h>
+
+#include <Eigen/Eigenvalues>
+
+#include <cmath>
+
+namespace Avogadro {
+namespace QtPlugins {
+
+using Core::Array;
+using Core::Elements;
+
+namespace {
+// Principal moments closer than this fraction of the largest one are treated
+// as degenerate, which leaves the orientation of the axes undetermined.
+const Real DegenerateMoments = 0.02;
+}
+
+SymmetryPrescreen::SymmetryPrescreen(const Array<unsigned char>& numbers,
+                                     const Array<Vector3>& positions,
+                                     Real tolerance)
+  : m_numbers(numbers), m_positions(positions), m_tolerance(tolerance),
+    m_center(Vector3::Zero()), m_moments(Vector3::Zero()),
+    m_axes(Matrix3::Identity())
+{
+  if (m_positions.size() != m_numbers.size() || m_positions.empty())
+    return;
+
+  Real totalMass = 0.0;
+  for (Index i = 0; i < m_positions.size(); ++i) {
+    Real mass = Elements::mass(m_numbers[i]);
+    m_center += mass * m_positions[i];
+    totalMass += mass;
+  }
+  if (totalMass > 0.0)
+    m_center /= totalMass;
+
+  Matrix3 inertia = Matrix3::Zero();
+  for (Index i = 0; i < m_positions.size(); ++i) {
+    Vector3 r = m_positions[i] - m_center;
+    inertia += Elements::mass(m_numbers[i]) *
+               (r.squaredNorm() * Matrix3::Identity() - r * r.transpose());
+  }
+  Eigen::SelfAdjointEigenSolver<Matrix3> solver(inertia);
+  m_moments = solver.eigenvalues();
+  m_axes = solver.eigenvectors();
+
+  if (m_tolerance > 0.0) {
+    for (Index i = 0; i < m_positions.size(); ++i)
+      m_cells[cellKey(m_numbers[i], m_positions[i])].push_back(i);
+  }
+}
+
+bool SymmetryPrescreen::isAsymmetric() const
+{
+  if (m_positions.size() < 2 || m_tolerance <= 0.0)
+    return false;
+
+  // Linear molecules and symmetric or spherical tops have rotation axes that
+  // are not fixed by the inertia tensor.
+  Real largest = m_moments[2];
+  if (largest <= 0.0 ||
+      m_moments[1] - m_moments[0] < DegenerateMoments * largest ||
+      m_moments[2] - m_moments[1] < DegenerateMoments * largest) {
+    return false;
+  }
+
+  // In the principal frame the candidates are diagonal: the inversion,
+  // C2 rotations (two negative entries) and reflections (one).
+  const Real signs[7][3] = { { -1, -1, -1 }, { 1, -1, -1 }, { -1, 1, -1 },
+                             { -1, -1, 1 },  { -1, 1, 1 },  { 1, -1, 1 },
+                             { 1, 1, -1 } };
+  for (int op = 0; op < 7; ++op) {
+    Vector3 diagonal(signs[op][0], signs[op][1], signs[op][2]);
+    Matrix3 rotation = m_axes * diagonal.asDiagonal() * m_axes.transpose();
+    if (isSymmetryOperation(rotation))
+      return false;
+  }
+  return true;
+}
+
+bool SymmetryPrescreen::isSymmetryOperation(const Matrix3& rotation) const
+{
+  for (Index i = 0; i < m_positions.size(); ++i) {
+    Vector3 image = rotation * (m_positions[i] - m_center) + m_center;
+    if (!hasImage(m_numbers[i], image))
+      return false;
+  }
+  return true;
+}
+
+long long SymmetryPrescreen::cellKey(unsigned char number,
+                                     const Vector3& position) const
+{
+  // 18 bits per coordinate and 8 for the element, which covers a cube of
+  // more than 26000 Angstrom at the smallest sensible tolerance.
+  const long long offset = 1 << 17;
+  long long key = number;
+  for (int c = 0; c < 3; ++c) {
+    long long cell =
+      static_cast<long long>(std::floor(position[c] / m_tolerance)) + offset;
+    key = (key << 18) | (cell & ((1 << 18) - 1));
+  }
+  return key;
+}
+
+bool SymmetryPrescreen::hasImage(unsigned char number,
+                                 const Vector3& position) const
+{
+  // Cells are as large as the tolerance, so an image is in one of the 27
+  // cells around the position.
+  const Real toleranceSquared = m_tolerance * m_tolerance;
+  for (int dx = -1; dx <= 1; ++dx) {
+    for (int dy = -1; dy <= 1; ++dy) {
+      for (int dz = -1; dz <= 1; ++dz) {
+        Vector3 probe = position + m_tolerance * Vector3(dx, dy, dz);
+        auto cell = m_cells.find(cellKey(number, probe));
+        if (cell == m_cells.end())
+          continue;
+        for (Index j : cell->second) {
+          if ((m_positions[j] - position).squaredNorm() <= toleranceSquared)
+            return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace QtPlugins
+} // namespace Avogadro
@@ -0,0 +1,77 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_QTPLUGINS_SYMMETRYPRESCREEN_H
+#define AVOGADRO_QTPLUGINS_SYMMETRYPRESCREEN_H
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/matrix.h>
+#include <avogadro/core/vector.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace Avogadro {
+namespace QtPlugins {
+
+/**
+ * @brief Cheap geometric tests run before handing a molecule to libmsym.
+ *
+ * Every symmetry element of a molecule passes through its center of mass and
+ * leaves the inertia tensor unchanged. For an asymmetric top, with three
+ * distinct principal moments, the only candidates are therefore the
+ * inversion, the three C2 axes along the principal axes and the three mirror
+ * planes perpendicular to them. If none of these maps every atom onto an atom
+ * of the same element, the molecule is C1 and the full search can be skipped.
+ * This is by far the most common outcome while editing large structures.
+ *
+ * Image atoms are looked up in a spatial hash keyed by element and grid cell,
+ * and each candidate is rejected at the first atom without an image.
+ */
+class SymmetryPrescreen
+{
+public:
+  /**
+   * @param numbers The atomic numbers.
+   * @param positions The atom positions.
+   * @param tolerance The largest distance between an image and its atom, in
+   * Angstrom.
+   */
+  SymmetryPrescreen(const Core::Array<unsigned char>& numbers,
+                    const Core::Array<Vector3>& positions, Real tolerance);
+
+  /** @return The mass-weighted center of the atoms. */
+  const Vector3& centerOfMass() const { return m_center; }
+
+  /**
+   * @return True if the molecule certainly has no symmetry besides the
+   * identity. False means it may be symmetric, or that the principal axes are
+   * degenerate and the test cannot decide.
+   */
+  bool isAsymmetric() const;
+
+  /**
+   * @return True if @a rotation, applied about the center of mass, maps every
+   * atom onto an atom of the same element.
+   */
+  bool isSymmetryOperation(const Matrix3& rotation) const;
+
+private:
+  long long cellKey(unsigned char number, const Vector3& position) const;
+  bool hasImage(unsigned char number, const Vector3& position) const;
+
+  Core::Array<unsigned char> m_numbers;
+  Core::Array<Vector3> m_positions;
+  Real m_tolerance;
+  Vector3 m_center;
+  Vector3 m_moments;
+  Matrix3 m_axes;
+  std::unordered_map<long long, std::vector<Index>> m_cells;
+};
+
+} // namespace QtPlugins
+} // namespace Avogadro
+
+#endif // AVOGADRO_QTPLUGINS_SYMMETRYPRESCREEN_H
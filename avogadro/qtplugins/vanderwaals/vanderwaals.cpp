@@ -57,6 +57,17 @@ void VanDerWaals::process(const Core::Molecule& molecule,
     spheres->addSphere(atom.position3d().cast<float>(), color,
                        static_cast<float>(Elements::radiusVDW(atomicNumber)));
   }
+
+  // An animated vibration is applied by the shaders, see Spectra.
+  const Core::Array<Vector3>& displacements =
+    molecule.vibrationDisplacements();
+  if (displacements.size() == molecule.atomCount()) {
+    Core::Array<Vector3f> sphereDisplacements;
+    sphereDisplacements.reserve(displacements.size());
+    for (Index i = 0; i < displacements.size(); ++i)
+      sphereDisplacements.push_back(displacements[i].cast<float>());
+    spheres->setDisplacements(sphereDisplacements);
+  }
 }
 
 bool VanDerWaals::isEnabled() const
@@ -0,0 +1,93 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "volumes.h"
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/cube.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/mutex.h>
+#include <avogadro/rendering/geometrynode.h>
+#include <avogadro/rendering/groupnode.h>
+#include <avogadro/rendering/volumegeometry.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Avogadro {
+namespace QtPlugins {
+
+using Core::Cube;
+using Core::Molecule;
+using Rendering::GeometryNode;
+using Rendering::GroupNode;
+using Rendering::VolumeGeometry;
+
+Volumes::Volumes(QObject* p) : ScenePlugin(p), m_enabled(false) {}
+
+Volumes::~Volumes() {}
+
+namespace {
+// Blue for negative values and red for positive ones, growing more opaque
+// with the magnitude of the value. Values close to zero are left transparent
+// so that the empty space around the molecule is skipped.
+Core::Array<Vector4ub> signedTransferFunction()
+{
+  const int entries = 65;
+  const int center = entries / 2;
+  Core::Array<Vector4ub> colors(entries);
+  for (int i = 0; i < entries; ++i) {
+    float magnitude = std::fabs(static_cast<float>(i - center)) / center;
+    float alpha = magnitude < 0.05f ? 0.f : magnitude * magnitude;
+    colors[i] = i < center ? Vector4ub(0, 0, 255, 0) : Vector4ub(255, 0, 0, 0);
+    colors[i][3] = static_cast<unsigned char>(255.f * alpha + 0.5f);
+  }
+  return colors;
+}
+}
+
+void Volumes::process(const Molecule& mol, GroupNode& node)
+{
+  if (mol.cubeCount() == 0)
+    return;
+
+  const Cube* cube = mol.cube(0);
+  Core::ReadLocker locker(cube->lock());
+  const std::vector<double>* values = cube->data();
+  if (!values || values->empty())
+    return;
+
+  VolumeGeometry* volume = new VolumeGeometry;
+  if (!volume->setData(*values, cube->dimensions(),
+                       cube->min().cast<float>(),
+                       cube->spacing().cast<float>())) {
+    delete volume;
+    return;
+  }
+
+  float range =
+    std::max(std::fabs(volume->minValue()), std::fabs(volume->maxValue()));
+  if (range <= 0.f || !volume->setTransferFunction(signedTransferFunction(),
+                                                   -range, range)) {
+    delete volume;
+    return;
+  }
+
+  GeometryNode* geometry = new GeometryNode;
+  node.addChild(geometry);
+  geometry->addDrawable(volume);
+}
+
+bool Volumes::isEnabled() const
+{
+  return m_enabled;
+}
+
+void Volumes::setEnabled(bool enable)
+{
+  m_enabled = enable;
+}
+}
+}
@@ -0,0 +1,47 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_QTPLUGINS_VOLUMES_H
+#define AVOGADRO_QTPLUGINS_VOLUMES_H
+
+#include <avogadro/qtgui/sceneplugin.h>
+
+namespace Avogadro {
+namespace QtPlugins {
+
+/**
+ * @brief Render the first cube of the molecule as a translucent volume,
+ * without extracting an isosurface.
+ */
+class Volumes : public QtGui::ScenePlugin
+{
+  Q_OBJECT
+
+public:
+  explicit Volumes(QObject* parent = 0);
+  ~Volumes() override;
+
+  void process(const Core::Molecule& molecule,
+               Rendering::GroupNode& node) override;
+
+  QString name() const override { return tr("Volumes"); }
+
+  QString description() const override
+  {
+    return tr("Render volumetric data such as densities and orbitals.");
+  }
+
+  bool isEnabled() const override;
+
+  void setEnabled(bool enable) override;
+
+private:
+  bool m_enabled;
+};
+
+} // end namespace QtPlugins
+} // end namespace Avogadro
+
+#endif // AVOGADRO_QTPLUGINS_VOLUMES_H
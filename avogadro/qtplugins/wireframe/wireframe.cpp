@@ -62,24 +62,38 @@ void Wireframe::process(const Molecule& molecule, Rendering::GroupNode& node)
   lines->identifier().molecule = &molecule;
   lines->identifier().type = Rendering::BondType;
   geometry->addDrawable(lines);
+
+  // An animated vibration is applied by the shaders, see Spectra.
+  const Array<Vector3>& displacements = molecule.vibrationDisplacements();
+  bool animated = displacements.size() == molecule.atomCount();
+
+  // Collect every bond, so they are added as one batch of segments.
+  Array<Vector3f> points;
+  Array<Vector3ub> colors;
+  Array<Vector3f> pointDisplacements;
+  points.reserve(2 * molecule.bondCount());
+  colors.reserve(2 * molecule.bondCount());
   for (Index i = 0; i < molecule.bondCount(); ++i) {
     Core::Bond bond = molecule.bond(i);
     if (!m_showHydrogens && (bond.atom1().atomicNumber() == 1 ||
                              bond.atom2().atomicNumber() == 1)) {
       continue;
     }
-    Vector3f pos1 = bond.atom1().position3d().cast<float>();
-    Vector3f pos2 = bond.atom2().position3d().cast<float>();
-    Vector3ub color1(Elements::color(bond.atom1().atomicNumber()));
-    Vector3ub color2(Elements::color(bond.atom2().atomicNumber()));
-    Array<Vector3f> points;
-    Array<Vector3ub> colors;
-    points.push_back(pos1);
-    points.push_back(pos2);
-    colors.push_back(color1);
-    colors.push_back(color2);
-    lines->addLineStrip(points, colors, 1.0f);
+    points.push_back(bond.atom1().position3d().cast<float>());
+    points.push_back(bond.atom2().position3d().cast<float>());
+    colors.push_back(Vector3ub(Elements::color(bond.atom1().atomicNumber())));
+    colors.push_back(Vector3ub(Elements::color(bond.atom2().atomicNumber())));
+    if (animated) {
+      pointDisplacements.push_back(
+        displacements[bond.atom1().index()].cast<float>());
+      pointDisplacements.push_back(
+        displacements[bond.atom2().index()].cast<float>());
+    }
   }
+  if (!points.empty())
+    lines->addLines(points, colors, 1.0f);
+  if (animated)
+    lines->setDisplacements(pointDisplacements);
 }
 
 bool Wireframe::isEnabled() const
@@ -49,6 +49,7 @@ public:
 
   BufferObject vbo;
   BufferObject ibo;
+  BufferObject displacementVbo;
 
   Shader vertexShader;
   Shader fragmentShader;
@@ -58,13 +59,16 @@ public:
   size_t numberOfIndices;
 };
 
-CylinderGeometry::CylinderGeometry() : m_dirty(false), d(new Private)
+CylinderGeometry::CylinderGeometry()
+  : m_displacementScale(0.0f), m_dirty(false), d(new Private)
 {
 }
 
 CylinderGeometry::CylinderGeometry(const CylinderGeometry& other)
   : Drawable(other), m_cylinders(other.m_cylinders), m_indices(other.m_indices),
-    m_indexMap(other.m_indexMap), m_dirty(true), d(new Private)
+    m_indexMap(other.m_indexMap), m_displacements(other.m_displacements),
+    m_displacementScale(other.m_displacementScale), m_dirty(true),
+    d(new Private)
 {
 }
 
@@ -94,6 +98,8 @@ void CylinderGeometry::update()
 
     std::vector<unsigned int> cylinderIndices;
     std::vector<ColorNormalVertex> cylinderVertices;
+    bool displaced = m_displacements.size() == 2 * m_cylinders.size();
+    std::vector<Vector3f> displacements;
     // cylinderIndices.reserve(m_indices.size() * 4);
     // cylinderVertices.reserve(m_cylinders.size() * 4);
 
@@ -132,6 +138,10 @@ void CylinderGeometry::update()
         vert2.normal = vert.normal;
         vert2.vertex = position2 + *it;
         cylinderVertices.push_back(vert2);
+        if (displaced) {
+          displacements.push_back(m_displacements[2 * i]);
+          displacements.push_back(m_displacements[2 * i + 1]);
+        }
       }
       // Now to stitch it together.
       for (unsigned int j = 0; j < resolution; ++j) {
@@ -149,6 +159,8 @@ void CylinderGeometry::update()
 
     d->vbo.upload(cylinderVertices, BufferObject::ArrayBuffer);
     d->ibo.upload(cylinderIndices, BufferObject::ElementArrayBuffer);
+    if (displaced)
+      d->displacementVbo.upload(displacements, BufferObject::ArrayBuffer);
     d->numberOfVertices = cylinderVertices.size();
     d->numberOfIndices = cylinderIndices.size();
 
@@ -209,6 +221,19 @@ void CylinderGeometry::render(const Camera& camera)
     cout << d->program.error() << endl;
   }
 
+  // Without displacements the attribute keeps its default value of zero.
+  bool displaced = m_displacements.size() == 2 * m_cylinders.size();
+  if (displaced) {
+    d->displacementVbo.bind();
+    if (!d->program.enableAttributeArray("displacement"))
+      cout << d->program.error() << endl;
+    if (!d->program.useAttributeArray("displacement", 0, sizeof(Vector3f),
+                                      FloatType, 3,
+                                      ShaderProgram::NoNormalize)) {
+      cout << d->program.error() << endl;
+    }
+  }
+
   // Set up our uniforms (model-view and projection matrices right now).
   if (!d->program.setUniformValue("modelView", camera.modelView().matrix())) {
     cout << d->program.error() << endl;
@@ -219,6 +244,10 @@ void CylinderGeometry::render(const Camera& camera)
   Matrix3f normalMatrix = camera.modelView().linear().inverse().transpose();
   if (!d->program.setUniformValue("normalMatrix", normalMatrix))
     std::cout << d->program.error() << std::endl;
+  if (!d->program.setUniformValue("displacementScale",
+                                  displaced ? m_displacementScale : 0.0f)) {
+    cout << d->program.error() << endl;
+  }
 
   // Render the loaded spheres using the shader and bound VBO.
   glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(d->numberOfVertices),
@@ -227,10 +256,14 @@ void CylinderGeometry::render(const Camera& camera)
 
   d->vbo.release();
   d->ibo.release();
+  if (displaced)
+    d->displacementVbo.release();
 
   d->program.disableAttributeArray("vector");
   d->program.disableAttributeArray("color");
   d->program.disableAttributeArray("normal");
+  if (displaced)
+    d->program.disableAttributeArray("displacement");
 
   d->program.release();
 }
@@ -243,10 +276,16 @@ std::multimap<float, Identifier> CylinderGeometry::hits(
 
   for (size_t i = 0; i < m_cylinders.size(); ++i) {
     const CylinderColor& cylinder = m_cylinders[i];
+    Vector3f end1 = cylinder.end1;
+    Vector3f end2 = cylinder.end2;
+    if (m_displacements.size() == 2 * m_cylinders.size()) {
+      end1 += m_displacementScale * m_displacements[2 * i];
+      end2 += m_displacementScale * m_displacements[2 * i + 1];
+    }
 
     // Check for cylinder intersection with the ray.
-    Vector3f ao = rayOrigin - cylinder.end1;
-    Vector3f ab = cylinder.end2 - cylinder.end1;
+    Vector3f ao = rayOrigin - end1;
+    Vector3f ab = end2 - end1;
     Vector3f aoxab = ao.cross(ab);
     Vector3f vxab = rayDirection.cross(ab);
 
@@ -264,8 +303,8 @@ std::multimap<float, Identifier> CylinderGeometry::hits(
                        (-B - std::sqrt(D)) / (2.0f * A));
 
     Vector3f ip = rayOrigin + (rayDirection * t);
-    Vector3f ip1 = ip - cylinder.end1;
-    Vector3f ip2 = ip - (cylinder.end1 + ab);
+    Vector3f ip1 = ip - end1;
+    Vector3f ip2 = ip - (end1 + ab);
 
     // intersection below base or above top of the cylinder
     if (ip1.dot(ab) < 0.0f || ip2.dot(ab) > 0.0f)
@@ -324,11 +363,19 @@ void CylinderGeometry::addCylinder(const Vector3f& pos1, const Vector3f& pos2,
   addCylinder(pos1, pos2, radius, colorStart, colorEnd);
 }
 
+void CylinderGeometry::setDisplacements(
+  const std::vector<Vector3f>& displacements)
+{
+  m_dirty = true;
+  m_displacements = displacements;
+}
+
 void CylinderGeometry::clear()
 {
   m_cylinders.clear();
   m_indices.clear();
   m_indexMap.clear();
+  m_displacements.clear();
 }
 
 } // End namespace Rendering
@@ -47,6 +47,9 @@ struct CylinderColor
  * <avogadro/rendering/cylindergeometry.h>
  * @brief The CylinderGeometry contains one or more cylinders.
  * @author Marcus D. Hanwell
+ *
+ * Both ends of a cylinder may carry a displacement vector that the vertex
+ * shader applies scaled by displacementScale(), see SphereGeometry.
  */
 
 class AVOGADRORENDERING_EXPORT CylinderGeometry : public Drawable
@@ -135,6 +138,20 @@ public:
                    const Vector3ub& color, const Vector3ub& color2,
                    size_t index);
 
+  /**
+   * Set the displacements of the cylinder ends, two per cylinder (end1 then
+   * end2) in the order they were added. An empty vector disables displacement.
+   */
+  void setDisplacements(const std::vector<Vector3f>& displacements);
+  const std::vector<Vector3f>& displacements() const { return m_displacements; }
+
+  /**
+   * The factor applied to the displacements when rendering and picking. Set by
+   * the render visitor from Scene::displacementScale().
+   */
+  void setDisplacementScale(float scale) { m_displacementScale = scale; }
+  float displacementScale() const { return m_displacementScale; }
+
   /**
    * Get a reference to the cylinders.
    */
@@ -155,6 +172,8 @@ private:
   std::vector<CylinderColor> m_cylinders;
   std::vector<size_t> m_indices;
   std::map<size_t, size_t> m_indexMap;
+  std::vector<Vector3f> m_displacements;
+  float m_displacementScale;
 
   bool m_dirty;
 
@@ -176,6 +195,8 @@ inline void swap(CylinderGeometry& lhs, CylinderGeometry& rhs)
   swap(lhs.m_cylinders, rhs.m_cylinders);
   swap(lhs.m_indices, rhs.m_indices);
   swap(lhs.m_indexMap, rhs.m_indexMap);
+  swap(lhs.m_displacements, rhs.m_displacements);
+  swap(lhs.m_displacementScale, rhs.m_displacementScale);
   lhs.m_dirty = rhs.m_dirty = true;
 }
 
@@ -1,16 +1,19 @@
 attribute vec4 vertex;
 attribute vec3 color;
 attribute vec3 normal;
+attribute vec3 displacement;
 
 uniform mat4 modelView;
 uniform mat4 projection;
 uniform mat3 normalMatrix;
+uniform float displacementScale;
 
 varying vec3 fnormal;
 
 void main()
 {
   gl_FrontColor = vec4(color, 1.0);
-  gl_Position = projection * modelView * vertex;
+  vec4 position = vertex + vec4(displacementScale * displacement, 0.0);
+  gl_Position = projection * modelView * position;
   fnormal = normalize(normalMatrix * normal);
 }
@@ -36,6 +36,7 @@ namespace Rendering {
 
 GLRenderer::GLRenderer()
   : m_valid(false)
+  , m_scene(&m_ownScene)
   , m_textRenderStrategy(nullptr)
   , m_center(Vector3f::Zero())
   , m_radius(20.0)
@@ -79,34 +80,39 @@ void GLRenderer::render()
   if (!m_valid)
     return;
 
-  Vector4ub c = m_scene.backgroundColor();
+  Vector4ub c = m_scene->backgroundColor();
   glClearColor(c[0] / 255.0f, c[1] / 255.0f, c[2] / 255.0f, c[3] / 255.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   applyProjection();
 
   GLRenderVisitor visitor(m_camera, m_textRenderStrategy);
+  visitor.setDisplacementScale(m_scene->displacementScale());
   // Setup for opaque geometry
   visitor.setRenderPass(OpaquePass);
   glEnable(GL_DEPTH_TEST);
   glDisable(GL_BLEND);
-  m_scene.rootNode().accept(visitor);
+  m_scene->rootNode().accept(visitor);
+  m_viewNode.accept(visitor);
 
   // Setup for transparent geometry
   visitor.setRenderPass(TranslucentPass);
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  m_scene.rootNode().accept(visitor);
+  m_scene->rootNode().accept(visitor);
+  m_viewNode.accept(visitor);
 
   // Setup for 3d overlay rendering
   visitor.setRenderPass(Overlay3DPass);
   glClear(GL_DEPTH_BUFFER_BIT);
-  m_scene.rootNode().accept(visitor);
+  m_scene->rootNode().accept(visitor);
+  m_viewNode.accept(visitor);
 
   // Setup for 2d overlay rendering
   visitor.setRenderPass(Overlay2DPass);
   visitor.setCamera(m_overlayCamera);
   glDisable(GL_DEPTH_TEST);
-  m_scene.rootNode().accept(visitor);
+  m_scene->rootNode().accept(visitor);
+  m_viewNode.accept(visitor);
 }
 
 void GLRenderer::resetCamera()
@@ -119,9 +125,15 @@ void GLRenderer::resetCamera()
 
 void GLRenderer::resetGeometry()
 {
-  m_scene.setDirty(true);
-  m_center = m_scene.center();
-  m_radius = m_scene.radius();
+  m_scene->setDirty(true);
+  m_center = m_scene->center();
+  m_radius = m_scene->radius();
+}
+
+void GLRenderer::setScene(Scene* scene)
+{
+  m_scene = scene ? scene : &m_ownScene;
+  resetGeometry();
 }
 
 void GLRenderer::setTextRenderStrategy(TextRenderStrategy* tren)
@@ -145,7 +157,8 @@ void GLRenderer::setTextRenderStrategy(TextRenderStrategy* tren)
       void visit(LineStripGeometry&) override { return; }
     } labelResetter;
 
-    m_scene.rootNode().accept(labelResetter);
+    m_scene->rootNode().accept(labelResetter);
+    m_viewNode.accept(labelResetter);
 
     delete m_textRenderStrategy;
     m_textRenderStrategy = tren;
@@ -217,7 +230,12 @@ std::multimap<float, Identifier> GLRenderer::hits(int x, int y) const
     Vector3f(static_cast<float>(x), static_cast<float>(y), 1.f)));
   const Vector3f direction((end - origin).normalized());
 
-  return hits(&m_scene.rootNode(), origin, end, direction);
+  std::multimap<float, Identifier> result(
+    hits(&m_scene->rootNode(), origin, end, direction));
+  std::multimap<float, Identifier> viewHits(
+    hits(&m_viewNode, origin, end, direction));
+  result.insert(viewHits.begin(), viewHits.end());
+  return result;
 }
 
 } // End Rendering namespace
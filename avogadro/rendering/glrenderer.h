@@ -21,6 +21,7 @@
 
 #include "bufferobject.h"
 #include "camera.h"
+#include "groupnode.h"
 #include "primitive.h"
 #include "scene.h"
 #include "shader.h"
@@ -90,8 +91,24 @@ public:
   Camera& overlayCamera();
 
   /** Get the scene for this renderer. */
-  const Scene& scene() const { return m_scene; }
-  Scene& scene() { return m_scene; }
+  const Scene& scene() const { return *m_scene; }
+  Scene& scene() { return *m_scene; }
+
+  /**
+   * Render @a scene, owned by the caller, in place of the renderer's own
+   * scene. Renderers whose OpenGL contexts share objects can render the same
+   * scene, so that its geometry is only built and uploaded once. Pass nullptr
+   * to return to the renderer's own scene.
+   */
+  void setScene(Scene* scene);
+
+  /**
+   * Get the view node, rendered after the scene and never shared with other
+   * renderers. It holds content that differs between views of one scene, such
+   * as tool overlays.
+   */
+  const GroupNode& viewNode() const { return m_viewNode; }
+  GroupNode& viewNode() { return m_viewNode; }
 
   /**
    * Get/set the text rendering strategy for this object. The renderer takes
@@ -128,7 +145,9 @@ private:
   std::string m_error;
   Camera m_camera;
   Camera m_overlayCamera;
-  Scene m_scene;
+  Scene m_ownScene;
+  Scene* m_scene;
+  GroupNode m_viewNode;
   TextRenderStrategy* m_textRenderStrategy;
 
   Vector3f m_center;
@@ -23,13 +23,15 @@
 #include "spheregeometry.h"
 #include "textlabel2d.h"
 #include "textlabel3d.h"
+#include "volumegeometry.h"
 
 namespace Avogadro {
 namespace Rendering {
 
 GLRenderVisitor::GLRenderVisitor(const Camera& camera_,
                                  const TextRenderStrategy* trs)
-  : m_camera(camera_), m_textRenderStrategy(trs), m_renderPass(NotRendering)
+  : m_camera(camera_), m_textRenderStrategy(trs), m_renderPass(NotRendering),
+    m_displacementScale(0.0f)
 {
 }
 
@@ -45,8 +47,10 @@ void GLRenderVisitor::visit(Drawable& geometry)
 
 void GLRenderVisitor::visit(SphereGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass) {
+    geometry.setDisplacementScale(m_displacementScale);
     geometry.render(m_camera);
+  }
 }
 
 void GLRenderVisitor::visit(AmbientOcclusionSphereGeometry& geometry)
@@ -57,8 +61,10 @@ void GLRenderVisitor::visit(AmbientOcclusionSphereGeometry& geometry)
 
 void GLRenderVisitor::visit(CylinderGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass) {
+    geometry.setDisplacementScale(m_displacementScale);
     geometry.render(m_camera);
+  }
 }
 
 void GLRenderVisitor::visit(MeshGeometry& geometry)
@@ -86,6 +92,14 @@ void GLRenderVisitor::visit(TextLabel3D& geometry)
 }
 
 void GLRenderVisitor::visit(LineStripGeometry& geometry)
+{
+  if (geometry.renderPass() == m_renderPass) {
+    geometry.setDisplacementScale(m_displacementScale);
+    geometry.render(m_camera);
+  }
+}
+
+void GLRenderVisitor::visit(VolumeGeometry& geometry)
 {
   if (geometry.renderPass() == m_renderPass)
     geometry.render(m_camera);
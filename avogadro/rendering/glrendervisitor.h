@@ -65,10 +65,19 @@ public:
   void visit(TextLabel2D& geometry) override;
   void visit(TextLabel3D& geometry) override;
   void visit(LineStripGeometry& geometry) override;
+  void visit(VolumeGeometry& geometry) override;
 
   void setCamera(const Camera& camera_) { m_camera = camera_; }
   Camera camera() const { return m_camera; }
 
+  /**
+   * The displacement scale handed to sphere, cylinder and line strip geometry
+   * before they are rendered.
+   * @sa Scene::displacementScale()
+   */
+  void setDisplacementScale(float scale) { m_displacementScale = scale; }
+  float displacementScale() const { return m_displacementScale; }
+
   /**
    * A TextRenderStrategy implementation used to render text for annotations.
    * If nullptr, no text will be produced.
@@ -88,6 +97,7 @@ private:
   Camera m_camera;
   const TextRenderStrategy* m_textRenderStrategy;
   RenderPass m_renderPass;
+  float m_displacementScale;
 };
 
 } // End namespace Rendering
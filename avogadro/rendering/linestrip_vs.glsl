@@ -1,11 +1,47 @@
-attribute vec4 vertex;
-attribute vec4 color;
+// Each segment is drawn as a quad facing the screen, corner.x selects its end
+// and corner.y its side.
+attribute vec2 corner;
+attribute vec3 start;
+attribute vec4 startColor;
+attribute vec3 end;
+attribute vec4 endColor;
+attribute float width;
+attribute vec3 startDisplacement;
+attribute vec3 endDisplacement;
 
 uniform mat4 modelView;
 uniform mat4 projection;
+uniform ivec2 viewport;
+uniform float displacementScale;
 
 void main()
 {
-  gl_FrontColor = color;
-  gl_Position = projection * modelView * vertex;
+  vec3 displacedStart = start + displacementScale * startDisplacement;
+  vec3 displacedEnd = end + displacementScale * endDisplacement;
+  vec4 clipStart = projection * modelView * vec4(displacedStart, 1.0);
+  vec4 clipEnd = projection * modelView * vec4(displacedEnd, 1.0);
+
+  // Clip the segment to the near plane, so that its direction on screen is
+  // defined.
+  float nearStart = clipStart.z + clipStart.w;
+  float nearEnd = clipEnd.z + clipEnd.w;
+  if (nearStart < 0.0 && nearEnd > 0.0)
+    clipStart = mix(clipStart, clipEnd, nearStart / (nearStart - nearEnd));
+  else if (nearEnd < 0.0 && nearStart > 0.0)
+    clipEnd = mix(clipEnd, clipStart, nearEnd / (nearEnd - nearStart));
+
+  // The direction of the segment in pixels.
+  vec2 pixels = vec2(viewport);
+  vec2 delta = (clipEnd.xy / clipEnd.w - clipStart.xy / clipStart.w) * pixels;
+  vec2 along = length(delta) > 1e-6 ? normalize(delta) : vec2(1.0, 0.0);
+  vec2 across = vec2(-along.y, along.x);
+
+  // Offset the corners by half the width, the ends are extended as well so
+  // that consecutive segments of a strip join without gaps.
+  vec2 offset = (along * (2.0 * corner.x - 1.0) + across * corner.y) * width;
+  vec4 position = mix(clipStart, clipEnd, corner.x);
+  position.xy += offset / pixels * position.w;
+
+  gl_FrontColor = mix(startColor, endColor, corner.x);
+  gl_Position = position;
 }
@@ -36,9 +36,58 @@ namespace {
 }
 
 using Avogadro::Core::Array;
+using Avogadro::Vector2f;
 using Avogadro::Vector3f;
 using Avogadro::Vector3ub;
 using Avogadro::Vector4ub;
+using Avogadro::Rendering::LineStripGeometry;
+
+namespace {
+// One segment of a line strip, expanded to a quad in the vertex shader.
+struct PackedSegment
+{                       // 36 bytes total:
+  Vector3f start;       // 12 bytes
+  Vector4ub startColor; //  4 bytes
+  Vector3f end;         // 12 bytes
+  Vector4ub endColor;   //  4 bytes
+  float width;          //  4 bytes
+
+  PackedSegment(const LineStripGeometry::PackedVertex& s,
+                const LineStripGeometry::PackedVertex& e, float w)
+    : start(s.vertex), startColor(s.color), end(e.vertex), endColor(e.color),
+      width(w)
+  {
+  }
+  static int startOffset() { return 0; }
+  static int startColorOffset() { return 12; }
+  static int endOffset() { return 16; }
+  static int endColorOffset() { return 28; }
+  static int widthOffset() { return 32; }
+};
+
+// The displacements of the ends of a segment.
+struct SegmentDisplacement
+{
+  Vector3f start;
+  Vector3f end;
+
+  SegmentDisplacement(const Vector3f& s, const Vector3f& e) : start(s), end(e)
+  {
+  }
+  static int startOffset() { return 0; }
+  static int endOffset() { return 12; }
+};
+
+// The corners of a segment's quad, in triangle strip order.
+const Vector2f Corners[4] = { Vector2f(0.f, -1.f), Vector2f(0.f, 1.f),
+                              Vector2f(1.f, -1.f), Vector2f(1.f, 1.f) };
+
+const char* SegmentAttributes[] = { "start", "startColor", "end", "endColor",
+                                    "width" };
+
+const char* DisplacementAttributes[] = { "startDisplacement",
+                                         "endDisplacement" };
+}
 
 using std::cout;
 using std::endl;
@@ -52,9 +101,14 @@ const size_t LineStripGeometry::InvalidIndex =
 class LineStripGeometry::Private
 {
 public:
-  Private() {}
+  Private() : segmentCount(0), instanced(false) {}
 
   BufferObject vbo;
+  BufferObject cornerVbo;
+  BufferObject displacementVbo;
+  BufferObject ibo;
+  size_t segmentCount;
+  bool instanced;
 
   Shader vertexShader;
   Shader fragmentShader;
@@ -62,14 +116,16 @@ public:
 };
 
 LineStripGeometry::LineStripGeometry()
-  : m_color(255, 0, 0), m_opacity(255), m_dirty(false), d(new Private)
+  : m_displacementScale(0.0f), m_color(255, 0, 0), m_opacity(255),
+    m_dirty(false), d(new Private)
 {
 }
 
 LineStripGeometry::LineStripGeometry(const LineStripGeometry& other)
   : Drawable(other), m_vertices(other.m_vertices),
     m_lineStarts(other.m_lineStarts), m_lineWidths(other.m_lineWidths),
-    m_color(other.m_color), m_opacity(other.m_opacity), m_dirty(true),
+    m_displacements(other.m_displacements),
+    m_displacementScale(other.m_displacementScale), m_color(other.m_color), m_opacity(other.m_opacity), m_dirty(true),
     d(new Private)
 {
 }
@@ -91,7 +147,70 @@ void LineStripGeometry::update()
 
   // Check if the VBOs are ready, if not get them ready.
   if (!d->vbo.ready() || m_dirty) {
-    d->vbo.upload(m_vertices, BufferObject::ArrayBuffer);
+    // Instanced drawing stores each segment once, the quads are otherwise
+    // expanded here with a copy of the segment per corner.
+    d->instanced = GLEW_VERSION_3_3 || GLEW_ARB_instanced_arrays;
+
+    bool displaced = m_displacements.size() == m_vertices.size();
+    Array<PackedSegment> segments;
+    Array<SegmentDisplacement> displacements;
+    segments.reserve(m_vertices.size());
+    if (displaced)
+      displacements.reserve(m_vertices.size());
+    for (size_t i = 0; i < m_lineStarts.size(); ++i) {
+      size_t begin = m_lineStarts[i];
+      size_t end = i + 1 < m_lineStarts.size() ? m_lineStarts[i + 1]
+                                               : m_vertices.size();
+      for (size_t j = begin; j + 1 < end; ++j) {
+        segments.push_back(
+          PackedSegment(m_vertices[j], m_vertices[j + 1], m_lineWidths[i]));
+        if (displaced) {
+          displacements.push_back(
+            SegmentDisplacement(m_displacements[j], m_displacements[j + 1]));
+        }
+      }
+    }
+    d->segmentCount = segments.size();
+
+    if (d->instanced) {
+      if (!segments.empty())
+        d->vbo.upload(segments, BufferObject::ArrayBuffer);
+      if (!displacements.empty())
+        d->displacementVbo.upload(displacements, BufferObject::ArrayBuffer);
+      d->cornerVbo.upload(Array<Vector2f>(Corners, Corners + 4),
+                          BufferObject::ArrayBuffer);
+    } else if (!segments.empty()) {
+      Array<PackedSegment> vertices;
+      Array<SegmentDisplacement> vertexDisplacements;
+      Array<Vector2f> corners;
+      Array<unsigned int> indices;
+      vertices.reserve(4 * segments.size());
+      vertexDisplacements.reserve(4 * displacements.size());
+      corners.reserve(4 * segments.size());
+      indices.reserve(6 * segments.size());
+      for (size_t i = 0; i < segments.size(); ++i) {
+        unsigned int first = static_cast<unsigned int>(4 * i);
+        for (int corner = 0; corner < 4; ++corner) {
+          vertices.push_back(segments[i]);
+          if (displaced)
+            vertexDisplacements.push_back(displacements[i]);
+          corners.push_back(Corners[corner]);
+        }
+        indices.push_back(first);
+        indices.push_back(first + 1);
+        indices.push_back(first + 2);
+        indices.push_back(first + 2);
+        indices.push_back(first + 1);
+        indices.push_back(first + 3);
+      }
+      d->vbo.upload(vertices, BufferObject::ArrayBuffer);
+      if (displaced) {
+        d->displacementVbo.upload(vertexDisplacements,
+                                  BufferObject::ArrayBuffer);
+      }
+      d->cornerVbo.upload(corners, BufferObject::ArrayBuffer);
+      d->ibo.upload(indices, BufferObject::ElementArrayBuffer);
+    }
     m_dirty = false;
   }
 
@@ -121,25 +240,64 @@ void LineStripGeometry::render(const Camera& camera)
   // Prepare the VBO and shader program if necessary.
   update();
 
+  if (d->segmentCount == 0)
+    return;
+
   if (!d->program.bind())
     cout << d->program.error() << endl;
 
-  d->vbo.bind();
-
-  // Set up our attribute arrays.
-  if (!d->program.enableAttributeArray("vertex"))
+  // Set up our attribute arrays, the corners first.
+  d->cornerVbo.bind();
+  if (!d->program.enableAttributeArray("corner"))
     cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("vertex", PackedVertex::vertexOffset(),
-                                    sizeof(PackedVertex), FloatType, 3,
-                                    ShaderProgram::NoNormalize)) {
+  if (!d->program.useAttributeArray("corner", 0, sizeof(Vector2f), FloatType,
+                                    2, ShaderProgram::NoNormalize)) {
     cout << d->program.error() << endl;
   }
-  if (!d->program.enableAttributeArray("color"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("color", PackedVertex::colorOffset(),
-                                    sizeof(PackedVertex), UCharType, 4,
-                                    ShaderProgram::Normalize)) {
-    cout << d->program.error() << endl;
+
+  d->vbo.bind();
+  const int offsets[] = { PackedSegment::startOffset(),
+                          PackedSegment::startColorOffset(),
+                          PackedSegment::endOffset(),
+                          PackedSegment::endColorOffset(),
+                          PackedSegment::widthOffset() };
+  const int tupleSizes[] = { 3, 4, 3, 4, 1 };
+  for (int i = 0; i < 5; ++i) {
+    bool color = tupleSizes[i] == 4;
+    if (!d->program.enableAttributeArray(SegmentAttributes[i]))
+      cout << d->program.error() << endl;
+    if (!d->program.useAttributeArray(
+          SegmentAttributes[i], offsets[i], sizeof(PackedSegment),
+          color ? UCharType : FloatType, tupleSizes[i],
+          color ? ShaderProgram::Normalize : ShaderProgram::NoNormalize)) {
+      cout << d->program.error() << endl;
+    }
+    if (d->instanced &&
+        !d->program.setAttributeArrayDivisor(SegmentAttributes[i], 1)) {
+      cout << d->program.error() << endl;
+    }
+  }
+
+  // Without displacements the attributes keep their default value of zero.
+  bool displaced = m_displacements.size() == m_vertices.size();
+  if (displaced) {
+    d->displacementVbo.bind();
+    const int displacementOffsets[] = { SegmentDisplacement::startOffset(),
+                                        SegmentDisplacement::endOffset() };
+    for (int i = 0; i < 2; ++i) {
+      if (!d->program.enableAttributeArray(DisplacementAttributes[i]))
+        cout << d->program.error() << endl;
+      if (!d->program.useAttributeArray(
+            DisplacementAttributes[i], displacementOffsets[i],
+            sizeof(SegmentDisplacement), FloatType, 3,
+            ShaderProgram::NoNormalize)) {
+        cout << d->program.error() << endl;
+      }
+      if (d->instanced &&
+          !d->program.setAttributeArrayDivisor(DisplacementAttributes[i], 1)) {
+        cout << d->program.error() << endl;
+      }
+    }
   }
 
   // Set up our uniforms (model-view and projection matrices right now).
@@ -149,34 +307,50 @@ void LineStripGeometry::render(const Camera& camera)
   if (!d->program.setUniformValue("projection", camera.projection().matrix())) {
     cout << d->program.error() << endl;
   }
-
-  // Render the linestrips using the shader and bound VBO.
-  Array<unsigned int>::const_iterator startIter = m_lineStarts.begin();
-  Array<unsigned int>::const_iterator startEnd = m_lineStarts.end();
-  Array<float>::const_iterator widthIter = m_lineWidths.begin();
-  unsigned int startIndex;
-  unsigned int endIndex;
-  while (startIter + 1 != startEnd) {
-    startIndex = *startIter;
-    endIndex = *(startIter + 1);
-    glLineWidth(*widthIter);
-    glDrawArrays(GL_LINE_STRIP, static_cast<GLint>(startIndex),
-                 static_cast<GLsizei>(endIndex - startIndex));
-    ++startIter;
-    ++widthIter;
+  if (!d->program.setUniformValue("displacementScale",
+                                  displaced ? m_displacementScale : 0.0f)) {
+    cout << d->program.error() << endl;
+  }
+  if (!d->program.setUniformValue("viewport",
+                                  Vector2i(camera.width(), camera.height()))) {
+    cout << d->program.error() << endl;
   }
 
-  // There is an implicit ending index of m_vertices.size():
-  startIndex = *startIter;
-  endIndex = static_cast<unsigned int>(m_vertices.size());
-  glLineWidth(*widthIter);
-  glDrawArrays(GL_LINE_STRIP, static_cast<GLint>(startIndex),
-               static_cast<GLsizei>(endIndex - startIndex));
+  // Render all of the segments in one call.
+  GLsizei count = static_cast<GLsizei>(d->segmentCount);
+  if (d->instanced) {
+    if (GLEW_VERSION_3_3)
+      glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+    else
+      glDrawArraysInstancedARB(GL_TRIANGLE_STRIP, 0, 4, count);
+
+    // The divisors are not part of the program, reset them for other
+    // drawables.
+    for (int i = 0; i < 5; ++i)
+      d->program.setAttributeArrayDivisor(SegmentAttributes[i], 0);
+    if (displaced) {
+      for (int i = 0; i < 2; ++i)
+        d->program.setAttributeArrayDivisor(DisplacementAttributes[i], 0);
+    }
+  } else {
+    d->ibo.bind();
+    glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(4 * count - 1),
+                        6 * count, GL_UNSIGNED_INT,
+                        reinterpret_cast<const GLvoid*>(NULL));
+    d->ibo.release();
+  }
 
   d->vbo.release();
-
-  d->program.disableAttributeArray("vector");
-  d->program.disableAttributeArray("color");
+  if (displaced)
+    d->displacementVbo.release();
+
+  d->program.disableAttributeArray("corner");
+  for (int i = 0; i < 5; ++i)
+    d->program.disableAttributeArray(SegmentAttributes[i]);
+  if (displaced) {
+    for (int i = 0; i < 2; ++i)
+      d->program.disableAttributeArray(DisplacementAttributes[i]);
+  }
 
   d->program.release();
 }
@@ -186,7 +360,15 @@ void LineStripGeometry::clear()
   m_vertices.clear();
   m_lineStarts.clear();
   m_lineWidths.clear();
+  m_displacements.clear();
+  m_dirty = true;
+}
+
+void LineStripGeometry::setDisplacements(
+  const Core::Array<Vector3f>& displacements)
+{
   m_dirty = true;
+  m_displacements = displacements;
 }
 
 size_t LineStripGeometry::addLineStrip(const Core::Array<Vector3f>& vertices,
@@ -260,5 +442,32 @@ size_t LineStripGeometry::addLineStrip(const Core::Array<Vector3f>& vertices,
   return result;
 }
 
+size_t LineStripGeometry::addLines(const Core::Array<Vector3f>& vertices,
+                                   const Core::Array<Vector3ub>& rgb,
+                                   float lineWidth)
+{
+  if (vertices.empty() || vertices.size() % 2 != 0 ||
+      vertices.size() != rgb.size()) {
+    return InvalidIndex;
+  }
+
+  size_t result = m_lineStarts.size();
+  m_lineStarts.reserve(m_lineStarts.size() + vertices.size() / 2);
+  m_lineWidths.reserve(m_lineWidths.size() + vertices.size() / 2);
+  m_vertices.reserve(m_vertices.size() + vertices.size());
+  Vector4ub tmpColor(0, 0, 0, m_opacity);
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    if (i % 2 == 0) {
+      m_lineStarts.push_back(static_cast<unsigned int>(m_vertices.size()));
+      m_lineWidths.push_back(lineWidth);
+    }
+    tmpColor.head<3>() = rgb[i];
+    m_vertices.push_back(PackedVertex(vertices[i], tmpColor));
+  }
+
+  m_dirty = true;
+  return result;
+}
+
 } // End namespace Rendering
 } // End namespace Avogadro
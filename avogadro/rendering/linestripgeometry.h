@@ -28,6 +28,13 @@ namespace Rendering {
  * @class LineStripGeometry linestripgeometry.h
  * <avogadro/rendering/linestripgeometry.h>
  * @brief The LineStripGeometry class is used to store sets of line strips.
+ *
+ * The segments of all strips are drawn together, as quads facing the screen
+ * that are expanded in the vertex shader. This takes a single draw call,
+ * instanced where supported, and allows any line width, unlike glLineWidth.
+ *
+ * Each vertex may also carry a displacement vector, which the vertex shader
+ * adds times displacementScale(), as in SphereGeometry.
  */
 
 class AVOGADRORENDERING_EXPORT LineStripGeometry : public Drawable
@@ -90,6 +97,20 @@ public:
   size_t addLineStrip(const Core::Array<Vector3f>& vertices, float lineWidth);
   /** @} */
 
+  /**
+   * Add independent line segments to the object, each pair of @a vertices is
+   * one segment. This is the same as adding a line strip of two vertices per
+   * segment, without the arrays for each of them.
+   * @param vertices The end points of the segments.
+   * @param color Vertex color, the current opacity() is used.
+   * @param lineWidth The width of the lines.
+   * @note The arrays must be the same length, and have an even number of
+   * elements, or this function call will fail, returning InvalidIndex.
+   * @return The index of the first line strip added by this call.
+   */
+  size_t addLines(const Core::Array<Vector3f>& vertices,
+                  const Core::Array<Vector3ub>& color, float lineWidth);
+
   /**
    * The default color of the lines. This is used to set the color of new
    * vertices when no explicit vertex color is specified.
@@ -108,6 +129,20 @@ public:
   unsigned char opacity() const { return m_opacity; }
   /** @} */
 
+  /**
+   * Set the displacements of the vertices, one per vertex in the order they
+   * were added. An empty array disables displacement.
+   */
+  void setDisplacements(const Core::Array<Vector3f>& displacements);
+  const Core::Array<Vector3f>& displacements() const { return m_displacements; }
+
+  /**
+   * The factor applied to the displacements when rendering. Set by the render
+   * visitor from Scene::displacementScale().
+   */
+  void setDisplacementScale(float scale) { m_displacementScale = scale; }
+  float displacementScale() const { return m_displacementScale; }
+
   /** The vertex array. */
   Core::Array<PackedVertex> vertices() const { return m_vertices; }
 
@@ -120,6 +155,8 @@ private:
   Core::Array<PackedVertex> m_vertices;
   Core::Array<unsigned int> m_lineStarts;
   Core::Array<float> m_lineWidths;
+  Core::Array<Vector3f> m_displacements;
+  float m_displacementScale;
 
   Vector3ub m_color;
   unsigned char m_opacity;
@@ -144,6 +181,8 @@ inline void swap(LineStripGeometry& lhs, LineStripGeometry& rhs)
   swap(lhs.m_vertices, rhs.m_vertices);
   swap(lhs.m_lineStarts, rhs.m_lineStarts);
   swap(lhs.m_lineWidths, rhs.m_lineWidths);
+  swap(lhs.m_displacements, rhs.m_displacements);
+  swap(lhs.m_displacementScale, rhs.m_displacementScale);
   swap(lhs.m_color, rhs.m_color);
   swap(lhs.m_opacity, rhs.m_opacity);
   lhs.m_dirty = rhs.m_dirty = true;
@@ -30,6 +30,7 @@
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <memory>
 
 namespace {
 #include "mesh_fs.h"
@@ -52,30 +53,37 @@ const unsigned int MeshGeometry::InvalidIndex =
 class MeshGeometry::Private
 {
 public:
-  Private() {}
+  // The uploaded vertices and indices, shared between copies of the geometry.
+  struct Buffers
+  {
+    Buffers() : uploaded(false), numberOfVertices(0), numberOfIndices(0) {}
 
-  BufferObject vbo;
-  BufferObject ibo;
+    BufferObject vbo;
+    BufferObject ibo;
+    bool uploaded;
+    size_t numberOfVertices;
+    size_t numberOfIndices;
+  };
+
+  Private() : buffers(new Buffers) {}
+
+  std::shared_ptr<Buffers> buffers;
 
   Shader vertexShader;
   Shader fragmentShader;
   ShaderProgram program;
-
-  size_t numberOfVertices;
-  size_t numberOfIndices;
 };
 
 MeshGeometry::MeshGeometry()
-  : m_color(255, 0, 0), m_opacity(255), m_dirty(false), d(new Private)
+  : m_color(255, 0, 0), m_opacity(255), d(new Private)
 {
 }
 
 MeshGeometry::MeshGeometry(const MeshGeometry& other)
   : Drawable(other), m_vertices(other.m_vertices), m_indices(other.m_indices),
-    m_color(other.m_color), m_opacity(other.m_opacity),
-    m_dirty(true), // Force rendering internals to be rebuilt
-    d(new Private)
+    m_color(other.m_color), m_opacity(other.m_opacity), d(new Private)
 {
+  d->buffers = other.d->buffers;
 }
 
 MeshGeometry::~MeshGeometry()
@@ -90,16 +98,19 @@ void MeshGeometry::accept(Visitor& visitor)
 
 void MeshGeometry::update()
 {
-  if (m_vertices.empty() || m_indices.empty())
+  if (m_vertices.empty())
     return;
 
-  // Check if the VBOs are ready, if not get them ready.
-  if (!d->vbo.ready() || m_dirty) {
-    d->vbo.upload(m_vertices, BufferObject::ArrayBuffer);
-    d->ibo.upload(m_indices, BufferObject::ElementArrayBuffer);
-    d->numberOfVertices = m_vertices.size();
-    d->numberOfIndices = m_indices.size();
-    m_dirty = false;
+  // Check if the VBOs are ready, if not get them ready. Copies sharing the
+  // buffers have the same contents, so any of them can upload them.
+  Private::Buffers& buffers = *d->buffers;
+  if (!buffers.uploaded) {
+    buffers.vbo.upload(m_vertices, BufferObject::ArrayBuffer);
+    if (!m_indices.empty())
+      buffers.ibo.upload(m_indices, BufferObject::ElementArrayBuffer);
+    buffers.numberOfVertices = m_vertices.size();
+    buffers.numberOfIndices = m_indices.size();
+    buffers.uploaded = true;
   }
 
   // Build and link the shader if it has not been used yet.
@@ -121,17 +132,19 @@ void MeshGeometry::update()
 
 void MeshGeometry::render(const Camera& camera)
 {
-  if (m_indices.empty() || m_vertices.empty())
+  if (m_vertices.empty())
     return;
 
   // Prepare the VBOs, IBOs and shader program if necessary.
   update();
+  Private::Buffers& buffers = *d->buffers;
 
   if (!d->program.bind())
     cout << d->program.error() << endl;
 
-  d->vbo.bind();
-  d->ibo.bind();
+  buffers.vbo.bind();
+  if (buffers.numberOfIndices > 0)
+    buffers.ibo.bind();
 
   // Set up our attribute arrays.
   if (!d->program.enableAttributeArray("vertex"))
@@ -167,16 +180,23 @@ void MeshGeometry::render(const Camera& camera)
   if (!d->program.setUniformValue("normalMatrix", normalMatrix))
     std::cout << d->program.error() << std::endl;
 
-  // Render the loaded spheres using the shader and bound VBO.
-  glDrawRangeElements(GL_TRIANGLES, 0,
-                      static_cast<GLuint>(d->numberOfVertices - 1),
-                      static_cast<GLsizei>(d->numberOfIndices), GL_UNSIGNED_INT,
-                      reinterpret_cast<const GLvoid*>(NULL));
+  // Render the triangles using the shader and bound VBO, without indices
+  // every three vertices are a triangle.
+  if (buffers.numberOfIndices > 0) {
+    glDrawRangeElements(GL_TRIANGLES, 0,
+                        static_cast<GLuint>(buffers.numberOfVertices - 1),
+                        static_cast<GLsizei>(buffers.numberOfIndices),
+                        GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(NULL));
+    buffers.ibo.release();
+  } else {
+    glDrawArrays(GL_TRIANGLES, 0,
+                 static_cast<GLsizei>(buffers.numberOfVertices -
+                                      buffers.numberOfVertices % 3));
+  }
 
-  d->vbo.release();
-  d->ibo.release();
+  buffers.vbo.release();
 
-  d->program.disableAttributeArray("vector");
+  d->program.disableAttributeArray("vertex");
   d->program.disableAttributeArray("color");
   d->program.disableAttributeArray("normal");
 
@@ -200,7 +220,7 @@ unsigned int MeshGeometry::addVertices(const Core::Array<Vector3f>& v,
   while (vIter != vEnd)
     m_vertices.push_back(PackedVertex(*(cIter++), *(nIter++), *(vIter++)));
 
-  m_dirty = true;
+  detachBuffers();
 
   return static_cast<unsigned int>(result);
 }
@@ -225,7 +245,7 @@ unsigned int MeshGeometry::addVertices(const Core::Array<Vector3f>& v,
     m_vertices.push_back(PackedVertex(tmpColor, *(nIter++), *(vIter++)));
   }
 
-  m_dirty = true;
+  detachBuffers();
 
   return static_cast<unsigned int>(result);
 }
@@ -246,7 +266,7 @@ unsigned int MeshGeometry::addVertices(const Core::Array<Vector3f>& v,
   while (vIter != vEnd)
     m_vertices.push_back(PackedVertex(tmpColor, *(nIter++), *(vIter++)));
 
-  m_dirty = true;
+  detachBuffers();
 
   return static_cast<unsigned int>(result);
 }
@@ -257,7 +277,7 @@ void MeshGeometry::addTriangle(unsigned int index1, unsigned int index2,
   m_indices.push_back(index1);
   m_indices.push_back(index2);
   m_indices.push_back(index3);
-  m_dirty = true;
+  detachBuffers();
 }
 
 void MeshGeometry::addTriangles(const Core::Array<unsigned int>& indiceArray)
@@ -265,14 +285,22 @@ void MeshGeometry::addTriangles(const Core::Array<unsigned int>& indiceArray)
   m_indices.reserve(m_indices.size() + indiceArray.size());
   std::copy(indiceArray.begin(), indiceArray.end(),
             std::back_inserter(m_indices));
-  m_dirty = true;
+  detachBuffers();
 }
 
 void MeshGeometry::clear()
 {
   m_vertices.clear();
   m_indices.clear();
-  m_dirty = true;
+  detachBuffers();
+}
+
+void MeshGeometry::detachBuffers()
+{
+  if (d->buffers.use_count() > 1)
+    d->buffers = std::make_shared<Private::Buffers>();
+  else
+    d->buffers->uploaded = false;
 }
 
 } // End namespace Rendering
@@ -28,6 +28,10 @@ namespace Rendering {
  * @class MeshGeometry meshgeometry.h <avogadro/rendering/meshgeometry.h>
  * @brief The MeshGeometry is used for triangle mesh geometry.
  * @author Marcus D. Hanwell
+ *
+ * Copies of a MeshGeometry share their GPU buffers until one of them is
+ * modified, so a copy of geometry that was already rendered is drawn without
+ * uploading it again.
  */
 
 class AVOGADRORENDERING_EXPORT MeshGeometry : public Drawable
@@ -75,8 +79,9 @@ public:
   void render(const Camera& camera) override;
 
   /**
-   * Add vertices to the object. Note that this just adds vertices to the
-   * object. Use addTriangles with size_t indices to actually draw them.
+   * Add vertices to the object. Use addTriangles with the indices of the
+   * vertices to draw them, if no triangles are added at all every three
+   * consecutive vertices form a triangle.
    * @param vertices The 3D vertex points to add to the drawable.
    * @param normals The normal direction at the vertex.
    * @param colors Vertex color. If not specified, use the current color() and
@@ -126,7 +131,10 @@ public:
   /**
    * Get the number of triangles.
    */
-  size_t triangleCount() const { return m_indices.size() / 3; }
+  size_t triangleCount() const
+  {
+    return (m_indices.empty() ? m_vertices.size() : m_indices.size()) / 3;
+  }
 
   /**
    * The default color of the mesh. This is used to set the color of new
@@ -155,13 +163,16 @@ private:
    */
   void update();
 
+  /**
+   * @brief Stop sharing the GPU buffers with copies, as the contents changed.
+   */
+  void detachBuffers();
+
   Core::Array<PackedVertex> m_vertices;
   Core::Array<unsigned int> m_indices;
   Vector3ub m_color;
   unsigned char m_opacity;
 
-  bool m_dirty;
-
   class Private;
   Private* d;
 };
@@ -181,7 +192,8 @@ inline void swap(MeshGeometry& lhs, MeshGeometry& rhs)
   swap(lhs.m_indices, rhs.m_indices);
   swap(lhs.m_color, rhs.m_color);
   swap(lhs.m_opacity, rhs.m_opacity);
-  lhs.m_dirty = rhs.m_dirty = true;
+  // The GPU buffers follow the contents.
+  swap(lhs.d, rhs.d);
 }
 
 } // End namespace Rendering
@@ -160,6 +160,12 @@ void POVRayVisitor::visit(MeshGeometry& geometry)
   str << "mesh2 {\n";
   Core::Array<Rendering::MeshGeometry::PackedVertex> v = geometry.vertices();
   Core::Array<unsigned int> tris = geometry.triangles();
+  // Without indices every three vertices are a triangle.
+  if (tris.empty()) {
+    tris.resize(v.size() - v.size() % 3);
+    for (size_t i = 0; i < tris.size(); ++i)
+      tris[i] = static_cast<unsigned int>(i);
+  }
   str << "vertex_vectors{" << v.size() << ",\n";
   for (size_t i = 0; i < v.size(); ++i) {
     str << "<" << v[i].vertex << ">,";
@@ -24,8 +24,8 @@ namespace Avogadro {
 namespace Rendering {
 
 Scene::Scene()
-  : m_backgroundColor(0, 0, 0, 0), m_dirty(true), m_center(Vector3f::Zero()),
-    m_radius(4.0f)
+  : m_backgroundColor(0, 0, 0, 0), m_displacementScale(0.0f), m_dirty(true),
+    m_center(Vector3f::Zero()), m_radius(4.0f)
 {
 }
 
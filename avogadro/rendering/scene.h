@@ -141,12 +141,21 @@ public:
    */
   bool isDirty() const { return m_dirty; }
 
+  /**
+   * Factor applied to the per-vertex displacements of sphere and cylinder
+   * geometry, typically sin(phase) of a vibration. Changing it only requires
+   * a redraw, not a rebuild of the scene. Default 0.
+   */
+  void setDisplacementScale(float scale) { m_displacementScale = scale; }
+  float displacementScale() const { return m_displacementScale; }
+
   /** Clear the scene of all elements. */
   void clear();
 
 private:
   GroupNode m_rootNode;
   Vector4ub m_backgroundColor;
+  float m_displacementScale;
 
   mutable bool m_dirty;
   mutable Vector3f m_center;
@@ -258,6 +258,27 @@ bool ShaderProgram::disableAttributeArray(const std::string& name)
   return true;
 }
 
+bool ShaderProgram::setAttributeArrayDivisor(const std::string& name,
+                                             int divisor)
+{
+  GLint location = static_cast<GLint>(findAttributeArray(name));
+  if (location == -1) {
+    m_error = "Could not set divisor of attribute " + name +
+              ". No such attribute.";
+    return false;
+  }
+  if (GLEW_VERSION_3_3) {
+    glVertexAttribDivisor(location, static_cast<GLuint>(divisor));
+  } else if (GLEW_ARB_instanced_arrays) {
+    glVertexAttribDivisorARB(location, static_cast<GLuint>(divisor));
+  } else {
+    m_error = "Could not set divisor of attribute " + name +
+              ". Instanced arrays are not supported.";
+    return false;
+  }
+  return true;
+}
+
 #define BUFFER_OFFSET(i) ((char*)nullptr + (i))
 
 bool ShaderProgram::useAttributeArray(const std::string& name, int offset,
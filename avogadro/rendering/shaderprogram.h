@@ -122,6 +122,14 @@ public:
                          Avogadro::Type elementType, int elementTupleSize,
                          NormalizeOption normalize);
 
+  /** Set how often the named attribute array advances in instanced drawing.
+   * @param divisor The attribute advances once every @a divisor instances,
+   * or once per vertex if 0, the default.
+   * @return false if the attribute array does not exist, or instanced arrays
+   * are not supported (OpenGL 3.3 or ARB_instanced_arrays).
+   */
+  bool setAttributeArrayDivisor(const std::string& name, int divisor);
+
   /** Upload the supplied array of tightly packed values to the named attribute.
    * BufferObject attributes should be preferred and this may be removed in
    * future.
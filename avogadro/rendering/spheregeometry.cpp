@@ -48,6 +48,7 @@ public:
 
   BufferObject vbo;
   BufferObject ibo;
+  BufferObject displacementVbo;
 
   Shader vertexShader;
   Shader fragmentShader;
@@ -57,13 +58,16 @@ public:
   size_t numberOfIndices;
 };
 
-SphereGeometry::SphereGeometry() : m_dirty(false), d(new Private)
+SphereGeometry::SphereGeometry()
+  : m_displacementScale(0.0f), m_dirty(false), d(new Private)
 {
 }
 
 SphereGeometry::SphereGeometry(const SphereGeometry& other)
   : Drawable(other), m_spheres(other.m_spheres), m_indices(other.m_indices),
-    m_dirty(true), d(new Private)
+    m_displacements(other.m_displacements),
+    m_displacementScale(other.m_displacementScale), m_dirty(true),
+    d(new Private)
 {
 }
 
@@ -125,6 +129,16 @@ void SphereGeometry::update()
     if (!d->ibo.upload(sphereIndices, BufferObject::ElementArrayBuffer))
       cout << d->ibo.error() << endl;
 
+    // The displacements go to their own buffer, one copy per quad corner.
+    if (m_displacements.size() == m_spheres.size()) {
+      std::vector<Vector3f> displacements;
+      displacements.reserve(m_displacements.size() * 4);
+      for (size_t i = 0; i < m_displacements.size(); ++i)
+        displacements.insert(displacements.end(), 4, m_displacements[i]);
+      if (!d->displacementVbo.upload(displacements, BufferObject::ArrayBuffer))
+        cout << d->displacementVbo.error() << endl;
+    }
+
     d->numberOfVertices = sphereVertices.size();
     d->numberOfIndices = sphereIndices.size();
 
@@ -185,6 +199,19 @@ void SphereGeometry::render(const Camera& camera)
     cout << d->program.error() << endl;
   }
 
+  // Without displacements the attribute keeps its default value of zero.
+  bool displaced = m_displacements.size() == m_spheres.size();
+  if (displaced) {
+    d->displacementVbo.bind();
+    if (!d->program.enableAttributeArray("displacement"))
+      cout << d->program.error() << endl;
+    if (!d->program.useAttributeArray("displacement", 0, sizeof(Vector3f),
+                                      FloatType, 3,
+                                      ShaderProgram::NoNormalize)) {
+      cout << d->program.error() << endl;
+    }
+  }
+
   // Set up our uniforms (model-view and projection matrices right now).
   if (!d->program.setUniformValue("modelView", camera.modelView().matrix())) {
     cout << d->program.error() << endl;
@@ -192,6 +219,10 @@ void SphereGeometry::render(const Camera& camera)
   if (!d->program.setUniformValue("projection", camera.projection().matrix())) {
     cout << d->program.error() << endl;
   }
+  if (!d->program.setUniformValue("displacementScale",
+                                  displaced ? m_displacementScale : 0.0f)) {
+    cout << d->program.error() << endl;
+  }
 
   // Render the loaded spheres using the shader and bound VBO.
   glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(d->numberOfVertices),
@@ -200,10 +231,14 @@ void SphereGeometry::render(const Camera& camera)
 
   d->vbo.release();
   d->ibo.release();
+  if (displaced)
+    d->displacementVbo.release();
 
   d->program.disableAttributeArray("vector");
   d->program.disableAttributeArray("color");
   d->program.disableAttributeArray("texCoordinates");
+  if (displaced)
+    d->program.disableAttributeArray("displacement");
 
   d->program.release();
 }
@@ -217,8 +252,11 @@ std::multimap<float, Identifier> SphereGeometry::hits(
   // Check for intersection.
   for (size_t i = 0; i < m_spheres.size(); ++i) {
     const SphereColor& sphere = m_spheres[i];
+    Vector3f center = sphere.center;
+    if (m_displacements.size() == m_spheres.size())
+      center += m_displacementScale * m_displacements[i];
 
-    Vector3f distance = sphere.center - rayOrigin;
+    Vector3f distance = center - rayOrigin;
     float B = distance.dot(rayDirection);
     float C = distance.dot(distance) - (sphere.radius * sphere.radius);
     float D = B * B - C;
@@ -228,7 +266,7 @@ std::multimap<float, Identifier> SphereGeometry::hits(
       continue;
 
     // Test for clipping
-    if (B < 0 || (sphere.center - rayEnd).dot(rayDirection) > 0)
+    if (B < 0 || (center - rayEnd).dot(rayDirection) > 0)
       continue;
 
     Identifier id;
@@ -252,10 +290,18 @@ void SphereGeometry::addSphere(const Vector3f& position, const Vector3ub& color,
   m_indices.push_back(m_indices.size());
 }
 
+void SphereGeometry::setDisplacements(
+  const Core::Array<Vector3f>& displacements)
+{
+  m_dirty = true;
+  m_displacements = displacements;
+}
+
 void SphereGeometry::clear()
 {
   m_spheres.clear();
   m_indices.clear();
+  m_displacements.clear();
 }
 
 } // End namespace Rendering
@@ -47,6 +47,10 @@ struct SphereColor
  * spheres are not a densely packed one-to-one mapping with the objects indices
  * they can also optionally use an identifier that will point to some numeric
  * ID for the purposes of picking.
+ *
+ * Each sphere may also carry a displacement vector. The vertex shader moves
+ * the sphere by its displacement times displacementScale(), so vibrations can
+ * be animated by changing a single uniform rather than rebuilding the VBOs.
  */
 
 class AVOGADRORENDERING_EXPORT SphereGeometry : public Drawable
@@ -92,6 +96,20 @@ public:
   void addSphere(const Vector3f& position, const Vector3ub& color,
                  float radius);
 
+  /**
+   * Set the displacements of the spheres, one per sphere in the order they
+   * were added. An empty array disables displacement.
+   */
+  void setDisplacements(const Core::Array<Vector3f>& displacements);
+  const Core::Array<Vector3f>& displacements() const { return m_displacements; }
+
+  /**
+   * The factor applied to the displacements when rendering and picking. Set by
+   * the render visitor from Scene::displacementScale().
+   */
+  void setDisplacementScale(float scale) { m_displacementScale = scale; }
+  float displacementScale() const { return m_displacementScale; }
+
   /**
    * Get a reference to the spheres.
    */
@@ -111,6 +129,8 @@ public:
 private:
   Core::Array<SphereColor> m_spheres;
   Core::Array<size_t> m_indices;
+  Core::Array<Vector3f> m_displacements;
+  float m_displacementScale;
 
   bool m_dirty;
 
@@ -131,6 +151,8 @@ inline void swap(SphereGeometry& lhs, SphereGeometry& rhs)
   swap(static_cast<Drawable&>(lhs), static_cast<Drawable&>(rhs));
   swap(lhs.m_spheres, rhs.m_spheres);
   swap(lhs.m_indices, rhs.m_indices);
+  swap(lhs.m_displacements, rhs.m_displacements);
+  swap(lhs.m_displacementScale, rhs.m_displacementScale);
   lhs.m_dirty = rhs.m_dirty = true;
 }
 
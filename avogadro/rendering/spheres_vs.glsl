@@ -1,6 +1,7 @@
 attribute vec4 vertex;
 attribute vec3 color;
 attribute vec2 texCoordinate;
+attribute vec3 displacement;
 varying vec2 v_texCoord;
 varying vec3 fColor;
 varying vec4 eyePosition;
@@ -8,13 +9,14 @@ varying float radius;
 
 uniform mat4 modelView;
 uniform mat4 projection;
+uniform float displacementScale;
 
 void main()
 {
   radius = abs(texCoordinate.x);
   fColor = color;
   v_texCoord = texCoordinate / radius;
-  gl_Position = modelView * vertex;
+  gl_Position = modelView * (vertex + vec4(displacementScale * displacement, 0.0));
   eyePosition = gl_Position;
 
   // Test if the closest point on the sphere would be clipped.
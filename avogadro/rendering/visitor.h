@@ -33,6 +33,7 @@ class Node;
 class SphereGeometry;
 class TextLabel2D;
 class TextLabel3D;
+class VolumeGeometry;
 class AmbientOcclusionSphereGeometry;
 
 /**
@@ -64,6 +65,7 @@ public:
   virtual void visit(TextLabel2D&) { return; }
   virtual void visit(TextLabel3D&) { return; }
   virtual void visit(LineStripGeometry&) { return; }
+  virtual void visit(VolumeGeometry&) { return; }
 };
 
 } // End namespace Rendering
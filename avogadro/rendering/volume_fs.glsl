@@ -0,0 +1,95 @@
+uniform sampler3D volume;
+uniform sampler1D transferFunction;
+uniform sampler3D occupancy;
+uniform sampler2D sceneDepth;
+
+uniform vec3 eyePosition;
+uniform vec3 viewDirection;
+uniform int orthographic;
+uniform mat4 inverseModelViewProjection;
+uniform ivec2 viewportOrigin;
+uniform ivec2 viewportSize;
+
+uniform vec3 boxMin;
+uniform vec3 boxMax;
+uniform vec3 voxelScale;
+uniform vec3 dimensions;
+uniform vec3 brickDimensions;
+uniform float brickSize;
+
+uniform float transferScale;
+uniform float transferOffset;
+uniform float sampleDistance;
+
+varying vec3 position;
+
+// Must match MaxSamples in volumegeometry.cpp.
+const int maxSamples = 2048;
+
+void main()
+{
+  vec3 dir = orthographic == 1 ? viewDirection
+                               : normalize(position - eyePosition);
+  if (abs(dir.x) < 1.0e-6)
+    dir.x = 1.0e-6;
+  if (abs(dir.y) < 1.0e-6)
+    dir.y = 1.0e-6;
+  if (abs(dir.z) < 1.0e-6)
+    dir.z = 1.0e-6;
+
+  // Distances along the ray from this fragment to the faces of the box.
+  vec3 t0 = (boxMin - position) / dir;
+  vec3 t1 = (boxMax - position) / dir;
+  vec3 tNear3 = min(t0, t1);
+  vec3 tFar3 = max(t0, t1);
+  float tNear = max(max(tNear3.x, tNear3.y), tNear3.z);
+  float tFar = min(min(tFar3.x, tFar3.y), tFar3.z);
+  // With a perspective camera inside the box the ray starts at the eye.
+  if (orthographic == 0)
+    tNear = max(tNear, -distance(position, eyePosition));
+
+  // Stop at the opaque geometry drawn before the volume, which is where the
+  // scene depth of this pixel puts it along the ray.
+  vec2 window = (gl_FragCoord.xy - vec2(viewportOrigin)) / vec2(viewportSize);
+  float depth = texture2D(sceneDepth, window).r;
+  vec4 scene = inverseModelViewProjection *
+               vec4(vec3(window, depth) * 2.0 - 1.0, 1.0);
+  tFar = min(tFar, dot(scene.xyz / scene.w - position, dir));
+
+  // March in grid coordinates, where point (i, j, k) is at (i, j, k).
+  vec3 start = (position - boxMin) * voxelScale;
+  vec3 delta = dir * voxelScale;
+  vec4 sum = vec4(0.0);
+  float t = tNear;
+  for (int i = 0; i < maxSamples; ++i) {
+    if (t > tFar || sum.a > 0.99)
+      break;
+    vec3 v = clamp(start + t * delta, vec3(0.0), dimensions - 1.0);
+
+    // Skip bricks the transfer function leaves transparent, staying on the
+    // sample positions of the ray.
+    vec3 brick = min(floor(v / brickSize), brickDimensions - 1.0);
+    if (texture3D(occupancy, ((brick + 0.5) / brickDimensions).zyx).r < 0.5) {
+      vec3 brickEnd = (brick + step(vec3(0.0), delta)) * brickSize;
+      vec3 tExit3 = (brickEnd - v) / delta;
+      float tExit = max(min(min(tExit3.x, tExit3.y), tExit3.z), 0.0);
+      t = tNear + (floor((t + tExit - tNear) / sampleDistance) + 1.0) *
+                    sampleDistance;
+      continue;
+    }
+
+    float value = texture3D(volume, ((v + 0.5) / dimensions).zyx).r;
+    vec4 color = texture1D(transferFunction,
+                           value * transferScale + transferOffset);
+    // The opacity is given for one Angstrom.
+    color.a = 1.0 - pow(1.0 - color.a, sampleDistance);
+    sum.rgb += (1.0 - sum.a) * color.a * color.rgb;
+    sum.a += (1.0 - sum.a) * color.a;
+    t += sampleDistance;
+  }
+
+  if (sum.a < 1.0 / 255.0)
+    discard;
+  // Blending multiplies by alpha again.
+  gl_FragColor = vec4(sum.rgb / sum.a, sum.a);
+}
@@ -0,0 +1,12 @@
+attribute vec4 vertex;
+
+uniform mat4 modelView;
+uniform mat4 projection;
+
+varying vec3 position;
+
+void main()
+{
+  position = vertex.xyz;
+  gl_Position = projection * modelView * vertex;
+}
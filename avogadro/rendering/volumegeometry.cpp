@@ -16,15 +16,553 @@
 
 #include "volumegeometry.h"
 
+#include "avogadrogl.h"
+#include "bufferobject.h"
+#include "camera.h"
+#include "shader.h"
+#include "shaderprogram.h"
+#include "visitor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+#include "volume_fs.h"
+#include "volume_vs.h"
+
+// Must match maxSamples in volume_fs.glsl.
+const float MaxSamples = 2048.f;
+
+// Triangles of the bounding box, counter-clockwise seen from outside. Corner
+// c is at (c & 1, (c >> 1) & 1, (c >> 2) & 1) in units of the box size.
+const unsigned int BoxIndices[36] = { 0, 4, 6, 0, 6, 2,   // -x
+                                      1, 3, 7, 1, 7, 5,   // +x
+                                      0, 1, 5, 0, 5, 4,   // -y
+                                      2, 6, 7, 2, 7, 3,   // +y
+                                      0, 2, 3, 0, 3, 1,   // -z
+                                      4, 5, 7, 4, 7, 6 }; // +z
+
+void setTextureParameters(GLenum target, GLint filter)
+{
+  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filter);
+  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, filter);
+  glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  if (target != GL_TEXTURE_1D)
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  if (target == GL_TEXTURE_3D)
+    glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+}
+} // namespace
+
+using std::cout;
+using std::endl;
+
 namespace Avogadro {
 namespace Rendering {
 
+class VolumeGeometry::Private
+{
+public:
+  Private()
+    : volumeTexture(0), transferTexture(0), occupancyTexture(0),
+      depthTexture(0), depthTextureSize(0, 0), supported(true)
+  {
+  }
+
+  ~Private()
+  {
+    if (volumeTexture > 0)
+      glDeleteTextures(1, &volumeTexture);
+    if (transferTexture > 0)
+      glDeleteTextures(1, &transferTexture);
+    if (occupancyTexture > 0)
+      glDeleteTextures(1, &occupancyTexture);
+    if (depthTexture > 0)
+      glDeleteTextures(1, &depthTexture);
+  }
+
+  /** Copy the depth buffer of the viewport, drawn so far, to depthTexture. */
+  void copyDepth(const Vector2i& origin, const Vector2i& size);
+
+  BufferObject vbo;
+  BufferObject ibo;
+
+  Shader vertexShader;
+  Shader fragmentShader;
+  ShaderProgram program;
+
+  GLuint volumeTexture;
+  GLuint transferTexture;
+  GLuint occupancyTexture;
+  GLuint depthTexture;
+  Vector2i depthTextureSize;
+
+  bool supported;
+};
+
+void VolumeGeometry::Private::copyDepth(const Vector2i& origin,
+                                        const Vector2i& size)
+{
+  if (depthTexture == 0) {
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    setTextureParameters(GL_TEXTURE_2D, GL_NEAREST);
+  } else {
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+  }
+  if (size != depthTextureSize) {
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size.x(), size.y(), 0,
+                 GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+    depthTextureSize = size;
+  }
+  glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, origin.x(), origin.y(),
+                      size.x(), size.y());
+}
+
+const int VolumeGeometry::BrickSize;
+
 VolumeGeometry::VolumeGeometry()
+  : m_dimensions(0, 0, 0), m_min(0.f, 0.f, 0.f), m_spacing(0.f, 0.f, 0.f),
+    m_minValue(0.f), m_maxValue(0.f), m_precision(Float16),
+    m_transferMinimum(0.f), m_transferMaximum(1.f), m_sampleDistance(0.f),
+    m_brickDimensions(0, 0, 0), m_valuesDirty(false), m_transferDirty(false),
+    d(new Private)
+{
+  m_renderPass = TranslucentPass;
+}
+
+VolumeGeometry::VolumeGeometry(const VolumeGeometry& other)
+  : Drawable(other), m_values(other.m_values),
+    m_dimensions(other.m_dimensions), m_min(other.m_min),
+    m_spacing(other.m_spacing), m_minValue(other.m_minValue),
+    m_maxValue(other.m_maxValue), m_precision(other.m_precision),
+    m_transferFunction(other.m_transferFunction),
+    m_transferMinimum(other.m_transferMinimum),
+    m_transferMaximum(other.m_transferMaximum),
+    m_sampleDistance(other.m_sampleDistance),
+    m_brickDimensions(other.m_brickDimensions),
+    m_brickMin(other.m_brickMin), m_brickMax(other.m_brickMax),
+    m_occupancy(other.m_occupancy),
+    m_valuesDirty(true), // Force rendering internals to be rebuilt
+    m_transferDirty(true), d(new Private)
 {
 }
 
 VolumeGeometry::~VolumeGeometry()
 {
+  delete d;
+}
+
+void VolumeGeometry::accept(Visitor& visitor)
+{
+  visitor.visit(*this);
+}
+
+bool VolumeGeometry::setData(const std::vector<double>& values,
+                             const Vector3i& dimensions, const Vector3f& min,
+                             const Vector3f& spacing)
+{
+  if ((dimensions.array() < 0).any() ||
+      values.size() != static_cast<size_t>(dimensions.x()) * dimensions.y() *
+                         dimensions.z()) {
+    return false;
+  }
+
+  m_values.resize(values.size());
+  std::copy(values.begin(), values.end(), m_values.begin());
+  m_dimensions = dimensions;
+  m_min = min;
+  m_spacing = spacing;
+  if (m_values.empty()) {
+    m_minValue = m_maxValue = 0.f;
+  } else {
+    m_minValue = *std::min_element(m_values.begin(), m_values.end());
+    m_maxValue = *std::max_element(m_values.begin(), m_values.end());
+  }
+
+  updateBricks();
+  updateOccupancy();
+  m_valuesDirty = true;
+  return true;
+}
+
+void VolumeGeometry::setPrecision(Precision precision)
+{
+  if (precision != m_precision) {
+    m_precision = precision;
+    m_valuesDirty = true;
+  }
+}
+
+bool VolumeGeometry::setTransferFunction(const Core::Array<Vector4ub>& colors,
+                                         float minimum, float maximum)
+{
+  if (colors.empty() || !(maximum > minimum))
+    return false;
+
+  m_transferFunction = colors;
+  m_transferMinimum = minimum;
+  m_transferMaximum = maximum;
+  updateOccupancy();
+  m_transferDirty = true;
+  return true;
+}
+
+bool VolumeGeometry::brickOccupied(const Vector3i& brick) const
+{
+  if ((brick.array() < 0).any() ||
+      (brick.array() >= m_brickDimensions.array()).any()) {
+    return false;
+  }
+  return m_occupancy[brickIndex(brick)] != 0;
+}
+
+Index VolumeGeometry::occupiedBrickCount() const
+{
+  return static_cast<Index>(
+    m_occupancy.size() -
+    std::count(m_occupancy.begin(), m_occupancy.end(), 0));
+}
+
+void VolumeGeometry::clear()
+{
+  m_values.clear();
+  m_dimensions.setZero();
+  m_minValue = m_maxValue = 0.f;
+  m_brickDimensions.setZero();
+  m_brickMin.clear();
+  m_brickMax.clear();
+  m_occupancy.clear();
+  m_valuesDirty = true;
+}
+
+void VolumeGeometry::updateBricks()
+{
+  m_brickMin.clear();
+  m_brickMax.clear();
+  if ((m_dimensions.array() < 2).any()) {
+    m_brickDimensions.setZero();
+    return;
+  }
+
+  // Neighboring bricks share their boundary points, so that a brick holds
+  // every point used to interpolate the values within it.
+  const Vector3i& n = m_dimensions;
+  for (int axis = 0; axis < 3; ++axis)
+    m_brickDimensions[axis] = (n[axis] - 2) / BrickSize + 1;
+  Index brickCount = static_cast<Index>(m_brickDimensions.prod());
+  m_brickMin.resize(brickCount, std::numeric_limits<float>::max());
+  m_brickMax.resize(brickCount, -std::numeric_limits<float>::max());
+
+  const float* value = m_values.data();
+  for (int i = 0; i < n.x(); ++i) {
+    // Points on a brick boundary belong to the bricks on both sides.
+    int bi0 = std::min(i / BrickSize, m_brickDimensions.x() - 1);
+    int bi1 = (i % BrickSize == 0 && i > 0) ? i / BrickSize - 1 : bi0;
+    for (int j = 0; j < n.y(); ++j) {
+      int bj0 = std::min(j / BrickSize, m_brickDimensions.y() - 1);
+      int bj1 = (j % BrickSize == 0 && j > 0) ? j / BrickSize - 1 : bj0;
+      for (int k = 0; k < n.z(); ++k, ++value) {
+        int bk0 = std::min(k / BrickSize, m_brickDimensions.z() - 1);
+        int bk1 = (k % BrickSize == 0 && k > 0) ? k / BrickSize - 1 : bk0;
+        for (int bi = bi1; bi <= bi0; ++bi) {
+          for (int bj = bj1; bj <= bj0; ++bj) {
+            for (int bk = bk1; bk <= bk0; ++bk) {
+              Index b = brickIndex(Vector3i(bi, bj, bk));
+              m_brickMin[b] = std::min(m_brickMin[b], *value);
+              m_brickMax[b] = std::max(m_brickMax[b], *value);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+void VolumeGeometry::updateOccupancy()
+{
+  m_occupancy.resize(m_brickMin.size());
+  if (m_transferFunction.empty()) {
+    std::fill(m_occupancy.begin(), m_occupancy.end(), 0);
+    return;
+  }
+
+  // visible[i] counts the entries with a nonzero opacity before entry i, so
+  // any range of entries is checked in constant time.
+  const int entries = static_cast<int>(m_transferFunction.size());
+  std::vector<int> visible(entries + 1, 0);
+  for (int i = 0; i < entries; ++i)
+    visible[i + 1] = visible[i] + (m_transferFunction[i][3] > 0 ? 1 : 0);
+
+  const float scale =
+    (entries - 1) / (m_transferMaximum - m_transferMinimum);
+  for (Index b = 0; b < m_occupancy.size(); ++b) {
+    // Values are interpolated between the entries around them.
+    float low = (m_brickMin[b] - m_transferMinimum) * scale;
+    float high = (m_brickMax[b] - m_transferMinimum) * scale;
+    int first = static_cast<int>(
+      std::floor(std::min(std::max(low, 0.f), entries - 1.f)));
+    int last = static_cast<int>(
+      std::ceil(std::min(std::max(high, 0.f), entries - 1.f)));
+    m_occupancy[b] = visible[last + 1] > visible[first] ? 255 : 0;
+  }
+}
+
+bool VolumeGeometry::update()
+{
+  if (!d->supported)
+    return false;
+
+  // Single channel floating point textures are core in OpenGL 3.0.
+  if (!GLEW_VERSION_3_0 && !(GLEW_ARB_texture_float && GLEW_ARB_texture_rg)) {
+    cout << "VolumeGeometry: floating point textures are not supported."
+         << endl;
+    d->supported = false;
+    return false;
+  }
+
+  if (m_valuesDirty) {
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+    if (m_dimensions.maxCoeff() > maxSize) {
+      cout << "VolumeGeometry: the volume exceeds the maximum texture size of "
+           << maxSize << "." << endl;
+      return false;
+    }
+
+    // Texture coordinates run along z, y, x to match the order of the values.
+    GLint internalFormat = m_precision == Float16 ? GL_R16F : GL_R32F;
+    if (d->volumeTexture == 0)
+      glGenTextures(1, &d->volumeTexture);
+    glBindTexture(GL_TEXTURE_3D, d->volumeTexture);
+    setTextureParameters(GL_TEXTURE_3D, GL_LINEAR);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_3D, 0, internalFormat, m_dimensions.z(),
+                 m_dimensions.y(), m_dimensions.x(), 0, GL_RED, GL_FLOAT,
+                 m_values.data());
+
+    // The brick occupancy depends on the transfer function as well, it is
+    // filled in below.
+    if (d->occupancyTexture == 0)
+      glGenTextures(1, &d->occupancyTexture);
+    glBindTexture(GL_TEXTURE_3D, d->occupancyTexture);
+    setTextureParameters(GL_TEXTURE_3D, GL_NEAREST);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R8, m_brickDimensions.z(),
+                 m_brickDimensions.y(), m_brickDimensions.x(), 0, GL_RED,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    // The bounding box of the points.
+    Vector3f size(m_spacing.cwiseProduct((m_dimensions.array() - 1)
+                                           .matrix()
+                                           .cast<float>()));
+    Core::Array<Vector3f> corners(8);
+    for (int c = 0; c < 8; ++c) {
+      corners[c] = m_min + Vector3f((c & 1) ? size.x() : 0.f,
+                                    (c & 2) ? size.y() : 0.f,
+                                    (c & 4) ? size.z() : 0.f);
+    }
+    d->vbo.upload(corners, BufferObject::ArrayBuffer);
+    d->ibo.upload(Core::Array<unsigned int>(BoxIndices, BoxIndices + 36),
+                  BufferObject::ElementArrayBuffer);
+    m_valuesDirty = false;
+    m_transferDirty = true;
+  }
+
+  if (m_transferDirty) {
+    if (d->transferTexture == 0)
+      glGenTextures(1, &d->transferTexture);
+    glBindTexture(GL_TEXTURE_1D, d->transferTexture);
+    setTextureParameters(GL_TEXTURE_1D, GL_LINEAR);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8,
+                 static_cast<GLsizei>(m_transferFunction.size()), 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, m_transferFunction.data());
+    glBindTexture(GL_TEXTURE_1D, 0);
+
+    glBindTexture(GL_TEXTURE_3D, d->occupancyTexture);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, m_brickDimensions.z(),
+                    m_brickDimensions.y(), m_brickDimensions.x(), GL_RED,
+                    GL_UNSIGNED_BYTE, m_occupancy.data());
+    glBindTexture(GL_TEXTURE_3D, 0);
+    m_transferDirty = false;
+  }
+
+  // Build and link the shader if it has not been used yet.
+  if (d->vertexShader.type() == Shader::Unknown) {
+    d->vertexShader.setType(Shader::Vertex);
+    d->vertexShader.setSource(volume_vs);
+    d->fragmentShader.setType(Shader::Fragment);
+    d->fragmentShader.setSource(volume_fs);
+    if (!d->vertexShader.compile())
+      cout << d->vertexShader.error() << endl;
+    if (!d->fragmentShader.compile())
+      cout << d->fragmentShader.error() << endl;
+    d->program.attachShader(d->vertexShader);
+    d->program.attachShader(d->fragmentShader);
+    if (!d->program.link())
+      cout << d->program.error() << endl;
+  }
+  return true;
+}
+
+void VolumeGeometry::render(const Camera& camera)
+{
+  if (m_brickDimensions.prod() == 0 || m_transferFunction.empty())
+    return;
+
+  // Upload the textures and prepare the shader program if necessary.
+  if (!update())
+    return;
+
+  // Nothing is visible through a completely transparent volume.
+  if (std::find(m_occupancy.begin(), m_occupancy.end(), 255) ==
+      m_occupancy.end()) {
+    return;
+  }
+
+  const Vector3f boxMax(
+    m_min +
+    m_spacing.cwiseProduct((m_dimensions.array() - 1).matrix().cast<float>()));
+  const Vector3f voxelScale((m_dimensions.array() - 1).cast<float>() /
+                            (boxMax - m_min).array());
+
+  // Sample often enough for the finest axis, within the fixed sample budget
+  // of the shader.
+  float sampleDistance = m_sampleDistance > 0.f
+                           ? m_sampleDistance
+                           : 0.5f * m_spacing.cwiseAbs().minCoeff();
+  sampleDistance =
+    std::max(sampleDistance, (boxMax - m_min).norm() / MaxSamples);
+
+  const Eigen::Affine3f inverseModelView(camera.modelView().inverse());
+  const Vector3f eye(inverseModelView * Vector3f::Zero());
+  const Vector3f viewDirection(
+    (inverseModelView.linear() * Vector3f(0.f, 0.f, -1.f)).normalized());
+  const bool orthographic = camera.projectionType() == Orthographic;
+
+  // The transfer function texel centers span the value range exactly.
+  const float entries = static_cast<float>(m_transferFunction.size());
+  const float transferScale =
+    (entries - 1.f) / (entries * (m_transferMaximum - m_transferMinimum));
+  const float transferOffset =
+    0.5f / entries - m_transferMinimum * transferScale;
+
+  // The opaque pass is drawn, its depth tells the rays where to stop.
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  const Vector2i viewportOrigin(viewport[0], viewport[1]);
+  const Vector2i viewportSize(viewport[2], viewport[3]);
+  glActiveTexture(GL_TEXTURE4);
+  d->copyDepth(viewportOrigin, viewportSize);
+  glActiveTexture(GL_TEXTURE0);
+  const Eigen::Matrix4f inverseModelViewProjection(
+    (camera.projection().matrix() * camera.modelView().matrix()).inverse());
+
+  if (!d->program.bind())
+    cout << d->program.error() << endl;
+
+  d->vbo.bind();
+  d->ibo.bind();
+
+  if (!d->program.enableAttributeArray("vertex"))
+    cout << d->program.error() << endl;
+  if (!d->program.useAttributeArray("vertex", 0, sizeof(Vector3f), FloatType,
+                                    3, ShaderProgram::NoNormalize)) {
+    cout << d->program.error() << endl;
+  }
+
+  // Texture unit 0 is left alone, as ShaderProgram does for its samplers.
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_3D, d->volumeTexture);
+  glActiveTexture(GL_TEXTURE2);
+  glBindTexture(GL_TEXTURE_1D, d->transferTexture);
+  glActiveTexture(GL_TEXTURE3);
+  glBindTexture(GL_TEXTURE_3D, d->occupancyTexture);
+  glActiveTexture(GL_TEXTURE0);
+
+  if (!d->program.setUniformValue("modelView", camera.modelView().matrix()))
+    cout << d->program.error() << endl;
+  if (!d->program.setUniformValue("projection", camera.projection().matrix()))
+    cout << d->program.error() << endl;
+  if (!d->program.setUniformValue("volume", 1) ||
+      !d->program.setUniformValue("transferFunction", 2) ||
+      !d->program.setUniformValue("occupancy", 3) ||
+      !d->program.setUniformValue("sceneDepth", 4)) {
+    cout << d->program.error() << endl;
+  }
+  if (!d->program.setUniformValue("inverseModelViewProjection",
+                                  inverseModelViewProjection) ||
+      !d->program.setUniformValue("viewportOrigin", viewportOrigin) ||
+      !d->program.setUniformValue("viewportSize", viewportSize)) {
+    cout << d->program.error() << endl;
+  }
+  if (!d->program.setUniformValue("eyePosition", eye) ||
+      !d->program.setUniformValue("viewDirection", viewDirection) ||
+      !d->program.setUniformValue("orthographic", orthographic ? 1 : 0)) {
+    cout << d->program.error() << endl;
+  }
+  if (!d->program.setUniformValue("boxMin", m_min) ||
+      !d->program.setUniformValue("boxMax", boxMax) ||
+      !d->program.setUniformValue("voxelScale", voxelScale)) {
+    cout << d->program.error() << endl;
+  }
+  if (!d->program.setUniformValue("dimensions",
+                                  Vector3f(m_dimensions.cast<float>())) ||
+      !d->program.setUniformValue("brickDimensions",
+                                  Vector3f(m_brickDimensions.cast<float>())) ||
+      !d->program.setUniformValue("brickSize", static_cast<float>(BrickSize))) {
+    cout << d->program.error() << endl;
+  }
+  if (!d->program.setUniformValue("transferScale", transferScale) ||
+      !d->program.setUniformValue("transferOffset", transferOffset) ||
+      !d->program.setUniformValue("sampleDistance", sampleDistance)) {
+    cout << d->program.error() << endl;
+  }
+
+  // Rays start on the front faces of the box, which also lets the opaque
+  // geometry in front of the volume hide it. From inside the box the front
+  // faces are clipped, and the back faces are drawn without depth test.
+  const float margin = 1e-3f * (boxMax - m_min).norm();
+  const bool inside = !orthographic &&
+                      (eye.array() > m_min.array() - margin).all() &&
+                      (eye.array() < boxMax.array() + margin).all();
+  GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+  GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+  glCullFace(inside ? GL_FRONT : GL_BACK);
+  if (inside)
+    glDisable(GL_DEPTH_TEST);
+  glDepthMask(GL_FALSE);
+
+  glDrawRangeElements(GL_TRIANGLES, 0, 7, 36, GL_UNSIGNED_INT,
+                      reinterpret_cast<const GLvoid*>(NULL));
+
+  glDepthMask(GL_TRUE);
+  glCullFace(GL_BACK);
+  if (!cullFace)
+    glDisable(GL_CULL_FACE);
+  if (depthTest)
+    glEnable(GL_DEPTH_TEST);
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_3D, 0);
+  glActiveTexture(GL_TEXTURE2);
+  glBindTexture(GL_TEXTURE_1D, 0);
+  glActiveTexture(GL_TEXTURE3);
+  glBindTexture(GL_TEXTURE_3D, 0);
+  glActiveTexture(GL_TEXTURE4);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+
+  d->vbo.release();
+  d->ibo.release();
+
+  d->program.disableAttributeArray("vertex");
+
+  d->program.release();
 }
 
 } // End namespace Rendering
@@ -19,25 +19,217 @@
 
 #include "drawable.h"
 
+#include <avogadro/core/array.h>
+
+#include <vector>
+
 namespace Avogadro {
 namespace Rendering {
 
 /**
  * @class VolumeGeometry volumegeometry.h <avogadro/rendering/volumegeometry.h>
  * @brief The VolumeGeometry class contains a regularly spaced volumetric data
- * set.
+ * set, rendered by ray marching on the GPU.
  * @author Marcus D. Hanwell
  *
- * @todo This is currently a stub and does nothing.
+ * The values are uploaded once as a 3D texture, in single or half precision,
+ * and mapped to colors by a transfer function while the rays are marched, so
+ * changing the view or the transfer function never touches the data again.
+ * Rays stop once they are nearly opaque. The volume is divided into bricks of
+ * BrickSize^3 points whose value range is kept, and bricks the transfer
+ * function leaves fully transparent are skipped over in one step.
+ *
+ * Since the volume is see-through it is drawn in the TranslucentPass. The
+ * depth buffer drawn so far is copied to a texture first, and rays end at
+ * the opaque geometry inside the box.
  */
 
 class AVOGADRORENDERING_EXPORT VolumeGeometry : public Drawable
 {
 public:
+  /** The precision of the values on the GPU. */
+  enum Precision
+  {
+    Float32,
+    Float16
+  };
+
+  /** The number of grid intervals along each side of a brick. */
+  static const int BrickSize = 8;
+
   VolumeGeometry();
+  VolumeGeometry(const VolumeGeometry& other);
   ~VolumeGeometry() override;
+
+  VolumeGeometry& operator=(VolumeGeometry);
+  friend void swap(VolumeGeometry& lhs, VolumeGeometry& rhs);
+
+  /**
+   * Accept a visit from our friendly visitor.
+   */
+  void accept(Visitor&) override;
+
+  /**
+   * @brief Render the volume.
+   * @param camera The current camera to be used for rendering.
+   */
+  void render(const Camera& camera) override;
+
+  /**
+   * Clear the contents of the node.
+   */
+  void clear() override;
+
+  /**
+   * Set the values of the volume.
+   * @param values The values, ordered as in Core::Cube: the last index varies
+   * fastest.
+   * @param dimensions The number of points along x, y and z. At least two
+   * points are needed along each axis to render.
+   * @param min The position of the first point.
+   * @param spacing The distance between points along each axis.
+   * @return False if the number of values does not match @a dimensions.
+   */
+  bool setData(const std::vector<double>& values, const Vector3i& dimensions,
+               const Vector3f& min, const Vector3f& spacing);
+
+  /** The number of points along each axis. */
+  Vector3i dimensions() const { return m_dimensions; }
+
+  /** The position of the first point, and the spacing between points. @{ */
+  Vector3f min() const { return m_min; }
+  Vector3f spacing() const { return m_spacing; }
+  /** @} */
+
+  /** The range of the values. @{ */
+  float minValue() const { return m_minValue; }
+  float maxValue() const { return m_maxValue; }
+  /** @} */
+
+  /**
+   * The precision of the 3D texture. Float16 halves the GPU memory, and is
+   * the default.
+   * @{
+   */
+  void setPrecision(Precision precision);
+  Precision precision() const { return m_precision; }
+  /** @} */
+
+  /**
+   * Set the transfer function. @a colors are spread evenly over the values
+   * from @a minimum to @a maximum, values outside take the color of the
+   * nearest end. The alpha component is the opacity of one Angstrom of the
+   * volume, so the image does not depend on the sample distance.
+   * @return False if @a colors is empty or @a maximum is not greater than
+   * @a minimum.
+   */
+  bool setTransferFunction(const Core::Array<Vector4ub>& colors, float minimum,
+                           float maximum);
+  const Core::Array<Vector4ub>& transferFunction() const
+  {
+    return m_transferFunction;
+  }
+  float transferMinimum() const { return m_transferMinimum; }
+  float transferMaximum() const { return m_transferMaximum; }
+
+  /**
+   * The distance in Angstrom between samples along a ray. Defaults to half of
+   * the smallest spacing of the grid. It is increased if a ray crossing the
+   * whole volume would need too many samples.
+   * @{
+   */
+  void setSampleDistance(float distance) { m_sampleDistance = distance; }
+  float sampleDistance() const { return m_sampleDistance; }
+  /** @} */
+
+  /** The number of bricks along each axis. */
+  Vector3i brickDimensions() const { return m_brickDimensions; }
+
+  /**
+   * @return True if the transfer function gives some part of @a brick a
+   * nonzero opacity.
+   */
+  bool brickOccupied(const Vector3i& brick) const;
+
+  /** @return The number of bricks that are not skipped when rendering. */
+  Index occupiedBrickCount() const;
+
+private:
+  /** Find the value range of each brick. */
+  void updateBricks();
+
+  /** Flag the bricks the current transfer function does not leave empty. */
+  void updateOccupancy();
+
+  /**
+   * @brief Upload the textures and build the shaders ready for rendering.
+   * @return False if the volume cannot be rendered.
+   */
+  bool update();
+
+  Index brickIndex(const Vector3i& brick) const
+  {
+    return (static_cast<Index>(brick.x()) * m_brickDimensions.y() +
+            brick.y()) *
+             m_brickDimensions.z() +
+           brick.z();
+  }
+
+  Core::Array<float> m_values;
+  Vector3i m_dimensions;
+  Vector3f m_min;
+  Vector3f m_spacing;
+  float m_minValue;
+  float m_maxValue;
+  Precision m_precision;
+
+  Core::Array<Vector4ub> m_transferFunction;
+  float m_transferMinimum;
+  float m_transferMaximum;
+  float m_sampleDistance;
+
+  Vector3i m_brickDimensions;
+  Core::Array<float> m_brickMin;
+  Core::Array<float> m_brickMax;
+  Core::Array<unsigned char> m_occupancy;
+
+  bool m_valuesDirty;
+  bool m_transferDirty;
+
+  class Private;
+  Private* d;
 };
 
+inline VolumeGeometry& VolumeGeometry::operator=(VolumeGeometry other)
+{
+  using std::swap;
+  swap(*this, other);
+  return *this;
+}
+
+inline void swap(VolumeGeometry& lhs, VolumeGeometry& rhs)
+{
+  using std::swap;
+  swap(static_cast<Drawable&>(lhs), static_cast<Drawable&>(rhs));
+  swap(lhs.m_values, rhs.m_values);
+  swap(lhs.m_dimensions, rhs.m_dimensions);
+  swap(lhs.m_min, rhs.m_min);
+  swap(lhs.m_spacing, rhs.m_spacing);
+  swap(lhs.m_minValue, rhs.m_minValue);
+  swap(lhs.m_maxValue, rhs.m_maxValue);
+  swap(lhs.m_precision, rhs.m_precision);
+  swap(lhs.m_transferFunction, rhs.m_transferFunction);
+  swap(lhs.m_transferMinimum, rhs.m_transferMinimum);
+  swap(lhs.m_transferMaximum, rhs.m_transferMaximum);
+  swap(lhs.m_sampleDistance, rhs.m_sampleDistance);
+  swap(lhs.m_brickDimensions, rhs.m_brickDimensions);
+  swap(lhs.m_brickMin, rhs.m_brickMin);
+  swap(lhs.m_brickMax, rhs.m_brickMax);
+  swap(lhs.m_occupancy, rhs.m_occupancy);
+  lhs.m_valuesDirty = rhs.m_valuesDirty = true;
+  lhs.m_transferDirty = rhs.m_transferDirty = true;
+}
+
 } // End namespace Rendering
 } // End namespace Avogadro
 
@@ -17,6 +17,7 @@
 #include "vtkglwidget.h"
 
 #include <avogadro/core/cube.h>
+#include <avogadro/core/mutex.h>
 #include <avogadro/qtgui/molecule.h>
 #include <avogadro/qtgui/sceneplugin.h>
 #include <avogadro/qtgui/scenepluginmodel.h>
@@ -45,8 +46,10 @@
 namespace Avogadro {
 namespace VTK {
 
-vtkVolume* cubeVolume(Core::Cube* cube)
+vtkVolume* cubeVolume(const Core::Cube* cube)
 {
+  Core::ReadLocker locker(cube->lock());
+
   qDebug() << "Cube dimensions: " << cube->dimensions().x()
            << cube->dimensions().y() << cube->dimensions().z();
 
@@ -64,7 +67,7 @@ vtkVolume* cubeVolume(Core::Cube* cube)
   data->AllocateScalars(VTK_DOUBLE, 1);
 
   double* dataPtr = static_cast<double*>(data->GetScalarPointer());
-  std::vector<double>* cubePtr = cube->data();
+  const std::vector<double>* cubePtr = cube->data();
 
   for (int i = 0; i < dim.x(); ++i)
     for (int j = 0; j < dim.y(); ++j)
@@ -177,8 +180,12 @@ void vtkGLWidget::setMolecule(QtGui::Molecule* mol)
   foreach (QtGui::ToolPlugin* tool, m_tools)
     tool->setMolecule(m_molecule);
   connect(m_molecule, SIGNAL(changed(unsigned int)), SLOT(updateScene()));
+  connect(m_molecule, SIGNAL(displacementScaleChanged(float)),
+          SLOT(updateDisplacementScale()));
   if (mol->cubeCount() > 0) {
-    vtkVolume* vol = cubeVolume(mol->cube(0));
+    // Only read the cube, so it stays shared with copies of the molecule.
+    const QtGui::Molecule* constMolecule = mol;
+    vtkVolume* vol = cubeVolume(constMolecule->cube(0));
     m_vtkRenderer->AddViewProp(vol);
   }
 }
@@ -221,6 +228,7 @@ void vtkGLWidget::updateScene()
       m_defaultTool->draw(*toolNode);
     }
 
+    m_renderer.scene().setDisplacementScale(mol->displacementScale());
     m_renderer.resetGeometry();
     update();
   }
@@ -228,6 +236,14 @@ void vtkGLWidget::updateScene()
     delete mol;
 }
 
+void vtkGLWidget::updateDisplacementScale()
+{
+  if (m_molecule) {
+    m_renderer.scene().setDisplacementScale(m_molecule->displacementScale());
+    update();
+  }
+}
+
 void vtkGLWidget::clearScene()
 {
   m_renderer.scene().clear();
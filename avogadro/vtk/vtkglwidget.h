@@ -81,6 +81,11 @@ public slots:
    */
   void updateScene();
 
+  /**
+   * Apply the molecule's displacement scale to the scene and redraw.
+   */
+  void updateDisplacementScale();
+
   /**
    * Clear the contents of the scene.
    */
@@ -0,0 +1,128 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/atomselection.h>
+#include <avogadro/core/molecule.h>
+
+using Avogadro::Index;
+using Avogadro::Core::AtomSelection;
+using Avogadro::Core::Molecule;
+
+TEST(AtomSelectionTest, setAndTest)
+{
+  AtomSelection selection(130);
+  EXPECT_EQ(selection.size(), static_cast<Index>(130));
+  EXPECT_TRUE(selection.none());
+
+  selection.set(0);
+  selection.set(64);
+  selection.set(129);
+  EXPECT_TRUE(selection.test(0));
+  EXPECT_TRUE(selection[64]);
+  EXPECT_TRUE(selection.test(129));
+  EXPECT_FALSE(selection.test(1));
+  EXPECT_FALSE(selection.test(1000));
+  EXPECT_EQ(selection.count(), static_cast<Index>(3));
+
+  selection.reset(64);
+  EXPECT_FALSE(selection.test(64));
+  EXPECT_EQ(selection.indices(), std::vector<Index>({ 0, 129 }));
+}
+
+TEST(AtomSelectionTest, ranges)
+{
+  AtomSelection selection(200);
+  selection.setRange(10, 150);
+  EXPECT_EQ(selection.count(), static_cast<Index>(140));
+  EXPECT_FALSE(selection.test(9));
+  EXPECT_TRUE(selection.test(10));
+  EXPECT_TRUE(selection.test(149));
+  EXPECT_FALSE(selection.test(150));
+
+  selection.setRange(20, 30, false);
+  EXPECT_EQ(selection.count(), static_cast<Index>(130));
+
+  // Ranges past the end are clipped.
+  selection.setRange(190, 1000);
+  EXPECT_EQ(selection.count(), static_cast<Index>(140));
+}
+
+TEST(AtomSelectionTest, invertKeepsSize)
+{
+  AtomSelection selection(70);
+  selection.set(3);
+  selection.invert();
+  EXPECT_EQ(selection.count(), static_cast<Index>(69));
+  EXPECT_FALSE(selection.test(3));
+  EXPECT_FALSE(selection.test(70));
+
+  AtomSelection all(70, true);
+  EXPECT_EQ(all.count(), static_cast<Index>(70));
+  EXPECT_EQ(~all, AtomSelection(70));
+}
+
+TEST(AtomSelectionTest, resize)
+{
+  AtomSelection selection(60, true);
+  selection.resize(100, false);
+  EXPECT_EQ(selection.count(), static_cast<Index>(60));
+  selection.resize(130, true);
+  EXPECT_EQ(selection.count(), static_cast<Index>(90));
+  selection.resize(10);
+  EXPECT_EQ(selection.count(), static_cast<Index>(10));
+  selection.resize(200);
+  EXPECT_EQ(selection.count(), static_cast<Index>(10));
+}
+
+TEST(AtomSelectionTest, setOperations)
+{
+  AtomSelection a(100);
+  AtomSelection b(150);
+  a.setRange(0, 60);
+  b.setRange(40, 120);
+
+  EXPECT_EQ((a & b).count(), static_cast<Index>(20));
+  EXPECT_EQ((a | b).count(), static_cast<Index>(120));
+  EXPECT_EQ((a ^ b).count(), static_cast<Index>(100));
+  EXPECT_EQ((a & b).size(), static_cast<Index>(150));
+
+  AtomSelection c(a);
+  c.subtract(b);
+  EXPECT_EQ(c.count(), static_cast<Index>(40));
+  EXPECT_TRUE(c.test(39));
+  EXPECT_FALSE(c.test(40));
+}
+
+TEST(AtomSelectionTest, forEach)
+{
+  AtomSelection selection(300);
+  std::vector<Index> expected = { 1, 63, 64, 65, 200, 299 };
+  for (Index i : expected)
+    selection.set(i);
+  std::vector<Index> visited;
+  selection.forEach([&visited](Index i) { visited.push_back(i); });
+  EXPECT_EQ(visited, expected);
+}
+
+TEST(AtomSelectionTest, molecule)
+{
+  Molecule molecule;
+  for (int i = 0; i < 5; ++i)
+    molecule.addAtom(6);
+  EXPECT_TRUE(molecule.isSelectionEmpty());
+
+  molecule.setAtomSelected(2, true);
+  EXPECT_FALSE(molecule.isSelectionEmpty());
+  EXPECT_TRUE(molecule.atomSelected(2));
+  EXPECT_FALSE(molecule.atomSelected(3));
+
+  AtomSelection selection(3, true);
+  molecule.setAtomSelection(selection);
+  EXPECT_EQ(molecule.atomSelection().size(), static_cast<Index>(5));
+  EXPECT_EQ(molecule.atomSelection().count(), static_cast<Index>(3));
+  EXPECT_FALSE(molecule.atomSelected(4));
+}
@@ -19,12 +19,19 @@
 #include <avogadro/core/coordinateblockgenerator.h>
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/unitcell.h>
 
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
 #include <string>
 
+using Avogadro::Index;
 using Avogadro::Core::CoordinateBlockGenerator;
 using Avogadro::Core::Elements;
 using Avogadro::Core::Molecule;
+using Avogadro::Core::UnitCell;
 using Avogadro::Vector3;
 
 namespace {
@@ -150,6 +157,23 @@ const std::string refCoordBlock(
     "118 117 117.0 Ts  Tennessine      54.638747   81.514831  108.390735 0 1   0 1\n"
     "119 118 118.0 Og  Oganesson       55.082016   82.168070  109.253941 0 1   0 1\n"
     );
+
+// Coordinates covering signs, rounding and large magnitudes.
+Molecule createMolecule(Index atomCount)
+{
+  const double special[] = { 0.0,         -0.0,       -1e-9,  0.0000005,
+                             -2.5e-7,     1.9999995, 1e10,   -123456.7890125,
+                             999999.9999995 };
+  Molecule molecule;
+  for (Index i = 0; i < atomCount; ++i) {
+    double x = special[i % 9];
+    double y = static_cast<double>(i) * 0.001234567 - 50.0;
+    double z = std::sin(static_cast<double>(i)) * 1000.0;
+    molecule.addAtom(static_cast<unsigned char>(1 + i % 20))
+      .setPosition3d(Vector3(x, y, z));
+  }
+  return molecule;
+}
 } // end anon namespace
 
 TEST(CoordinateBlockGeneratorTest, generateCoordinateBlock)
@@ -167,3 +191,91 @@ TEST(CoordinateBlockGeneratorTest, generateCoordinateBlock)
 
   EXPECT_EQ(refCoordBlock, gen.generateCoordinateBlock());
 }
+
+TEST(CoordinateBlockGeneratorTest, threads)
+{
+  Molecule molecule = createMolecule(2000);
+  CoordinateBlockGenerator gen;
+  gen.setMolecule(&molecule);
+  gen.setSpecification("#Sxyz_");
+
+  // The index column is as wide as the largest index.
+  std::string expected;
+  char line[256];
+  for (Index i = 0; i < molecule.atomCount(); ++i) {
+    const Vector3& pos = molecule.atomPosition3d(i);
+    std::snprintf(line, sizeof(line), "%-4d %-3s %11.6f %11.6f %11.6f  \n",
+                  static_cast<int>(i + 1),
+                  Elements::symbol(molecule.atomicNumber(i)), pos.x(),
+                  pos.y(), pos.z());
+    expected += line;
+  }
+
+  // Chunks that split the molecule unevenly must join up to the same block
+  // as the serial path, whatever the hardware.
+  gen.setThreadCount(1);
+  EXPECT_EQ(expected, gen.generateCoordinateBlock());
+  const unsigned int counts[] = { 2, 3, 7, 5000 };
+  for (unsigned int threads : counts) {
+    gen.setThreadCount(threads);
+    EXPECT_EQ(expected, gen.generateCoordinateBlock()) << threads;
+  }
+
+  // All fields, including the atom counters.
+  gen.setSpecification("#ZGSNxyz01__01");
+  gen.setThreadCount(1);
+  std::string serial = gen.generateCoordinateBlock();
+  gen.setThreadCount(3);
+  EXPECT_EQ(serial, gen.generateCoordinateBlock());
+}
+
+// Times the block of a molecule large enough to be formatted on several
+// threads. Run it with
+// --gtest_also_run_disabled_tests --gtest_filter=CoordinateBlockGeneratorTest.*
+TEST(CoordinateBlockGeneratorTest, DISABLED_largeMolecule)
+{
+  const Index atomCount = 1000000;
+  Molecule molecule = createMolecule(atomCount);
+  CoordinateBlockGenerator gen;
+  gen.setMolecule(&molecule);
+  gen.setSpecification("#Sxyz_");
+
+  typedef std::chrono::steady_clock Clock;
+  gen.setThreadCount(1);
+  Clock::time_point start = Clock::now();
+  std::string serial = gen.generateCoordinateBlock();
+  double serialTime =
+    std::chrono::duration<double>(Clock::now() - start).count();
+
+  gen.setThreadCount(0);
+  start = Clock::now();
+  std::string block = gen.generateCoordinateBlock();
+  double time = std::chrono::duration<double>(Clock::now() - start).count();
+  EXPECT_EQ(serial, block);
+
+  std::cout << atomCount << " atoms\n"
+            << "  one thread: " << serialTime * 1000.0 << " ms\n"
+            << "  automatic:  " << time * 1000.0 << " ms" << std::endl;
+}
+
+TEST(CoordinateBlockGeneratorTest, fractionalCoordinates)
+{
+  Molecule molecule;
+  molecule.addAtom(6).setPosition3d(Vector3(1.0, 2.0, 3.0));
+  molecule.addAtom(8).setPosition3d(Vector3(-1.0, 0.5, 0.0));
+
+  CoordinateBlockGenerator gen;
+  gen.setMolecule(&molecule);
+  gen.setSpecification("Sabc");
+  EXPECT_EQ("C           N/A         N/A         N/A\n"
+            "O           N/A         N/A         N/A\n",
+            gen.generateCoordinateBlock());
+
+  molecule.setUnitCell(new UnitCell(Vector3(4.0, 0.0, 0.0),
+                                    Vector3(0.0, 4.0, 0.0),
+                                    Vector3(0.0, 0.0, 6.0)));
+  gen.setDistanceUnit(CoordinateBlockGenerator::Bohr);
+  EXPECT_EQ("C      0.250000    0.500000    0.500000\n"
+            "O     -0.250000    0.125000    0.000000\n",
+            gen.generateCoordinateBlock());
+}
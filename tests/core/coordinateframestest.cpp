@@ -0,0 +1,142 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/coordinateframes.h>
+#include <avogadro/core/molecule.h>
+
+#include <cmath>
+
+using Avogadro::Index;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::CoordinateFrames;
+using Avogadro::Core::Molecule;
+
+namespace {
+// A chain of atoms drifting slowly, like consecutive frames of a trajectory.
+Array<Vector3> trajectoryFrame(Index atoms, Index frame)
+{
+  Array<Vector3> positions(atoms);
+  for (Index i = 0; i < atoms; ++i) {
+    Real t = 0.05 * static_cast<Real>(frame) + 0.3 * static_cast<Real>(i);
+    positions[i] =
+      Vector3(1.5 * i + 0.2 * std::sin(t), 0.4 * std::cos(t), -0.1 * i);
+  }
+  return positions;
+}
+
+Real maxDeviation(const Array<Vector3>& a, const Array<Vector3>& b)
+{
+  EXPECT_EQ(a.size(), b.size());
+  Real deviation = 0.0;
+  for (Index i = 0; i < a.size() && i < b.size(); ++i)
+    deviation = std::max(deviation, (a[i] - b[i]).cwiseAbs().maxCoeff());
+  return deviation;
+}
+} // namespace
+
+TEST(CoordinateFramesTest, uncompressed)
+{
+  CoordinateFrames frames;
+  EXPECT_EQ(frames.compression(), CoordinateFrames::None);
+  frames.setFrame(2, trajectoryFrame(10, 2));
+  EXPECT_EQ(frames.size(), static_cast<Index>(3));
+  EXPECT_TRUE(frames.frame(0).empty());
+  EXPECT_EQ(maxDeviation(frames.frame(2), trajectoryFrame(10, 2)), 0.0);
+}
+
+TEST(CoordinateFramesTest, singlePrecision)
+{
+  CoordinateFrames frames;
+  ASSERT_TRUE(frames.setCompression(CoordinateFrames::SinglePrecision));
+  for (Index f = 0; f < 5; ++f)
+    frames.setFrame(f, trajectoryFrame(100, f));
+  for (Index f = 0; f < 5; ++f)
+    EXPECT_LT(maxDeviation(frames.frame(f), trajectoryFrame(100, f)), 1e-5);
+}
+
+TEST(CoordinateFramesTest, quantized)
+{
+  const Index atoms = 500;
+  const Index count = 40;
+  CoordinateFrames frames;
+  ASSERT_TRUE(frames.setCompression(CoordinateFrames::Quantized, 0.001));
+  for (Index f = 0; f < count; ++f)
+    frames.setFrame(f, trajectoryFrame(atoms, f));
+
+  Array<Vector3> positions;
+  for (Index f = 0; f < count; ++f) {
+    frames.frame(f, positions);
+    EXPECT_LE(maxDeviation(positions, trajectoryFrame(atoms, f)), 0.0005);
+  }
+
+  // Deltas of a few milli-Angstrom fit in one or two bytes per coordinate.
+  Index uncompressed = atoms * count * sizeof(Vector3);
+  EXPECT_LT(frames.memoryUsage(), uncompressed / 4);
+}
+
+TEST(CoordinateFramesTest, replaceReferenceFrame)
+{
+  CoordinateFrames frames;
+  frames.setCompression(CoordinateFrames::Quantized, 0.01);
+  for (Index f = 0; f < 20; ++f)
+    frames.setFrame(f, trajectoryFrame(30, f));
+
+  // Frames of the first block may be stored relative to frame 0, they must
+  // survive it being replaced.
+  Array<Vector3> shifted = trajectoryFrame(30, 0);
+  for (Index i = 0; i < shifted.size(); ++i)
+    shifted[i] += Vector3(5.0, -3.0, 2.0);
+  frames.setFrame(0, shifted);
+
+  EXPECT_LE(maxDeviation(frames.frame(0), shifted), 0.005);
+  for (Index f = 1; f < 20; ++f)
+    EXPECT_LE(maxDeviation(frames.frame(f), trajectoryFrame(30, f)), 0.005);
+
+  // Frames of a different size fall back to per-frame deltas.
+  frames.setFrame(3, trajectoryFrame(7, 3));
+  EXPECT_LE(maxDeviation(frames.frame(3), trajectoryFrame(7, 3)), 0.005);
+}
+
+TEST(CoordinateFramesTest, convert)
+{
+  CoordinateFrames frames;
+  for (Index f = 0; f < 20; ++f)
+    frames.setFrame(f, trajectoryFrame(50, f));
+  Index uncompressed = frames.memoryUsage();
+
+  EXPECT_FALSE(frames.setCompression(CoordinateFrames::Quantized, 0.0));
+  EXPECT_EQ(frames.compression(), CoordinateFrames::None);
+
+  ASSERT_TRUE(frames.setCompression(CoordinateFrames::Quantized, 0.001));
+  EXPECT_LT(frames.memoryUsage(), uncompressed);
+  ASSERT_TRUE(frames.setCompression(CoordinateFrames::SinglePrecision));
+  ASSERT_TRUE(frames.setCompression(CoordinateFrames::None));
+  EXPECT_EQ(frames.size(), static_cast<Index>(20));
+  for (Index f = 0; f < 20; ++f)
+    EXPECT_LE(maxDeviation(frames.frame(f), trajectoryFrame(50, f)), 0.0005);
+}
+
+TEST(CoordinateFramesTest, molecule)
+{
+  Molecule molecule;
+  for (int i = 0; i < 10; ++i)
+    molecule.addAtom(6);
+  molecule.setCoordinate3dCompression(CoordinateFrames::Quantized, 0.001);
+  for (int f = 0; f < 3; ++f)
+    molecule.setCoordinate3d(trajectoryFrame(10, f), f);
+  EXPECT_EQ(molecule.coordinate3dCount(), 3);
+
+  Molecule copy(molecule);
+  EXPECT_TRUE(copy.setCoordinate3d(2));
+  EXPECT_LE(maxDeviation(copy.atomPositions3d(), trajectoryFrame(10, 2)),
+            0.0005);
+  EXPECT_EQ(copy.coordinateFrames().compression(),
+            CoordinateFrames::Quantized);
+  EXPECT_FALSE(copy.setCoordinate3d(3));
+}
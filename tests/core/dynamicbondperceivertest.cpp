@@ -0,0 +1,156 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/dynamicbondperceiver.h>
+#include <avogadro/core/molecule.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+using Avogadro::Index;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::DynamicBondPerceiver;
+using Avogadro::Core::Molecule;
+
+namespace {
+Real jitter(Real amount)
+{
+  return amount * (2.0 * std::rand() / static_cast<Real>(RAND_MAX) - 1.0);
+}
+
+// A loose lattice of carbon, oxygen and hydrogen atoms where many pairs are
+// close to their bond cutoff.
+Molecule lattice()
+{
+  std::srand(7);
+  const unsigned char elements[] = { 6, 1, 8, 1, 6 };
+  Molecule mol;
+  for (int x = 0; x < 8; ++x) {
+    for (int y = 0; y < 8; ++y) {
+      for (int z = 0; z < 8; ++z) {
+        Vector3 pos(1.45 * x + jitter(0.2), 1.45 * y + jitter(0.2),
+                    1.45 * z + jitter(0.2));
+        mol.addAtom(elements[(x + y + z) % 5]).setPosition3d(pos);
+      }
+    }
+  }
+  return mol;
+}
+
+Array<std::pair<Index, Index>> sortedBonds(const Molecule& mol)
+{
+  Array<std::pair<Index, Index>> pairs = mol.bondPairs();
+  std::sort(pairs.begin(), pairs.end());
+  return pairs;
+}
+
+Array<std::pair<Index, Index>> referenceBonds(const Molecule& mol)
+{
+  Molecule copy(mol);
+  copy.clearBonds();
+  copy.perceiveBondsSimple();
+  return sortedBonds(copy);
+}
+} // namespace
+
+TEST(DynamicBondPerceiverTest, matchesSimplePerception)
+{
+  Molecule mol = lattice();
+  DynamicBondPerceiver perceiver;
+  EXPECT_TRUE(perceiver.update(mol));
+  EXPECT_EQ(sortedBonds(mol), referenceBonds(mol));
+
+  for (int frame = 0; frame < 20; ++frame) {
+    Array<Vector3> positions = mol.atomPositions3d();
+    for (Index i = 0; i < positions.size(); ++i)
+      positions[i] += Vector3(jitter(0.03), jitter(0.03), jitter(0.03));
+    mol.setAtomPositions3d(positions);
+    perceiver.update(mol);
+    ASSERT_EQ(sortedBonds(mol), referenceBonds(mol)) << "frame " << frame;
+    for (Index b = 0; b < mol.bondCount(); ++b)
+      EXPECT_EQ(mol.bondOrder(b), 1);
+  }
+
+  // Small motions are handled with only a few rebuilds of the pair list.
+  EXPECT_LT(perceiver.rebuildCount(), 10u);
+
+  // Unchanged positions leave the bonds alone.
+  EXPECT_FALSE(perceiver.update(mol));
+}
+
+TEST(DynamicBondPerceiverTest, largeMoves)
+{
+  Molecule mol = lattice();
+  DynamicBondPerceiver perceiver;
+  perceiver.update(mol);
+  Index rebuilds = perceiver.rebuildCount();
+
+  // Squeeze the lattice, which brings new pairs within bonding distance.
+  Array<Vector3> positions = mol.atomPositions3d();
+  for (Index i = 0; i < positions.size(); ++i)
+    positions[i] *= 0.8;
+  mol.setAtomPositions3d(positions);
+  EXPECT_TRUE(perceiver.update(mol));
+  EXPECT_GT(perceiver.rebuildCount(), rebuilds);
+  EXPECT_EQ(sortedBonds(mol), referenceBonds(mol));
+}
+
+TEST(DynamicBondPerceiverTest, externalChanges)
+{
+  Molecule mol = lattice();
+  DynamicBondPerceiver perceiver;
+  perceiver.update(mol);
+  Array<std::pair<Index, Index>> expected = sortedBonds(mol);
+  ASSERT_GT(mol.bondCount(), 2u);
+
+  // Bonds edited behind the perceiver's back are perceived again.
+  mol.addBond(0, mol.atomCount() - 1, 2);
+  mol.setBondOrder(0, 3);
+  mol.removeBond(1);
+  EXPECT_TRUE(perceiver.update(mol));
+  EXPECT_EQ(sortedBonds(mol), expected);
+  for (Index b = 0; b < mol.bondCount(); ++b)
+    EXPECT_EQ(mol.bondOrder(b), 1);
+
+  mol.clearBonds();
+  EXPECT_TRUE(perceiver.update(mol));
+  EXPECT_EQ(sortedBonds(mol), expected);
+}
+
+TEST(DynamicBondPerceiverTest, adoptBonds)
+{
+  // One perceiver works ahead on a copy, as the player's prefetcher does, and
+  // its bonds are copied into the molecule the other one keeps updating.
+  Molecule mol = lattice();
+  Molecule ahead(mol);
+  DynamicBondPerceiver perceiver;
+  DynamicBondPerceiver prefetcher;
+  perceiver.update(mol);
+
+  for (int frame = 0; frame < 20; ++frame) {
+    Array<Vector3> positions = mol.atomPositions3d();
+    for (Index i = 0; i < positions.size(); ++i)
+      positions[i] += Vector3(jitter(0.03), jitter(0.03), jitter(0.03));
+    mol.setAtomPositions3d(positions);
+
+    if (frame % 3 != 2) {
+      ahead.setAtomPositions3d(positions);
+      prefetcher.update(ahead);
+      mol.clearBonds();
+      mol.addBonds(ahead.bondPairs());
+      perceiver.adoptBonds(mol);
+    } else {
+      perceiver.update(mol);
+    }
+    ASSERT_EQ(sortedBonds(mol), referenceBonds(mol)) << "frame " << frame;
+  }
+
+  // Adopted bonds are left as they are.
+  EXPECT_FALSE(perceiver.update(mol));
+}
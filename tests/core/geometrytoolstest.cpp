@@ -0,0 +1,222 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/geometrytools.h>
+#include <avogadro/core/unitcell.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using Avogadro::Real;
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::DEG_TO_RAD;
+using Avogadro::Core::Array;
+using Avogadro::Core::GeometryTools;
+using Avogadro::Core::UnitCell;
+
+namespace {
+Array<Vector3> randomPositions(Index count, Real extent)
+{
+  std::srand(42);
+  Array<Vector3> positions;
+  for (Index i = 0; i < count; ++i) {
+    positions.push_back(Vector3(std::rand(), std::rand(), std::rand()) *
+                        (extent / RAND_MAX));
+  }
+  return positions;
+}
+
+UnitCell triclinicCell()
+{
+  UnitCell cell;
+  cell.setCellParameters(7.5, 9.0, 11.0, 80.0 * DEG_TO_RAD, 95.0 * DEG_TO_RAD,
+                         105.0 * DEG_TO_RAD);
+  return cell;
+}
+
+Array<std::pair<Index, Index>> allPairs(Index count)
+{
+  Array<std::pair<Index, Index>> pairs;
+  for (Index i = 0; i < count; ++i)
+    for (Index j = i + 1; j < count; ++j)
+      pairs.push_back(std::make_pair(i, j));
+  return pairs;
+}
+} // namespace
+
+TEST(GeometryToolsTest, structureOfArrays)
+{
+  Array<Vector3> positions = randomPositions(10, 5.0);
+  GeometryTools::Positions soa = GeometryTools::toStructureOfArrays(positions);
+  ASSERT_EQ(soa.cols(), 10);
+  for (Index i = 0; i < positions.size(); ++i) {
+    EXPECT_EQ(soa(0, i), positions[i].x());
+    EXPECT_EQ(soa(1, i), positions[i].y());
+    EXPECT_EQ(soa(2, i), positions[i].z());
+  }
+}
+
+TEST(GeometryToolsTest, distances)
+{
+  Array<Vector3> positions = randomPositions(37, 10.0);
+  GeometryTools::Positions soa = GeometryTools::toStructureOfArrays(positions);
+
+  Vector3 point(1.0, 2.0, 3.0);
+  GeometryTools::Values toPoint = GeometryTools::distances(soa, point);
+  ASSERT_EQ(toPoint.size(), 37);
+  for (Index i = 0; i < positions.size(); ++i)
+    EXPECT_NEAR(toPoint[i], (positions[i] - point).norm(), 1e-5);
+
+  Array<std::pair<Index, Index>> pairs = allPairs(positions.size());
+  GeometryTools::Values pairDistances = GeometryTools::distances(soa, pairs);
+  ASSERT_EQ(static_cast<Index>(pairDistances.size()), pairs.size());
+  for (Index k = 0; k < pairs.size(); ++k) {
+    Real expected = (positions[pairs[k].first] - positions[pairs[k].second])
+                      .norm();
+    EXPECT_NEAR(pairDistances[k], expected, 1e-5);
+  }
+}
+
+TEST(GeometryToolsTest, periodicDistances)
+{
+  UnitCell cell = triclinicCell();
+  Array<Vector3> positions = randomPositions(37, 20.0);
+  GeometryTools::Positions soa = GeometryTools::toStructureOfArrays(positions);
+
+  Vector3 point(1.0, 2.0, 3.0);
+  GeometryTools::Values toPoint = GeometryTools::distances(soa, point, cell);
+  for (Index i = 0; i < positions.size(); ++i)
+    EXPECT_NEAR(toPoint[i], cell.distance(positions[i], point), 1e-4);
+
+  Array<std::pair<Index, Index>> pairs = allPairs(positions.size());
+  GeometryTools::Values pairDistances =
+    GeometryTools::distances(soa, pairs, cell);
+  for (Index k = 0; k < pairs.size(); ++k) {
+    Real expected = cell.distance(positions[pairs[k].first],
+                                  positions[pairs[k].second]);
+    EXPECT_NEAR(pairDistances[k], expected, 1e-4);
+  }
+}
+
+TEST(GeometryToolsTest, distanceMatrix)
+{
+  // More rows than one block, so the block boundaries are exercised.
+  Array<Vector3> a = randomPositions(300, 10.0);
+  Array<Vector3> b = randomPositions(7, 10.0);
+  GeometryTools::Positions soaA = GeometryTools::toStructureOfArrays(a);
+  GeometryTools::Positions soaB = GeometryTools::toStructureOfArrays(b);
+
+  GeometryTools::DistanceMatrix matrix =
+    GeometryTools::distanceMatrix(soaA, soaB);
+  ASSERT_EQ(matrix.rows(), 300);
+  ASSERT_EQ(matrix.cols(), 7);
+  for (Index i = 0; i < a.size(); ++i)
+    for (Index j = 0; j < b.size(); ++j)
+      EXPECT_NEAR(matrix(i, j), (a[i] - b[j]).norm(), 1e-5);
+
+  UnitCell cell = triclinicCell();
+  GeometryTools::DistanceMatrix periodic =
+    GeometryTools::distanceMatrix(soaA, soaB, cell);
+  for (Index i = 0; i < a.size(); ++i)
+    for (Index j = 0; j < b.size(); ++j)
+      EXPECT_NEAR(periodic(i, j), cell.distance(a[i], b[j]), 1e-4);
+}
+
+TEST(GeometryToolsTest, angles)
+{
+  Array<Vector3> positions;
+  positions.push_back(Vector3(1.0, 0.0, 0.0));
+  positions.push_back(Vector3(0.0, 0.0, 0.0));
+  positions.push_back(Vector3(0.0, 2.0, 0.0));
+  positions.push_back(Vector3(-3.0, 0.0, 0.0));
+  positions.push_back(Vector3(1.0, 1.0, 0.0));
+  GeometryTools::Positions soa = GeometryTools::toStructureOfArrays(positions);
+
+  Array<std::array<Index, 3>> triples;
+  triples.push_back({ { 0, 1, 2 } });
+  triples.push_back({ { 0, 1, 3 } });
+  triples.push_back({ { 0, 1, 4 } });
+  triples.push_back({ { 0, 1, 0 } });
+  GeometryTools::Values angles = GeometryTools::angles(soa, triples);
+  ASSERT_EQ(angles.size(), 4);
+  EXPECT_NEAR(angles[0], 90.0, 1e-4);
+  EXPECT_NEAR(angles[1], 180.0, 1e-4);
+  EXPECT_NEAR(angles[2], 45.0, 1e-4);
+  EXPECT_NEAR(angles[3], 0.0, 1e-4);
+}
+
+TEST(GeometryToolsTest, dihedrals)
+{
+  Array<Vector3> positions;
+  positions.push_back(Vector3(1.0, 0.0, 0.0));
+  positions.push_back(Vector3(0.0, 0.0, 0.0));
+  positions.push_back(Vector3(0.0, 0.0, 1.5));
+  positions.push_back(Vector3(1.0, 0.0, 1.5));
+  positions.push_back(Vector3(0.0, 1.0, 1.5));
+  positions.push_back(Vector3(-1.0, 0.0, 1.5));
+  positions.push_back(Vector3(0.0, -1.0, 1.5));
+  GeometryTools::Positions soa = GeometryTools::toStructureOfArrays(positions);
+
+  Array<std::array<Index, 4>> quadruples;
+  for (Index last = 3; last < 7; ++last)
+    quadruples.push_back({ { 0, 1, 2, last } });
+  GeometryTools::Values dihedrals = GeometryTools::dihedrals(soa, quadruples);
+  ASSERT_EQ(dihedrals.size(), 4);
+  EXPECT_NEAR(dihedrals[0], 0.0, 1e-4);
+  EXPECT_NEAR(dihedrals[1], 90.0, 1e-4);
+  EXPECT_NEAR(std::abs(dihedrals[2]), 180.0, 1e-4);
+  EXPECT_NEAR(dihedrals[3], -90.0, 1e-4);
+}
+
+// Compares the batched kernels with a loop over Vector3 pairs. Run it with
+// --gtest_also_run_disabled_tests --gtest_filter=GeometryToolsTest.*
+TEST(GeometryToolsTest, DISABLED_benchmark)
+{
+  typedef std::chrono::steady_clock Clock;
+  const int repeats = 3;
+  UnitCell cell = triclinicCell();
+  Array<Vector3> positions = randomPositions(1000, 30.0);
+  GeometryTools::Positions soa = GeometryTools::toStructureOfArrays(positions);
+  const Index n = positions.size();
+
+  Real checksum = 0.0;
+  Clock::time_point start = Clock::now();
+  for (int r = 0; r < repeats; ++r)
+    for (Index i = 0; i < n; ++i)
+      for (Index j = 0; j < n; ++j)
+        checksum += (positions[i] - positions[j]).norm();
+  double loop = std::chrono::duration<double>(Clock::now() - start).count();
+
+  start = Clock::now();
+  for (int r = 0; r < repeats; ++r)
+    checksum -= GeometryTools::distanceMatrix(soa, soa).sum();
+  double batched = std::chrono::duration<double>(Clock::now() - start).count();
+
+  start = Clock::now();
+  for (int r = 0; r < repeats; ++r)
+    for (Index i = 0; i < n; ++i)
+      for (Index j = 0; j < n; ++j)
+        checksum += cell.distance(positions[i], positions[j]);
+  double periodicLoop =
+    std::chrono::duration<double>(Clock::now() - start).count();
+
+  start = Clock::now();
+  for (int r = 0; r < repeats; ++r)
+    checksum -= GeometryTools::distanceMatrix(soa, soa, cell).sum();
+  double periodicBatched =
+    std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::cout << n << "x" << n << " distances, " << repeats << " repeats\n"
+            << "  loop:             " << loop << " s\n"
+            << "  batched:          " << batched << " s\n"
+            << "  periodic loop:    " << periodicLoop << " s\n"
+            << "  periodic batched: " << periodicBatched << " s\n"
+            << "  checksum:         " << checksum << std::endl;
+}
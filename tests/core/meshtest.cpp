@@ -21,6 +21,7 @@
 #include <avogadro/core/mesh.h>
 #include <avogadro/core/vector.h>
 
+using Avogadro::Index;
 using Avogadro::Vector3f;
 using Avogadro::Core::Array;
 using Avogadro::Core::Color3f;
@@ -97,3 +98,25 @@ TEST_F(MeshTest, assigment)
   assertEquals(m_testMesh, assign);
   EXPECT_NE(m_testMesh.lock(), assign.lock());
 }
+
+TEST_F(MeshTest, revision)
+{
+  Mesh copy(m_testMesh);
+  EXPECT_EQ(m_testMesh.revision(), copy.revision());
+
+  Mesh other;
+  EXPECT_NE(m_testMesh.revision(), other.revision());
+  other = m_testMesh;
+  EXPECT_EQ(m_testMesh.revision(), other.revision());
+
+  // Every change gives a new revision, not used by any other mesh.
+  Array<Vector3f> vertices(3, Vector3f::Zero());
+  copy.addVertices(vertices);
+  EXPECT_NE(m_testMesh.revision(), copy.revision());
+  Index added = copy.revision();
+  other.setNormals(vertices);
+  EXPECT_NE(m_testMesh.revision(), other.revision());
+  EXPECT_NE(added, other.revision());
+  other.clear();
+  EXPECT_NE(added, other.revision());
+}
@@ -20,6 +20,7 @@
 
 #include <avogadro/core/array.h>
 #include <avogadro/core/color3f.h>
+#include <avogadro/core/cube.h>
 #include <avogadro/core/mesh.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/vector.h>
@@ -28,10 +29,13 @@ using Avogadro::Index;
 using Avogadro::Vector2;
 using Avogadro::Vector3;
 using Avogadro::Vector3f;
+using Avogadro::Vector3i;
 using Avogadro::Core::Array;
 using Avogadro::Core::Atom;
+using Avogadro::Core::AtomSelection;
 using Avogadro::Core::Bond;
 using Avogadro::Core::Color3f;
+using Avogadro::Core::Cube;
 using Avogadro::Core::Mesh;
 using Avogadro::Core::Molecule;
 using Avogadro::Core::Variant;
@@ -177,6 +181,27 @@ TEST_F(MoleculeTest, addBond)
   EXPECT_EQ(bond.atom2().index(), c.index());
 }
 
+TEST_F(MoleculeTest, addBonds)
+{
+  Molecule molecule;
+  molecule.addAtom(6);
+  molecule.addAtom(6);
+  molecule.addAtom(8);
+  molecule.addBond(0, 1);
+
+  Array<std::pair<Index, Index>> pairs;
+  pairs.push_back(std::make_pair(2, 1));
+  pairs.push_back(std::make_pair(0, 2));
+  molecule.addBonds(pairs, 2);
+
+  EXPECT_EQ(3, molecule.bondCount());
+  EXPECT_TRUE(molecule.bond(1, 2).isValid());
+  EXPECT_TRUE(molecule.bond(0, 2).isValid());
+  EXPECT_EQ(1, molecule.bond(1, 2).atom1().index());
+  EXPECT_EQ(2, molecule.bond(0, 2).order());
+  EXPECT_EQ(1, molecule.bond(0, 1).order());
+}
+
 TEST_F(MoleculeTest, removeBond)
 {
   Molecule molecule;
@@ -282,3 +307,85 @@ TEST_F(MoleculeTest, assignment)
 
   assertEqual(m_testMolecule, assign);
 }
+
+TEST_F(MoleculeTest, sharedCubesAndMeshes)
+{
+  Molecule molecule(m_testMolecule);
+  Cube* cube = molecule.addCube();
+  cube->setLimits(Vector3::Zero(), Vector3i(2, 2, 2), 1.0);
+  cube->setValue(0, 0, 0, 1.0);
+
+  // Copies share the objects until one of them is modified.
+  Molecule copy(molecule);
+  const Molecule& constMolecule = molecule;
+  const Molecule& constCopy = copy;
+  EXPECT_EQ(constMolecule.cube(0), constCopy.cube(0));
+  EXPECT_EQ(constMolecule.mesh(0), constCopy.mesh(0));
+
+  Cube* copyCube = copy.cube(0);
+  EXPECT_NE(copyCube, constMolecule.cube(0));
+  copyCube->setValue(0, 0, 0, 2.0);
+  EXPECT_EQ(constMolecule.cube(0)->value(0, 0, 0), 1.0);
+  EXPECT_EQ(constCopy.cube(0)->value(0, 0, 0), 2.0);
+  EXPECT_NE(constMolecule.cube(0)->lock(), constCopy.cube(0)->lock());
+
+  // The mesh is still shared, and unshared objects are not copied again.
+  EXPECT_EQ(constMolecule.mesh(0), constCopy.mesh(0));
+  EXPECT_EQ(copy.cube(0), copyCube);
+
+  copy.mesh(0)->setName("changed");
+  EXPECT_EQ(constMolecule.mesh(0)->name(), "testmesh");
+  EXPECT_EQ(constCopy.mesh(0)->name(), "changed");
+
+  // Assignment shares as well, and releases the previous objects.
+  copy = molecule;
+  EXPECT_EQ(constCopy.cube(0), constMolecule.cube(0));
+  EXPECT_EQ(constCopy.mesh(0)->name(), "testmesh");
+}
+
+TEST_F(MoleculeTest, vibrationDisplacements)
+{
+  Molecule molecule;
+  molecule.addAtom(8);
+  molecule.addAtom(1);
+  EXPECT_TRUE(molecule.vibrationDisplacements().empty());
+
+  Array<Vector3> displacements;
+  displacements.push_back(Vector3(0.0, 0.1, 0.0));
+  displacements.push_back(Vector3(0.0, -0.2, 0.3));
+  molecule.setVibrationDisplacements(displacements);
+  ASSERT_EQ(molecule.vibrationDisplacements().size(), 2);
+
+  Molecule copy(molecule);
+  ASSERT_EQ(copy.vibrationDisplacements().size(), 2);
+  EXPECT_TRUE(copy.vibrationDisplacements()[1].isApprox(displacements[1]));
+
+  molecule.setVibrationDisplacements(Array<Vector3>());
+  EXPECT_TRUE(molecule.vibrationDisplacements().empty());
+}
+
+TEST_F(MoleculeTest, invertAtomSelection)
+{
+  Molecule molecule;
+  molecule.addAtom(6);
+  molecule.addAtom(1);
+  molecule.addAtom(1);
+
+  // A selection that was never touched inverts to every atom.
+  molecule.invertAtomSelection();
+  EXPECT_EQ(molecule.atomSelection().count(), 3);
+  for (Index i = 0; i < molecule.atomCount(); ++i)
+    EXPECT_TRUE(molecule.atomSelected(i));
+
+  // Atoms added after the selection was made are unselected, and must be
+  // selected once the selection is inverted.
+  molecule.setAtomSelection(AtomSelection(molecule.atomCount()));
+  molecule.setAtomSelected(0, true);
+  molecule.addAtom(8);
+  molecule.addAtom(1);
+  molecule.invertAtomSelection();
+  EXPECT_EQ(molecule.atomSelection().size(), 5);
+  EXPECT_FALSE(molecule.atomSelected(0));
+  for (Index i = 1; i < molecule.atomCount(); ++i)
+    EXPECT_TRUE(molecule.atomSelected(i)) << "atom " << i;
+}
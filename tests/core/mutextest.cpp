@@ -18,7 +18,13 @@
 
 #include <avogadro/core/mutex.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 using Avogadro::Core::Mutex;
+using Avogadro::Core::ReadLocker;
+using Avogadro::Core::WriteLocker;
 
 TEST(MutexTest, lock)
 {
@@ -47,3 +53,76 @@ TEST(MutexText, tryLock)
 
   EXPECT_EQ(array[4], 2);
 }
+
+TEST(MutexTest, sharedLock)
+{
+  Mutex mutex;
+
+  // Any number of shared locks can be held together, but they exclude an
+  // exclusive lock.
+  mutex.lockShared();
+  EXPECT_TRUE(mutex.tryLockShared());
+  EXPECT_FALSE(mutex.tryLock());
+  mutex.unlockShared();
+  EXPECT_FALSE(mutex.tryLock());
+  mutex.unlockShared();
+
+  EXPECT_TRUE(mutex.tryLock());
+  EXPECT_FALSE(mutex.tryLockShared());
+  mutex.unlock();
+  EXPECT_TRUE(mutex.tryLockShared());
+  mutex.unlockShared();
+}
+
+TEST(MutexTest, lockers)
+{
+  Mutex mutex;
+  {
+    ReadLocker first(&mutex);
+    ReadLocker second(&mutex);
+    EXPECT_FALSE(mutex.tryLock());
+  }
+  {
+    WriteLocker locker(&mutex);
+    EXPECT_FALSE(mutex.tryLockShared());
+  }
+  EXPECT_TRUE(mutex.tryLock());
+  mutex.unlock();
+}
+
+TEST(MutexTest, writerWaitsForReaders)
+{
+  Mutex mutex;
+  std::atomic<int> readersDone(0);
+  std::atomic<bool> written(false);
+
+  mutex.lockShared();
+  std::thread writer([&]() {
+    WriteLocker locker(&mutex);
+    EXPECT_EQ(readersDone, 1);
+    written = true;
+  });
+
+  // Once the writer is waiting it blocks new readers. Poll for that instead
+  // of sleeping, releasing every shared lock that still succeeds so that the
+  // writer can never be stuck behind one of ours.
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point deadline = Clock::now() + std::chrono::seconds(10);
+  bool writerWaiting = false;
+  while (!writerWaiting && Clock::now() < deadline) {
+    if (mutex.tryLockShared()) {
+      mutex.unlockShared();
+      std::this_thread::yield();
+    } else {
+      writerWaiting = true;
+    }
+  }
+  EXPECT_TRUE(writerWaiting);
+  EXPECT_FALSE(written);
+  readersDone = 1;
+  mutex.unlockShared();
+
+  writer.join();
+  EXPECT_TRUE(written);
+  ReadLocker locker(&mutex);
+}
@@ -0,0 +1,87 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/neighborperceiver.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+using Avogadro::Index;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::NeighborPerceiver;
+
+namespace {
+Array<Vector3> randomPoints(Index count, Real extent)
+{
+  std::srand(42);
+  Array<Vector3> points;
+  for (Index i = 0; i < count; ++i) {
+    Vector3 p;
+    for (int c = 0; c < 3; ++c)
+      p[c] = extent * std::rand() / static_cast<Real>(RAND_MAX);
+    points.push_back(p);
+  }
+  return points;
+}
+} // namespace
+
+TEST(NeighborPerceiverTest, neighbors)
+{
+  Array<Vector3> points = randomPoints(500, 20.0);
+  const Real maxDistance = 2.5;
+  NeighborPerceiver perceiver(points, maxDistance);
+
+  Array<Index> candidates;
+  for (Index i = 0; i < points.size(); i += 7) {
+    perceiver.getNeighborsInclusive(candidates, points[i]);
+    EXPECT_NE(std::find(candidates.begin(), candidates.end(), i),
+              candidates.end());
+    for (Index j = 0; j < points.size(); ++j) {
+      if ((points[i] - points[j]).norm() < maxDistance) {
+        EXPECT_NE(std::find(candidates.begin(), candidates.end(), j),
+                  candidates.end());
+      }
+    }
+  }
+}
+
+TEST(NeighborPerceiverTest, pairs)
+{
+  Array<Vector3> points = randomPoints(400, 15.0);
+  const Real maxDistance = 3.0;
+  NeighborPerceiver perceiver(points, maxDistance);
+
+  std::vector<std::pair<Index, Index>> pairs;
+  perceiver.getPairs(pairs);
+  std::sort(pairs.begin(), pairs.end());
+
+  std::vector<std::pair<Index, Index>> expected;
+  for (Index i = 0; i < points.size(); ++i)
+    for (Index j = i + 1; j < points.size(); ++j)
+      if ((points[i] - points[j]).norm() < maxDistance)
+        expected.push_back(std::make_pair(i, j));
+
+  EXPECT_EQ(pairs, expected);
+}
+
+TEST(NeighborPerceiverTest, sparse)
+{
+  // Two distant clusters must not allocate a huge grid.
+  Array<Vector3> points;
+  points.push_back(Vector3(0.0, 0.0, 0.0));
+  points.push_back(Vector3(0.5, 0.0, 0.0));
+  points.push_back(Vector3(1.0e5, 1.0e5, 1.0e5));
+  NeighborPerceiver perceiver(points, 1.0);
+
+  std::vector<std::pair<Index, Index>> pairs;
+  perceiver.getPairs(pairs);
+  ASSERT_EQ(pairs.size(), static_cast<size_t>(1));
+  EXPECT_EQ(pairs[0], std::make_pair(Index(0), Index(1)));
+}
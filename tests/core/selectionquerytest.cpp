@@ -0,0 +1,170 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/residue.h>
+#include <avogadro/core/selectionquery.h>
+
+#include <chrono>
+#include <iostream>
+
+using Avogadro::Index;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Atom;
+using Avogadro::Core::AtomSelection;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::Residue;
+using Avogadro::Core::SelectionQuery;
+
+namespace {
+// A chain of residues along x, each residue one carbon, one oxygen and two
+// hydrogens, spaced 4 Angstrom apart. Residues 1-5 are chain A, the rest B.
+Molecule createPeptide(Index residueCount)
+{
+  Molecule molecule;
+  for (Index r = 1; r <= residueCount; ++r) {
+    std::string name = r % 2 ? "ALA" : "GLY";
+    Index id = r;
+    char chain = r <= 5 ? 'A' : 'B';
+    Residue& residue = molecule.addResidue(name, id, chain);
+    const unsigned char numbers[] = { 6, 8, 1, 1 };
+    const char* names[] = { "C", "O", "H1", "H2" };
+    for (int a = 0; a < 4; ++a) {
+      Atom atom = molecule.addAtom(numbers[a]);
+      atom.setPosition3d(Vector3(4.0 * r + 0.5 * a, 0.0, 0.0));
+      std::string atomName = names[a];
+      residue.addResidueAtom(atomName, atom);
+    }
+  }
+  return molecule;
+}
+
+Index count(const Molecule& molecule, const std::string& query)
+{
+  SelectionQuery selection(query);
+  EXPECT_TRUE(selection.isValid()) << query << ": " << selection.error();
+  return selection.evaluate(molecule).count();
+}
+} // namespace
+
+TEST(SelectionQueryTest, simpleTerms)
+{
+  Molecule molecule = createPeptide(10);
+  EXPECT_EQ(count(molecule, "all"), static_cast<Index>(40));
+  EXPECT_EQ(count(molecule, "none"), static_cast<Index>(0));
+  EXPECT_EQ(count(molecule, "hydrogen"), static_cast<Index>(20));
+  EXPECT_EQ(count(molecule, "heavy"), static_cast<Index>(20));
+  EXPECT_EQ(count(molecule, "element C"), static_cast<Index>(10));
+  EXPECT_EQ(count(molecule, "element c O 1"), static_cast<Index>(40));
+  EXPECT_EQ(count(molecule, "index 0-9 20"), static_cast<Index>(11));
+}
+
+TEST(SelectionQueryTest, residues)
+{
+  Molecule molecule = createPeptide(10);
+  EXPECT_EQ(count(molecule, "resid 3"), static_cast<Index>(4));
+  EXPECT_EQ(count(molecule, "resid 2-4 9"), static_cast<Index>(16));
+  EXPECT_EQ(count(molecule, "resname GLY"), static_cast<Index>(20));
+  EXPECT_EQ(count(molecule, "chain A"), static_cast<Index>(20));
+  EXPECT_EQ(count(molecule, "chain A and not hydrogen"),
+            static_cast<Index>(10));
+}
+
+TEST(SelectionQueryTest, operators)
+{
+  Molecule molecule = createPeptide(10);
+  EXPECT_EQ(count(molecule, "not element C"), static_cast<Index>(30));
+  EXPECT_EQ(count(molecule, "element C or element O"),
+            static_cast<Index>(20));
+  EXPECT_EQ(count(molecule, "element C or element O and chain A"),
+            static_cast<Index>(15));
+  EXPECT_EQ(count(molecule, "(element C or element O) and chain A"),
+            static_cast<Index>(10));
+  EXPECT_EQ(count(molecule, "NOT not ALL"), static_cast<Index>(40));
+
+  molecule.setAtomSelected(0, true);
+  molecule.setAtomSelected(5, true);
+  EXPECT_EQ(count(molecule, "selected and hydrogen"), static_cast<Index>(0));
+  EXPECT_EQ(count(molecule, "selected or hydrogen"), static_cast<Index>(22));
+}
+
+TEST(SelectionQueryTest, within)
+{
+  Molecule molecule = createPeptide(10);
+  // Residue 5 spans x = 20 to 21.5, so 2.6 Angstrom reaches the last atom of
+  // residue 4 (x = 17.5) and the first atom of residue 6 (x = 24).
+  EXPECT_EQ(count(molecule, "within 2.6 of resid 5"), static_cast<Index>(6));
+  EXPECT_EQ(count(molecule, "element C and within 2.6 of resid 5"),
+            static_cast<Index>(2));
+  EXPECT_EQ(count(molecule, "within 0 of resid 5"), static_cast<Index>(4));
+  EXPECT_EQ(count(molecule, "within 5 of none"), static_cast<Index>(0));
+}
+
+TEST(SelectionQueryTest, errors)
+{
+  const char* invalid[] = { "",        "element",          "element Qq",
+                            "resid x", "within of resid 1", "within 3 resid 1",
+                            "(all",    "all)",             "all and",
+                            "bogus" };
+  for (const char* query : invalid) {
+    SelectionQuery selection(query);
+    EXPECT_FALSE(selection.isValid()) << query;
+    EXPECT_FALSE(selection.error().empty()) << query;
+    EXPECT_EQ(selection.evaluate(createPeptide(2)).count(),
+              static_cast<Index>(0));
+  }
+}
+
+TEST(SelectionQueryTest, combinedQuery)
+{
+  // The query of the benchmark below, on a chain small enough to check every
+  // atom of it.
+  Molecule molecule = createPeptide(60);
+  SelectionQuery query("element C and within 5 of resid 42 or "
+                       "chain A and not hydrogen");
+  ASSERT_TRUE(query.isValid());
+  AtomSelection selection = query.evaluate(molecule);
+  ASSERT_EQ(selection.size(), molecule.atomCount());
+
+  for (Index i = 0; i < molecule.atomCount(); ++i) {
+    // Four atoms per residue, residue r starts at x = 4 r.
+    Index residue = i / 4 + 1;
+    unsigned char number = molecule.atomicNumber(i);
+    Real x = molecule.atomPosition3d(i).x();
+    bool nearResidue42 = x >= 168.0 - 5.0 && x <= 169.5 + 5.0;
+    bool expected = (number == 6 && nearResidue42) ||
+                    (residue <= 5 && number != 1);
+    EXPECT_EQ(selection.test(i), expected) << "atom " << i;
+  }
+
+  // Carbons of residues 41-43 and the heavy atoms of residues 1-5.
+  EXPECT_EQ(selection.count(), static_cast<Index>(13));
+}
+
+// Times a query on one million atoms. Run it with
+// --gtest_also_run_disabled_tests --gtest_filter=SelectionQueryTest.*
+TEST(SelectionQueryTest, DISABLED_largeSystem)
+{
+  // 250000 residues, one million atoms.
+  Molecule molecule = createPeptide(250000);
+  SelectionQuery query("element C and within 5 of resid 42 or "
+                       "chain A and not hydrogen");
+  ASSERT_TRUE(query.isValid());
+
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  AtomSelection selection = query.evaluate(molecule);
+  double seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << "Evaluated on " << molecule.atomCount() << " atoms in "
+            << seconds * 1000.0 << " ms" << std::endl;
+
+  // Carbons of residues 41-43 and the heavy atoms of residues 1-5.
+  EXPECT_EQ(selection.count(), static_cast<Index>(13));
+}
@@ -23,13 +23,47 @@
 #include <avogadro/core/unitcell.h>
 #include <avogadro/core/vector.h>
 
+#include <sstream>
+#include <string>
+
+using Avogadro::Index;
 using Avogadro::Matrix3;
 using Avogadro::Vector3;
+using Avogadro::Core::Array;
 using Avogadro::Core::AvoSpglib;
 using Avogadro::Core::Molecule;
 using Avogadro::Core::SpaceGroups;
+using Avogadro::Core::SymmetryOperation;
 using Avogadro::Core::UnitCell;
 
+namespace {
+// Evaluates a transform string such as "1/2-x,y-x,z" at @a v, independently of
+// the parsed operation table, as getTransforms() used to for each position.
+Vector3 applyTransform(const std::string& transform, const Vector3& v)
+{
+  Vector3 result(0.0, 0.0, 0.0);
+  int c = 0;
+  double sign = 1.0;
+  for (size_t i = 0; i < transform.size(); ++i) {
+    char ch = transform[i];
+    if (ch == ',') {
+      ++c;
+      sign = 1.0;
+    } else if (ch == '+') {
+      sign = 1.0;
+    } else if (ch == '-') {
+      sign = -1.0;
+    } else if (ch >= 'x' && ch <= 'z') {
+      result[c] += sign * v[ch - 'x'];
+    } else {
+      result[c] += sign * (ch - '0') / double(transform[i + 2] - '0');
+      i += 2;
+    }
+  }
+  return result;
+}
+} // namespace
+
 TEST(SpaceGroupTest, getSpaceGroup)
 {
   Molecule mol;
@@ -505,3 +539,90 @@ TEST(SpaceGroupTest, reduceToAsymmetricUnit)
   ASSERT_EQ(mol2.atomCount(), 4);
   ASSERT_EQ(mol2.atomicNumbers().size(), 4);
 }
+
+TEST(SpaceGroupTest, symmetryOperations)
+{
+  // C 2y: x,y,z -x,y,-z 1/2+x,1/2+y,z 1/2-x,1/2+y,-z
+  const std::vector<SymmetryOperation>& ops =
+    SpaceGroups::symmetryOperations(9);
+  ASSERT_EQ(ops.size(), 4u);
+  EXPECT_EQ(SpaceGroups::transformsCount(9), 4);
+  EXPECT_TRUE(ops[0].rotation.isIdentity());
+  EXPECT_TRUE(ops[0].translation.isZero());
+  EXPECT_TRUE(
+    ops[3].rotation.isApprox(Matrix3(Vector3(-1, 1, -1).asDiagonal())));
+  EXPECT_TRUE(ops[3].translation.isApprox(Vector3(0.5, 0.5, 0.0)));
+
+  EXPECT_TRUE(SpaceGroups::symmetryOperations(0).empty());
+  EXPECT_TRUE(SpaceGroups::symmetryOperations(531).empty());
+  EXPECT_EQ(SpaceGroups::transformsCount(531), 0);
+
+  // Every rotation is an integer matrix with a determinant of +-1.
+  for (unsigned short hall = 1; hall <= 530; ++hall) {
+    const std::vector<SymmetryOperation>& group =
+      SpaceGroups::symmetryOperations(hall);
+    ASSERT_FALSE(group.empty()) << "hall " << hall;
+    EXPECT_TRUE(group[0].rotation.isIdentity()) << "hall " << hall;
+    for (size_t i = 0; i < group.size(); ++i) {
+      EXPECT_NEAR(std::abs(group[i].rotation.determinant()), 1.0, 1e-12)
+        << "hall " << hall << " operation " << i;
+      EXPECT_TRUE(group[i].rotation.isApprox(group[i].rotation.array().round()
+                                               .matrix()))
+        << "hall " << hall << " operation " << i;
+    }
+  }
+}
+
+TEST(SpaceGroupTest, batchedTransforms)
+{
+  Array<Vector3> positions;
+  positions.push_back(Vector3(0.1, 0.2, 0.3));
+  positions.push_back(Vector3(0.7, 0.05, 0.45));
+  positions.push_back(Vector3(0.0, 0.5, 0.25));
+
+  // The transforms of a few hall numbers, copied from spacegroupdata.h.
+  const unsigned short halls[] = { 1, 9, 108, 436, 508 };
+  const char* transforms[] = {
+    "x,y,z",
+    "x,y,z -x,y,-z 1/2+x,1/2+y,z 1/2-x,1/2+y,-z",
+    "x,y,z -x,-y,z -x,y,-z x,-y,-z",
+    "x,y,z -y,x-y,z y-x,-x,z -x,-y,-z y,y-x,-z x-y,x,-z 2/3+x,1/3+y,1/3+z "
+    "2/3-y,1/3+x-y,1/3+z 2/3+y-x,1/3-x,1/3+z 2/3-x,1/3-y,1/3-z "
+    "2/3+y,1/3+y-x,1/3-z 2/3+x-y,1/3+x,1/3-z 1/3+x,2/3+y,2/3+z "
+    "1/3-y,2/3+x-y,2/3+z 1/3+y-x,2/3-x,2/3+z 1/3-x,2/3-y,2/3-z "
+    "1/3+y,2/3+y-x,2/3-z 1/3+x-y,2/3+x,2/3-z",
+    "x,y,z 1/2-x,-y,1/2+z -x,1/2+y,1/2-z 1/2+x,1/2-y,-z z,x,y 1/2+z,1/2-x,-y "
+    "1/2-z,-x,1/2+y -z,1/2+x,1/2-y y,z,x -y,1/2+z,1/2-x 1/2+y,1/2-z,-x "
+    "1/2-y,-z,1/2+x 1/4+y,3/4+x,3/4-z 1/4-y,1/4-x,1/4-z 3/4+y,3/4-x,1/4+z "
+    "3/4-y,1/4+x,3/4+z 1/4+x,3/4+z,3/4-y 3/4-x,1/4+z,3/4+y 1/4-x,1/4-z,1/4-y "
+    "3/4+x,3/4-z,1/4+y 1/4+z,3/4+y,3/4-x 3/4+z,3/4-y,1/4+x 3/4-z,1/4+y,3/4+x "
+    "1/4-z,1/4-y,1/4-x"
+  };
+
+  for (size_t h = 0; h < sizeof(halls) / sizeof(halls[0]); ++h) {
+    const unsigned short hall = halls[h];
+    std::vector<std::string> baseline;
+    std::istringstream stream(transforms[h]);
+    for (std::string transform; stream >> transform;)
+      baseline.push_back(transform);
+    ASSERT_EQ(SpaceGroups::transformsCount(hall), baseline.size())
+      << "hall " << hall;
+
+    Array<Vector3> batched = SpaceGroups::getTransforms(hall, positions);
+    ASSERT_EQ(batched.size(), baseline.size() * positions.size());
+    for (Index i = 0; i < positions.size(); ++i) {
+      Array<Vector3> single = SpaceGroups::getTransforms(hall, positions[i]);
+      ASSERT_EQ(single.size(), baseline.size());
+      for (Index j = 0; j < baseline.size(); ++j) {
+        Vector3 expected = applyTransform(baseline[j], positions[i]);
+        EXPECT_TRUE(single[j].isApprox(expected, 1e-12))
+          << "hall " << hall << " " << baseline[j] << " position " << i;
+        EXPECT_TRUE(batched[j * positions.size() + i].isApprox(expected, 1e-12))
+          << "hall " << hall << " " << baseline[j] << " position " << i;
+      }
+    }
+  }
+
+  EXPECT_TRUE(SpaceGroups::getTransforms(0, positions).empty());
+  EXPECT_TRUE(SpaceGroups::getTransforms(508, Array<Vector3>()).empty());
+}
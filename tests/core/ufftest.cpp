@@ -0,0 +1,203 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/lbfgs.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/uff.h>
+
+using Avogadro::Index;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::LBFGS;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::UFF;
+
+namespace {
+
+// A distorted ethane molecule, optionally shifted by @a offset.
+void addEthane(Molecule& mol, const Vector3& offset)
+{
+  Index c1 = mol.addAtom(6).index();
+  Index c2 = mol.addAtom(6).index();
+  mol.atom(c1).setPosition3d(offset + Vector3(0.0, 0.0, 0.0));
+  mol.atom(c2).setPosition3d(offset + Vector3(1.62, 0.05, -0.02));
+  mol.addBond(c1, c2);
+  const Vector3 hydrogens[6] = {
+    Vector3(-0.40, 1.00, 0.10),  Vector3(-0.35, -0.55, 0.90),
+    Vector3(-0.45, -0.45, -0.80), Vector3(2.00, 1.05, 0.20),
+    Vector3(1.95, -0.60, 0.85),  Vector3(2.10, -0.40, -0.95)
+  };
+  for (int h = 0; h < 6; ++h) {
+    Index hi = mol.addAtom(1).index();
+    mol.atom(hi).setPosition3d(offset + hydrogens[h]);
+    mol.addBond(h < 3 ? c1 : c2, hi);
+  }
+}
+
+// A distorted ethylene molecule.
+void addEthylene(Molecule& mol)
+{
+  Index c1 = mol.addAtom(6).index();
+  Index c2 = mol.addAtom(6).index();
+  mol.atom(c1).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  mol.atom(c2).setPosition3d(Vector3(1.30, 0.10, 0.05));
+  mol.addBond(c1, c2, 2);
+  const Vector3 hydrogens[4] = { Vector3(-0.55, 0.90, 0.20),
+                                 Vector3(-0.50, -0.95, -0.25),
+                                 Vector3(1.90, 1.00, 0.35),
+                                 Vector3(1.85, -0.85, -0.30) };
+  for (int h = 0; h < 4; ++h) {
+    Index hi = mol.addAtom(1).index();
+    mol.atom(hi).setPosition3d(hydrogens[h]);
+    mol.addBond(h < 2 ? c1 : c2, hi);
+  }
+}
+
+void checkGradient(UFF& uff, const Eigen::VectorXd& x)
+{
+  Eigen::VectorXd analytic;
+  uff.gradient(x, analytic);
+  ASSERT_EQ(analytic.size(), x.size());
+
+  const Real h = 1.0e-6;
+  Eigen::VectorXd displaced(x);
+  for (Eigen::Index i = 0; i < x.size(); ++i) {
+    displaced[i] = x[i] + h;
+    Real plus = uff.value(displaced);
+    displaced[i] = x[i] - h;
+    Real minus = uff.value(displaced);
+    displaced[i] = x[i];
+    EXPECT_NEAR(analytic[i], (plus - minus) / (2.0 * h), 1.0e-4)
+      << "coordinate " << i;
+  }
+}
+
+} // namespace
+
+TEST(UFFTest, atomTypes)
+{
+  Molecule mol;
+  addEthane(mol, Vector3::Zero());
+  addEthylene(mol);
+
+  UFF uff;
+  EXPECT_TRUE(uff.setMolecule(mol));
+  EXPECT_EQ(uff.atomCount(), mol.atomCount());
+  EXPECT_EQ(uff.atomType(0), "C_3");
+  EXPECT_EQ(uff.atomType(2), "H_");
+  EXPECT_EQ(uff.atomType(8), "C_2");
+}
+
+TEST(UFFTest, gradients)
+{
+  Molecule mol;
+  addEthane(mol, Vector3::Zero());
+  addEthane(mol, Vector3(0.5, 3.5, 0.3));
+  UFF uff;
+  ASSERT_TRUE(uff.setMolecule(mol));
+  checkGradient(uff, UFF::toCoordinates(mol.atomPositions3d()));
+
+  Molecule ethylene;
+  addEthylene(ethylene);
+  ASSERT_TRUE(uff.setMolecule(ethylene));
+  checkGradient(uff, UFF::toCoordinates(ethylene.atomPositions3d()));
+}
+
+TEST(UFFTest, threads)
+{
+  Molecule mol;
+  for (int i = 0; i < 5; ++i)
+    for (int j = 0; j < 5; ++j)
+      addEthane(mol, Vector3(4.0 * i, 4.0 * j, 0.0));
+  UFF uff;
+  ASSERT_TRUE(uff.setMolecule(mol));
+  Eigen::VectorXd x = UFF::toCoordinates(mol.atomPositions3d());
+
+  Eigen::VectorXd serialGrad, threadedGrad;
+  uff.setThreadCount(1);
+  Real serial = uff.valueAndGradient(x, serialGrad);
+  uff.setThreadCount(4);
+  Real threaded = uff.valueAndGradient(x, threadedGrad);
+  EXPECT_NEAR(serial, threaded, 1.0e-8);
+  EXPECT_LT((serialGrad - threadedGrad).cwiseAbs().maxCoeff(), 1.0e-8);
+}
+
+TEST(UFFTest, optimize)
+{
+  Molecule mol;
+  addEthane(mol, Vector3::Zero());
+  UFF uff;
+  ASSERT_TRUE(uff.setMolecule(mol));
+  Eigen::VectorXd x = UFF::toCoordinates(mol.atomPositions3d());
+  Real start = uff.value(x);
+
+  int updates = 0;
+  LBFGS lbfgs;
+  lbfgs.setMaxIterations(1000);
+  lbfgs.setProgressFunction([&updates](int, const Eigen::VectorXd&, Real) {
+    ++updates;
+    return true;
+  });
+  EXPECT_TRUE(lbfgs.minimize(uff, x));
+  EXPECT_GT(updates, 0);
+  EXPECT_LT(uff.value(x), start);
+
+  // The C-C bond relaxes to the UFF rest length of about 1.51 A.
+  Array<Vector3> positions;
+  UFF::fromCoordinates(x, positions);
+  EXPECT_NEAR((positions[0] - positions[1]).norm(), 1.514, 0.02);
+}
+
+TEST(UFFTest, mask)
+{
+  Molecule mol;
+  addEthane(mol, Vector3::Zero());
+  UFF uff;
+  ASSERT_TRUE(uff.setMolecule(mol));
+  Eigen::VectorXd x = UFF::toCoordinates(mol.atomPositions3d());
+  Eigen::VectorXd start(x);
+
+  // Freeze the first carbon.
+  Eigen::VectorXd mask = Eigen::VectorXd::Ones(x.size());
+  mask.head<3>().setZero();
+  uff.setMask(mask);
+
+  LBFGS lbfgs;
+  lbfgs.minimize(uff, x);
+  EXPECT_EQ(x.head<3>(), start.head<3>());
+  EXPECT_GT((x - start).norm(), 0.0);
+}
+
+TEST(UFFTest, activeAtoms)
+{
+  Molecule mol;
+  addEthane(mol, Vector3::Zero());
+  addEthane(mol, Vector3(0.5, 3.5, 0.3));
+  UFF uff;
+  ASSERT_TRUE(uff.setMolecule(mol));
+  Eigen::VectorXd x = UFF::toCoordinates(mol.atomPositions3d());
+
+  Eigen::VectorXd full;
+  uff.gradient(x, full);
+
+  // Activate the first ethane only; its gradient must be unchanged and all
+  // other atoms frozen.
+  std::vector<bool> active(mol.atomCount(), false);
+  for (Index i = 0; i < 8; ++i)
+    active[i] = true;
+  uff.setActiveAtoms(active);
+
+  Eigen::VectorXd region;
+  uff.gradient(x, region);
+  EXPECT_LT((region.head(24) - full.head(24)).cwiseAbs().maxCoeff(), 1.0e-8);
+  EXPECT_EQ(region.tail(24).cwiseAbs().maxCoeff(), 0.0);
+
+  uff.setActiveAtoms(std::vector<bool>());
+  uff.gradient(x, region);
+  EXPECT_LT((region - full).cwiseAbs().maxCoeff(), 1.0e-8);
+}
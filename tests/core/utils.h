@@ -38,7 +38,7 @@ void assertEqual(const Avogadro::Core::Molecule& m1,
     const Avogadro::Core::Mesh* mesh2 = m2.mesh(i);
 
     EXPECT_TRUE(mesh1->vertices() == mesh2->vertices());
-    EXPECT_TRUE(mesh1->normals() == mesh2->vertices());
+    EXPECT_TRUE(mesh1->normals() == mesh2->normals());
     EXPECT_EQ(mesh1->name(), mesh2->name());
     EXPECT_EQ(mesh1->isoValue(), mesh2->isoValue());
   }
@@ -0,0 +1,208 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/io/textwriter.h>
+#include <avogadro/io/xyzformat.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+using Avogadro::Vector3;
+using Avogadro::Core::Molecule;
+using Avogadro::Io::TextWriter;
+using Avogadro::Io::XyzFormat;
+
+namespace {
+std::string printfString(const char* format, int precision, double value)
+{
+  char text[512];
+  std::snprintf(text, sizeof(text), format, precision, value);
+  return text;
+}
+
+std::string fixed(double value, int precision, int width = 0,
+                  TextWriter::Alignment alignment = TextWriter::Right)
+{
+  std::ostringstream stream;
+  {
+    TextWriter writer(stream);
+    writer.writeFixed(value, precision, width, alignment);
+  }
+  return stream.str();
+}
+
+std::string shortest(double value)
+{
+  std::ostringstream stream;
+  TextWriter writer(stream);
+  writer.writeShortest(value);
+  writer.flush();
+  return stream.str();
+}
+
+double randomValue(double extent)
+{
+  return (std::rand() / static_cast<double>(RAND_MAX) - 0.5) * 2.0 * extent;
+}
+} // namespace
+
+TEST(TextWriterTest, text)
+{
+  std::ostringstream stream;
+  {
+    TextWriter writer(stream, 16);
+    writer.write('a').write("bc").write(std::string("def"));
+    writer.writePadded("C", 3).write('|');
+    writer.writePadded("Cl", 3, TextWriter::Right).write('|');
+    writer.writePadded("long", 2).write('|');
+    // Longer than the buffer.
+    writer.write(std::string(200, 'x'));
+    EXPECT_EQ(static_cast<size_t>(219), writer.bytesWritten());
+  }
+  EXPECT_EQ("abcdefC  | Cl|long|" + std::string(200, 'x'), stream.str());
+}
+
+TEST(TextWriterTest, integers)
+{
+  std::ostringstream stream;
+  {
+    TextWriter writer(stream);
+    writer.writeInteger(0).write(' ');
+    writer.writeInteger(-42, 5).write(' ');
+    writer.writeInteger(7, 3, TextWriter::Left).write('|');
+    writer.writeInteger(std::numeric_limits<long long>::min()).write(' ');
+    writer.writeInteger(std::numeric_limits<long long>::max());
+  }
+  EXPECT_EQ("0   -42 7  |-9223372036854775808 9223372036854775807",
+            stream.str());
+}
+
+TEST(TextWriterTest, fixed)
+{
+  EXPECT_EQ("   1.50000", fixed(1.5, 5, 10));
+  EXPECT_EQ("-1.5000   ", fixed(-1.5, 4, 10, TextWriter::Left));
+  EXPECT_EQ("0", fixed(0.4, 0));
+  EXPECT_EQ("-0.00000", fixed(-1e-7, 5));
+  EXPECT_EQ("-0.0", fixed(-0.0, 1));
+  EXPECT_EQ("123456789.12", fixed(123456789.123, 2));
+  // Ties are rounded as printf does.
+  EXPECT_EQ(printfString("%.*f", 2, 0.125), fixed(0.125, 2));
+  EXPECT_EQ(printfString("%.*f", 0, 2.5), fixed(2.5, 0));
+  EXPECT_EQ(printfString("%.*f", 3, 1e300), fixed(1e300, 3));
+  EXPECT_EQ(printfString("%.*f", 3, std::numeric_limits<double>::infinity()),
+            fixed(std::numeric_limits<double>::infinity(), 3));
+}
+
+TEST(TextWriterTest, fixedMatchesPrintf)
+{
+  std::srand(42);
+  const double extents[] = { 1e-3, 1.0, 100.0, 1e5, 1e9 };
+  for (int precision = 0; precision <= 10; ++precision) {
+    for (size_t e = 0; e < sizeof(extents) / sizeof(extents[0]); ++e) {
+      for (int i = 0; i < 2000; ++i) {
+        double value = randomValue(extents[e]);
+        ASSERT_EQ(printfString("%.*f", precision, value),
+                  fixed(value, precision))
+          << std::setprecision(17) << value << " precision " << precision;
+      }
+    }
+    // Decimal values that are ties or close to one.
+    for (int i = -2000; i <= 2000; ++i) {
+      double value = i / 1000.0 + 0.0005;
+      ASSERT_EQ(printfString("%.*f", precision, value),
+                fixed(value, precision))
+        << std::setprecision(17) << value << " precision " << precision;
+    }
+  }
+}
+
+TEST(TextWriterTest, shortest)
+{
+  EXPECT_EQ("0.1", shortest(0.1));
+  EXPECT_EQ("12.011", shortest(12.011));
+  EXPECT_EQ("-3", shortest(-3.0));
+  EXPECT_EQ("0", shortest(0.0));
+  EXPECT_EQ("-0", shortest(-0.0));
+  EXPECT_EQ("1e+20", shortest(1e20));
+  EXPECT_EQ("0.30000000000000004", shortest(0.1 + 0.2));
+
+  std::srand(42);
+  for (int i = 0; i < 10000; ++i) {
+    double value = randomValue(1000.0);
+    std::string text = shortest(value);
+    ASSERT_EQ(value, std::strtod(text.c_str(), nullptr)) << text;
+    ASSERT_LE(text.size(), printfString("%.*g", 17, value).size());
+  }
+}
+
+// Compares the throughput of writing XYZ coordinate lines with iostream
+// manipulators and with TextWriter. Run it with
+// --gtest_also_run_disabled_tests --gtest_filter=TextWriterTest.*
+TEST(TextWriterTest, DISABLED_benchmark)
+{
+  typedef std::chrono::steady_clock Clock;
+  const size_t numAtoms = 1000000;
+  std::srand(42);
+  Molecule molecule;
+  for (size_t i = 0; i < numAtoms; ++i) {
+    molecule.addAtom(static_cast<unsigned char>(1 + i % 18))
+      .setPosition3d(Vector3(randomValue(100.0), randomValue(100.0),
+                             randomValue(100.0)));
+  }
+
+  Clock::time_point start = Clock::now();
+  std::ostringstream streamOut;
+  for (size_t i = 0; i < numAtoms; ++i) {
+    const Vector3 pos = molecule.atomPosition3d(i);
+    streamOut << std::setw(3) << std::left << "C"
+              << " " << std::setw(10) << std::right << std::fixed
+              << std::setprecision(5) << pos.x() << " " << std::setw(10)
+              << pos.y() << " " << std::setw(10) << pos.z() << "\n";
+  }
+  double streamTime =
+    std::chrono::duration<double>(Clock::now() - start).count();
+  double streamBytes = static_cast<double>(streamOut.str().size());
+
+  start = Clock::now();
+  std::ostringstream writerOut;
+  {
+    TextWriter writer(writerOut);
+    for (size_t i = 0; i < numAtoms; ++i) {
+      const Vector3 pos = molecule.atomPosition3d(i);
+      writer.writePadded("C", 3).write(' ');
+      writer.writeFixed(pos.x(), 5, 10).write(' ');
+      writer.writeFixed(pos.y(), 5, 10).write(' ');
+      writer.writeFixed(pos.z(), 5, 10).write('\n');
+    }
+  }
+  double writerTime =
+    std::chrono::duration<double>(Clock::now() - start).count();
+  double writerBytes = static_cast<double>(writerOut.str().size());
+  EXPECT_EQ(streamOut.str(), writerOut.str());
+
+  start = Clock::now();
+  std::string xyz;
+  XyzFormat format;
+  EXPECT_TRUE(format.writeString(xyz, molecule));
+  double xyzTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+  const double megabyte = 1024.0 * 1024.0;
+  std::cout << numAtoms << " coordinate lines\n"
+            << "  iostream:   " << streamBytes / megabyte / streamTime
+            << " MB/s\n"
+            << "  TextWriter: " << writerBytes / megabyte / writerTime
+            << " MB/s\n"
+            << "  XyzFormat:  " << xyz.size() / megabyte / xyzTime << " MB/s"
+            << std::endl;
+}
@@ -152,6 +152,58 @@ TEST(XyzTest, modes)
   EXPECT_TRUE(format.isMode(FileFormat::MultiMolecule));
 }
 
+// A trajectory of many small frames, large enough for several progress
+// reports.
+std::string longTrajectory()
+{
+  std::ostringstream out;
+  for (int frame = 0; frame < 3000; ++frame) {
+    out << "4\nFrame " << frame << "\n";
+    for (int i = 0; i < 4; ++i)
+      out << "C " << i << ".0 " << frame << ".0 0.0\n";
+  }
+  return out.str();
+}
+
+TEST(XyzTest, progress)
+{
+  std::string trajectory = longTrajectory();
+  XyzFormat xyz;
+  std::vector<std::streamoff> reports;
+  std::streamoff total = 0;
+  xyz.setProgressFunction([&](std::streamoff done, std::streamoff size) {
+    reports.push_back(done);
+    total = size;
+  });
+  Molecule molecule;
+  EXPECT_TRUE(xyz.readString(trajectory, molecule));
+  EXPECT_EQ(molecule.coordinate3dCount(), 3000);
+  ASSERT_FALSE(reports.empty());
+  EXPECT_EQ(total, static_cast<std::streamoff>(trajectory.size()));
+  for (size_t i = 1; i < reports.size(); ++i)
+    EXPECT_GT(reports[i], reports[i - 1]);
+  EXPECT_LE(reports.back(), total);
+}
+
+TEST(XyzTest, cancel)
+{
+  std::string trajectory = longTrajectory();
+  XyzFormat xyz;
+  xyz.setProgressFunction(
+    [&](std::streamoff, std::streamoff) { xyz.cancel(); });
+  Molecule molecule;
+  EXPECT_FALSE(xyz.readString(trajectory, molecule));
+  EXPECT_TRUE(xyz.isCanceled());
+  EXPECT_LT(molecule.coordinate3dCount(), 3000);
+
+  // Clearing the format allows it to be used again.
+  xyz.clear();
+  xyz.setProgressFunction(XyzFormat::ProgressFunction());
+  Molecule second;
+  EXPECT_TRUE(xyz.readString(trajectory, second));
+  EXPECT_EQ(second.coordinate3dCount(), 3000);
+}
+
 TEST(DISABLED_XyzTest, readMulti)
 {
   XyzFormat multi;
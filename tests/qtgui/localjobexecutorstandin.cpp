@@ -0,0 +1,51 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+// A stand-in for a quantum chemistry program, run by LocalJobExecutorTest. The
+// first word of the input file named on the command line selects what to do:
+//   fail <code>     print to standard error and exit with <code>
+//   sleep <seconds> wait, then exit successfully
+// Any other input is copied to standard output.
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <input file>" << std::endl;
+    return 2;
+  }
+
+  std::ifstream input(argv[1]);
+  if (!input) {
+    std::cerr << "cannot read " << argv[1] << std::endl;
+    return 2;
+  }
+  std::stringstream contents;
+  contents << input.rdbuf();
+
+  std::string command;
+  contents >> command;
+  if (command == "fail") {
+    int code = 1;
+    contents >> code;
+    std::cerr << "failing with " << code << std::endl;
+    return code;
+  }
+  if (command == "sleep") {
+    int seconds = 0;
+    contents >> seconds;
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    return 0;
+  }
+
+  std::cout << contents.str();
+  return 0;
+}
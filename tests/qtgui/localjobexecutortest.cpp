@@ -0,0 +1,213 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/molequeue/localjobexecutor.h>
+
+#include <molequeue/client/jobobject.h>
+
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+
+using Avogadro::MoleQueue::LocalJobExecutor;
+using MoleQueue::JobObject;
+
+// The executor needs an event loop to start jobs and notice them finish.
+#define START_QAPP                                                             \
+  int argc = 1;                                                                \
+  char argName[] = "FakeApp.exe";                                              \
+  char* argv[2] = { argName, nullptr };                                        \
+  QCoreApplication app(argc, argv);                                            \
+  Q_UNUSED(app)
+
+namespace {
+JobObject createJob(const QString& contents)
+{
+  JobObject job;
+  job.setInputFile("job.inp", contents);
+  return job;
+}
+
+void setStandIn(LocalJobExecutor& executor)
+{
+  executor.setProgram(LOCALJOBEXECUTOR_STANDIN,
+                      QStringList() << "$$inputFileName$$");
+}
+
+bool waitForState(const LocalJobExecutor& executor,
+                  LocalJobExecutor::JobId jobId, const QString& state)
+{
+  QElapsedTimer timer;
+  timer.start();
+  while (executor.jobState(jobId) != state && timer.elapsed() < 10000)
+    QTest::qWait(10);
+  return executor.jobState(jobId) == state;
+}
+
+QString readFile(const QString& path)
+{
+  QFile file(path);
+  if (!file.open(QFile::ReadOnly))
+    return QString();
+  return QString::fromUtf8(file.readAll());
+}
+
+QString jobFile(const LocalJobExecutor& executor, LocalJobExecutor::JobId id,
+                const QString& fileName)
+{
+  QDir dir(executor.job(id).value("localWorkingDirectory").toString());
+  return dir.filePath(fileName);
+}
+} // namespace
+
+TEST(LocalJobExecutorTest, submit)
+{
+  START_QAPP;
+  QTemporaryDir workingDirectory;
+  ASSERT_TRUE(workingDirectory.isValid());
+
+  LocalJobExecutor executor;
+  setStandIn(executor);
+  executor.setWorkingDirectory(workingDirectory.path());
+  LocalJobExecutor::JobId id = executor.submit(createJob("hello"));
+  ASSERT_NE(id, LocalJobExecutor::InvalidJobId);
+  // Nothing starts before control returns to the event loop.
+  EXPECT_EQ(executor.jobState(id), QString("QueuedLocal"));
+
+  ASSERT_TRUE(waitForState(executor, id, "Finished"));
+  EXPECT_EQ(executor.job(id).value("exitCode").toInt(), 0);
+  EXPECT_EQ(executor.runningJobCount(), 0);
+  EXPECT_EQ(readFile(jobFile(executor, id, "job.out")), QString("hello"));
+  QString jobDirectory =
+    executor.job(id).value("localWorkingDirectory").toString();
+  EXPECT_TRUE(jobDirectory.startsWith(workingDirectory.path()));
+}
+
+TEST(LocalJobExecutorTest, dependencies)
+{
+  START_QAPP;
+  QTemporaryDir workingDirectory;
+  ASSERT_TRUE(workingDirectory.isValid());
+
+  LocalJobExecutor executor;
+  setStandIn(executor);
+  executor.setWorkingDirectory(workingDirectory.path());
+  executor.setMaximumConcurrentJobs(4);
+  QSignalSpy spy(&executor, SIGNAL(jobStateChanged(int, QString, QString)));
+
+  LocalJobExecutor::JobId first = executor.submit(createJob("first"));
+  LocalJobExecutor::JobId second =
+    executor.submit(createJob("second"), QList<int>() << first);
+  EXPECT_EQ(executor.submit(createJob("bad"), QList<int>() << 5),
+            LocalJobExecutor::InvalidJobId);
+  ASSERT_TRUE(waitForState(executor, second, "Finished"));
+  EXPECT_EQ(executor.jobState(first), QString("Finished"));
+
+  // The second job only started once the first one finished.
+  int firstFinished = -1;
+  int secondStarted = -1;
+  for (int i = 0; i < spy.count(); ++i) {
+    int id = spy.at(i).at(0).toInt();
+    QString state = spy.at(i).at(2).toString();
+    if (id == first && state == "Finished")
+      firstFinished = i;
+    else if (id == second && state == "RunningLocal")
+      secondStarted = i;
+  }
+  ASSERT_GE(firstFinished, 0);
+  EXPECT_GT(secondStarted, firstFinished);
+}
+
+TEST(LocalJobExecutorTest, failure)
+{
+  START_QAPP;
+  QTemporaryDir workingDirectory;
+  ASSERT_TRUE(workingDirectory.isValid());
+
+  LocalJobExecutor executor;
+  setStandIn(executor);
+  executor.setWorkingDirectory(workingDirectory.path());
+  LocalJobExecutor::JobId failing = executor.submit(createJob("fail 3"));
+  LocalJobExecutor::JobId dependent =
+    executor.submit(createJob("dependent"), QList<int>() << failing);
+
+  ASSERT_TRUE(waitForState(executor, dependent, "Canceled"));
+  EXPECT_EQ(executor.jobState(failing), QString("Error"));
+  EXPECT_EQ(executor.job(failing).value("exitCode").toInt(), 3);
+  EXPECT_FALSE(readFile(jobFile(executor, failing, "job.err")).isEmpty());
+  // The dependent job never started.
+  JobObject dependentJob = executor.job(dependent);
+  EXPECT_FALSE(dependentJob.value("localWorkingDirectory").isValid());
+
+  // A program that cannot be started fails its jobs as well.
+  LocalJobExecutor missing;
+  missing.setProgram(workingDirectory.path() + "/no-such-program");
+  missing.setWorkingDirectory(workingDirectory.path());
+  LocalJobExecutor::JobId id = missing.submit(createJob("hello"));
+  ASSERT_TRUE(waitForState(missing, id, "Error"));
+  EXPECT_EQ(missing.runningJobCount(), 0);
+}
+
+TEST(LocalJobExecutorTest, cancel)
+{
+  START_QAPP;
+  QTemporaryDir workingDirectory;
+  ASSERT_TRUE(workingDirectory.isValid());
+
+  LocalJobExecutor executor;
+  setStandIn(executor);
+  executor.setWorkingDirectory(workingDirectory.path());
+  LocalJobExecutor::JobId running = executor.submit(createJob("sleep 30"));
+  LocalJobExecutor::JobId dependent =
+    executor.submit(createJob("dependent"), QList<int>() << running);
+  ASSERT_TRUE(waitForState(executor, running, "RunningLocal"));
+
+  // Canceling does not wait for the process to exit.
+  QElapsedTimer timer;
+  timer.start();
+  executor.cancel(running);
+  EXPECT_LT(timer.elapsed(), 500);
+  EXPECT_EQ(executor.jobState(running), QString("Canceled"));
+  EXPECT_EQ(executor.runningJobCount(), 0);
+  EXPECT_TRUE(waitForState(executor, dependent, "Canceled"));
+
+  // Queued jobs are canceled without ever starting.
+  LocalJobExecutor::JobId queued = executor.submit(createJob("queued"));
+  executor.cancel(queued);
+  EXPECT_EQ(executor.jobState(queued), QString("Canceled"));
+  QTest::qWait(50);
+  EXPECT_EQ(executor.jobState(queued), QString("Canceled"));
+}
+
+TEST(LocalJobExecutorTest, destructor)
+{
+  START_QAPP;
+  QString workingDirectory;
+  QElapsedTimer timer;
+  {
+    LocalJobExecutor executor;
+    setStandIn(executor);
+    workingDirectory = executor.workingDirectory();
+    ASSERT_FALSE(workingDirectory.isEmpty());
+    LocalJobExecutor::JobId id = executor.submit(createJob("sleep 30"));
+    ASSERT_TRUE(waitForState(executor, id, "RunningLocal"));
+    EXPECT_TRUE(QDir(workingDirectory).exists());
+    timer.start();
+  }
+
+  // The running job was killed without blocking, and the default working
+  // directory is gone.
+  EXPECT_LT(timer.elapsed(), 500);
+  EXPECT_FALSE(QDir(workingDirectory).exists());
+  // Let the killed process be reaped.
+  QTest::qWait(100);
+}
@@ -0,0 +1,197 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "symmetryprescreen.h"
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/avogadrocore.h>
+
+#include <Eigen/Geometry>
+
+#include <cmath>
+
+using Avogadro::Matrix3;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::PI_D;
+using Avogadro::Core::Array;
+using Avogadro::QtPlugins::SymmetryPrescreen;
+
+namespace {
+const Real tolerance = 0.05;
+
+struct Structure
+{
+  Array<unsigned char> numbers;
+  Array<Vector3> positions;
+
+  void add(unsigned char number, const Vector3& position)
+  {
+    numbers.push_back(number);
+    positions.push_back(position);
+  }
+
+  // Rotate and translate the structure, which must not change its symmetry.
+  Structure moved() const
+  {
+    Structure result(*this);
+    Matrix3 rotation =
+      (Eigen::AngleAxis<Real>(0.7, Vector3(1.0, 2.0, 3.0).normalized()))
+        .toRotationMatrix();
+    for (size_t i = 0; i < result.positions.size(); ++i)
+      result.positions[i] = rotation * positions[i] + Vector3(3.0, -2.0, 5.0);
+    return result;
+  }
+
+  bool isAsymmetric() const
+  {
+    return SymmetryPrescreen(numbers, positions, tolerance).isAsymmetric();
+  }
+};
+
+// C2v, an asymmetric top whose C2 axis lies along z.
+Structure water()
+{
+  Structure s;
+  s.add(8, Vector3(0.0, 0.0, 0.1173));
+  s.add(1, Vector3(0.0, 0.7572, -0.4692));
+  s.add(1, Vector3(0.0, -0.7572, -0.4692));
+  return s;
+}
+
+// Td, a spherical top.
+Structure methane()
+{
+  const Real d = 0.629;
+  Structure s;
+  s.add(6, Vector3::Zero());
+  s.add(1, Vector3(d, d, d));
+  s.add(1, Vector3(d, -d, -d));
+  s.add(1, Vector3(-d, d, -d));
+  s.add(1, Vector3(-d, -d, d));
+  return s;
+}
+
+// D6h, an oblate symmetric top.
+Structure benzene()
+{
+  Structure s;
+  for (int i = 0; i < 6; ++i) {
+    Real angle = i * PI_D / 3.0;
+    Vector3 direction(std::cos(angle), std::sin(angle), 0.0);
+    s.add(6, 1.39 * direction);
+    s.add(1, 2.47 * direction);
+  }
+  return s;
+}
+
+// C2h, an asymmetric top with an inversion center.
+Structure transDichloroethylene()
+{
+  Structure s;
+  s.add(6, Vector3(0.0, 0.665, 0.0));
+  s.add(6, Vector3(0.0, -0.665, 0.0));
+  s.add(17, Vector3(1.48, 1.52, 0.0));
+  s.add(17, Vector3(-1.48, -1.52, 0.0));
+  s.add(1, Vector3(-0.93, 1.23, 0.0));
+  s.add(1, Vector3(0.93, -1.23, 0.0));
+  return s;
+}
+
+// C2, a nonplanar asymmetric top with only the C2 axis along z.
+Structure hydrogenPeroxide()
+{
+  Structure s;
+  s.add(8, Vector3(0.0, 0.7375, -0.05));
+  s.add(8, Vector3(0.0, -0.7375, -0.05));
+  s.add(1, Vector3(0.8, 0.9, 0.4));
+  s.add(1, Vector3(-0.8, -0.9, 0.4));
+  return s;
+}
+
+// C1, bromochlorofluoromethane.
+Structure bromochlorofluoromethane()
+{
+  const Vector3 corners[4] = { Vector3(1, 1, 1), Vector3(1, -1, -1),
+                               Vector3(-1, 1, -1), Vector3(-1, -1, 1) };
+  const unsigned char numbers[4] = { 1, 9, 17, 35 };
+  const Real lengths[4] = { 1.09, 1.35, 1.77, 1.94 };
+  Structure s;
+  s.add(6, Vector3::Zero());
+  for (int i = 0; i < 4; ++i)
+    s.add(numbers[i], lengths[i] * corners[i].normalized());
+  return s;
+}
+} // namespace
+
+TEST(SymmetryPrescreenTest, centerOfMass)
+{
+  Structure s = water();
+  SymmetryPrescreen prescreen(s.numbers, s.positions, tolerance);
+  EXPECT_NEAR(0.0, prescreen.centerOfMass().x(), 1e-12);
+  EXPECT_NEAR(0.0, prescreen.centerOfMass().y(), 1e-12);
+}
+
+TEST(SymmetryPrescreenTest, symmetryOperations)
+{
+  Structure s = water();
+  SymmetryPrescreen prescreen(s.numbers, s.positions, tolerance);
+  EXPECT_TRUE(prescreen.isSymmetryOperation(Matrix3::Identity()));
+  // The C2 axis and both mirror planes.
+  EXPECT_TRUE(prescreen.isSymmetryOperation(Vector3(-1, -1, 1).asDiagonal()));
+  EXPECT_TRUE(prescreen.isSymmetryOperation(Vector3(1, -1, 1).asDiagonal()));
+  EXPECT_TRUE(prescreen.isSymmetryOperation(Vector3(-1, 1, 1).asDiagonal()));
+  // But not the inversion.
+  EXPECT_FALSE(prescreen.isSymmetryOperation(-Matrix3::Identity()));
+
+  Structure b = benzene();
+  SymmetryPrescreen benzenePrescreen(b.numbers, b.positions, tolerance);
+  Matrix3 c6 =
+    Eigen::AngleAxis<Real>(PI_D / 3.0, Vector3::UnitZ()).toRotationMatrix();
+  EXPECT_TRUE(benzenePrescreen.isSymmetryOperation(c6));
+  Matrix3 c4 =
+    Eigen::AngleAxis<Real>(PI_D / 2.0, Vector3::UnitZ()).toRotationMatrix();
+  EXPECT_FALSE(benzenePrescreen.isSymmetryOperation(c4));
+}
+
+TEST(SymmetryPrescreenTest, symmetricNotRejected)
+{
+  // Whatever their orientation, symmetric molecules must reach libmsym.
+  Structure structures[5] = { water(), methane(), benzene(),
+                              transDichloroethylene(), hydrogenPeroxide() };
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_FALSE(structures[i].isAsymmetric()) << "structure " << i;
+    EXPECT_FALSE(structures[i].moved().isAsymmetric()) << "structure " << i;
+  }
+}
+
+TEST(SymmetryPrescreenTest, withinTolerance)
+{
+  // Noise smaller than the tolerance keeps the symmetry.
+  Structure s = hydrogenPeroxide().moved();
+  s.positions[2] += Vector3(0.01, -0.01, 0.01);
+  EXPECT_FALSE(s.isAsymmetric());
+
+  // Breaking it beyond the tolerance leaves only the identity. Any three
+  // atoms would still have their plane as a mirror.
+  s.positions[2] += Vector3(0.3, 0.0, 0.0);
+  EXPECT_TRUE(s.isAsymmetric());
+}
+
+TEST(SymmetryPrescreenTest, asymmetric)
+{
+  EXPECT_TRUE(bromochlorofluoromethane().isAsymmetric());
+  EXPECT_TRUE(bromochlorofluoromethane().moved().isAsymmetric());
+
+  // Too few atoms or no tolerance never reject.
+  Structure atom;
+  atom.add(6, Vector3::Zero());
+  EXPECT_FALSE(atom.isAsymmetric());
+  Structure s = bromochlorofluoromethane();
+  EXPECT_FALSE(
+    SymmetryPrescreen(s.numbers, s.positions, 0.0).isAsymmetric());
+}
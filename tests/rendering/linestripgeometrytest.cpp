@@ -0,0 +1,80 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/vector.h>
+#include <avogadro/rendering/linestripgeometry.h>
+
+using Avogadro::Vector3f;
+using Avogadro::Vector3ub;
+using Avogadro::Core::Array;
+using Avogadro::Rendering::LineStripGeometry;
+
+TEST(LineStripGeometryTest, addLines)
+{
+  LineStripGeometry lines;
+  lines.setOpacity(128);
+
+  Array<Vector3f> points;
+  Array<Vector3ub> colors;
+  for (int i = 0; i < 4; ++i) {
+    points.push_back(Vector3f(static_cast<float>(i), 0.f, 0.f));
+    colors.push_back(Vector3ub(static_cast<unsigned char>(i), 0, 0));
+  }
+
+  EXPECT_EQ(static_cast<size_t>(0), lines.addLines(points, colors, 2.f));
+  ASSERT_EQ(static_cast<size_t>(4), lines.vertices().size());
+  EXPECT_EQ(Vector3f(3.f, 0.f, 0.f), lines.vertices()[3].vertex);
+  EXPECT_EQ(3, lines.vertices()[3].color[0]);
+  EXPECT_EQ(128, lines.vertices()[3].color[3]);
+
+  // Each segment is its own strip.
+  EXPECT_EQ(static_cast<size_t>(2), lines.addLines(points, colors, 2.f));
+  EXPECT_EQ(static_cast<size_t>(4), lines.addLineStrip(points, 1.f));
+}
+
+TEST(LineStripGeometryTest, addLinesInvalid)
+{
+  LineStripGeometry lines;
+  Array<Vector3f> points(3, Vector3f::Zero());
+  Array<Vector3ub> colors(3, Vector3ub(0, 0, 0));
+  EXPECT_EQ(LineStripGeometry::InvalidIndex,
+            lines.addLines(points, colors, 1.f));
+
+  points.push_back(Vector3f::Zero());
+  EXPECT_EQ(LineStripGeometry::InvalidIndex,
+            lines.addLines(points, colors, 1.f));
+  EXPECT_TRUE(lines.vertices().empty());
+}
+
+TEST(LineStripGeometryTest, displacements)
+{
+  LineStripGeometry lines;
+  Array<Vector3f> points(2, Vector3f::Zero());
+  lines.addLineStrip(points, 1.f);
+  lines.setDisplacements(Array<Vector3f>(2, Vector3f(0.f, 1.f, 0.f)));
+  lines.setDisplacementScale(0.5f);
+
+  LineStripGeometry copy(lines);
+  ASSERT_EQ(static_cast<size_t>(2), copy.displacements().size());
+  EXPECT_EQ(Vector3f(0.f, 1.f, 0.f), copy.displacements()[1]);
+  EXPECT_FLOAT_EQ(0.5f, copy.displacementScale());
+
+  lines.clear();
+  EXPECT_TRUE(lines.displacements().empty());
+}
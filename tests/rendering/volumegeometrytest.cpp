@@ -0,0 +1,137 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/vector.h>
+#include <avogadro/rendering/volumegeometry.h>
+
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Vector3f;
+using Avogadro::Vector3i;
+using Avogadro::Vector4ub;
+using Avogadro::Core::Array;
+using Avogadro::Rendering::VolumeGeometry;
+
+namespace {
+// A 17^3 grid, two bricks along each axis, that is zero except for a single
+// point in the brick at the far corner.
+std::vector<double> peakValues(const Vector3i& peak)
+{
+  std::vector<double> values(17 * 17 * 17, 0.0);
+  values[(peak.x() * 17 + peak.y()) * 17 + peak.z()] = 1.0;
+  return values;
+}
+
+// Transparent below 0.5, opaque above.
+Array<Vector4ub> stepFunction()
+{
+  Array<Vector4ub> colors(4, Vector4ub(255, 0, 0, 0));
+  colors[2][3] = colors[3][3] = 255;
+  return colors;
+}
+} // namespace
+
+TEST(VolumeGeometryTest, setData)
+{
+  VolumeGeometry volume;
+  EXPECT_FALSE(volume.setData(std::vector<double>(7), Vector3i(2, 2, 2),
+                              Vector3f::Zero(), Vector3f::Ones()));
+
+  std::vector<double> values(2 * 3 * 4);
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i] = static_cast<double>(i) - 5.0;
+  EXPECT_TRUE(volume.setData(values, Vector3i(2, 3, 4), Vector3f(1, 2, 3),
+                             Vector3f(0.5f, 0.5f, 0.25f)));
+  EXPECT_EQ(Vector3i(2, 3, 4), volume.dimensions());
+  EXPECT_EQ(Vector3f(1, 2, 3), volume.min());
+  EXPECT_FLOAT_EQ(-5.f, volume.minValue());
+  EXPECT_FLOAT_EQ(18.f, volume.maxValue());
+  EXPECT_EQ(Vector3i(1, 1, 1), volume.brickDimensions());
+
+  volume.clear();
+  EXPECT_EQ(Vector3i(0, 0, 0), volume.brickDimensions());
+}
+
+TEST(VolumeGeometryTest, brickDimensions)
+{
+  VolumeGeometry volume;
+  // Bricks span BrickSize intervals, so 9 points fit in one brick.
+  volume.setData(std::vector<double>(9 * 10 * 2), Vector3i(9, 10, 2),
+                 Vector3f::Zero(), Vector3f::Ones());
+  EXPECT_EQ(Vector3i(1, 2, 1), volume.brickDimensions());
+  EXPECT_EQ(8, VolumeGeometry::BrickSize);
+}
+
+TEST(VolumeGeometryTest, transferFunction)
+{
+  VolumeGeometry volume;
+  EXPECT_FALSE(volume.setTransferFunction(Array<Vector4ub>(), 0.f, 1.f));
+  EXPECT_FALSE(volume.setTransferFunction(stepFunction(), 1.f, 1.f));
+  EXPECT_TRUE(volume.setTransferFunction(stepFunction(), 0.f, 1.f));
+  EXPECT_EQ(static_cast<size_t>(4), volume.transferFunction().size());
+  EXPECT_FLOAT_EQ(0.f, volume.transferMinimum());
+  EXPECT_FLOAT_EQ(1.f, volume.transferMaximum());
+}
+
+TEST(VolumeGeometryTest, emptySpaceSkipping)
+{
+  VolumeGeometry volume;
+  volume.setData(peakValues(Vector3i(12, 12, 12)), Vector3i(17, 17, 17),
+                 Vector3f::Zero(), Vector3f::Ones());
+  EXPECT_EQ(Vector3i(2, 2, 2), volume.brickDimensions());
+
+  // Without a transfer function everything is transparent.
+  EXPECT_EQ(static_cast<Index>(0), volume.occupiedBrickCount());
+
+  volume.setTransferFunction(stepFunction(), 0.f, 1.f);
+  EXPECT_EQ(static_cast<Index>(1), volume.occupiedBrickCount());
+  EXPECT_TRUE(volume.brickOccupied(Vector3i(1, 1, 1)));
+  EXPECT_FALSE(volume.brickOccupied(Vector3i(0, 0, 0)));
+  EXPECT_FALSE(volume.brickOccupied(Vector3i(2, 0, 0)));
+
+  // Values between the entries are interpolated, so a brick is visible when
+  // its range reaches an opaque entry.
+  volume.setTransferFunction(stepFunction(), 0.f, 2.f);
+  EXPECT_EQ(static_cast<Index>(1), volume.occupiedBrickCount());
+  volume.setTransferFunction(stepFunction(), 0.f, 4.f);
+  EXPECT_EQ(static_cast<Index>(0), volume.occupiedBrickCount());
+
+  // Values below the range take the first entry.
+  Array<Vector4ub> colors(stepFunction());
+  colors[0][3] = 10;
+  volume.setTransferFunction(colors, 2.f, 3.f);
+  EXPECT_EQ(static_cast<Index>(8), volume.occupiedBrickCount());
+}
+
+TEST(VolumeGeometryTest, sharedBoundaries)
+{
+  // A point on the boundary between bricks is needed to interpolate within
+  // both of them.
+  VolumeGeometry volume;
+  volume.setData(peakValues(Vector3i(8, 3, 3)), Vector3i(17, 17, 17),
+                 Vector3f::Zero(), Vector3f::Ones());
+  volume.setTransferFunction(stepFunction(), 0.f, 1.f);
+  EXPECT_EQ(static_cast<Index>(2), volume.occupiedBrickCount());
+  EXPECT_TRUE(volume.brickOccupied(Vector3i(0, 0, 0)));
+  EXPECT_TRUE(volume.brickOccupied(Vector3i(1, 0, 0)));
+
+  volume.setData(peakValues(Vector3i(8, 8, 16)), Vector3i(17, 17, 17),
+                 Vector3f::Zero(), Vector3f::Ones());
+  EXPECT_EQ(static_cast<Index>(4), volume.occupiedBrickCount());
+}